@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef AMBIENT_H
+#define AMBIENT_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "config.h"
+#include "sensors.h"
+
+#define AMBIENT_DEFAULT_INTERVAL_SEC 60
+#define AMBIENT_DEFAULT_DRIVE_OFFSET 8.0    // °C an idle drive sits above the intake air
+#define AMBIENT_DEFAULT_REFERENCE 25.0      // Room the curves and ramp rates are tuned for
+#define AMBIENT_DEFAULT_RATE_GAIN 0.03      // Ramp rate change per °C away from the reference
+#define AMBIENT_RATE_MIN 0.5                // Ramp rate factor bounds
+#define AMBIENT_RATE_MAX 2.0
+#define AMBIENT_STALE_INTERVALS 3           // A reading older than this many intervals is dropped
+#define AMBIENT_BASELINE_SLOTS 60           // Drive baseline window, in intervals (an hour by default)
+#define AMBIENT_SOURCE_DRIVES "drives"
+#define AMBIENT_PATH_LEN 128
+
+// Room or intake temperature, from an hwmon temp*_input file (milli-°C),
+// a 1-wire w1_slave file (DS18B20 and friends: "... YES" then "t=<milli-°C>")
+// or, with source "drives", the idle baseline of the drives: the coolest
+// reading of the last AMBIENT_BASELINE_SLOTS intervals less drive_offset.
+// The control loop takes a reading once per interval. An hwmon file joins
+// the tick's sensors batch; a 1-wire read blocks for the sensor's
+// conversion time (about 0.75 s), so a reader thread does it and the tick
+// only takes the thread's last result.
+typedef struct {
+    char path[AMBIENT_PATH_LEN];    // "" = drives baseline
+    int enabled;
+    int interval_sec;
+    int32_t drive_offset_mc;
+    double read_at;                 // Monotonic time of the last attempt (0 = none)
+    double valid_at;                // Monotonic time of the last good reading (0 = none)
+    int32_t mc;                     // Last good reading, milli-°C
+    int failing;                    // The source failed since its last good reading (logged once)
+    int32_t baseline_mc[AMBIENT_BASELINE_SLOTS];
+    int baseline_count;
+    int baseline_index;
+
+    sensors_t *sensors;             // Batch the hwmon file is registered with (NULL = none)
+    int sensor_id;
+    int reader;                     // A reader thread owns the file (1-wire)
+    pthread_t thread;
+    pthread_mutex_t lock;           // Guards the fields below
+    pthread_cond_t wake;
+    int stop;
+    unsigned int read_seq;          // Reads the thread finished
+    unsigned int seen_seq;          // The last of them the tick took
+    int read_rc;
+    int32_t read_mc;
+} ambient_t;
+
+// From [ambient]; disabled when source is empty
+void ambient_init(ambient_t *a, const config_t *cfg);
+// Register an hwmon file with sensors (read by the tick's batch; NULL =
+// read it directly) or start the 1-wire reader thread. Returns 0, or -1 if
+// the thread cannot be created (the file is then read on the tick).
+int ambient_start(ambient_t *a, sensors_t *sensors);
+// Stop the reader thread; the batch keeps its file until sensors_close()
+void ambient_stop(ambient_t *a);
+// Parse an hwmon or w1_slave file's contents; -1 if it holds no plausible
+// air temperature (a failed 1-wire CRC or the DS18B20 power-on value among them)
+int ambient_parse(const char *text, int32_t *mc);
+// Refresh once the interval has passed; ssd_temps (MAX_DEVICES slots, 0 =
+// no reading) feed the drives baseline
+void ambient_update(ambient_t *a, const int *ssd_temps, double mono);
+// The last good reading if it is still fresh; 0 if there is none
+int ambient_current(const ambient_t *a, double mono, int32_t *mc);
+
+#endif // AMBIENT_H
@@ -0,0 +1,64 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <pthread.h>
+#include <time.h>
+
+#define BUDGET_DEFAULT_CPU_PERCENT 1.0
+#define BUDGET_WINDOW_SEC 60.0      // Usage is evaluated over this window
+#define BUDGET_MAX_LEVEL 3          // Slow paths run at most 2^3 = 8x less often
+#define BUDGET_RELAX_RATIO 0.5      // Step back down below this fraction of the budget
+
+// Self-overhead monitor. Measures the daemon's own CPU time (process-wide,
+// reaped children such as smartctl/popen helpers, and the control-loop and
+// OLED threads individually), voluntary wakeups and process spawns. When
+// process + children CPU exceeds the budget the degradation level rises,
+// and callers stretch the non-critical intervals (OLED refresh, smartctl
+// cache) by budget_scale(). The control tick, CPU sensor and fan writes are
+// never slowed down.
+typedef struct {
+    double cpu_budget_pct;      // Of one core; 0 = measure only
+    int level;                  // 0 = normal, up to BUDGET_MAX_LEVEL
+
+    // Latest window
+    double self_pct;            // Whole process (all threads)
+    double child_pct;           // Reaped child processes
+    double loop_pct;            // Control-loop thread
+    double oled_pct;            // OLED thread (0 when not running)
+    double wakeups_per_sec;     // Voluntary context switches
+    double spawns_per_min;
+
+    // Window start
+    double window_start;
+    double self_cpu0;
+    double child_cpu0;
+    double loop_cpu0;
+    double oled_cpu0;
+    long nvcsw0;
+    unsigned long spawns0;
+
+    clockid_t oled_clock;
+    int have_oled_clock;
+} budget_t;
+
+void budget_init(budget_t *b, double cpu_budget_pct, double now);
+
+// Track an extra thread's CPU clock (the OLED scroller)
+void budget_watch_oled_thread(budget_t *b, pthread_t thread);
+
+// Call once per tick; returns 1 when the degradation level changed
+int budget_update(budget_t *b, double now);
+
+// Interval multiplier for the current level (1, 2, 4, ...)
+unsigned int budget_scale(const budget_t *b);
+
+// Count one child process spawn (popen/fork); safe from any thread
+void budget_count_spawn(void);
+unsigned long budget_spawns(void);
+
+#endif // BUDGET_H
@@ -0,0 +1,22 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include "ctl.h"
+#include "daemon.h"
+
+// Control socket command handler (ctx is a daemon_t *)
+int commands_handle(void *ctx, int argc, char **argv, ctl_reply_t *reply);
+
+// Combine the controller output with any active override. The controller's
+// full-speed decision always wins so an override can never starve cooling.
+double commands_apply_overrides(daemon_t *d, double controller_dc, double now);
+
+daemon_mode_t commands_mode(const daemon_t *d, double now);
+const char *commands_mode_name(daemon_mode_t mode);
+
+#endif // COMMANDS_H
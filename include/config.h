@@ -9,6 +9,14 @@
 #define CONFIG_FILE "/etc/radxa-penta-fan-ctrl/radxa-penta-fan-ctrl.conf"
 #define MAX_LINE 256
 #define MAX_DEVICES 8
+#define CONFIG_METRICS_LISTEN "127.0.0.1:9105"
+#define CONFIG_MAX_PROFILES 6           // Including "default"
+#define CONFIG_MAX_SCHEDULE 8
+#define CONFIG_PROFILE_NAME_LEN 16
+#define CONFIG_DEFAULT_PROFILE "default"
+#define CONFIG_MAX_UNITS 4              // HAT sets (fan/display/button/disks) per daemon
+#define CONFIG_UNIT_NAME_LEN 16
+#define CONFIG_DEFAULT_UNIT "main"
 
 typedef struct {
     double lv0;
@@ -37,17 +45,117 @@ typedef struct {
     double down_rate_per_cycle;
     // After any increase, keep fan from decreasing for this many seconds
     double cooldown_hold_sec;
+
+    // Adaptive control period (rates above stay per second)
+    double period_min_sec;          // While ramping / heating fast (default 0.5)
+    double period_max_sec;          // When idle and cold (default 10)
+    double idle_margin_c;           // "Cold" = this far below every lv0 (default 5)
+    double idle_after_sec;          // Steady duty this long before slowing down (default 60)
 } thermal_tunables_t;
 
+// One complete set of curves and tunables. [fan]/[fan_ssd]/[thermal] form
+// "default"; each [profile.<name>] section starts from it and overrides keys.
 typedef struct {
+    char name[CONFIG_PROFILE_NAME_LEN];
     fan_config_t fan;
     fan_config_t fan_ssd;
+    thermal_tunables_t thermal;
+} fan_profile_t;
+
+// [schedule] entry "HH:MM = profile": active from that time of day on
+typedef struct {
+    int minute;                     // Minutes after local midnight
+    int profile;                    // Index into profiles
+} schedule_entry_t;
+
+typedef enum {
+    UNIT_FAN_NONE,
+    UNIT_FAN_GPIO,                  // Software PWM on a GPIO line
+    UNIT_FAN_PWM                    // Hardware PWM through /sys/class/pwm
+} unit_fan_t;
+
+// One HAT: a fan, an optional display and button, and the sensors that
+// drive its fan. Without [unit.<name>] sections a single "main" unit is
+// built from the environment file (HARDWARE_PWM, FAN_LINE, BUTTON_LINE...).
+typedef struct {
+    char name[CONFIG_UNIT_NAME_LEN];
+    unit_fan_t fan;
+    int fan_chip;                   // GPIO chip index (software PWM)
+    int fan_line;                   // GPIO line (software PWM)
+    int pwm_chip;                   // pwmchipN (hardware PWM)
+    int pwm_channel;                // pwmN (hardware PWM)
+    int oled;                       // 1 = SSD1306 display present
+    int oled_bus;                   // I2C bus (/dev/i2c-N)
+    int oled_addr;                  // 7-bit I2C address
+    int oled_rotate;                // -1 = inherit [oled] rotate
+    int button_chip;                // -1 = no button
+    int button_line;
+    int cpu;                        // CPU temperature drives this fan (default 1)
+    unsigned int disks;             // Bit i = SSD i (sda..sdd) drives this fan
+} unit_config_t;
+
+typedef struct {
+    fan_profile_t profiles[CONFIG_MAX_PROFILES];
+    int profile_count;
+    fan_profile_t *active;          // Curves the controller uses; swapped between ticks
+    schedule_entry_t schedule[CONFIG_MAX_SCHEDULE];
+    int schedule_count;             // Sorted by minute
+    unit_config_t units[CONFIG_MAX_UNITS];
+    int unit_count;                 // >= 1; units[0] is the primary unit
     int fan_enabled;
-    thermal_tunables_t thermal;    // New thermal tunables
     int oled_rotate;                // OLED 180 degree rotation (default 0)
+    int metrics_enabled;            // Prometheus exporter (default 0)
+    char metrics_listen[64];        // "host:port" or "unix:/path"
+    int ctl_enabled;                // Unix control socket (default 1)
+    char ctl_socket[64];            // Control socket path
+    int status_shm_enabled;         // /dev/shm status segment (default 1)
+    int flightrec_records;          // Flight recorder ring size, 0 = off (default 3600)
+    char flightrec_dir[64];         // Where dumps are written
+    int history_enabled;            // Compressed on-disk history (default 1)
+    char history_path[128];         // History file
+    int history_size_mb;            // Preallocated file size (default 8)
+    int history_flush_sec;          // RAM block flush interval (default 600)
+    int usage_enabled;              // SLO / fan-usage counters (default 1)
+    char usage_path[128];           // Counter checkpoint file
+    int usage_checkpoint_sec;       // Checkpoint interval (default 300)
+    int mqtt_enabled;               // MQTT telemetry publisher (default 0)
+    char mqtt_broker[64];           // "host[:port]" (default 127.0.0.1:1883)
+    char mqtt_client_id[48];        // "" = radxa-penta-<hostname>
+    char mqtt_username[32];         // "" = no authentication
+    char mqtt_password[64];
+    char mqtt_topic[64];            // Base topic, "" = radxa-penta/<hostname>
+    int mqtt_discovery;             // Home Assistant discovery configs (default 1)
+    char mqtt_discovery_prefix[32]; // Default "homeassistant"
+    int mqtt_keepalive_sec;         // Default 60
+    double mqtt_temp_deadband;      // °C change before republishing (default 0.5)
+    double mqtt_duty_deadband;      // Duty change (0-1) before republishing (default 0.02)
+    char log_level[16];             // "auto" (RADXA_DEBUG) or error/warning/info/debug/verbose
+    int log_journal;                // 1 = native journald, 0 = stdout/stderr, -1 = auto
+    char log_journal_socket[108];   // journald native socket
+    double budget_cpu_percent;      // Self-overhead budget, % of one core, 0 = off (default 1.0)
+    char shadow_config[128];        // Shadow controller config, "" = off (default)
+    double shadow_divergence;       // |duty delta| counted as divergent (default 0.10)
+    int smart_health_interval_sec;  // smartctl passes that also parse health (default 3600)
+    int smart_json;                 // Run smartctl --json instead of the text report (default 0)
+    int sensors_io_uring;           // Batch sensor file reads through io_uring (default 0)
+    char controller_plugin[128];    // Controller plugin .so, "" = built-in (default)
+    char controller_config[128];    // File handed to the plugin's init, "" = none
+    char ambient_source[128];       // hwmon/w1_slave file or "drives", "" = off (default)
+    int ambient_interval_sec;       // Ambient read interval (default 60)
+    double ambient_drive_offset;    // "drives": °C an idle drive sits above the air (default 8.0)
+    double ambient_reference;       // Ambient the curves and ramp rates are tuned for (default 25.0)
+    int ambient_relative;           // Curve levels are °C above ambient (default 0)
+    double ambient_rate_gain;       // Ramp rate change per °C away from the reference (default 0.03)
+    unsigned int generation;        // New on every load or config_changed(); keys caches of derived values
 } config_t;
 
 int config_load(config_t *cfg);
+int config_load_file(config_t *cfg, const char *path);
+// Call after editing a loaded config in place: values derived from it
+// (the fixed-point law's integer tunables) are rebuilt on the next step
+void config_changed(config_t *cfg);
+int config_find_profile(const config_t *cfg, const char *name);  // -1 if unknown
+int config_find_unit(const config_t *cfg, const char *name);     // -1 if unknown
 double config_temp_to_dc(fan_config_t *fan_cfg, double temp);
 
 #endif // CONFIG_H
@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "thermal.h"
+#include "controller_abi.h"
+
+#define CONTROLLER_CONFIG_MAX 4096          // Largest [controller] config file handed to init
+#define CONTROLLER_STATE_MAX (1024 * 1024)  // Largest per-instance state a plugin may ask for
+#define CONTROLLER_STEP_BUDGET_NS 500000ULL // A step slower than this is counted (and logged once)
+
+// Built-in law's instance state: init takes this struct by value instead
+// of a text config, and the law keeps working on the unit's state in place.
+// The host sets the step's readings here, as read (the plugin input carries
+// them converted to doubles).
+typedef struct {
+    config_t *cfg;
+    thermal_state_t *ts;
+    int32_t cpu_mc;
+    const int *ssd_temps;           // MAX_DEVICES slots
+    int ssd_count;
+} controller_builtin_t;
+
+// Host side of the controller plugin ABI (controller_abi.h). The built-in
+// law is itself a controller_plugin_t; its state points at the unit's
+// thermal_state_t so every status surface reads the same fields whatever
+// controller runs. For a loaded plugin the host runs the shared filter
+// and duty bookkeeping on that thermal_state_t around each step.
+typedef struct {
+    const controller_plugin_t *ops;
+    void *dl;                       // dlopen handle, NULL for the built-in
+    void *state;                    // ops->state_size bytes, allocated at load
+    int builtin;
+    controller_builtin_t builtin_state; // state of the built-in (no allocation)
+    thermal_state_t *thermal;
+    controller_input_t in;          // Reused every step (steps never allocate)
+    double last_duty;
+    unsigned long steps;
+    unsigned long slow_steps;       // Steps over CONTROLLER_STEP_BUDGET_NS
+    unsigned long bad_outputs;      // NaN or out-of-range duties (clamped)
+    unsigned long forced_steps;     // Plugin duties raised to 100% with a sensor at lv3
+    uint64_t max_step_ns;
+} controller_t;
+
+// Load [controller] plugin for one unit. Any failure (missing file, wrong
+// ABI version, init error) warns and falls back to the built-in law; the
+// return value is -1 in that case so callers can report it.
+int controller_load(controller_t *c, config_t *cfg, thermal_state_t *ts, const char *label);
+
+// One step on this unit's view of the tick's readings (CPU in milli-°C);
+// returns the duty (0-1)
+double controller_step(controller_t *c, config_t *cfg, int32_t cpu_mc, const int *ssd_temps, int ssd_count);
+
+// ops->serialize into buf (0 if the controller has none)
+size_t controller_serialize(const controller_t *c, void *buf, size_t len);
+
+void controller_unload(controller_t *c);
+
+#endif // CONTROLLER_H
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef CONTROLLER_ABI_H
+#define CONTROLLER_ABI_H
+
+// Controller plugin ABI. A plugin is a shared object exporting
+//
+//     const controller_plugin_t *radxa_penta_controller_plugin(void);
+//
+// selected with [controller] plugin = /path/to/plugin.so. The daemon keeps
+// one instance per unit: it allocates state_size zeroed bytes once, calls
+// init() with the [controller] config file's contents, then step() every
+// control tick from the main loop (never concurrently). step() must not
+// allocate, block or do I/O: all memory it needs lives in the state block.
+// The host filters the sensors (moving average, trend) and passes both the
+// raw and the filtered values; overrides, the thermal emergency rule and
+// actuation stay in the host.
+//
+// Only this header is needed to build a plugin:
+//     cc -shared -fPIC -o my_law.so my_law.c
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CONTROLLER_ABI_VERSION 1        // Bumped on any incompatible change
+#define CONTROLLER_PLUGIN_SYMBOL "radxa_penta_controller_plugin"
+#define CONTROLLER_MAX_SSD 8
+
+// One step's inputs. Temperatures in °C, trends in °C per second.
+typedef struct {
+    double now;                         // Monotonic seconds
+    double cpu_temp;                    // Raw; 0 when the unit ignores the CPU
+    double cpu_avg;                     // Host moving average
+    double cpu_trend;                   // Positive = heating
+    int32_t ssd_temps[CONTROLLER_MAX_SSD];  // Raw per drive; 0 = no reading / not this unit's
+    uint32_t ssd_count;                 // Drives with a reading
+    double ssd_avg;                     // Moving average of the hottest drive
+    double ssd_trend;
+    double cpu_levels[4];               // Active fan profile's curves (lv0..lv3)
+    double ssd_levels[4];
+    double last_duty;                   // What this instance returned last step (0-1)
+} controller_input_t;
+
+typedef struct {
+    uint32_t abi_version;               // CONTROLLER_ABI_VERSION
+    const char *name;
+    size_t state_size;                  // Per-instance state, zeroed by the host
+
+    // config is NUL-terminated (empty without a config file); 0 = ready
+    int (*init)(void *state, const char *config, size_t config_len);
+
+    // Duty for the fan (0-1) after dt_sec since the previous step
+    double (*step)(void *state, const controller_input_t *in, double dt_sec);
+
+    // Optional: compact snapshot of the state for diagnostics; returns the
+    // bytes written (at most buf_len)
+    size_t (*serialize)(const void *state, void *buf, size_t buf_len);
+} controller_plugin_t;
+
+typedef const controller_plugin_t *(*controller_plugin_entry_t)(void);
+
+#endif // CONTROLLER_ABI_H
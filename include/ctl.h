@@ -0,0 +1,64 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef CTL_H
+#define CTL_H
+
+#include <stddef.h>
+#include <poll.h>
+
+#define CTL_SOCKET_PATH "/run/radxa-penta-fan-ctrl.sock"
+#define CTL_MAX_CLIENTS 4
+#define CTL_IN_BUF 256
+#define CTL_OUT_BUF 4096
+#define CTL_MAX_ARGS 8
+
+// Line protocol: the client sends one command per line ("status\n",
+// "boost 60 100\n", ...). Each reply is zero or more data lines followed by a
+// final "OK" or "ERR <reason>" line.
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    int overflow;
+    int error;
+} ctl_reply_t;
+
+// Command handler supplied by the daemon. Write data lines with
+// ctl_reply_printf() and return 0 for OK, or -1 after ctl_reply_error().
+typedef int (*ctl_handler_fn)(void *ctx, int argc, char **argv, ctl_reply_t *reply);
+
+typedef struct {
+    int fd;
+    size_t in_len;
+    int discarding;            // Skipping the rest of an over-long line
+    char in[CTL_IN_BUF];
+    size_t out_len;
+    size_t out_off;
+    char out[CTL_OUT_BUF];
+} ctl_client_t;
+
+typedef struct {
+    int listen_fd;
+    char path[108];
+    ctl_handler_fn handler;
+    void *handler_ctx;
+    ctl_client_t clients[CTL_MAX_CLIENTS];
+} ctl_server_t;
+
+int ctl_init(ctl_server_t *ctl, const char *path, ctl_handler_fn handler, void *ctx);
+void ctl_cleanup(ctl_server_t *ctl);
+
+__attribute__((format(printf, 2, 3)))
+void ctl_reply_printf(ctl_reply_t *reply, const char *fmt, ...);
+__attribute__((format(printf, 2, 3)))
+void ctl_reply_error(ctl_reply_t *reply, const char *fmt, ...);
+
+// Event-loop integration (same contract as metrics_pollfds/metrics_dispatch)
+int ctl_pollfds(ctl_server_t *ctl, struct pollfd *pfds, int max);
+void ctl_dispatch(ctl_server_t *ctl, const struct pollfd *pfds, int count);
+
+#endif // CTL_H
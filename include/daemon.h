@@ -0,0 +1,64 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "config.h"
+#include "thermal.h"
+#include "fan.h"
+#include "history.h"
+#include "stages.h"
+#include "budget.h"
+#include "shadow.h"
+#include "usage.h"
+#include "mqtt.h"
+#include "unit.h"
+#include "sensors.h"
+#include "sysinfo.h"
+
+typedef enum {
+    DAEMON_MODE_AUTO,
+    DAEMON_MODE_MANUAL,
+    DAEMON_MODE_BOOST
+} daemon_mode_t;
+
+// Runtime overrides requested over the control socket
+typedef struct {
+    double manual_duty;     // Fixed duty (0-1), or < 0 for automatic control
+    double boost_until;     // Monotonic deadline of an active boost (0 = none)
+    double boost_duty;      // Minimum duty while boosting
+} override_t;
+
+// State shared between the control loop and the runtime interfaces. The
+// single-value fields (thermal, duties) describe the primary unit; the
+// sample, fan_error and the counters cover every unit.
+typedef struct {
+    config_t *cfg;
+    unit_t *units;
+    int unit_count;
+    thermal_state_t *thermal;   // Primary unit's controller
+    thermal_sample_t sample;    // Last tick's sensor pass: every drive, not one unit's
+    fan_t *fan;                 // Primary unit's fan, NULL if it has none
+    history_t *history;     // NULL when the history store is disabled
+    stages_t *stages;       // Per-stage latency histograms
+    budget_t *budget;       // Self-overhead monitor
+    shadow_t *shadow;       // NULL unless a shadow controller is configured
+    usage_t *usage;         // NULL when usage accounting is disabled
+    mqtt_t *mqtt;           // NULL unless MQTT is enabled
+    sensors_t *sensors;     // Batched sensor file reader
+    sysinfo_t *sysinfo;     // Cached addresses, hostname, RAID mount
+    override_t override;
+    double controller_dc;   // Duty requested by the thermal controller
+    double applied_dc;      // Duty actually written to the fan
+    double started_at;      // Monotonic start time
+    unsigned long ticks;
+    unsigned long duty_changes;
+    unsigned long fan_write_errors;
+    unsigned long ssd_reads;
+    int fan_error;          // Last duty write failed on any unit
+} daemon_t;
+
+#endif // DAEMON_H
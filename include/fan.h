@@ -8,9 +8,8 @@
 
 #include <gpiod.h>
 #include "config.h"
-
-#define PWM_PERIOD_US 40  // 40µs = 25 kHz (standard for PC PWM fans like Noctua)
-#define GPIO_PERIOD_S 0.01f  // 10ms = 100 Hz (RPi 5 requirement for Radxa Penta fan)
+#include "metrics.h"
+#include "fan_pwm.h"
 
 typedef struct {
     int use_hardware_pwm;
@@ -29,9 +28,16 @@ typedef struct {
     double period_s;
     double duty_cycle;
     int running;
+    metrics_histogram_t *edge_jitter;  // Optional: software PWM edge lateness
 } fan_t;
 
-int fan_init(fan_t *fan);
+#define FAN_PWM_ROOT "/sys/class/pwm"
+
+// Claim the unit's fan output (hardware PWM or a software PWM thread)
+int fan_init(fan_t *fan, const unit_config_t *unit);
+// Where the pwmchip directories are looked up (for mock backends; NULL
+// restores FAN_PWM_ROOT)
+void fan_set_pwm_root(const char *root);
 int fan_set_duty_cycle(fan_t *fan, double duty);
 void fan_cleanup(fan_t *fan);
 void* fan_control_loop(void *arg);
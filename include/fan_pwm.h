@@ -0,0 +1,30 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef FAN_PWM_H
+#define FAN_PWM_H
+
+#include <time.h>
+
+#define PWM_PERIOD_US 40  // 40µs = 25 kHz (standard for PC PWM fans like Noctua)
+#define GPIO_PERIOD_S 0.01f  // 10ms = 100 Hz (RPi 5 requirement for Radxa Penta fan)
+
+// Duty-to-output arithmetic of the fan actuator, kept apart from the
+// sysfs/gpiod backends in fan.c so it builds and runs without hardware.
+
+typedef struct {
+    struct timespec high;
+    struct timespec low;
+    struct timespec full;
+} fan_pwm_timing_t;
+
+// Requested duty clamped to 0-1
+double fan_pwm_clamp(double duty);
+// Hardware PWM duty_cycle attribute (ns) for a period
+int fan_pwm_duty_ns(int period_ns, double duty);
+// Software PWM high/low sleeps of one period of period_s
+void fan_pwm_timing(double period_s, double duty, fan_pwm_timing_t *t);
+
+#endif // FAN_PWM_H
@@ -0,0 +1,96 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef FLIGHTREC_H
+#define FLIGHTREC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLIGHTREC_DIR "/var/lib/radxa-penta-fan-ctrl"
+#define FLIGHTREC_DEFAULT_RECORDS 3600       // One hour at 1 Hz (~170 KiB)
+#define FLIGHTREC_MAGIC 0x52465052u          // "RPFR" little-endian
+#define FLIGHTREC_VERSION 2
+#define FLIGHTREC_ALARM_MIN_INTERVAL_SEC 600 // Rate limit for alarm-triggered dumps
+#define FLIGHTREC_NAME_TRIES 100             // Taken names skipped before a dump gives up
+
+// flightrec_record_t.flags
+#define FR_FLAG_HOLD          (1u << 0)  // Cooldown hold active
+#define FR_FLAG_DEADBAND      (1u << 1)  // Tick suppressed by dead-band
+#define FR_FLAG_RATE_LIMITED  (1u << 2)  // Controller output clipped by ramp limits
+#define FR_FLAG_SSD_FRESH     (1u << 3)  // smartctl ran this tick
+#define FR_FLAG_FAN_ERROR     (1u << 4)  // Duty write failed
+#define FR_FLAG_ALARM         (1u << 5)  // A sensor is at/above its lv3 threshold
+
+// Dump reasons (flightrec_header_t.reason)
+#define FR_REASON_SIGNAL   1
+#define FR_REASON_ALARM    2
+
+// One control tick, 48 bytes, fixed-width fields only. Temperatures are
+// centi-°C (trends per history window), duties per-mille. t_ms is 64-bit
+// so dumps after months of uptime still decode to the right time.
+typedef struct {
+    uint64_t t_ms;           // Milliseconds since the recorder started
+    uint32_t tick;
+    int16_t cpu_raw_cc;
+    int16_t cpu_avg_cc;
+    int16_t cpu_trend_cc;
+    int16_t ssd_max_c;       // Hottest raw SSD reading, °C
+    int16_t ssd_avg_c;
+    int16_t ssd_trend_cc;
+    uint16_t target_pm;      // Curve target
+    uint16_t controller_pm;  // After rate limiting
+    uint16_t applied_pm;     // After overrides, written to the fan
+    uint8_t flags;           // FR_FLAG_*
+    uint8_t mode;            // STATUS_MODE_* (auto/manual/boost)
+    uint32_t tick_us;        // Whole tick duration
+    uint32_t ssd_read_us;    // smartctl pass duration (0 when cached)
+    uint16_t cpu_read_us;
+    uint16_t reserved;
+    uint32_t reserved2;
+} flightrec_record_t;
+
+_Static_assert(sizeof(flightrec_record_t) == 48, "flightrec_record_t layout changed: bump FLIGHTREC_VERSION");
+
+// Dump file: header followed by `count` records, oldest first
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t reason;         // FR_REASON_*
+    int64_t start_wall_sec;  // Wall clock when t_ms was 0
+    int64_t dump_wall_sec;
+} flightrec_header_t;
+
+_Static_assert(sizeof(flightrec_header_t) == 32, "flightrec_header_t layout changed: bump FLIGHTREC_VERSION");
+
+typedef struct {
+    flightrec_record_t *ring;   // Allocated once at init
+    size_t capacity;
+    uint64_t written;           // Total records ever appended
+    double start_mono;
+    int64_t start_wall_sec;
+    int64_t last_alarm_dump;    // Wall time of the last alarm dump
+    int alarm_latched;          // Alarm seen on the previous tick
+    unsigned int dump_seq;      // Sequence number of the next dump's file name
+    char dir[64];
+} flightrec_t;
+
+int flightrec_init(flightrec_t *fr, size_t capacity, const char *dir);
+void flightrec_cleanup(flightrec_t *fr);
+
+// Returns the next ring slot to fill in place (no allocation, no locking;
+// the control loop is the only writer). t_ms is pre-filled.
+flightrec_record_t *flightrec_next(flightrec_t *fr);
+
+// Write the ring to <dir>/flightrec-<unix time>-<seq>.bin, published with
+// link() so an existing dump is never replaced. Returns 0 on success.
+int flightrec_dump(flightrec_t *fr, uint32_t reason);
+
+// Dump once when an alarm condition first appears (rate limited).
+void flightrec_check_alarm(flightrec_t *fr, int alarm);
+
+#endif // FLIGHTREC_H
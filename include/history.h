@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define HISTORY_PATH "/var/lib/radxa-penta-fan-ctrl/history.dat"
+#define HISTORY_BLOCK_SIZE 4096
+#define HISTORY_DEFAULT_SIZE_MB 8     // ~30 days at 1 Hz for the series below
+#define HISTORY_DEFAULT_FLUSH_SEC 600
+
+// Compressed time-series store (Gorilla-style): timestamps are
+// delta-of-delta encoded and values XOR encoded into fixed 4 KiB blocks of
+// a preallocated, memory-mapped file used as a ring (oldest block is
+// overwritten on rollover). The block being filled lives in RAM and is
+// copied to the mapping only every flush_sec, so an SD card sees one page
+// write per flush instead of one per sample.
+
+typedef enum {
+    HISTORY_CPU_TEMP,   // Filtered CPU temperature, °C
+    HISTORY_SSD_TEMP,   // Filtered hottest-SSD temperature, °C
+    HISTORY_DUTY,       // Applied fan duty, 0-1
+    HISTORY_SERIES
+} history_series_t;
+
+typedef struct {
+    pthread_mutex_t lock;       // Appends (control loop) vs queries (OLED, socket)
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    uint32_t nblocks;           // Data blocks (file block 0 is the header)
+    uint32_t head;              // Data block the RAM block is flushed into
+    uint32_t next_seq;
+    uint8_t cur[HISTORY_BLOCK_SIZE] __attribute__((aligned(8)));  // Block header at offset 0
+    int dirty;
+    int flush_sec;
+    double last_flush;
+
+    // Encoder state for the current block
+    int64_t prev_ts;
+    int64_t prev_delta;
+    uint64_t prev_bits[HISTORY_SERIES];
+    int prev_lead[HISTORY_SERIES];
+    int prev_trail[HISTORY_SERIES];
+} history_t;
+
+int history_open(history_t *h, const char *path, size_t size_mb, int flush_sec);
+void history_close(history_t *h);
+
+// Append one sample row (values indexed by history_series_t) at wall time ts
+void history_append(history_t *h, int64_t ts, const double *values);
+
+// Copy the RAM block to the mapping if flush_sec has elapsed (call per tick)
+void history_maybe_flush(history_t *h, double now_mono);
+
+// Average one series into nbuckets equal buckets over [from, to).
+// Empty buckets are NAN. Returns the number of samples aggregated.
+size_t history_query(history_t *h, history_series_t series, int64_t from, int64_t to,
+                     double *out, size_t nbuckets);
+
+const char *history_series_name(history_series_t series);
+int history_series_from_name(const char *name);
+
+#endif // HISTORY_H
@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stddef.h>
+
+#define LOGGER_JOURNAL_SOCKET "/run/systemd/journal/socket"
+#define LOGGER_IDENTIFIER "radxa-penta-fan-ctrl"
+#define LOGGER_FIELDS_SIZE 384
+#define LOGGER_MESSAGE_SIZE 512
+#define LOGGER_SITES 32                 // Call sites tracked for rate limiting
+#define LOGGER_RATE_INTERVAL_SEC 10.0
+#define LOGGER_RATE_BURST 10            // Messages per call site per interval
+#define LOGGER_DEDUP_SEC 60.0           // Identical repeats within this are folded
+
+// Levels use syslog priorities (VERBOSE is sent to journald as debug)
+typedef enum {
+    LOGGER_ERROR = 3,
+    LOGGER_WARNING = 4,
+    LOGGER_INFO = 6,
+    LOGGER_DEBUG = 7,
+    LOGGER_VERBOSE = 8
+} logger_level_t;
+
+// Structured fields attached to one message, as journald "KEY=value" lines
+typedef struct {
+    char buf[LOGGER_FIELDS_SIZE];
+    size_t len;
+} logger_fields_t;
+
+// Set the threshold once at startup. level_name is "auto" (derive from
+// RADXA_DEBUG: unset/0 = info, 1 = debug, 2 = verbose) or a level name.
+// journal: 1 = send to journald's native socket, 0 = stdout/stderr only,
+// -1 = only when running under systemd (JOURNAL_STREAM is set). Failed
+// sends fall back to stdout (info and below) or stderr.
+void logger_init(const char *level_name, int journal, const char *journal_socket);
+void logger_close(void);
+
+// Cheap threshold check for guarding expensive debug output
+int logger_enabled(logger_level_t level);
+int logger_parse_level(const char *name);  // -1 if unknown
+
+void logger_fields_init(logger_fields_t *f);
+void logger_field(logger_fields_t *f, const char *key, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+// Log one message (fields may be NULL). Rate limited and deduplicated per
+// call site (fmt pointer); suppressed counts are reported once the site's
+// window ends or a different message follows.
+void logger_log(logger_level_t level, const logger_fields_t *fields, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#endif // LOGGER_H
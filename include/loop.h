@@ -0,0 +1,134 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef LOOP_H
+#define LOOP_H
+
+#include <time.h>
+#include "config.h"
+#include "metrics.h"
+#include "ctl.h"
+#include "daemon.h"
+#include "status_shm.h"
+#include "flightrec.h"
+#include "history.h"
+#include "stages.h"
+#include "budget.h"
+#include "shadow.h"
+#include "usage.h"
+#include "mqtt.h"
+#include "sensors.h"
+#include "ambient.h"
+#include "sysinfo.h"
+#include "unit.h"
+
+#define LOOP_MAX_POLL_FDS 16
+#define LOOP_STAGE_QUANTILES 3
+
+// Prometheus series the loop publishes every tick
+typedef struct {
+    metrics_gauge_t *temp_cpu;
+    metrics_gauge_t *temp_ssd[SSD_DEVICE_COUNT];
+    metrics_gauge_t *temp_ambient;  // NULL without [ambient] source
+    metrics_gauge_t *filtered_cpu;
+    metrics_gauge_t *filtered_ssd;
+    metrics_gauge_t *age_cpu;
+    metrics_gauge_t *age_ssd;
+    metrics_gauge_t *duty;
+    metrics_gauge_t *duty_target;
+    metrics_gauge_t *hold;
+    metrics_gauge_t *deadband;
+    metrics_gauge_t *ticks;
+    metrics_gauge_t *period;
+    metrics_histogram_t *tick_duration;
+    metrics_histogram_t *read_cpu;
+    metrics_histogram_t *read_ssd;
+    metrics_gauge_t *stage_latency[STAGE_COUNT][LOOP_STAGE_QUANTILES];
+    metrics_gauge_t *cpu_self;
+    metrics_gauge_t *cpu_children;
+    metrics_gauge_t *cpu_loop;
+    metrics_gauge_t *cpu_oled;
+    metrics_gauge_t *wakeups;
+    metrics_gauge_t *spawns;
+    metrics_gauge_t *budget_level;
+    metrics_gauge_t *shadow_duty;
+    metrics_gauge_t *shadow_delta;
+    metrics_gauge_t *shadow_divergent;
+    metrics_gauge_t *energy_active;
+    metrics_gauge_t *energy_shadow;
+    metrics_gauge_t *profile[CONFIG_MAX_PROFILES];
+    metrics_gauge_t *above_level[USAGE_SENSORS][USAGE_LEVELS];
+    metrics_gauge_t *duty_band[USAGE_DUTY_BANDS];
+    metrics_gauge_t *fan_starts;
+    metrics_gauge_t *mqtt_connected;
+    metrics_gauge_t *mqtt_dropped;
+    metrics_gauge_t *health[5][SSD_DEVICE_COUNT];
+    metrics_gauge_t *unit_duty[CONFIG_MAX_UNITS];
+    metrics_gauge_t *unit_cpu[CONFIG_MAX_UNITS];
+    metrics_gauge_t *unit_ssd[CONFIG_MAX_UNITS];
+} loop_metrics_t;
+
+// The daemon's control loop without main(): the units it steps and every
+// surface a tick feeds (metrics, control socket, status segment, flight
+// recorder, MQTT, history, usage counters, shadow controller, ambient
+// sensor). The daemon runs it on the real clock; radxa-penta-soak runs the
+// same ticks on a virtual one against mock backends. Large (the metrics
+// registry is fixed-size), so keep it static.
+typedef struct {
+    config_t *cfg;
+    int use_metrics;
+    int use_ctl;
+    int use_status_shm;
+    int use_flightrec;
+    int use_history;
+    int use_shadow;
+    int use_usage;
+    int use_mqtt;
+
+    metrics_t metrics;
+    loop_metrics_t series;
+    ctl_server_t ctl;
+    daemon_t daemon;
+    status_pub_t status_pub;
+    flightrec_t flightrec;
+    history_t history;
+    stages_t stages;
+    budget_t budget;
+    shadow_t shadow;
+    usage_t usage;
+    mqtt_t mqtt;
+    sensors_t sensors;
+    ambient_t ambient;
+    sysinfo_t sysinfo;
+    unit_t units[CONFIG_MAX_UNITS];
+    int unit_count;
+
+    double last_tick_start;
+    double last_period;
+    double tick_end;            // Monotonic end of the last tick
+    time_t last_history_sec;
+} loop_t;
+
+// Start every surface cfg enables and claim each unit's hardware. A
+// surface that cannot start only warns; a unit whose fan cannot be claimed
+// fails the loop (-1, nothing left running). status_name is the shm_open
+// name of the status segment (STATUS_SHM_NAME for the daemon).
+int loop_open(loop_t *l, config_t *cfg, const char *status_name);
+
+// One control tick: profile switch, sensor pass, every unit's controller
+// and fan, shadow, status, metrics, history, MQTT, usage, flight recorder
+// and the overhead budget. Returns the period until the next tick.
+double loop_tick(loop_t *l);
+
+// One poll round over the loop's sockets and change notifications, at
+// most timeout_ms (0 = only what is ready). Returns 1 when a control
+// command changed the overrides or a profile switch is queued, so the
+// caller can run the next tick at once.
+int loop_poll(loop_t *l, int timeout_ms);
+
+// Stop the fans and release everything loop_open() started
+void loop_close(loop_t *l);
+
+#endif // LOOP_H
@@ -0,0 +1,105 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <poll.h>
+
+#define METRICS_MAX_GAUGES 136
+#define METRICS_MAX_HISTOGRAMS 12
+#define METRICS_MAX_BUCKETS 16
+#define METRICS_MAX_CLIENTS 4
+#define METRICS_LABELS_LEN 48
+#define METRICS_NAME_MAX 64             // Longer names or help texts are refused at registration
+#define METRICS_HELP_MAX 128
+#define METRICS_REQ_BUF 1024
+#define METRICS_HTTP_HEADER_MAX 128
+
+// Worst-case exposition size of a full registry, so a scrape always fits:
+// a family's "# HELP"/"# TYPE" pair, and one sample line with the longest
+// labels, an le="..." bucket label and a value ("%.6g", "%llu" or "%.9f")
+#define METRICS_FAMILY_LINES_MAX (2 * METRICS_NAME_MAX + METRICS_HELP_MAX + 32)
+#define METRICS_SAMPLE_LINE_MAX (METRICS_NAME_MAX + METRICS_LABELS_LEN + 32 + 24 + 16)
+#define METRICS_BODY_MAX \
+    (METRICS_MAX_GAUGES * (METRICS_FAMILY_LINES_MAX + METRICS_SAMPLE_LINE_MAX) + \
+     METRICS_MAX_HISTOGRAMS * (METRICS_FAMILY_LINES_MAX + (METRICS_MAX_BUCKETS + 3) * METRICS_SAMPLE_LINE_MAX))
+#define METRICS_RESP_BUF (METRICS_HTTP_HEADER_MAX + METRICS_BODY_MAX)
+
+// All storage is fixed-size and lives inside metrics_t: registration only
+// hands out pointers into these arrays, so updating a metric never allocates.
+
+typedef struct {
+    const char *name;
+    const char *help;
+    const char *type;                   // "gauge" or "counter"
+    char labels[METRICS_LABELS_LEN];    // e.g. sensor="cpu" (may be empty)
+    double value;
+} metrics_gauge_t;
+
+typedef struct {
+    const char *name;
+    const char *help;
+    char labels[METRICS_LABELS_LEN];
+    const double *bounds;               // Upper bounds in seconds, ascending
+    size_t nbounds;
+    // Non-cumulative counts; index nbounds is the +Inf bucket.
+    // Updated with relaxed atomics so other threads (software PWM) may observe.
+    uint64_t buckets[METRICS_MAX_BUCKETS + 1];
+    uint64_t count;
+    uint64_t sum_ns;
+} metrics_histogram_t;
+
+typedef struct {
+    int fd;
+    size_t in_len;
+    char in[METRICS_REQ_BUF];
+    size_t out_len;
+    size_t out_off;
+    int responding;
+    char out[METRICS_RESP_BUF];
+} metrics_client_t;
+
+typedef struct {
+    int listen_fd;
+    int is_unix;
+    char unix_path[108];
+    metrics_gauge_t gauges[METRICS_MAX_GAUGES];
+    size_t gauge_count;
+    metrics_histogram_t histograms[METRICS_MAX_HISTOGRAMS];
+    size_t histogram_count;
+    int truncated;                      // A render did not fit (warned once)
+    metrics_client_t clients[METRICS_MAX_CLIENTS];
+} metrics_t;
+
+// listen is "host:port" (IPv4, e.g. 127.0.0.1:9105) or "unix:/path/to.sock"
+int metrics_init(metrics_t *m, const char *listen);
+void metrics_cleanup(metrics_t *m);
+
+// Registration (startup only). Returns NULL when the registry is full or
+// the name, help or labels exceed their bounds.
+metrics_gauge_t *metrics_gauge(metrics_t *m, const char *name, const char *help, const char *labels);
+metrics_gauge_t *metrics_counter(metrics_t *m, const char *name, const char *help, const char *labels);
+metrics_histogram_t *metrics_histogram(metrics_t *m, const char *name, const char *help, const char *labels,
+                                       const double *bounds, size_t nbounds);
+
+// Hot-path updates. NULL-safe so callers need no "is metrics enabled" checks.
+void metrics_gauge_set(metrics_gauge_t *g, double value);
+void metrics_counter_add(metrics_gauge_t *g, double delta);
+void metrics_observe(metrics_histogram_t *h, double seconds);
+
+// Render the whole registry in Prometheus text format. Returns bytes written;
+// a buffer smaller than METRICS_BODY_MAX may truncate, which is cut at a line
+// boundary and logged.
+size_t metrics_render(metrics_t *m, char *buf, size_t size);
+
+// Event-loop integration: add our fds to pfds (returns count added), then
+// hand the same slice back after poll() returns.
+int metrics_pollfds(metrics_t *m, struct pollfd *pfds, int max);
+void metrics_dispatch(metrics_t *m, const struct pollfd *pfds, int count);
+
+#endif // METRICS_H
@@ -0,0 +1,122 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef MQTT_H
+#define MQTT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include "config.h"
+#include "netutil.h"
+#include "thermal.h"
+
+#define MQTT_DEFAULT_PORT 1883
+#define MQTT_DEFAULT_KEEPALIVE_SEC 60
+#define MQTT_DEFAULT_TEMP_DEADBAND 0.5  // °C change before a temperature is republished
+#define MQTT_DEFAULT_DUTY_DEADBAND 0.02 // Duty change (0-1) before it is republished
+#define MQTT_QUEUE_LEN 32               // Outbound packets; the oldest is dropped when full
+#define MQTT_PACKET_MAX 768             // Largest encoded packet (discovery configs)
+#define MQTT_RECONNECT_MAX_SEC 60.0
+#define MQTT_TOPIC_LEN 96
+
+// Minimal MQTT 3.1.1 publisher (QoS 0, no subscriptions) for telemetry and
+// Home Assistant discovery. Everything runs on one non-blocking socket
+// serviced from the main event loop: connects never wait, and packets go
+// into a fixed ring that drops its oldest entry when the broker falls
+// behind, so a slow or dead broker can never stall a control tick.
+// Availability is a retained <topic>/status ("online"/"offline", the
+// latter also as the broker-side last will).
+
+typedef enum {
+    MQTT_DISCONNECTED,
+    MQTT_RESOLVING,     // Broker name lookup in progress
+    MQTT_CONNECTING,    // TCP connect in progress
+    MQTT_HANDSHAKE,     // CONNECT sent, waiting for CONNACK
+    MQTT_CONNECTED
+} mqtt_conn_state_t;
+
+typedef struct {
+    uint16_t len;
+    uint8_t data[MQTT_PACKET_MAX];
+} mqtt_packet_t;
+
+// One tick's values, filled by the daemon
+typedef struct {
+    double cpu_temp;
+    int ssd_temps[SSD_DEVICE_COUNT];
+    double duty;                // Applied, 0-1
+    const char *mode;           // auto/manual/boost
+    const char *profile;
+    int alarm;                  // A sensor at lv3 or a failed fan write
+} mqtt_state_t;
+
+typedef struct {
+    int fd;
+    mqtt_conn_state_t state;
+    struct sockaddr_in broker;          // Address of the latest lookup
+    netutil_lookup_t *lookup;           // NULL unless MQTT_RESOLVING
+    char broker_spec[64];               // As configured; resolved again on each attempt
+    char client_id[48];
+    char username[32];
+    char password[64];
+    char topic[MQTT_TOPIC_LEN];         // Base topic, e.g. radxa-penta/nas1
+    char node_id[32];                   // Sanitized hostname for discovery ids
+    char discovery_prefix[32];          // "" = no discovery
+    int keepalive_sec;
+    double temp_deadband;
+    double duty_deadband;
+
+    // Outbound ring. The head may be partially written (head_off bytes);
+    // it is never the one dropped, so the stream stays well-formed.
+    mqtt_packet_t queue[MQTT_QUEUE_LEN];
+    size_t head;
+    size_t count;
+    size_t head_off;
+
+    uint8_t in[4];                      // CONNACK / PINGRESP
+    size_t in_len;
+
+    double next_attempt;                // Monotonic time of the next connect
+    double backoff;
+    double last_tx;
+    double ping_sent;                   // 0 = no PINGREQ outstanding
+    double connected_at;
+
+    // Last published values (NAN / -1 / "" force a publish)
+    double pub_cpu;
+    int pub_ssd[SSD_DEVICE_COUNT];
+    double pub_duty;
+    char pub_mode[16];
+    char pub_profile[CONFIG_PROFILE_NAME_LEN];
+    int pub_alarm;
+
+    unsigned long published;
+    unsigned long dropped;
+    unsigned long connects;
+} mqtt_t;
+
+// Prepare topics and start resolving the broker. Only a malformed broker
+// address fails; an unresolvable name is retried with the connect backoff.
+// The first connection attempt happens on the first mqtt_service().
+int mqtt_init(mqtt_t *m, const config_t *cfg);
+// Best effort "offline" + DISCONNECT, then close
+void mqtt_cleanup(mqtt_t *m);
+
+// Queue publishes for values that moved past their deadband (O(1) per tick;
+// nothing is queued while disconnected, everything is resent on connect)
+void mqtt_publish_state(mqtt_t *m, const mqtt_state_t *s);
+
+// Timers: lookup and reconnect with backoff, keepalive pings, handshake timeout
+void mqtt_service(mqtt_t *m, double now);
+
+// Event-loop integration (same contract as metrics_pollfds/metrics_dispatch)
+int mqtt_pollfds(mqtt_t *m, struct pollfd *pfds, int max);
+void mqtt_dispatch(mqtt_t *m, const struct pollfd *pfds, int count);
+
+const char *mqtt_state_name(const mqtt_t *m);
+
+#endif // MQTT_H
@@ -0,0 +1,39 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef NETUTIL_H
+#define NETUTIL_H
+
+#include <stddef.h>
+#include <netinet/in.h>
+
+// Open a non-blocking, close-on-exec listening socket.
+// spec is "unix:/path/to.sock" or "host:port" (IPv4 literal or "localhost").
+// For Unix sockets a stale socket file is removed first and the path is
+// copied to unix_path (so the caller can unlink it on shutdown); otherwise
+// unix_path is set to "". Returns the fd, or -1 on error.
+int netutil_listen(const char *spec, char *unix_path, size_t unix_path_size);
+
+// Accept one pending connection as a non-blocking, close-on-exec socket.
+// Returns -1 when nothing is pending or on error.
+int netutil_accept(int listen_fd);
+
+// Resolve "host[:port]" to an IPv4 address without blocking: literals
+// complete at once, hostnames go through getaddrinfo_a(). Start a fresh
+// lookup for each connection attempt so a changed or briefly unresolvable
+// name recovers. Returns NULL on a malformed spec or if the lookup cannot start.
+typedef struct netutil_lookup netutil_lookup_t;
+netutil_lookup_t *netutil_lookup_start(const char *spec, int default_port);
+// 1 with *addr filled, 0 while pending, -1 on failure (*error = reason)
+int netutil_lookup_poll(netutil_lookup_t *l, struct sockaddr_in *addr, const char **error);
+// Cancel (waiting out a lookup that cannot be cancelled) and free; NULL is fine
+void netutil_lookup_free(netutil_lookup_t *l);
+
+// Start a non-blocking, close-on-exec TCP connect. Returns the fd with the
+// connection possibly still in progress (wait for POLLOUT, then check
+// SO_ERROR), or -1 on immediate failure.
+int netutil_connect(const struct sockaddr_in *addr);
+
+#endif // NETUTIL_H
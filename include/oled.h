@@ -8,17 +8,24 @@
 
 #include <stdint.h>
 #include "config.h"
+#include "history.h"
+#include "stages.h"
+#include "sysinfo.h"
 
 #define OLED_WIDTH 128
 #define OLED_HEIGHT 32
 #define OLED_I2C_BUS 1
 #define OLED_I2C_ADDR 0x3C
+#define OLED_SCROLL_INTERVAL_SEC 10  // Page period before any overhead-budget stretching
+#define OLED_GRAPH_SPAN_SEC 7200     // Graph page covers the last two hours
 
 typedef enum {
     PAGE_SYSTEM,
     PAGE_RESOURCES,
     PAGE_DISKS,
+    PAGE_HEALTH,
     PAGE_RAID,
+    PAGE_GRAPH,
     PAGE_COUNT
 } oled_page_t;
 
@@ -26,13 +33,19 @@ typedef struct {
     int initialized;
     int8_t i2c_bus;
     int8_t i2c_addr;
+    unsigned int disks;         // Drives on PAGE_DISKS/PAGE_HEALTH (bit i = SSD i)
     int current_page;
     int auto_scroll;
     unsigned int scroll_interval;
     int rotate_180;
+    history_t *history;         // Source for PAGE_GRAPH (NULL = page skipped)
+    stages_t *stages;           // Render latency is recorded here if set
+    sysinfo_t *sysinfo;         // Cached address/RAID mount (NULL = spawn hostname/df)
 } oled_t;
 
-int oled_init(oled_t *oled);
+// The SSD1306 driver talks to one display at a time: with several units,
+// every draw takes a shared lock and re-binds the driver to its own bus.
+int oled_init(oled_t *oled, int i2c_bus, int i2c_addr);
 void oled_set_rotation(oled_t *oled, int rotate_180);
 void oled_cleanup(oled_t *oled);
 void oled_welcome(oled_t *oled);
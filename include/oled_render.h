@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef OLED_RENDER_H
+#define OLED_RENDER_H
+
+#include <stdint.h>
+#include "oled.h"
+
+#define OLED_FRAME_MAX_TEXT 4
+#define OLED_TEXT_LEN 64
+#define OLED_NO_BAR OLED_HEIGHT     // bar_top value of an empty graph column
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    int bold;
+    char text[OLED_TEXT_LEN];
+} oled_text_t;
+
+// One page as the panel should show it, independent of the display
+// driver: 6x8 text items plus graph columns drawn from bar_top down to
+// the bottom row. oled_show_page() clears the panel and draws a frame.
+typedef struct {
+    oled_text_t text[OLED_FRAME_MAX_TEXT];
+    int text_count;
+    uint8_t bar_top[OLED_WIDTH];
+} oled_frame_t;
+
+// Compose page from the caches (thermal, history, sysinfo) and, where the
+// page has no cache, the system tools; touches no display hardware.
+void oled_render_page(oled_t *oled, oled_page_t page, oled_frame_t *frame);
+
+#endif // OLED_RENDER_H
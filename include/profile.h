@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <time.h>
+#include "config.h"
+
+#define PROFILE_REQUEST_NONE (-1)
+#define PROFILE_REQUEST_NEXT (-2)   // Cycle to the next profile (button)
+
+// Runtime fan profiles. Each profile is a complete curve + tunables set in
+// cfg->profiles[]; switching only repoints cfg->active, and only the main
+// loop does that (at the top of a tick), so the controller never sees a
+// half-applied profile. Other threads queue a request instead.
+
+// Profile index the [schedule] selects at wall time now (the latest entry
+// at or before the local time of day, wrapping over midnight), or -1 when
+// there is no schedule
+int profile_scheduled(const config_t *cfg, time_t now);
+
+// Queue a switch to profile idx, or PROFILE_REQUEST_NEXT; any thread
+void profile_request(int idx);
+int profile_pending(void);
+
+// Apply a schedule boundary or a queued request. A manual switch holds
+// until the next schedule boundary. Returns 1 if the active profile changed.
+int profile_tick(config_t *cfg, time_t now);
+
+#endif // PROFILE_H
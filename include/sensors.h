@@ -0,0 +1,74 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define SENSORS_MAX_FILES 32
+#define SENSORS_BUF_LEN 4096    // Enough for /proc/meminfo and /proc/diskstats
+#define SENSORS_PATH_LEN 96
+
+// Batched reads of sysfs/procfs sensor files. Files are opened once and
+// re-read from offset 0 every tick (sysfs and seq_file regenerate their
+// contents on such a read). With io_uring every registered file is read
+// by one io_uring_enter() per tick; otherwise, or when the kernel refuses
+// the ring, one pread() per file.
+
+typedef enum {
+    SENSORS_PREAD,
+    SENSORS_IO_URING
+} sensors_backend_t;
+
+typedef struct {
+    char path[SENSORS_PATH_LEN];
+    int fd;
+    ssize_t len;                // Bytes from the last read, -errno on failure
+    char buf[SENSORS_BUF_LEN];  // NUL-terminated contents of the last read
+} sensors_file_t;
+
+// Submission/completion ring mappings (io_uring backend only)
+typedef struct {
+    int fd;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;               // Same mapping as sq_ptr with IORING_FEAT_SINGLE_MMAP
+    size_t cq_size;
+    void *sqes;
+    size_t sqes_size;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    void *cqes;
+} sensors_ring_t;
+
+typedef struct {
+    sensors_file_t files[SENSORS_MAX_FILES];
+    int count;
+    sensors_backend_t backend;
+    sensors_ring_t ring;
+    unsigned long batches;      // sensors_read_all() calls
+    unsigned long syscalls;     // Read-side syscalls they made
+} sensors_t;
+
+// use_io_uring: try the ring, falling back to pread (with a warning) when
+// unavailable. Returns 0.
+int sensors_init(sensors_t *s, int use_io_uring);
+// Open path for batched reads; returns its id or -1
+int sensors_add(sensors_t *s, const char *path);
+// Read every registered file; returns how many failed
+int sensors_read_all(sensors_t *s);
+// Integer at the start of the last read of id (e.g. millidegrees); -1 on error
+int sensors_long(const sensors_t *s, int id, long *out);
+void sensors_close(sensors_t *s);
+
+const char *sensors_backend_name(const sensors_t *s);
+
+#endif // SENSORS_H
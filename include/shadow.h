@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef SHADOW_H
+#define SHADOW_H
+
+#include "config.h"
+#include "thermal.h"
+
+#define SHADOW_DEFAULT_DIVERGENCE 0.10  // |duty delta| counted as divergent
+#define SHADOW_FAN_WATTS 1.0            // Nominal fan power at 100% for energy estimates
+
+// Shadow controller: a second controller instance with its own
+// configuration, fed the active controller's sensor snapshot every tick.
+// Its output is only recorded, never written to the fan. Both energies
+// are estimates from the cube law (P = SHADOW_FAN_WATTS * duty^3) on the
+// controllers' own outputs, before manual/boost overrides.
+typedef struct {
+    config_t cfg;
+    thermal_state_t state;
+    double divergence;          // Threshold for divergent_sec
+
+    double dc;                  // Last shadow output
+    double delta;               // Last shadow - active
+    unsigned long ticks;
+    double seconds;             // Time covered by the comparison
+    double divergent_sec;       // Time with |delta| > divergence
+    double abs_delta_sum;       // Integral of |delta| dt
+    double delta_sum;           // Integral of delta dt (sign = shadow runs faster)
+    double max_abs_delta;
+    double active_wh;
+    double shadow_wh;
+} shadow_t;
+
+// Load the shadow configuration; returns -1 if the file cannot be read
+int shadow_init(shadow_t *s, const char *config_path, double divergence);
+
+// Run the shadow on the active state's last snapshot (after the active
+// controller's tick) and account the interval dt_sec
+void shadow_step(shadow_t *s, const thermal_state_t *active, double active_dc, double dt_sec);
+
+// Time-weighted mean |shadow - active| since start
+double shadow_mean_abs_delta(const shadow_t *s);
+
+#endif // SHADOW_H
@@ -0,0 +1,101 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef SMART_H
+#define SMART_H
+
+#include <stddef.h>
+
+// Fields a caller can ask for
+#define SMART_TEMP          (1u << 0)
+#define SMART_REALLOCATED   (1u << 1)   // ATA 5
+#define SMART_PENDING       (1u << 2)   // ATA 197
+#define SMART_WEAR          (1u << 3)   // ATA 177/231/233 normalized value
+#define SMART_USED          (1u << 4)   // NVMe Percentage Used
+#define SMART_MEDIA_ERRORS  (1u << 5)   // NVMe Media and Data Integrity Errors
+#define SMART_HEALTH (SMART_REALLOCATED | SMART_PENDING | SMART_WEAR | SMART_USED | SMART_MEDIA_ERRORS)
+
+#define SMART_KEY_LEN 40
+#define SMART_JSON_DEPTH 8
+
+// Streaming parser for `smartctl -A` output, either the text report (ATA
+// attribute table, NVMe/SCSI "Key: value" lines) or `--json`, detected
+// from the first byte. Bytes are consumed exactly once as they arrive
+// from the pipe, with no line buffer and no allocation; feed() reports
+// when every wanted field has been seen so the caller can stop reading.
+//
+// Text: an attribute row is any line whose first token is a number; its
+// raw value is the column under RAW_VALUE in the "ID#" header (10th by
+// default, so `-f brief` layouts work) and only its leading integer is
+// used ("35 (Min/Max 20/45)" reads 35). JSON: temperature.current,
+// ata_smart_attributes.table[].{id,value,raw.value} and
+// nvme_smart_health_information_log.{temperature,percentage_used,media_errors}.
+
+typedef enum {
+    SMART_MODE_UNKNOWN,
+    SMART_MODE_TEXT,
+    SMART_MODE_JSON
+} smart_mode_t;
+
+typedef struct {
+    unsigned int want;
+    unsigned int found;
+
+    // Results (valid where the matching bit of found is set)
+    int temp;
+    long reallocated;
+    long pending;
+    int wear;
+    int percent_used;
+    long media_errors;
+
+    smart_mode_t mode;
+
+    // Token being read (text columns, JSON keys)
+    char tok[SMART_KEY_LEN];
+    size_t tok_len;             // May exceed the buffer: then matches nothing
+    int in_token;
+    long lead;                  // Leading integer of the token
+    int lead_digits;
+    int lead_open;              // Still in the leading digits
+    int all_digits;
+
+    // Text: one attribute row or "Key: value" line at a time
+    int col;                    // Index of the next token on the line
+    int raw_col;                // Column of RAW_VALUE (from the "ID#" header)
+    int header;
+    int row;                    // First token was a number: attribute row
+    long id;
+    long norm;                  // VALUE column (-1 = not numeric)
+    long raw;                   // Leading integer of RAW_VALUE (-1 = none)
+    char key[SMART_KEY_LEN];    // Words before ':', single-spaced
+    size_t key_len;
+    int colon;
+    long kv;                    // First integer after ':' (commas skipped)
+    int kv_state;               // 0 = none yet, 1 = in digits, 2 = done, 3 = no number
+
+    // JSON: key that opened each container level (1 = root object)
+    unsigned int depth;
+    int key_id[SMART_JSON_DEPTH + 1];
+    int is_array[SMART_JSON_DEPTH + 1];
+    int cur_key;                // Key whose value comes next
+    int expect_key;
+    int in_string;
+    int escape;
+    int in_number;
+    int number_frac;            // Past '.', 'e': the integer part is final
+    int negative;
+    long item_id;               // ata_smart_attributes.table entry
+    long item_value;
+    long item_raw;
+} smart_parser_t;
+
+void smart_parser_init(smart_parser_t *p, unsigned int want);
+// Returns 1 once every wanted field has been found (stop reading), else 0
+int smart_parser_feed(smart_parser_t *p, const char *buf, size_t len);
+// End of input: completes a last line without a newline
+void smart_parser_finish(smart_parser_t *p);
+
+#endif // SMART_H
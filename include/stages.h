@@ -0,0 +1,52 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef STAGES_H
+#define STAGES_H
+
+#include <stdint.h>
+
+// Log-bucketed (HDR-style) latency histograms, one per pipeline stage.
+// Each power of two is split into 2^STAGES_SUB_BITS linear sub-buckets, so
+// any recorded value is reported within 1/16 (6.25%) of its true value,
+// from 1 ns up to 2^STAGES_MAX_EXP ns (~68 s); larger values saturate.
+#define STAGES_SUB_BITS 4
+#define STAGES_SUB (1u << STAGES_SUB_BITS)
+#define STAGES_MAX_EXP 36
+#define STAGES_BUCKETS ((STAGES_MAX_EXP - STAGES_SUB_BITS + 1) * STAGES_SUB)
+
+typedef enum {
+    STAGE_READ_CPU,     // sysfs thermal zone read
+    STAGE_READ_SSD,     // smartctl pass (only when the cache refreshed)
+    STAGE_COMPUTE,      // Filtering, curves, trend and ramp logic
+    STAGE_ACTUATE,      // PWM duty write (only when the duty changed)
+    STAGE_OLED,         // One OLED page render over I2C
+    STAGE_TICK,         // Whole control tick
+    STAGE_COUNT
+} stage_id_t;
+
+typedef struct {
+    uint32_t buckets[STAGES_BUCKETS];   // Updated with __atomic builtins
+    uint64_t max_ns;
+} stage_hist_t;
+
+typedef struct {
+    stage_hist_t hist[STAGE_COUNT];
+} stages_t;
+
+// Fixed memory (~13 KiB); record from any thread, no allocation or locks
+void stages_init(stages_t *st);
+void stages_record(stages_t *st, stage_id_t stage, uint64_t ns);
+
+// Value (ns) at quantile q in [0, 1]; 0 when nothing was recorded
+uint64_t stages_percentile_ns(const stages_t *st, stage_id_t stage, double q);
+uint64_t stages_count(const stages_t *st, stage_id_t stage);
+
+const char *stages_name(stage_id_t stage);
+
+// One line per stage with count, p50/p90/p99/p99.9 and max, to stdout
+void stages_log(const stages_t *st);
+
+#endif // STAGES_H
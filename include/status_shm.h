@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef STATUS_SHM_H
+#define STATUS_SHM_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Published at /dev/shm/radxa-penta-fan-ctrl.status (shm_open name below).
+// Readers mmap it read-only and take consistent snapshots with
+// status_shm_read(); no syscalls and no locking against the daemon.
+#define STATUS_SHM_NAME "/radxa-penta-fan-ctrl.status"
+#define STATUS_SHM_MAGIC 0x46535052u   // "RPSF" little-endian
+#define STATUS_SHM_VERSION 1
+#define STATUS_SHM_MAX_SSD 8
+
+// Alarm / state bits in status_shm_t.flags
+#define STATUS_FLAG_HOLD          (1u << 0)  // Cooldown hold active
+#define STATUS_FLAG_DEADBAND      (1u << 1)  // Last tick suppressed by dead-band
+#define STATUS_FLAG_CPU_STALE     (1u << 2)  // CPU sample older than 2 ticks
+#define STATUS_FLAG_SSD_STALE     (1u << 3)  // SSD sample older than 3 cache periods
+#define STATUS_FLAG_CPU_CRITICAL  (1u << 4)  // Filtered CPU temp >= lv3
+#define STATUS_FLAG_SSD_CRITICAL  (1u << 5)  // Filtered SSD temp >= lv3
+#define STATUS_FLAG_FAN_ERROR     (1u << 6)  // Last duty write failed
+#define STATUS_FLAG_STOPPED       (1u << 31) // Daemon has shut down
+
+// Values of status_shm_t.mode
+#define STATUS_MODE_AUTO   0
+#define STATUS_MODE_MANUAL 1
+#define STATUS_MODE_BOOST  2
+
+// Fixed layout: only fixed-width fields, naturally aligned, no implicit
+// padding. New fields are appended and bump STATUS_SHM_VERSION; readers
+// check size before touching fields beyond what they know.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;               // sizeof(status_shm_t) of the writer
+    uint32_t seq;                // Seqlock: odd while an update is in progress
+
+    uint64_t updated_mono_ns;    // CLOCK_MONOTONIC of the last update
+    int64_t updated_wall_sec;    // time(NULL) of the last update
+    uint64_t ticks;              // Control ticks since start
+    uint64_t duty_changes;       // Number of duty writes
+    uint64_t fan_write_errors;
+    uint64_t ssd_reads;          // smartctl passes (cache refreshes)
+
+    uint32_t flags;              // STATUS_FLAG_*
+    uint32_t mode;               // STATUS_MODE_*
+    int32_t pid;
+    uint16_t duty_permille;      // Applied duty (0-1000)
+    uint16_t controller_permille;// Duty requested by the controller
+    uint16_t target_permille;    // Curve target before rate limiting
+    uint16_t ssd_count;          // Valid entries in ssd_temp_c
+    int32_t cpu_temp_mc;         // Raw CPU temperature, milli-°C
+    int32_t cpu_avg_mc;          // Filtered CPU temperature, milli-°C
+    int32_t cpu_trend_mc;        // CPU trend, milli-°C per window
+    int32_t ssd_avg_c;           // Filtered max SSD temperature, °C
+    int32_t ssd_trend_mc;        // SSD trend, milli-°C per window
+    int32_t ssd_temp_c[STATUS_SHM_MAX_SSD]; // Raw per-drive temperatures (0 = none)
+} status_shm_t;
+
+_Static_assert(sizeof(status_shm_t) == 136, "status_shm_t layout changed: bump STATUS_SHM_VERSION");
+
+typedef struct {
+    status_shm_t *shm;
+    int fd;
+    char name[64];
+} status_pub_t;
+
+// name is the shm_open name, STATUS_SHM_NAME for the daemon
+int status_pub_init(status_pub_t *pub, const char *name);
+void status_pub_cleanup(status_pub_t *pub);
+// Writer side: bracket field updates with begin/end (single writer only)
+status_shm_t *status_pub_begin(status_pub_t *pub);
+void status_pub_end(status_pub_t *pub);
+
+// Reader side: copy a consistent snapshot. Returns 0 on success, -1 if the
+// segment is not (yet) valid or a stable copy could not be taken.
+static inline int status_shm_read(const status_shm_t *shm, status_shm_t *out) {
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint32_t s1 = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1u) continue;
+        memcpy(out, shm, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t s2 = __atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+        if (s1 == s2) {
+            return (out->magic == STATUS_SHM_MAGIC && out->version == STATUS_SHM_VERSION) ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+#endif // STATUS_SHM_H
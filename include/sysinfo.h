@@ -0,0 +1,75 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef SYSINFO_H
+#define SYSINFO_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <poll.h>
+#include <netinet/in.h>
+
+#define SYSINFO_MAX_ADDRS 16
+#define SYSINFO_ADDR_LEN INET6_ADDRSTRLEN
+#define SYSINFO_HOST_LEN 65
+#define SYSINFO_PATH_LEN 128
+#define SYSINFO_RAID_DEVICE "/dev/md0"
+#define SYSINFO_FDS 3
+
+// System facts the display pages and status surfaces show, kept current by
+// change notifications instead of being recomputed on every read:
+// addresses from rtnetlink RTM_NEWADDR/RTM_DELADDR, the hostname from
+// uname() whenever /proc/sys/kernel/hostname signals a change, and the
+// RAID mount point whenever /proc/self/mountinfo does (POLLPRI). The
+// descriptors are serviced from the main event loop; readers on other
+// threads only copy under the lock.
+
+typedef struct {
+    int ifindex;
+    int family;                     // AF_INET / AF_INET6
+    uint8_t prefix;
+    char text[SYSINFO_ADDR_LEN];
+} sysinfo_addr_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int nl_fd;                      // rtnetlink, -1 if unavailable
+    int host_fd;                    // /proc/sys/kernel/hostname, -1 if unavailable
+    int mounts_fd;                  // /proc/self/mountinfo, -1 if unavailable
+    int resync;                     // Netlink overflowed: dump addresses again
+    int fixed;                      // sysinfo_init_static(): the cache is current without sources
+    uint32_t seq;
+
+    sysinfo_addr_t addrs[SYSINFO_MAX_ADDRS];
+    int addr_count;
+    char hostname[SYSINFO_HOST_LEN];
+    char raid_mount[SYSINFO_PATH_LEN];  // "" = SYSINFO_RAID_DEVICE not mounted
+
+    unsigned long addr_events;
+    unsigned long host_events;
+    unsigned long mount_events;
+} sysinfo_t;
+
+// Open the notification sources and fill the cache (a sub-second blocking
+// address dump). Sources that cannot be opened only warn: their fields
+// keep the value read here.
+int sysinfo_init(sysinfo_t *si);
+// A cache with fixed contents and no notification sources (benchmarks,
+// tests): one address (a /24 or /64), the hostname and the RAID mount
+void sysinfo_init_static(sysinfo_t *si, const char *hostname, const char *address, const char *raid_mount);
+void sysinfo_cleanup(sysinfo_t *si);
+
+// Event-loop integration (same contract as metrics_pollfds/metrics_dispatch)
+int sysinfo_pollfds(sysinfo_t *si, struct pollfd *pfds, int max);
+void sysinfo_dispatch(sysinfo_t *si, const struct pollfd *pfds, int count);
+
+// Copies from the cache (no syscalls). The primary address is the first
+// IPv4 address outside loopback/link-local, else the first such IPv6 one;
+// -1 when there is none.
+int sysinfo_primary_address(sysinfo_t *si, char *buf, size_t len);
+void sysinfo_hostname(sysinfo_t *si, char *buf, size_t len);
+int sysinfo_raid_mount(sysinfo_t *si, char *buf, size_t len);
+
+#endif // SYSINFO_H
@@ -7,33 +7,236 @@
 #define THERMAL_H
 
 #include "config.h"
+#include "sensors.h"
+#include "ambient.h"
+#include <stdint.h>
 #include <time.h>
 
 #define THERMAL_ZONE_PATH "/sys/class/thermal/thermal_zone0/temp"
 #define SMARTCTL_CMD "smartctl -A /dev/%s 2>/dev/null"
+#define SMARTCTL_JSON_CMD "smartctl -A -j /dev/%s 2>/dev/null"
+#define SMARTCTL_READ_CHUNK 1024   // Pipe read size; parsing stops mid-output once done
 #define SSD_TEMP_CACHE_SEC 5  // Only read SSD temps every 5 seconds
+#define SSD_DEVICE_COUNT 4     // sda..sdd
+#define SSD_HEALTH_INTERVAL_SEC 3600  // Health attributes parsed once an hour by default
 
 // Temperature history for moving average and trend analysis
 #define TEMP_HISTORY_SIZE 10
+
+// The per-cycle ramp rates and trend thresholds are defined for this
+// control period; other periods scale them so they stay rates per second
+#define THERMAL_REFERENCE_PERIOD_SEC 1.0
+#define THERMAL_DEADBAND_STABLE_SEC 5.5   // Steady this long before the dead-band applies
 // The values above are now tunable via config/env; defaults are initialized in config.c
-// and consumed in thermal.c through cfg->thermal.*
+// and consumed in thermal.c through cfg->active->thermal.*
+
+// Comparisons the fixed-point law decided on an exact tie in its last step
+// (thermal_fixed_t.ties). The double law reaches the same comparison
+// through rounded averages, trends and ramp steps and may take it either
+// way; radxa-penta-fixed-check reports such steps as known divergences.
+#define THERMAL_TIE_HEATING 0x1     // A trend exactly at trend_heat
+#define THERMAL_TIE_CURVE 0x2       // An average exactly on a curve level
+#define THERMAL_TIE_DEADBAND 0x4    // Stable time or temperature change exactly at its dead-band limit,
+                                    // or the duty gap within THERMAL_TIE_DUTY_PPB of it
+#define THERMAL_TIE_RAMP 0x8        // The duty change within THERMAL_TIE_DUTY_PPB of a ramp limit
+// Duties of the two laws differ by the ppb rounding of each ramp step, so
+// a duty comparison this close to its limit counts as a tie
+#define THERMAL_TIE_DUTY_PPB 1000
+
+// Integer state of the fixed-point law: milli-°C, milliseconds, and the
+// duty and ramp rates in parts per billion (so a long trend- or
+// ambient-scaled ramp does not drift from the double law). The double
+// observables of thermal_state_t are filled from it after every step.
+typedef struct {
+    int32_t cpu_mc[TEMP_HISTORY_SIZE];
+    int64_t sample_ms[TEMP_HISTORY_SIZE];
+    int64_t last_step_ms;
+    int64_t step_ms;
+    int64_t stable_ms;
+    int32_t duty_ppb;
+    int64_t last_cpu_sum;       // Moving-average numerator (milli-°C) at the last step
+    int32_t last_cpu_count;
+
+    unsigned int ties;          // THERMAL_TIE_* of the last step
+
+    // Tunables in the same units, converted when the active profile or the
+    // config generation differs from the one they were built from
+    const config_t *tunables_cfg;
+    const fan_profile_t *tunables_profile;
+    unsigned int tunables_generation;   // tunables_cfg is NULL until the first step
+    int32_t cpu_lv_mc[4];
+    int32_t ssd_lv_mc[4];
+    int32_t hysteresis_mc;
+    int32_t deadband_mc;
+    int32_t trend_heat_mcps;    // Milli-°C per second
+    int32_t up_base_ppm;
+    int32_t up_gain_ppm;        // Per °C/s of trend
+    int32_t up_max_ppm;
+    int32_t legacy_max_ppm;
+    int32_t down_ppm;
+    int32_t hold_sec;
+    int64_t step_max_ms;
+    // [ambient] in the same units, rebuilt with the profile
+    int ambient_relative;
+    int32_t ambient_ref_mc;
+    int64_t ambient_gain_ppb;   // Ramp rate factor change per °C
+} thermal_fixed_t;
 
 typedef struct {
     double cpu_temps[TEMP_HISTORY_SIZE];
     int ssd_temps[TEMP_HISTORY_SIZE];
+    double sample_at[TEMP_HISTORY_SIZE];    // Monotonic time of each history slot
     int history_index;
     int history_count;
     double last_duty_cycle;
     double last_cpu_temp;
     int last_ssd_temp;
     int stable_cycles;  // Count of cycles at same duty cycle
+    double stable_sec;  // Time at the same duty cycle
     time_t hold_until;  // Do not decrease duty while now < hold_until
+    double last_step_at;    // Monotonic time of the previous controller step
+    double step_sec;        // Interval the last step covered (scales ramp rates)
+    double period_sec;      // Current control period (see thermal_next_period)
+
+    // Observables from the last control tick (for metrics/status surfaces)
+    double cpu_temp_raw;        // Set by thermal_sample_view() and the double filter
+    int32_t cpu_mc_raw;         // The same reading in milli-°C, as the sensor reports it
+    int ssd_temps_raw[MAX_DEVICES];
+    int ssd_count_raw;          // Drives that reported a temperature
+    double cpu_sampled_at;      // Monotonic time of the last CPU read
+    double ssd_sampled_at;      // Monotonic time of the last smartctl pass
+    double cpu_read_sec;        // Latency of the last CPU read (raw clock)
+    double ssd_read_sec;        // Latency of the last smartctl pass (raw clock)
+    double compute_sec;         // Filter/curve/ramp time of the last tick (raw clock)
+    int ssd_read_fresh;         // 1 if this tick ran smartctl (not served from cache)
+    double cpu_avg;
+    int ssd_avg;
+    double cpu_trend;
+    double ssd_trend;
+    double dc_target;
+    int hold_active;
+    int deadband_active;
+    int32_t ambient_mc;         // Ambient reading of this tick, milli-°C
+    int ambient_valid;          // 0 = none (compensation works from [ambient] reference)
+    double ambient_rate;        // Ramp rate factor the last step applied
+
+    thermal_fixed_t fixed;      // Fixed-point law only
+
+    int quiet;                  // Set after init to keep this instance out of the log (shadow)
+    const char *label;          // Unit name in log lines (NULL = single unit)
+    int log_counter;
 } thermal_state_t;
 
+// One pass over every sensor, shared by all units in a tick: the CPU zone
+// is read once and smartctl runs at most once per cache interval, however
+// many fans the drives feed.
+typedef struct {
+    int32_t cpu_mc;             // Milli-°C, as read
+    double cpu_temp;            // The same in °C
+    int ssd_temps[MAX_DEVICES];
+    int ssd_count;
+    double cpu_sampled_at;
+    double cpu_read_sec;
+    double ssd_sampled_at;
+    double ssd_read_sec;
+    int ssd_read_fresh;
+    int32_t ambient_mc;
+    int ambient_valid;
+} thermal_sample_t;
+
+// SMART health of one drive, parsed from the same smartctl output as its
+// temperature on every health pass (no extra runs). -1 = not reported.
+typedef struct {
+    int valid;                  // The last health pass parsed at least one field
+    long reallocated;           // Reallocated sectors (ATA 5)
+    long pending;               // Current pending sectors (ATA 197)
+    int wear_leveling;          // Normalized wear indicator, 100 = new (ATA 177/231/233)
+    int percent_used;           // NVMe Percentage Used
+    long media_errors;          // NVMe Media and Data Integrity Errors
+    double updated_at;          // Monotonic time of the pass
+} ssd_health_t;
+
 double thermal_read_cpu_temp(void);
+// Read the CPU temperature from another file (mock backends); the string is
+// kept, not copied. NULL restores THERMAL_ZONE_PATH. Call before
+// thermal_use_sensors().
+void thermal_set_zone_path(const char *path);
+// Register the CPU zone with a batched reader: thermal_sample() then runs
+// sensors_read_all() at the start of each tick instead of reopening the
+// file. NULL detaches. -1 (and the plain read stays) if the zone cannot be
+// opened.
+int thermal_use_sensors(sensors_t *sensors);
+// Room/intake sensor refreshed by thermal_sample() (NULL = none)
+void thermal_use_ambient(ambient_t *ambient);
 int thermal_read_ssd_temps(int *temps, size_t max_count);
+const char *thermal_ssd_device_name(size_t index);
+// smartctl cache lifetime (default SSD_TEMP_CACHE_SEC)
+void thermal_set_ssd_interval(int sec);
+int thermal_ssd_interval(void);
 double thermal_calculate_duty_cycle(config_t *cfg);
 double thermal_calculate_duty_cycle_smart(config_t *cfg, thermal_state_t *state);
+void thermal_sample(thermal_sample_t *sample);
+// Last smartctl readings without running it (0 = no reading); returns how
+// many drives reported
+int thermal_ssd_cached(int *temps, size_t max_count);
+// Health from the last health pass (copies; safe from any thread); returns
+// how many drives reported any field
+int thermal_ssd_health(ssd_health_t *health, size_t max_count);
+// How often a smartctl pass also parses health (default SSD_HEALTH_INTERVAL_SEC)
+void thermal_set_health_interval(int sec);
+// Run smartctl with --json instead of parsing the text report
+void thermal_set_smartctl_json(int json);
+// Controller step for one unit: only the drives in disk_mask (bit i = SSD i)
+// and, if use_cpu, the CPU temperature feed its curve
+double thermal_step_sample(config_t *cfg, thermal_state_t *state, const thermal_sample_t *sample,
+                           unsigned int disk_mask, int use_cpu);
+// The unit's view of a sample: copies the sample timings and CPU reading
+// into state and fills cpu_mc / ssd_temps (MAX_DEVICES slots, others 0);
+// returns drives
+int thermal_sample_view(thermal_state_t *state, const thermal_sample_t *sample, unsigned int disk_mask,
+                        int use_cpu, int32_t *cpu_mc, int *ssd_temps);
+// For controllers other than the built-in law: thermal_observe() runs the
+// shared filter (raw values, moving averages, trends) and
+// thermal_record_duty() the bookkeeping for the duty they chose, so every
+// status surface and the adaptive period keep working.
+void thermal_observe(config_t *cfg, thermal_state_t *state, double cpu_temp, const int *ssd_temps, int ssd_count);
+void thermal_record_duty(thermal_state_t *state, double dc);
+// Controller only: filtering, curves and ramp limits on the given readings
+// (CPU in milli-°C, ssd_temps holds MAX_DEVICES slots). Used by the smart
+// path above and by the simulator on synthetic sensors.
+double thermal_control_step(config_t *cfg, thermal_state_t *state, int32_t cpu_mc,
+                            const int *ssd_temps, int ssd_count);
+// The two implementations behind it: double, and milli-°C / ppb integer
+// arithmetic for boards where floating point is slow. thermal_control_step()
+// runs the fixed one when built with RADXA_PENTA_FIXED_POINT. The fixed law
+// takes the double law's decisions on the same readings except on exact
+// ties (THERMAL_TIE_*); radxa-penta-fixed-check compares them.
+double thermal_control_step_double(config_t *cfg, thermal_state_t *state, double cpu_temp,
+                                   const int *ssd_temps, int ssd_count);
+double thermal_control_step_fixed(config_t *cfg, thermal_state_t *state, int32_t cpu_mc,
+                                  const int *ssd_temps, int ssd_count);
 void thermal_state_init(thermal_state_t *state);
 
+// The curves of a profile as the control law applies them at the state's
+// ambient: unchanged unless [ambient] relative is set, when the levels are
+// °C above ambient. lv0-lv2 follow a room warmer than the reference up, so
+// a hot room alone does not spin the fan; a cooler room (or no reading)
+// counts as the reference, so it never spends more than the reference
+// curve. lv3 stays at the reference as a hard ceiling for all of them.
+void thermal_curves(const config_t *cfg, const fan_profile_t *profile, const thermal_state_t *state,
+                    fan_config_t *cpu, fan_config_t *ssd);
+// Filtered averages at or over the top level (lv3) of the active curves
+void thermal_curve_critical(const config_t *cfg, const thermal_state_t *state, int *cpu, int *ssd);
+// Gain schedule of the ramp rates: 1 + rate_gain * (ambient - reference),
+// within AMBIENT_RATE_MIN..AMBIENT_RATE_MAX. Up ramps are multiplied by it
+// and down ramps divided, so a cool room ramps up gently and spins down
+// sooner, a hot one the other way round. 1 without a reading.
+double thermal_ambient_rate(const config_t *cfg, const thermal_state_t *state);
+
+// Adaptive control period for the next tick: stretches geometrically up to
+// cfg period_max while every sensor is far below its first threshold and
+// the duty has been steady, drops to period_min while the duty is ramping
+// or temperatures rise fast, otherwise THERMAL_REFERENCE_PERIOD_SEC.
+double thermal_next_period(const config_t *cfg, thermal_state_t *state);
+
 #endif // THERMAL_H
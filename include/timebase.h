@@ -0,0 +1,32 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Monotonic time in seconds (CLOCK_MONOTONIC). Used for tick scheduling,
+// latency measurement and sample ages; never jumps with wall-clock changes.
+double timebase_mono_sec(void);
+
+// The same clock in whole milliseconds, without floating point (the
+// fixed-point control law)
+int64_t timebase_mono_ms(void);
+
+// Raw hardware monotonic time in nanoseconds (CLOCK_MONOTONIC_RAW): not
+// slewed by NTP, so short stage latencies are measured in true ticks.
+uint64_t timebase_raw_ns(void);
+
+// Wall-clock seconds (time(NULL)); used for controller hold deadlines
+time_t timebase_wall_sec(void);
+
+// Virtual clock for simulation. Once enabled, every reader above returns
+// virtual time, which only moves when timebase_virtual_advance() is called.
+void timebase_virtual_enable(time_t start_wall);
+void timebase_virtual_advance(double sec);
+
+#endif // TIMEBASE_H
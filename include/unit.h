@@ -0,0 +1,60 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef UNIT_H
+#define UNIT_H
+
+#include <pthread.h>
+#include "config.h"
+#include "thermal.h"
+#include "fan.h"
+#include "oled.h"
+#include "button.h"
+#include "history.h"
+#include "stages.h"
+#include "budget.h"
+#include "controller.h"
+
+// Runtime side of one [unit.<name>]: its fan, display and button, and a
+// controller of its own fed from the tick's shared sensor sample. All
+// units are stepped from the main loop; only the display and button
+// threads are per unit.
+typedef struct {
+    const unit_config_t *cfg;
+    fan_t fan;
+    oled_t oled;
+    button_t button;
+    thermal_state_t thermal;
+    controller_t controller;    // Built-in law or [controller] plugin instance
+    int has_fan;
+    int has_oled;
+    int has_button;
+    double controller_dc;       // Duty requested by this unit's controller
+    double applied_dc;          // Duty after overrides
+    double last_dc;             // Last duty written (-1 = none yet)
+    int fan_error;              // Last duty write failed
+    unsigned long duty_changes;
+    unsigned long fan_write_errors;
+} unit_t;
+
+// Claim the unit's hardware and load its controller. A missing display or
+// button only warns, a plugin that fails to load falls back to the built-in
+// law; a fan that is configured but cannot be claimed fails the unit (-1)
+// after releasing what it had claimed, as unit_stop() does.
+int unit_start(unit_t *u, config_t *cfg, const unit_config_t *ucfg, history_t *history, stages_t *stages,
+               budget_t *budget, sysinfo_t *sysinfo);
+
+// Controller step on the shared sample (0 when fan control is disabled)
+double unit_control(unit_t *u, config_t *cfg, const thermal_sample_t *sample);
+
+// Write dc to the fan if it changed; returns 1 if the duty changed
+int unit_actuate(unit_t *u, double dc, stages_t *stages);
+
+void unit_set_scroll_interval(unit_t *u, unsigned int sec);
+
+// Fan to 0, release the button, goodbye screen, unload the controller
+void unit_stop(unit_t *u);
+
+#endif // UNIT_H
@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef USAGE_H
+#define USAGE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "thermal.h"
+
+#define USAGE_PATH "/var/lib/radxa-penta-fan-ctrl/usage.dat"
+#define USAGE_DEFAULT_CHECKPOINT_SEC 300
+#define USAGE_SENSORS (1 + SSD_DEVICE_COUNT)   // CPU, then sda..sdd
+#define USAGE_LEVELS 4                          // lv0..lv3
+#define USAGE_DUTY_BANDS 5                      // off, 1-25, 26-50, 51-75, 76-100 %
+#define USAGE_MAX_TICK_SEC 30.0                 // Longer gaps (suspend, stalls) are not counted
+
+// Lifetime thermal SLO and fan-wear counters. The control loop adds each
+// tick's interval to a handful of fixed slots (O(1), no allocation); the
+// totals are checkpointed to a small file by write-to-temp, fsync and
+// rename, so a crash loses at most one checkpoint interval and never
+// leaves a torn file. Levels are those of the default profile, so the
+// counters keep one meaning across profile switches.
+typedef struct {
+    int64_t since;                                  // Wall time the counters started
+    double total_sec;                               // Time accounted
+    double above_sec[USAGE_SENSORS][USAGE_LEVELS];  // Time at or above each level
+    double peak_c[USAGE_SENSORS];
+    double band_sec[USAGE_DUTY_BANDS];              // Applied duty
+    uint64_t fan_starts;                            // Off -> on transitions
+} usage_counters_t;
+
+typedef struct {
+    usage_counters_t c;
+    char path[128];
+    int checkpoint_sec;
+    double last_checkpoint;     // Monotonic
+    double last_duty;
+    int checkpoint_errors;
+} usage_t;
+
+// Load the previous totals from path (a missing or corrupt file starts
+// fresh with a warning). Returns 0; the counters work even if saving fails.
+int usage_open(usage_t *u, const char *path, int checkpoint_sec, double now_mono);
+
+// Account one tick of dt_sec with the levels of the default profile
+void usage_tick(usage_t *u, const config_t *cfg, const thermal_state_t *ts, double duty, double dt_sec);
+
+// Checkpoint if checkpoint_sec has elapsed (call per tick)
+void usage_maybe_checkpoint(usage_t *u, double now_mono);
+
+// Write a checkpoint now; returns -1 on failure
+int usage_checkpoint(usage_t *u);
+
+// Final checkpoint and summary log line
+void usage_close(usage_t *u);
+
+const char *usage_sensor_name(int sensor);
+const char *usage_band_name(int band);
+
+#endif // USAGE_H
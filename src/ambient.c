@@ -0,0 +1,205 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include "ambient.h"
+#include "logger.h"
+
+#define AMBIENT_MIN_MC (-40000)     // Plausible air temperatures; anything else is a fault
+#define AMBIENT_MAX_MC 80000        // (the DS18B20 power-on value 85000 among them)
+#define AMBIENT_READ_LEN 256
+#define AMBIENT_W1_FILE "w1_slave"
+
+void ambient_init(ambient_t *a, const config_t *cfg) {
+    memset(a, 0, sizeof(*a));
+    a->enabled = cfg->ambient_source[0] != '\0';
+    if (strcmp(cfg->ambient_source, AMBIENT_SOURCE_DRIVES) != 0) {
+        snprintf(a->path, sizeof(a->path), "%s", cfg->ambient_source);
+    }
+    a->interval_sec = cfg->ambient_interval_sec > 0 ? cfg->ambient_interval_sec : AMBIENT_DEFAULT_INTERVAL_SEC;
+    a->drive_offset_mc = (int32_t)lround(cfg->ambient_drive_offset * 1000.0);
+    a->sensor_id = -1;
+}
+
+static int ambient_plausible(long v) {
+    return v >= AMBIENT_MIN_MC && v <= AMBIENT_MAX_MC;
+}
+
+int ambient_parse(const char *text, int32_t *mc) {
+    const char *value = text;
+    const char *t = strstr(text, "t=");
+    if (t) {
+        // w1_slave: the first line ends in YES when the CRC matched
+        const char *eol = strchr(text, '\n');
+        const char *yes = strstr(text, "YES");
+        if (!yes || (eol && yes > eol)) return -1;
+        value = t + 2;
+    }
+    char *end;
+    long v = strtol(value, &end, 10);
+    if (end == value || !ambient_plausible(v)) return -1;
+    *mc = (int32_t)v;
+    return 0;
+}
+
+static int ambient_read_file(const char *path, int32_t *mc) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    char buf[AMBIENT_READ_LEN];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    return ambient_parse(buf, mc);
+}
+
+// This tick's batch already read the file
+static int ambient_read_batched(const ambient_t *a, int32_t *mc) {
+    long v;
+    if (sensors_long(a->sensors, a->sensor_id, &v) < 0 || !ambient_plausible(v)) return -1;
+    *mc = (int32_t)v;
+    return 0;
+}
+
+// One read per interval, off the control thread; stop wakes it early
+static void *ambient_reader_thread(void *arg) {
+    ambient_t *a = arg;
+    pthread_mutex_lock(&a->lock);
+    while (!a->stop) {
+        pthread_mutex_unlock(&a->lock);
+        int32_t mc = 0;
+        int rc = ambient_read_file(a->path, &mc);
+        pthread_mutex_lock(&a->lock);
+        a->read_rc = rc;
+        a->read_mc = mc;
+        a->read_seq++;
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += a->interval_sec;
+        while (!a->stop && pthread_cond_timedwait(&a->wake, &a->lock, &deadline) != ETIMEDOUT) {
+        }
+    }
+    pthread_mutex_unlock(&a->lock);
+    return NULL;
+}
+
+int ambient_start(ambient_t *a, sensors_t *sensors) {
+    if (!a->enabled || !a->path[0]) return 0;
+    if (!strstr(a->path, AMBIENT_W1_FILE)) {
+        if (sensors) a->sensor_id = sensors_add(sensors, a->path);
+        if (a->sensor_id >= 0) a->sensors = sensors;
+        return 0;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&a->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&a->lock, NULL);
+    a->stop = 0;
+    if (pthread_create(&a->thread, NULL, ambient_reader_thread, a) != 0) {
+        fprintf(stderr, "Warning: Failed to create ambient reader thread, reading %s on the tick\n", a->path);
+        pthread_cond_destroy(&a->wake);
+        pthread_mutex_destroy(&a->lock);
+        return -1;
+    }
+    a->reader = 1;
+    return 0;
+}
+
+void ambient_stop(ambient_t *a) {
+    a->sensors = NULL;
+    a->sensor_id = -1;
+    if (!a->reader) return;
+    pthread_mutex_lock(&a->lock);
+    a->stop = 1;
+    pthread_cond_signal(&a->wake);
+    pthread_mutex_unlock(&a->lock);
+    pthread_join(a->thread, NULL);
+    pthread_cond_destroy(&a->wake);
+    pthread_mutex_destroy(&a->lock);
+    a->reader = 0;
+}
+
+// The reader thread's result, once per read it finishes; 1 if there is a new one
+static int ambient_take_read(ambient_t *a, int *rc, int32_t *mc) {
+    pthread_mutex_lock(&a->lock);
+    int fresh = a->read_seq != a->seen_seq;
+    a->seen_seq = a->read_seq;
+    *rc = a->read_rc;
+    *mc = a->read_mc;
+    pthread_mutex_unlock(&a->lock);
+    return fresh;
+}
+
+// Coolest drive this interval into the window; the window minimum is the
+// idle baseline
+static int ambient_read_drives(ambient_t *a, const int *ssd_temps, int32_t *mc) {
+    int coolest = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (ssd_temps[i] > 0 && (coolest == 0 || ssd_temps[i] < coolest)) coolest = ssd_temps[i];
+    }
+    if (coolest == 0) return -1;
+    a->baseline_mc[a->baseline_index] = coolest * 1000;
+    a->baseline_index = (a->baseline_index + 1) % AMBIENT_BASELINE_SLOTS;
+    if (a->baseline_count < AMBIENT_BASELINE_SLOTS) a->baseline_count++;
+
+    int32_t low = a->baseline_mc[0];
+    for (int i = 1; i < a->baseline_count; i++) {
+        if (a->baseline_mc[i] < low) low = a->baseline_mc[i];
+    }
+    *mc = low - a->drive_offset_mc;
+    return 0;
+}
+
+void ambient_update(ambient_t *a, const int *ssd_temps, double mono) {
+    if (!a->enabled) return;
+    int32_t mc = 0;
+    int rc;
+    if (a->reader) {
+        if (!ambient_take_read(a, &rc, &mc)) return;
+        a->read_at = mono;
+    } else {
+        if (a->read_at > 0.0 && mono - a->read_at < (double)a->interval_sec) return;
+        a->read_at = mono;
+        if (a->sensors) {
+            rc = ambient_read_batched(a, &mc);
+        } else if (a->path[0]) {
+            rc = ambient_read_file(a->path, &mc);
+        } else {
+            rc = ambient_read_drives(a, ssd_temps, &mc);
+        }
+    }
+    if (rc < 0) {
+        if (!a->failing) {
+            logger_log(LOGGER_WARNING, NULL, "Warning: Cannot read ambient temperature from %s",
+                       a->path[0] ? a->path : AMBIENT_SOURCE_DRIVES);
+            a->failing = 1;
+        }
+        return;
+    }
+    if (a->failing) {
+        logger_log(LOGGER_INFO, NULL, "Ambient temperature available again (%.1f°C)", (double)mc / 1000.0);
+        a->failing = 0;
+    }
+    a->mc = mc;
+    a->valid_at = mono;
+}
+
+int ambient_current(const ambient_t *a, double mono, int32_t *mc) {
+    if (!a->enabled || a->valid_at <= 0.0) return 0;
+    if (mono - a->valid_at > (double)(a->interval_sec * AMBIENT_STALE_INTERVALS)) return 0;
+    *mc = a->mc;
+    return 1;
+}
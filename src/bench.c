@@ -0,0 +1,189 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// Core benchmark: the cost of one controller step, one sensor and smartctl
+// parse, and one OLED page render, run against the mock backends of
+// tests/mock_backend.c (a synthetic temperature trace, canned smartctl
+// outputs, a thermal zone file and a fixed address/mount cache in a scratch
+// directory, two hours of history) so it needs no HAT. Results are CSV on
+// stdout.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "config.h"
+#include "controller.h"
+#include "fan_pwm.h"
+#include "logger.h"
+#include "oled_render.h"
+#include "sensors.h"
+#include "smart.h"
+#include "thermal.h"
+#include "timebase.h"
+#include "mock_backend.h"
+
+#define BENCH_DEFAULT_ITERATIONS 100000
+#define BENCH_DEFAULT_RENDERS 200
+#define BENCH_HISTORY_SEC 7200
+#define BENCH_SMART_LEN 2048
+
+static void print_row(const char *name, long iterations, uint64_t ns) {
+    printf("%s,%ld,%llu,%.1f\n", name, iterations, (unsigned long long)ns, (double)ns / (double)iterations);
+}
+
+// Synthetic trace: CPU swinging 40-70°C, drives 35-50°C, a few seconds per cycle
+static void bench_controller(config_t *cfg, long iterations) {
+    thermal_state_t ts;
+    controller_t c;
+    thermal_state_init(&ts);
+    controller_load(&c, cfg, &ts, "bench");
+
+    int ssd[MAX_DEVICES] = { 0 };
+    uint64_t t0 = timebase_raw_ns();
+    for (long i = 0; i < iterations; i++) {
+        double phase = (double)i / 500.0;
+        int32_t cpu_mc = (int32_t)lround(55000.0 + 15000.0 * sin(phase));
+        for (int d = 0; d < SSD_DEVICE_COUNT; d++) {
+            ssd[d] = 42 + (int)(8.0 * sin(phase / 3.0 + d));
+        }
+        controller_step(&c, cfg, cpu_mc, ssd, SSD_DEVICE_COUNT);
+    }
+    print_row(c.builtin ? "controller_step_builtin" : "controller_step_plugin", iterations, timebase_raw_ns() - t0);
+    controller_unload(&c);
+
+    // Mock actuator: what fan_set_duty_cycle() computes for either backend
+    fan_pwm_timing_t timing;
+    t0 = timebase_raw_ns();
+    for (long i = 0; i < iterations; i++) {
+        double duty = (double)(i % 101) / 100.0;
+        fan_pwm_duty_ns(PWM_PERIOD_US * 1000, duty);
+        fan_pwm_timing((double)GPIO_PERIOD_S, fan_pwm_clamp(duty), &timing);
+    }
+    print_row("fan_pwm", iterations, timebase_raw_ns() - t0);
+}
+
+static void bench_smart(const char *name, const char *data, unsigned int want, long iterations) {
+    size_t len = strlen(data);
+    smart_parser_t p;
+    unsigned int found = 0;
+    uint64_t t0 = timebase_raw_ns();
+    for (long i = 0; i < iterations; i++) {
+        smart_parser_init(&p, want);
+        size_t off = 0;
+        int done = 0;
+        while (!done && off < len) {
+            size_t n = len - off < SMARTCTL_READ_CHUNK ? len - off : SMARTCTL_READ_CHUNK;
+            done = smart_parser_feed(&p, data + off, n);
+            off += n;
+        }
+        if (!done) smart_parser_finish(&p);
+        found |= p.found;
+    }
+    print_row(name, iterations, timebase_raw_ns() - t0);
+    if (!(found & SMART_TEMP)) fprintf(stderr, "Warning: %s: no temperature parsed\n", name);
+}
+
+static void bench_sensors(const mock_backend_t *m, long iterations) {
+    static sensors_t s;
+    sensors_init(&s, 0);
+    int id = sensors_add(&s, m->zone);
+    if (id < 0) {
+        sensors_close(&s);
+        return;
+    }
+    long value;
+    uint64_t t0 = timebase_raw_ns();
+    for (long i = 0; i < iterations; i++) {
+        sensors_read_all(&s);
+        sensors_long(&s, id, &value);
+    }
+    print_row("sensors_pread_zone", iterations, timebase_raw_ns() - t0);
+    sensors_close(&s);
+}
+
+static void bench_render(mock_backend_t *m, long renders) {
+    static const char *names[PAGE_COUNT] = {
+        "render_system", "render_resources", "render_disks", "render_health", "render_raid", "render_graph"
+    };
+    oled_t oled;
+    memset(&oled, 0, sizeof(oled));
+    oled.disks = ~0u;
+    oled.history = m->have_history ? &m->history : NULL;
+    oled.sysinfo = &m->sysinfo;
+
+    oled_frame_t frame;
+    for (int page = 0; page < PAGE_COUNT; page++) {
+        uint64_t t0 = timebase_raw_ns();
+        for (long i = 0; i < renders; i++) {
+            oled_render_page(&oled, (oled_page_t)page, &frame);
+        }
+        print_row(names[page], renders, timebase_raw_ns() - t0);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-c config] [-n iterations] [-r renders]\n"
+            "  -c  config whose profile and [controller] are used (default %s)\n"
+            "  -n  controller steps and parses per benchmark (default %d)\n"
+            "  -r  renders per OLED page (default %d; some pages spawn tools)\n",
+            prog, CONFIG_FILE, BENCH_DEFAULT_ITERATIONS, BENCH_DEFAULT_RENDERS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *config_path = CONFIG_FILE;
+    long iterations = BENCH_DEFAULT_ITERATIONS;
+    long renders = BENCH_DEFAULT_RENDERS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:r:h")) != -1) {
+        switch (opt) {
+            case 'c': config_path = optarg; break;
+            case 'n': iterations = strtol(optarg, NULL, 10); break;
+            case 'r': renders = strtol(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (iterations <= 0 || renders <= 0) {
+        fprintf(stderr, "Error: Iterations and renders must be positive\n");
+        return 2;
+    }
+    logger_init("warning", 0, NULL);
+
+    // Setup chatter (config and history messages) goes to stderr so that
+    // stdout is only the CSV
+    static config_t cfg;
+    mock_backend_t mock;
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    if (saved_stdout >= 0) dup2(STDERR_FILENO, STDOUT_FILENO);
+    config_load_file(&cfg, config_path);
+    int mock_ok = mock_open(&mock, "bench", BENCH_HISTORY_SEC);
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+    if (mock_ok < 0) return 1;
+
+    printf("# config=%s profile=%s\n", config_path, cfg.active->name);
+    printf("benchmark,iterations,total_ns,ns_per_op\n");
+    bench_controller(&cfg, iterations);
+    char smart_text[BENCH_SMART_LEN], smart_json[BENCH_SMART_LEN];
+    mock_smart_report(smart_text, sizeof(smart_text), 0, MOCK_SMART_TEMP);
+    mock_smart_report(smart_json, sizeof(smart_json), 1, MOCK_SMART_TEMP);
+    bench_smart("smart_parse_text_temp", smart_text, SMART_TEMP, iterations);
+    bench_smart("smart_parse_text_health", smart_text, SMART_TEMP | SMART_HEALTH, iterations);
+    bench_smart("smart_parse_json_health", smart_json, SMART_TEMP | SMART_HEALTH, iterations);
+    bench_sensors(&mock, iterations);
+    bench_render(&mock, renders);
+
+    mock_close(&mock);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <string.h>
+#include <sys/resource.h>
+#include "budget.h"
+#include "logger.h"
+
+static unsigned long spawn_count;
+
+void budget_count_spawn(void) {
+    __atomic_fetch_add(&spawn_count, 1ul, __ATOMIC_RELAXED);
+}
+
+unsigned long budget_spawns(void) {
+    return __atomic_load_n(&spawn_count, __ATOMIC_RELAXED);
+}
+
+static double timeval_sec(const struct timeval *tv) {
+    return (double)tv->tv_sec + (double)tv->tv_usec / 1e6;
+}
+
+static double rusage_cpu_sec(int who, long *nvcsw) {
+    struct rusage ru;
+    if (getrusage(who, &ru) < 0) return 0.0;
+    if (nvcsw) *nvcsw = ru.ru_nvcsw;
+    return timeval_sec(&ru.ru_utime) + timeval_sec(&ru.ru_stime);
+}
+
+static double clock_cpu_sec(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) < 0) return 0.0;
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void window_reset(budget_t *b, double now) {
+    b->window_start = now;
+    b->self_cpu0 = rusage_cpu_sec(RUSAGE_SELF, &b->nvcsw0);
+    b->child_cpu0 = rusage_cpu_sec(RUSAGE_CHILDREN, NULL);
+    b->loop_cpu0 = clock_cpu_sec(CLOCK_THREAD_CPUTIME_ID);
+    b->oled_cpu0 = b->have_oled_clock ? clock_cpu_sec(b->oled_clock) : 0.0;
+    b->spawns0 = budget_spawns();
+}
+
+void budget_init(budget_t *b, double cpu_budget_pct, double now) {
+    memset(b, 0, sizeof(budget_t));
+    b->cpu_budget_pct = cpu_budget_pct;
+    window_reset(b, now);
+}
+
+void budget_watch_oled_thread(budget_t *b, pthread_t thread) {
+    if (pthread_getcpuclockid(thread, &b->oled_clock) == 0) {
+        b->have_oled_clock = 1;
+        b->oled_cpu0 = clock_cpu_sec(b->oled_clock);
+    }
+}
+
+unsigned int budget_scale(const budget_t *b) {
+    return 1u << b->level;
+}
+
+int budget_update(budget_t *b, double now) {
+    double elapsed = now - b->window_start;
+    if (elapsed < BUDGET_WINDOW_SEC) return 0;
+
+    long nvcsw = 0;
+    double self_cpu = rusage_cpu_sec(RUSAGE_SELF, &nvcsw);
+    double child_cpu = rusage_cpu_sec(RUSAGE_CHILDREN, NULL);
+    double loop_cpu = clock_cpu_sec(CLOCK_THREAD_CPUTIME_ID);
+    double oled_cpu = b->have_oled_clock ? clock_cpu_sec(b->oled_clock) : 0.0;
+
+    b->self_pct = (self_cpu - b->self_cpu0) / elapsed * 100.0;
+    b->child_pct = (child_cpu - b->child_cpu0) / elapsed * 100.0;
+    b->loop_pct = (loop_cpu - b->loop_cpu0) / elapsed * 100.0;
+    b->oled_pct = b->have_oled_clock ? (oled_cpu - b->oled_cpu0) / elapsed * 100.0 : 0.0;
+    b->wakeups_per_sec = (double)(nvcsw - b->nvcsw0) / elapsed;
+    b->spawns_per_min = (double)(budget_spawns() - b->spawns0) / elapsed * 60.0;
+    window_reset(b, now);
+
+    if (b->cpu_budget_pct <= 0.0) return 0;
+
+    double used = b->self_pct + b->child_pct;
+    int old_level = b->level;
+    if (used > b->cpu_budget_pct && b->level < BUDGET_MAX_LEVEL) {
+        b->level++;
+    } else if (used < b->cpu_budget_pct * BUDGET_RELAX_RATIO && b->level > 0) {
+        b->level--;
+    }
+    if (b->level == old_level) return 0;
+
+    logger_fields_t fields;
+    logger_fields_init(&fields);
+    logger_field(&fields, "CPU_PERCENT", "%.3f", used);
+    logger_field(&fields, "BUDGET_PERCENT", "%.3f", b->cpu_budget_pct);
+    logger_field(&fields, "BUDGET_LEVEL", "%d", b->level);
+    logger_log(b->level > old_level ? LOGGER_WARNING : LOGGER_INFO, &fields,
+               "[Budget] CPU %.2f%% (self %.2f%%, children %.2f%%, %.0f spawns/min) vs budget %.2f%%: level %d -> %d",
+               used, b->self_pct, b->child_pct, b->spawns_per_min, b->cpu_budget_pct, old_level, b->level);
+    return 1;
+}
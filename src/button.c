@@ -11,9 +11,11 @@
 #include <gpiod.h>
 #include "button.h"
 #include "oled.h"
+#include "profile.h"
 
 #define BUTTON_DEBOUNCE_MS 50
 #define BUTTON_POLL_MS 100
+#define BUTTON_LONG_PRESS_MS 1500   // Hold at least this long to cycle fan profiles
 
 int button_init(button_t *button, int gpio_chip, unsigned int gpio_line, oled_t *oled) {
     memset(button, 0, sizeof(button_t));
@@ -103,16 +105,13 @@ void* button_watch_thread(void *arg) {
         
         int current_value = (value == GPIOD_LINE_VALUE_ACTIVE) ? 0 : 1;
         
-        // Detect button press (transition from HIGH to LOW)
+        // Detect button press (transition from HIGH to LOW). The gesture is
+        // decided on release: a long hold cycles the fan profile, a short
+        // press advances the OLED page.
         if (last_value == 1 && current_value == 0) {
-            printf("Button pressed! Advancing to next page\n");
-            if (button->oled && button->oled->initialized) {
-                button->oled->current_page = (button->oled->current_page + 1) % PAGE_COUNT;
-                printf("Switched to page %d\n", button->oled->current_page);
-                // Immediately update the display with the new page
-                oled_show_page(button->oled, (oled_page_t)button->oled->current_page);
-            }
-            
+            struct timespec pressed_at, released_at;
+            clock_gettime(CLOCK_MONOTONIC, &pressed_at);
+
             // Wait for button release with debouncing
             // Keep reading until button is released (returns to HIGH)
             do {
@@ -120,7 +119,24 @@ void* button_watch_thread(void *arg) {
                 value = gpiod_line_request_get_value(button->request, button->gpio_line);
                 current_value = (value == GPIOD_LINE_VALUE_ACTIVE) ? 0 : 1;
             } while (current_value == 0 && button->initialized);
-            
+
+            clock_gettime(CLOCK_MONOTONIC, &released_at);
+            long held_ms = (released_at.tv_sec - pressed_at.tv_sec) * 1000L +
+                           (released_at.tv_nsec - pressed_at.tv_nsec) / 1000000L;
+
+            if (held_ms >= BUTTON_LONG_PRESS_MS) {
+                printf("Button held %ldms, cycling fan profile\n", held_ms);
+                profile_request(PROFILE_REQUEST_NEXT);
+            } else {
+                printf("Button pressed! Advancing to next page\n");
+                if (button->oled && button->oled->initialized) {
+                    button->oled->current_page = (button->oled->current_page + 1) % PAGE_COUNT;
+                    printf("Switched to page %d\n", button->oled->current_page);
+                    // Immediately update the display with the new page
+                    oled_show_page(button->oled, (oled_page_t)button->oled->current_page);
+                }
+            }
+
             // Additional debounce delay after release to ensure stable state
             usleep((unsigned int)(BUTTON_DEBOUNCE_MS * 1000));
         }
@@ -0,0 +1,410 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "commands.h"
+#include "timebase.h"
+#include "logger.h"
+#include "profile.h"
+
+#define BOOST_MAX_SEC 86400.0
+#define HISTORY_MAX_SPAN_SEC (400L * 86400L)
+#define HISTORY_MAX_REPLY_BUCKETS 120
+#define HISTORY_DEFAULT_BUCKETS 24
+
+static int parse_percent(const char *s, double *out) {
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || *end != '\0' || v < 0.0 || v > 100.0) return -1;
+    *out = v / 100.0;
+    return 0;
+}
+
+daemon_mode_t commands_mode(const daemon_t *d, double now) {
+    if (d->override.manual_duty >= 0.0) return DAEMON_MODE_MANUAL;
+    if (d->override.boost_until > now) return DAEMON_MODE_BOOST;
+    return DAEMON_MODE_AUTO;
+}
+
+const char *commands_mode_name(daemon_mode_t mode) {
+    switch (mode) {
+        case DAEMON_MODE_MANUAL: return "manual";
+        case DAEMON_MODE_BOOST: return "boost";
+        case DAEMON_MODE_AUTO: return "auto";
+        default: return "auto";
+    }
+}
+
+static const char *mode_name(const daemon_t *d, double now) {
+    return commands_mode_name(commands_mode(d, now));
+}
+
+double commands_apply_overrides(daemon_t *d, double controller_dc, double now) {
+    override_t *o = &d->override;
+    double dc = controller_dc;
+
+    if (o->boost_until != 0.0 && now >= o->boost_until) {
+        logger_log(LOGGER_INFO, NULL, "[Ctl] Boost expired");
+        o->boost_until = 0.0;
+    }
+
+    if (controller_dc >= 1.0) {
+        return controller_dc; // Thermal emergency: ignore overrides
+    }
+    if (o->manual_duty >= 0.0) {
+        dc = o->manual_duty;
+    }
+    if (o->boost_until != 0.0 && o->boost_duty > dc) {
+        dc = o->boost_duty;
+    }
+    return dc;
+}
+
+static int cmd_status(daemon_t *d, ctl_reply_t *reply) {
+    double now = timebase_mono_sec();
+    const thermal_state_t *ts = d->thermal;
+    double boost_left = (d->override.boost_until > now) ? d->override.boost_until - now : 0.0;
+
+    ctl_reply_printf(reply, "mode=%s duty=%.0f controller=%.0f target=%.0f cpu=%.1f ssd=%d hold=%d deadband=%d boost_remaining=%.0f",
+                     mode_name(d, now), d->applied_dc * 100.0, d->controller_dc * 100.0, ts->dc_target * 100.0,
+                     ts->cpu_avg, ts->ssd_avg, ts->hold_active, ts->deadband_active, boost_left);
+    return 0;
+}
+
+static int cmd_set_manual_duty(daemon_t *d, int argc, char **argv, ctl_reply_t *reply) {
+    if (argc != 2) {
+        ctl_reply_error(reply, "usage: set-manual-duty <0-100|auto>");
+        return -1;
+    }
+    if (strcmp(argv[1], "auto") == 0) {
+        d->override.manual_duty = -1.0;
+        logger_log(LOGGER_INFO, NULL, "[Ctl] Manual duty cleared, back to automatic control");
+        return 0;
+    }
+    double duty;
+    if (parse_percent(argv[1], &duty) < 0) {
+        ctl_reply_error(reply, "duty must be 0-100 or 'auto'");
+        return -1;
+    }
+    d->override.manual_duty = duty;
+    logger_log(LOGGER_INFO, NULL, "[Ctl] Manual duty set to %.0f%%", duty * 100.0);
+    return 0;
+}
+
+static int cmd_boost(daemon_t *d, int argc, char **argv, ctl_reply_t *reply) {
+    if (argc < 2 || argc > 3) {
+        ctl_reply_error(reply, "usage: boost <seconds|off> [duty 0-100, default 100]");
+        return -1;
+    }
+    if (strcmp(argv[1], "off") == 0) {
+        d->override.boost_until = 0.0;
+        logger_log(LOGGER_INFO, NULL, "[Ctl] Boost cancelled");
+        return 0;
+    }
+
+    char *end;
+    double secs = strtod(argv[1], &end);
+    if (end == argv[1] || *end != '\0' || secs <= 0.0 || secs > BOOST_MAX_SEC) {
+        ctl_reply_error(reply, "seconds must be in (0, %.0f]", BOOST_MAX_SEC);
+        return -1;
+    }
+    double duty = 1.0;
+    if (argc == 3 && parse_percent(argv[2], &duty) < 0) {
+        ctl_reply_error(reply, "duty must be 0-100");
+        return -1;
+    }
+
+    d->override.boost_duty = duty;
+    d->override.boost_until = timebase_mono_sec() + secs;
+    logger_log(LOGGER_INFO, NULL, "[Ctl] Boost to %.0f%% for %.0fs", duty * 100.0, secs);
+    return 0;
+}
+
+static int cmd_profile(daemon_t *d, int argc, char **argv, ctl_reply_t *reply) {
+    const config_t *cfg = d->cfg;
+    if (argc == 1) {
+        for (int i = 0; i < cfg->profile_count; i++) {
+            const fan_profile_t *p = &cfg->profiles[i];
+            ctl_reply_printf(reply, "%c %s cpu=%.0f/%.0f/%.0f/%.0f ssd=%.0f/%.0f/%.0f/%.0f",
+                             p == cfg->active ? '*' : ' ', p->name,
+                             p->fan.lv0, p->fan.lv1, p->fan.lv2, p->fan.lv3,
+                             p->fan_ssd.lv0, p->fan_ssd.lv1, p->fan_ssd.lv2, p->fan_ssd.lv3);
+        }
+        for (int i = 0; i < cfg->schedule_count; i++) {
+            ctl_reply_printf(reply, "  at %02d:%02d -> %s", cfg->schedule[i].minute / 60,
+                             cfg->schedule[i].minute % 60, cfg->profiles[cfg->schedule[i].profile].name);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        ctl_reply_error(reply, "usage: profile [name]");
+        return -1;
+    }
+    int idx = config_find_profile(cfg, argv[1]);
+    if (idx < 0) {
+        ctl_reply_error(reply, "unknown profile '%s'", argv[1]);
+        return -1;
+    }
+    // Applied by the control loop at the start of its next tick
+    profile_request(idx);
+    ctl_reply_printf(reply, "switching to %s", cfg->profiles[idx].name);
+    return 0;
+}
+
+static int cmd_history(daemon_t *d, int argc, char **argv, ctl_reply_t *reply) {
+    if (argc < 3 || argc > 4) {
+        ctl_reply_error(reply, "usage: history <cpu|ssd|duty> <seconds> [buckets]");
+        return -1;
+    }
+    if (!d->history) {
+        ctl_reply_error(reply, "history store disabled");
+        return -1;
+    }
+    int series = history_series_from_name(argv[1]);
+    if (series < 0) {
+        ctl_reply_error(reply, "unknown series '%s'", argv[1]);
+        return -1;
+    }
+    char *end;
+    long span = strtol(argv[2], &end, 10);
+    if (end == argv[2] || *end != '\0' || span <= 0 || span > HISTORY_MAX_SPAN_SEC) {
+        ctl_reply_error(reply, "seconds must be in (0, %ld]", HISTORY_MAX_SPAN_SEC);
+        return -1;
+    }
+    long nbuckets = HISTORY_DEFAULT_BUCKETS;
+    if (argc == 4) {
+        nbuckets = strtol(argv[3], &end, 10);
+        if (end == argv[3] || *end != '\0' || nbuckets <= 0 || nbuckets > HISTORY_MAX_REPLY_BUCKETS) {
+            ctl_reply_error(reply, "buckets must be 1-%d", HISTORY_MAX_REPLY_BUCKETS);
+            return -1;
+        }
+    }
+
+    double values[HISTORY_MAX_REPLY_BUCKETS];
+    int64_t to = (int64_t)time(NULL) + 1;
+    int64_t from = to - span;
+    size_t samples = history_query(d->history, (history_series_t)series, from, to, values, (size_t)nbuckets);
+
+    // One line per bucket: start time (unix seconds) and average, "-" if empty
+    ctl_reply_printf(reply, "series=%s from=%lld to=%lld samples=%zu", argv[1], (long long)from, (long long)to, samples);
+    for (long i = 0; i < nbuckets; i++) {
+        long long start = (long long)(from + span * i / nbuckets);
+        if (isnan(values[i])) {
+            ctl_reply_printf(reply, "%lld -", start);
+        } else {
+            ctl_reply_printf(reply, "%lld %.2f", start, values[i]);
+        }
+    }
+    return 0;
+}
+
+static int cmd_stages(daemon_t *d, ctl_reply_t *reply) {
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        stage_id_t id = (stage_id_t)s;
+        ctl_reply_printf(reply, "%s count=%llu p50_us=%.1f p90_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f",
+                         stages_name(id), (unsigned long long)stages_count(d->stages, id),
+                         (double)stages_percentile_ns(d->stages, id, 0.50) / 1e3,
+                         (double)stages_percentile_ns(d->stages, id, 0.90) / 1e3,
+                         (double)stages_percentile_ns(d->stages, id, 0.99) / 1e3,
+                         (double)stages_percentile_ns(d->stages, id, 0.999) / 1e3,
+                         (double)stages_percentile_ns(d->stages, id, 1.0) / 1e3);
+    }
+    return 0;
+}
+
+static int cmd_shadow(daemon_t *d, ctl_reply_t *reply) {
+    const shadow_t *s = d->shadow;
+    if (!s) {
+        ctl_reply_error(reply, "no shadow controller configured ([shadow] config)");
+        return -1;
+    }
+    ctl_reply_printf(reply, "active_duty=%.1f shadow_duty=%.1f delta=%+.1f",
+                     d->controller_dc * 100.0, s->dc * 100.0, s->delta * 100.0);
+    ctl_reply_printf(reply, "compared_sec=%.0f ticks=%lu", s->seconds, s->ticks);
+    ctl_reply_printf(reply, "mean_abs_delta=%.2f mean_delta=%+.2f max_abs_delta=%.1f",
+                     shadow_mean_abs_delta(s) * 100.0,
+                     s->seconds > 0.0 ? s->delta_sum / s->seconds * 100.0 : 0.0,
+                     s->max_abs_delta * 100.0);
+    ctl_reply_printf(reply, "divergent_sec=%.0f threshold=%.0f", s->divergent_sec, s->divergence * 100.0);
+    ctl_reply_printf(reply, "fan_energy_wh active=%.3f shadow=%.3f", s->active_wh, s->shadow_wh);
+    return 0;
+}
+
+static int cmd_usage(daemon_t *d, ctl_reply_t *reply) {
+    const usage_t *u = d->usage;
+    if (!u) {
+        ctl_reply_error(reply, "usage accounting disabled ([usage] enabled)");
+        return -1;
+    }
+    const usage_counters_t *c = &u->c;
+    double total = c->total_sec > 0.0 ? c->total_sec : 1.0;
+
+    ctl_reply_printf(reply, "since=%lld hours=%.2f fan_starts=%llu checkpoint_errors=%d",
+                     (long long)c->since, c->total_sec / 3600.0, (unsigned long long)c->fan_starts, u->checkpoint_errors);
+    // Hours (and share of all accounted time) at or above each curve level
+    for (int s = 0; s < USAGE_SENSORS; s++) {
+        const double *a = c->above_sec[s];
+        ctl_reply_printf(reply, "%s lv0=%.2fh(%.1f%%) lv1=%.2fh(%.1f%%) lv2=%.2fh(%.1f%%) lv3=%.2fh(%.1f%%) peak=%.0f",
+                         usage_sensor_name(s),
+                         a[0] / 3600.0, a[0] / total * 100.0, a[1] / 3600.0, a[1] / total * 100.0,
+                         a[2] / 3600.0, a[2] / total * 100.0, a[3] / 3600.0, a[3] / total * 100.0, c->peak_c[s]);
+    }
+    for (int b = 0; b < USAGE_DUTY_BANDS; b++) {
+        ctl_reply_printf(reply, "duty=%s %.2fh(%.1f%%)", usage_band_name(b),
+                         c->band_sec[b] / 3600.0, c->band_sec[b] / total * 100.0);
+    }
+    return 0;
+}
+
+static int cmd_units(daemon_t *d, ctl_reply_t *reply) {
+    for (int i = 0; i < d->unit_count; i++) {
+        const unit_t *u = &d->units[i];
+        const unit_config_t *c = u->cfg;
+        char disks[32] = "";
+        size_t len = 0;
+        for (size_t k = 0; k < SSD_DEVICE_COUNT; k++) {
+            if (c->disks & (1u << k)) {
+                len += (size_t)snprintf(disks + len, sizeof(disks) - len, "%s%s", len ? "," : "", thermal_ssd_device_name(k));
+            }
+        }
+        ctl_reply_printf(reply, "%s fan=%s duty=%.0f controller=%.0f cpu=%.1f%s ssd=%d disks=%s display=%s button=%s errors=%lu",
+                         c->name, !u->has_fan ? "none" : u->fan.use_hardware_pwm ? "hardware" : "software",
+                         u->applied_dc * 100.0, u->controller_dc * 100.0, u->thermal.cpu_avg, c->cpu ? "" : "(unused)",
+                         u->thermal.ssd_avg, len ? disks : "none", u->has_oled ? "yes" : "no",
+                         u->has_button ? "yes" : "no", u->fan_write_errors);
+    }
+    return 0;
+}
+
+static int cmd_controller(daemon_t *d, ctl_reply_t *reply) {
+    for (int i = 0; i < d->unit_count; i++) {
+        const controller_t *c = &d->units[i].controller;
+        uint8_t buf[256];
+        char hex[sizeof(buf) * 2 + 1] = "";
+        size_t n = controller_serialize(c, buf, sizeof(buf));
+        for (size_t k = 0; k < n; k++) {
+            snprintf(hex + k * 2, 3, "%02x", buf[k]);
+        }
+        ctl_reply_printf(reply, "%s name=%s abi=%u steps=%lu slow_steps=%lu bad_outputs=%lu forced_steps=%lu max_step_us=%.1f",
+                         d->units[i].cfg->name, c->ops->name ? c->ops->name : "?", c->ops->abi_version,
+                         c->steps, c->slow_steps, c->bad_outputs, c->forced_steps, (double)c->max_step_ns / 1e3);
+        ctl_reply_printf(reply, "%s state=%s", d->units[i].cfg->name, n ? hex : "-");
+    }
+    return 0;
+}
+
+static int cmd_dump(daemon_t *d, ctl_reply_t *reply) {
+    double now = timebase_mono_sec();
+    const thermal_state_t *ts = d->thermal;
+    const config_t *cfg = d->cfg;
+
+    char host[SYSINFO_HOST_LEN], addr[SYSINFO_ADDR_LEN], raid[SYSINFO_PATH_LEN];
+    sysinfo_hostname(d->sysinfo, host, sizeof(host));
+    ctl_reply_printf(reply, "uptime_sec=%.0f", now - d->started_at);
+    ctl_reply_printf(reply, "hostname=%s", host);
+    ctl_reply_printf(reply, "ip=%s", sysinfo_primary_address(d->sysinfo, addr, sizeof(addr)) == 0 ? addr : "-");
+    ctl_reply_printf(reply, "raid_mount=%s", sysinfo_raid_mount(d->sysinfo, raid, sizeof(raid)) == 0 ? raid : "-");
+    ctl_reply_printf(reply, "ticks=%lu", d->ticks);
+    ctl_reply_printf(reply, "mode=%s", mode_name(d, now));
+    ctl_reply_printf(reply, "manual_duty=%.2f", d->override.manual_duty);
+    ctl_reply_printf(reply, "boost_duty=%.2f", d->override.boost_duty);
+    ctl_reply_printf(reply, "boost_remaining_sec=%.0f",
+                     d->override.boost_until > now ? d->override.boost_until - now : 0.0);
+    ctl_reply_printf(reply, "applied_duty=%.3f", d->applied_dc);
+    ctl_reply_printf(reply, "controller_duty=%.3f", d->controller_dc);
+    ctl_reply_printf(reply, "target_duty=%.3f", ts->dc_target);
+    ctl_reply_printf(reply, "cpu_raw=%.1f", ts->cpu_temp_raw);
+    ctl_reply_printf(reply, "cpu_avg=%.2f", ts->cpu_avg);
+    ctl_reply_printf(reply, "cpu_trend=%+.2f", ts->cpu_trend);
+    ctl_reply_printf(reply, "cpu_age_sec=%.1f", now - ts->cpu_sampled_at);
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        ctl_reply_printf(reply, "ssd_%s=%d", thermal_ssd_device_name(i), d->sample.ssd_temps[i]);
+    }
+    if (cfg->ambient_source[0]) {
+        if (ts->ambient_valid) ctl_reply_printf(reply, "ambient=%.1f", (double)ts->ambient_mc / 1000.0);
+        else ctl_reply_printf(reply, "ambient=none");
+        ctl_reply_printf(reply, "ambient_rate=%.2f", ts->ambient_rate);
+    }
+    ssd_health_t health[SSD_DEVICE_COUNT];
+    thermal_ssd_health(health, SSD_DEVICE_COUNT);
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        const ssd_health_t *h = &health[i];
+        ctl_reply_printf(reply, "health_%s=reallocated:%ld pending:%ld wear:%d used:%d media_errors:%ld age_sec:%.0f",
+                         thermal_ssd_device_name(i), h->reallocated, h->pending, h->wear_leveling, h->percent_used,
+                         h->media_errors, h->valid ? now - h->updated_at : -1.0);
+    }
+    ctl_reply_printf(reply, "ssd_avg=%d", ts->ssd_avg);
+    ctl_reply_printf(reply, "ssd_trend=%+.2f", ts->ssd_trend);
+    ctl_reply_printf(reply, "ssd_age_sec=%.1f", ts->ssd_sampled_at > 0.0 ? now - ts->ssd_sampled_at : -1.0);
+    ctl_reply_printf(reply, "stable_cycles=%d", ts->stable_cycles);
+    ctl_reply_printf(reply, "stable_sec=%.1f", ts->stable_sec);
+    ctl_reply_printf(reply, "period_sec=%.2f", ts->period_sec);
+    ctl_reply_printf(reply, "hold_active=%d", ts->hold_active);
+    ctl_reply_printf(reply, "deadband_active=%d", ts->deadband_active);
+    ctl_reply_printf(reply, "self_cpu_pct=%.3f", d->budget->self_pct);
+    ctl_reply_printf(reply, "child_cpu_pct=%.3f", d->budget->child_pct);
+    ctl_reply_printf(reply, "loop_cpu_pct=%.3f", d->budget->loop_pct);
+    ctl_reply_printf(reply, "oled_cpu_pct=%.3f", d->budget->oled_pct);
+    ctl_reply_printf(reply, "wakeups_per_sec=%.1f", d->budget->wakeups_per_sec);
+    ctl_reply_printf(reply, "spawns_per_min=%.1f", d->budget->spawns_per_min);
+    ctl_reply_printf(reply, "budget_level=%d", d->budget->level);
+    ctl_reply_printf(reply, "ssd_interval_sec=%d", thermal_ssd_interval());
+    ctl_reply_printf(reply, "sensors=%s files=%d syscalls_per_tick=%.2f", sensors_backend_name(d->sensors), d->sensors->count,
+                     d->sensors->batches ? (double)d->sensors->syscalls / (double)d->sensors->batches : 0.0);
+    ctl_reply_printf(reply, "fan_backend=%s", !d->fan ? "none" : d->fan->use_hardware_pwm ? "hardware" : "software");
+    ctl_reply_printf(reply, "units=%d", d->unit_count);
+    ctl_reply_printf(reply, "controller=%s", d->units[0].controller.ops->name ? d->units[0].controller.ops->name : "?");
+    ctl_reply_printf(reply, "profile=%s", cfg->active->name);
+    if (d->mqtt) {
+        ctl_reply_printf(reply, "mqtt=%s published=%lu dropped=%lu connects=%lu",
+                         mqtt_state_name(d->mqtt), d->mqtt->published, d->mqtt->dropped, d->mqtt->connects);
+    }
+    // As applied: relative curves are shown at the current ambient
+    fan_config_t cpu_curve, ssd_curve;
+    thermal_curves(cfg, cfg->active, ts, &cpu_curve, &ssd_curve);
+    ctl_reply_printf(reply, "curve_cpu=%.1f/%.1f/%.1f/%.1f", cpu_curve.lv0, cpu_curve.lv1, cpu_curve.lv2, cpu_curve.lv3);
+    ctl_reply_printf(reply, "curve_ssd=%.1f/%.1f/%.1f/%.1f", ssd_curve.lv0, ssd_curve.lv1, ssd_curve.lv2, ssd_curve.lv3);
+    return 0;
+}
+
+static int cmd_help(ctl_reply_t *reply) {
+    ctl_reply_printf(reply, "status                         one-line summary");
+    ctl_reply_printf(reply, "dump                           full controller state");
+    ctl_reply_printf(reply, "set-manual-duty <0-100|auto>   fix the fan duty / return to automatic");
+    ctl_reply_printf(reply, "boost <seconds|off> [duty]     raise the duty floor for a while");
+    ctl_reply_printf(reply, "profile [name]                 list or select a fan profile");
+    ctl_reply_printf(reply, "history <series> <sec> [n]     averages of cpu/ssd/duty in n buckets");
+    ctl_reply_printf(reply, "stages                         per-stage latency percentiles");
+    ctl_reply_printf(reply, "shadow                         shadow controller divergence (percent)");
+    ctl_reply_printf(reply, "usage                          lifetime time above curve levels, fan hours");
+    ctl_reply_printf(reply, "units                          per-HAT fan, duty, sensors and display");
+    ctl_reply_printf(reply, "controller                     controller plugin, step timing, state (hex)");
+    return 0;
+}
+
+int commands_handle(void *ctx, int argc, char **argv, ctl_reply_t *reply) {
+    daemon_t *d = (daemon_t *)ctx;
+    const char *cmd = argv[0];
+
+    if (strcmp(cmd, "status") == 0) return cmd_status(d, reply);
+    if (strcmp(cmd, "dump") == 0) return cmd_dump(d, reply);
+    if (strcmp(cmd, "set-manual-duty") == 0) return cmd_set_manual_duty(d, argc, argv, reply);
+    if (strcmp(cmd, "boost") == 0) return cmd_boost(d, argc, argv, reply);
+    if (strcmp(cmd, "profile") == 0) return cmd_profile(d, argc, argv, reply);
+    if (strcmp(cmd, "history") == 0) return cmd_history(d, argc, argv, reply);
+    if (strcmp(cmd, "stages") == 0) return cmd_stages(d, reply);
+    if (strcmp(cmd, "shadow") == 0) return cmd_shadow(d, reply);
+    if (strcmp(cmd, "usage") == 0) return cmd_usage(d, reply);
+    if (strcmp(cmd, "units") == 0) return cmd_units(d, reply);
+    if (strcmp(cmd, "controller") == 0) return cmd_controller(d, reply);
+    if (strcmp(cmd, "help") == 0) return cmd_help(reply);
+
+    ctl_reply_error(reply, "unknown command '%s' (try 'help')", cmd);
+    return -1;
+}
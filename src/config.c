@@ -8,6 +8,17 @@
 #include <string.h>
 #include <ctype.h>
 #include "config.h"
+#include "thermal.h"
+#include "oled.h"
+#include "ctl.h"
+#include "flightrec.h"
+#include "history.h"
+#include "usage.h"
+#include "mqtt.h"
+#include "budget.h"
+#include "shadow.h"
+#include "logger.h"
+#include "ambient.h"
 
 static char* trim(char *str) {
     char *end;
@@ -21,6 +32,7 @@ static char* trim(char *str) {
     return str;
 }
 
+// section, key and value hold MAX_LINE bytes, so any part of a line fits
 static int parse_line(const char *line, char *section, char *key, char *value) {
     char buf[MAX_LINE];
     strncpy(buf, line, MAX_LINE - 1);
@@ -47,106 +59,501 @@ static int parse_line(const char *line, char *section, char *key, char *value) {
         strcpy(value, eq + 1);
         char *trimmed_key = trim(key);
         char *trimmed_value = trim(value);
-        strcpy(key, trimmed_key);
-        strcpy(value, trimmed_value);
+        // Source and destination overlap, so strcpy() is not safe here
+        memmove(key, trimmed_key, strlen(trimmed_key) + 1);
+        memmove(value, trimmed_value, strlen(trimmed_value) + 1);
         return 2;
     }
     
     return 0;
 }
 
-int config_load(config_t *cfg) {
-    FILE *fp = fopen(CONFIG_FILE, "r");
-    if (!fp) {
-        fprintf(stderr, "Warning: Cannot open config file %s, using defaults\n", CONFIG_FILE);
-        // Set defaults optimized for Raspberry Pi 5
-        cfg->fan.lv0 = 55.0;
-        cfg->fan.lv1 = 62.0;
-        cfg->fan.lv2 = 70.0;
-        cfg->fan.lv3 = 78.0;
-        
-        cfg->fan_ssd.lv0 = 45.0;
-        cfg->fan_ssd.lv1 = 50.0;
-        cfg->fan_ssd.lv2 = 55.0;
-        cfg->fan_ssd.lv3 = 60.0;
-        
-        cfg->fan_enabled = 1;
-
-        // OLED defaults
-        cfg->oled_rotate = 0;
-
-        // Thermal tunable defaults
-        cfg->thermal.hysteresis_c = 3.0;
-        cfg->thermal.deadband_c = 1.5;
-        cfg->thermal.trend_heat_c = 0.3;
-        cfg->thermal.trend_fast_heat_c = 1.0;
-        cfg->thermal.max_dc_change_per_cycle = 0.10; // legacy cap
-        // New asymmetric/adaptive ramp defaults
-        cfg->thermal.up_rate_base_per_cycle = 0.07;   // 7% per cycle base
-        cfg->thermal.up_rate_trend_gain = 0.20;       // +20% per +1°C trend (responsive to rapid heating)
-        cfg->thermal.up_rate_max_per_cycle = 0.30;    // cap at 30% per cycle
-        cfg->thermal.down_rate_per_cycle = 0.05;      // 5% per cycle down (gentle deceleration)
-        cfg->thermal.cooldown_hold_sec = 20.0;        // 20s hold before decreasing
-        return 0;
+// A value that does not fit its field keeps the default: a cut-off path
+// or socket name would point somewhere else
+static void config_string(char *dst, size_t len, const char *section, const char *key, const char *value) {
+    if (strlen(value) >= len) {
+        fprintf(stderr, "Warning: [%s] %s is longer than %zu characters, ignored\n", section, key, len - 1);
+        return;
     }
-    
-    char line[MAX_LINE];
-    char section[64] = "";
-    char key[64], value[64];
-    
-    // Set defaults first (RPi 5 optimized)
-    cfg->fan.lv0 = 55.0;
-    cfg->fan.lv1 = 62.0;
-    cfg->fan.lv2 = 70.0;
-    cfg->fan.lv3 = 78.0;
-    
-    cfg->fan_ssd.lv0 = 45.0;
-    cfg->fan_ssd.lv1 = 50.0;
-    cfg->fan_ssd.lv2 = 55.0;
-    cfg->fan_ssd.lv3 = 60.0;
-    
+    memcpy(dst, value, strlen(value) + 1);
+}
+
+static void config_set_defaults(config_t *cfg) {
+    fan_profile_t *def = &cfg->profiles[0];
+    snprintf(def->name, sizeof(def->name), "%s", CONFIG_DEFAULT_PROFILE);
+    cfg->profile_count = 1;
+    cfg->active = def;
+
+    // Defaults optimized for Raspberry Pi 5
+    def->fan.lv0 = 55.0;
+    def->fan.lv1 = 62.0;
+    def->fan.lv2 = 70.0;
+    def->fan.lv3 = 78.0;
+
+    def->fan_ssd.lv0 = 45.0;
+    def->fan_ssd.lv1 = 50.0;
+    def->fan_ssd.lv2 = 55.0;
+    def->fan_ssd.lv3 = 60.0;
+
     cfg->fan_enabled = 1;
 
     // OLED defaults
     cfg->oled_rotate = 0;
 
     // Thermal tunable defaults
-    cfg->thermal.hysteresis_c = 3.0;
-    cfg->thermal.deadband_c = 1.5;
-    cfg->thermal.trend_heat_c = 0.3;
-    cfg->thermal.trend_fast_heat_c = 1.0;
-    cfg->thermal.max_dc_change_per_cycle = 0.10; // legacy cap
-    cfg->thermal.up_rate_base_per_cycle = 0.07;
-    cfg->thermal.up_rate_trend_gain = 0.20;
-    cfg->thermal.up_rate_max_per_cycle = 0.30;
-    cfg->thermal.down_rate_per_cycle = 0.05;
-    cfg->thermal.cooldown_hold_sec = 20.0;
+    def->thermal.hysteresis_c = 3.0;
+    def->thermal.deadband_c = 1.5;
+    def->thermal.trend_heat_c = 0.3;
+    def->thermal.trend_fast_heat_c = 1.0;
+    def->thermal.max_dc_change_per_cycle = 0.10; // legacy cap
+    def->thermal.min_effective_dc = 0.0;
+    // Asymmetric/adaptive ramp defaults
+    def->thermal.up_rate_base_per_cycle = 0.07;   // 7% per cycle base
+    def->thermal.up_rate_trend_gain = 0.20;       // +20% per +1°C trend (responsive to rapid heating)
+    def->thermal.up_rate_max_per_cycle = 0.30;    // cap at 30% per cycle
+    def->thermal.down_rate_per_cycle = 0.05;      // 5% per cycle down (gentle deceleration)
+    def->thermal.cooldown_hold_sec = 20.0;        // 20s hold before decreasing
+    // Adaptive control period
+    def->thermal.period_min_sec = 0.5;
+    def->thermal.period_max_sec = 10.0;
+    def->thermal.idle_margin_c = 5.0;
+    def->thermal.idle_after_sec = 60.0;
+
+    // Metrics exporter (opt-in)
+    cfg->metrics_enabled = 0;
+    snprintf(cfg->metrics_listen, sizeof(cfg->metrics_listen), "%s", CONFIG_METRICS_LISTEN);
+
+    // Control socket
+    cfg->ctl_enabled = 1;
+    snprintf(cfg->ctl_socket, sizeof(cfg->ctl_socket), "%s", CTL_SOCKET_PATH);
+
+    // Shared-memory status segment
+    cfg->status_shm_enabled = 1;
+
+    // Flight recorder
+    cfg->flightrec_records = FLIGHTREC_DEFAULT_RECORDS;
+    snprintf(cfg->flightrec_dir, sizeof(cfg->flightrec_dir), "%s", FLIGHTREC_DIR);
+
+    // Compressed history
+    cfg->history_enabled = 1;
+    snprintf(cfg->history_path, sizeof(cfg->history_path), "%s", HISTORY_PATH);
+    cfg->history_size_mb = HISTORY_DEFAULT_SIZE_MB;
+    cfg->history_flush_sec = HISTORY_DEFAULT_FLUSH_SEC;
+
+    // Thermal SLO and fan-usage counters
+    cfg->usage_enabled = 1;
+    snprintf(cfg->usage_path, sizeof(cfg->usage_path), "%s", USAGE_PATH);
+    cfg->usage_checkpoint_sec = USAGE_DEFAULT_CHECKPOINT_SEC;
+
+    // MQTT telemetry (opt-in)
+    cfg->mqtt_enabled = 0;
+    snprintf(cfg->mqtt_broker, sizeof(cfg->mqtt_broker), "127.0.0.1:%d", MQTT_DEFAULT_PORT);
+    cfg->mqtt_client_id[0] = '\0';
+    cfg->mqtt_username[0] = '\0';
+    cfg->mqtt_password[0] = '\0';
+    cfg->mqtt_topic[0] = '\0';
+    cfg->mqtt_discovery = 1;
+    snprintf(cfg->mqtt_discovery_prefix, sizeof(cfg->mqtt_discovery_prefix), "homeassistant");
+    cfg->mqtt_keepalive_sec = MQTT_DEFAULT_KEEPALIVE_SEC;
+    cfg->mqtt_temp_deadband = MQTT_DEFAULT_TEMP_DEADBAND;
+    cfg->mqtt_duty_deadband = MQTT_DEFAULT_DUTY_DEADBAND;
+    cfg->smart_health_interval_sec = SSD_HEALTH_INTERVAL_SEC;
+    cfg->smart_json = 0;
+    cfg->sensors_io_uring = 0;
+    cfg->controller_plugin[0] = '\0';
+    cfg->controller_config[0] = '\0';
+
+    // Ambient compensation (off until a source is set)
+    cfg->ambient_source[0] = '\0';
+    cfg->ambient_interval_sec = AMBIENT_DEFAULT_INTERVAL_SEC;
+    cfg->ambient_drive_offset = AMBIENT_DEFAULT_DRIVE_OFFSET;
+    cfg->ambient_reference = AMBIENT_DEFAULT_REFERENCE;
+    cfg->ambient_relative = 0;
+    cfg->ambient_rate_gain = AMBIENT_DEFAULT_RATE_GAIN;
+
+    // Logging
+    snprintf(cfg->log_level, sizeof(cfg->log_level), "auto");
+    cfg->log_journal = -1;
+    snprintf(cfg->log_journal_socket, sizeof(cfg->log_journal_socket), "%s", LOGGER_JOURNAL_SOCKET);
+
+    // Self-overhead budget
+    cfg->budget_cpu_percent = BUDGET_DEFAULT_CPU_PERCENT;
+
+    // Shadow controller (off unless a config is given)
+    cfg->shadow_config[0] = '\0';
+    cfg->shadow_divergence = SHADOW_DEFAULT_DIVERGENCE;
+}
+
+static int parse_bool(const char *value) {
+    return (strcmp(value, "true") == 0 || strcmp(value, "1") == 0 ||
+            strcmp(value, "yes") == 0 || strcmp(value, "on") == 0) ? 1 : 0;
+}
+
+static int parse_fan_key(fan_config_t *f, const char *key, const char *value) {
+    if (strcmp(key, "lv0") == 0) f->lv0 = strtod(value, NULL);
+    else if (strcmp(key, "lv1") == 0) f->lv1 = strtod(value, NULL);
+    else if (strcmp(key, "lv2") == 0) f->lv2 = strtod(value, NULL);
+    else if (strcmp(key, "lv3") == 0) f->lv3 = strtod(value, NULL);
+    else return -1;
+    return 0;
+}
+
+static int parse_thermal_key(thermal_tunables_t *t, const char *key, const char *value) {
+    if (strcmp(key, "hysteresis") == 0) t->hysteresis_c = strtod(value, NULL);
+    else if (strcmp(key, "deadband") == 0) t->deadband_c = strtod(value, NULL);
+    else if (strcmp(key, "trend_heat") == 0) t->trend_heat_c = strtod(value, NULL);
+    else if (strcmp(key, "trend_fast_heat") == 0) t->trend_fast_heat_c = strtod(value, NULL);
+    else if (strcmp(key, "max_dc_change") == 0) t->max_dc_change_per_cycle = strtod(value, NULL);
+    else if (strcmp(key, "up_rate_base") == 0) t->up_rate_base_per_cycle = strtod(value, NULL);
+    else if (strcmp(key, "up_rate_trend_gain") == 0) t->up_rate_trend_gain = strtod(value, NULL);
+    else if (strcmp(key, "up_rate_max") == 0) t->up_rate_max_per_cycle = strtod(value, NULL);
+    else if (strcmp(key, "down_rate") == 0) t->down_rate_per_cycle = strtod(value, NULL);
+    else if (strcmp(key, "cooldown_hold_sec") == 0) t->cooldown_hold_sec = strtod(value, NULL);
+    else if (strcmp(key, "period_min") == 0) t->period_min_sec = strtod(value, NULL);
+    else if (strcmp(key, "period_max") == 0) t->period_max_sec = strtod(value, NULL);
+    else if (strcmp(key, "idle_margin") == 0) t->idle_margin_c = strtod(value, NULL);
+    else if (strcmp(key, "idle_after_sec") == 0) t->idle_after_sec = strtod(value, NULL);
+    else return -1;
+    return 0;
+}
+
+// Profile and schedule lines are applied once the whole file is read, so a
+// profile inherits the final "default" values wherever its section appears.
+#define CONFIG_MAX_PROFILE_KEYS 96
+
+typedef struct {
+    struct {
+        int profile;
+        char key[32];
+        char value[32];
+    } keys[CONFIG_MAX_PROFILE_KEYS];
+    int key_count;
+    struct {
+        int minute;
+        char profile[CONFIG_PROFILE_NAME_LEN];
+    } schedule[CONFIG_MAX_SCHEDULE];
+    int schedule_count;
+} config_pending_t;
+
+int config_find_unit(const config_t *cfg, const char *name) {
+    for (int i = 0; i < cfg->unit_count; i++) {
+        if (strcmp(cfg->units[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static void unit_defaults(unit_config_t *u, const char *name) {
+    memset(u, 0, sizeof(unit_config_t));
+    snprintf(u->name, sizeof(u->name), "%s", name);
+    u->fan = UNIT_FAN_NONE;
+    u->fan_line = 27;
+    u->oled_bus = OLED_I2C_BUS;
+    u->oled_addr = OLED_I2C_ADDR;
+    u->oled_rotate = -1;
+    u->button_chip = -1;
+    u->button_line = -1;
+    u->cpu = 1;
+    u->disks = (1u << SSD_DEVICE_COUNT) - 1u;
+}
+
+// "all", "none" or a comma list of device names (sda,sdc)
+static int parse_disks(const char *value, unsigned int *mask) {
+    if (strcmp(value, "all") == 0) {
+        *mask = (1u << SSD_DEVICE_COUNT) - 1u;
+        return 0;
+    }
+    *mask = 0;
+    if (strcmp(value, "none") == 0) return 0;
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", value);
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, ", ", &save); tok; tok = strtok_r(NULL, ", ", &save)) {
+        size_t i = 0;
+        while (i < SSD_DEVICE_COUNT && strcmp(tok, thermal_ssd_device_name(i)) != 0) i++;
+        if (i == SSD_DEVICE_COUNT) return -1;
+        *mask |= 1u << i;
+    }
+    return 0;
+}
+
+static void unit_key(config_t *cfg, const char *name, const char *key, const char *value) {
+    int idx = config_find_unit(cfg, name);
+    if (idx < 0) {
+        if (strlen(name) == 0 || strlen(name) >= CONFIG_UNIT_NAME_LEN || cfg->unit_count >= CONFIG_MAX_UNITS) {
+            fprintf(stderr, "Warning: Ignoring unit '%s' (empty, too long or too many units)\n", name);
+            return;
+        }
+        idx = cfg->unit_count++;
+        unit_defaults(&cfg->units[idx], name);
+    }
+    unit_config_t *u = &cfg->units[idx];
+
+    if (strcmp(key, "fan") == 0) {
+        if (strcmp(value, "gpio") == 0) u->fan = UNIT_FAN_GPIO;
+        else if (strcmp(value, "pwm") == 0) u->fan = UNIT_FAN_PWM;
+        else if (strcmp(value, "none") == 0) u->fan = UNIT_FAN_NONE;
+        else fprintf(stderr, "Warning: [unit.%s] fan must be gpio, pwm or none\n", name);
+    } else if (strcmp(key, "disks") == 0) {
+        if (parse_disks(value, &u->disks) < 0) {
+            fprintf(stderr, "Warning: [unit.%s] bad disks '%s', using all\n", name, value);
+            u->disks = (1u << SSD_DEVICE_COUNT) - 1u;
+        }
+    } else if (strcmp(key, "fan_chip") == 0) u->fan_chip = atoi(value);
+    else if (strcmp(key, "fan_line") == 0) u->fan_line = atoi(value);
+    else if (strcmp(key, "pwm_chip") == 0) u->pwm_chip = atoi(value);
+    else if (strcmp(key, "pwm_channel") == 0) u->pwm_channel = atoi(value);
+    else if (strcmp(key, "oled") == 0) u->oled = parse_bool(value);
+    else if (strcmp(key, "oled_bus") == 0) u->oled_bus = atoi(value);
+    else if (strcmp(key, "oled_addr") == 0) u->oled_addr = (int)strtol(value, NULL, 0);
+    else if (strcmp(key, "oled_rotate") == 0) u->oled_rotate = parse_bool(value);
+    else if (strcmp(key, "button_chip") == 0) u->button_chip = atoi(value);
+    else if (strcmp(key, "button_line") == 0) u->button_line = atoi(value);
+    else if (strcmp(key, "cpu") == 0) u->cpu = parse_bool(value);
+    else fprintf(stderr, "Warning: Unknown key '%s' in [unit.%s]\n", key, name);
+}
+
+static int env_int(const char *name, int fallback) {
+    const char *v = getenv(name);
+    return v ? atoi(v) : fallback;
+}
+
+// Without [unit.*] sections: the single HAT described by the environment
+// file, exactly as before units existed. Then drop hardware claimed twice.
+static void units_resolve(config_t *cfg) {
+    if (cfg->unit_count == 0) {
+        unit_config_t *u = &cfg->units[0];
+        unit_defaults(u, CONFIG_DEFAULT_UNIT);
+        const char *hwpwm = getenv("HARDWARE_PWM");
+        u->fan = (hwpwm && strcmp(hwpwm, "1") == 0) ? UNIT_FAN_PWM : UNIT_FAN_GPIO;
+        u->pwm_chip = env_int("PWMCHIP", 0);
+        u->pwm_channel = env_int("PWMCHAN", 0);
+        u->fan_chip = env_int("FAN_CHIP", 0);
+        u->fan_line = env_int("FAN_LINE", 27);
+        u->oled = 1;
+        if (getenv("BUTTON_CHIP") && getenv("BUTTON_LINE")) {
+            u->button_chip = env_int("BUTTON_CHIP", -1);
+            u->button_line = env_int("BUTTON_LINE", -1);
+        }
+        cfg->unit_count = 1;
+    }
+
+    for (int i = 0; i < cfg->unit_count; i++) {
+        unit_config_t *u = &cfg->units[i];
+        if (u->oled_rotate < 0) u->oled_rotate = cfg->oled_rotate;
+        for (int j = 0; j < i; j++) {
+            const unit_config_t *o = &cfg->units[j];
+            if (u->fan == UNIT_FAN_GPIO && o->fan == UNIT_FAN_GPIO &&
+                u->fan_chip == o->fan_chip && u->fan_line == o->fan_line) {
+                fprintf(stderr, "Warning: [unit.%s] fan line %d:%d already belongs to unit '%s'\n",
+                        u->name, u->fan_chip, u->fan_line, o->name);
+                u->fan = UNIT_FAN_NONE;
+            }
+            if (u->fan == UNIT_FAN_PWM && o->fan == UNIT_FAN_PWM &&
+                u->pwm_chip == o->pwm_chip && u->pwm_channel == o->pwm_channel) {
+                fprintf(stderr, "Warning: [unit.%s] pwmchip%d/pwm%d already belongs to unit '%s'\n",
+                        u->name, u->pwm_chip, u->pwm_channel, o->name);
+                u->fan = UNIT_FAN_NONE;
+            }
+            if (u->oled && o->oled && u->oled_bus == o->oled_bus && u->oled_addr == o->oled_addr) {
+                fprintf(stderr, "Warning: [unit.%s] display %d:0x%02X already belongs to unit '%s'\n",
+                        u->name, u->oled_bus, u->oled_addr, o->name);
+                u->oled = 0;
+            }
+        }
+    }
+}
+
+int config_find_profile(const config_t *cfg, const char *name) {
+    for (int i = 0; i < cfg->profile_count; i++) {
+        if (strcmp(cfg->profiles[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static void profile_key_defer(config_t *cfg, config_pending_t *p, const char *name, const char *key, const char *value) {
+    int idx = config_find_profile(cfg, name);
+    if (idx < 0) {
+        if (strlen(name) == 0 || strlen(name) >= CONFIG_PROFILE_NAME_LEN || cfg->profile_count >= CONFIG_MAX_PROFILES) {
+            fprintf(stderr, "Warning: Ignoring profile '%s' (empty, too long or too many profiles)\n", name);
+            return;
+        }
+        idx = cfg->profile_count++;
+        snprintf(cfg->profiles[idx].name, sizeof(cfg->profiles[idx].name), "%s", name);
+    }
+    if (idx == 0) {
+        fprintf(stderr, "Warning: [profile.%s] is built from [fan]/[fan_ssd]/[thermal]; ignoring %s\n", name, key);
+        return;
+    }
+    if (p->key_count >= CONFIG_MAX_PROFILE_KEYS) {
+        fprintf(stderr, "Warning: Too many profile keys, ignoring %s\n", key);
+        return;
+    }
+    p->keys[p->key_count].profile = idx;
+    snprintf(p->keys[p->key_count].key, sizeof(p->keys[p->key_count].key), "%s", key);
+    snprintf(p->keys[p->key_count].value, sizeof(p->keys[p->key_count].value), "%s", value);
+    p->key_count++;
+}
+
+static void schedule_defer(config_pending_t *p, const char *key, const char *value) {
+    int hh, mm;
+    char extra;
+    if (sscanf(key, "%d:%d%c", &hh, &mm, &extra) != 2 || hh < 0 || hh > 23 || mm < 0 || mm > 59) {
+        fprintf(stderr, "Warning: Bad schedule time '%s' (expected HH:MM)\n", key);
+        return;
+    }
+    if (p->schedule_count >= CONFIG_MAX_SCHEDULE) {
+        fprintf(stderr, "Warning: Too many schedule entries, ignoring %s\n", key);
+        return;
+    }
+    p->schedule[p->schedule_count].minute = hh * 60 + mm;
+    snprintf(p->schedule[p->schedule_count].profile, sizeof(p->schedule[p->schedule_count].profile), "%s", value);
+    p->schedule_count++;
+}
+
+static void profiles_resolve(config_t *cfg, const config_pending_t *p) {
+    for (int i = 1; i < cfg->profile_count; i++) {
+        fan_profile_t *prof = &cfg->profiles[i];
+        char name[CONFIG_PROFILE_NAME_LEN];
+        memcpy(name, prof->name, sizeof(name));
+        *prof = cfg->profiles[0];
+        memcpy(prof->name, name, sizeof(name));
+    }
+
+    for (int k = 0; k < p->key_count; k++) {
+        fan_profile_t *prof = &cfg->profiles[p->keys[k].profile];
+        const char *key = p->keys[k].key;
+        int rc;
+        if (strncmp(key, "ssd_", 4) == 0) {
+            rc = parse_fan_key(&prof->fan_ssd, key + 4, p->keys[k].value);
+        } else if (parse_fan_key(&prof->fan, key, p->keys[k].value) == 0) {
+            rc = 0;
+        } else {
+            rc = parse_thermal_key(&prof->thermal, key, p->keys[k].value);
+        }
+        if (rc < 0) {
+            fprintf(stderr, "Warning: Unknown key '%s' in [profile.%s]\n", key, prof->name);
+        }
+    }
+
+    // Sorted by time of day (insertion sort, at most CONFIG_MAX_SCHEDULE entries)
+    cfg->schedule_count = 0;
+    for (int i = 0; i < p->schedule_count; i++) {
+        int idx = config_find_profile(cfg, p->schedule[i].profile);
+        if (idx < 0) {
+            fprintf(stderr, "Warning: Schedule refers to unknown profile '%s'\n", p->schedule[i].profile);
+            continue;
+        }
+        int j = cfg->schedule_count++;
+        while (j > 0 && cfg->schedule[j - 1].minute > p->schedule[i].minute) {
+            cfg->schedule[j] = cfg->schedule[j - 1];
+            j--;
+        }
+        cfg->schedule[j].minute = p->schedule[i].minute;
+        cfg->schedule[j].profile = idx;
+    }
+}
+
+int config_load(config_t *cfg) {
+    return config_load_file(cfg, CONFIG_FILE);
+}
+
+void config_changed(config_t *cfg) {
+    // Process-wide, so a config reloaded at the same address still changes
+    static unsigned int generation;
+    cfg->generation = ++generation;
+}
+
+int config_load_file(config_t *cfg, const char *path) {
+    memset(cfg, 0, sizeof(config_t));
+    config_set_defaults(cfg);
+    config_changed(cfg);
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Warning: Cannot open config file %s, using defaults\n", path);
+        units_resolve(cfg);
+        return 0;
+    }
+    
+    char line[MAX_LINE];
+    char section[MAX_LINE] = "";
+    char key[MAX_LINE], value[MAX_LINE];
+    static config_pending_t pending;
+    memset(&pending, 0, sizeof(pending));
     
     while (fgets(line, sizeof(line), fp)) {
         int result = parse_line(line, section, key, value);
         
         if (result == 2) { // Key-value pair
             if (strcmp(section, "fan") == 0) {
-                if (strcmp(key, "lv0") == 0) cfg->fan.lv0 = strtod(value, NULL);
-                else if (strcmp(key, "lv1") == 0) cfg->fan.lv1 = strtod(value, NULL);
-                else if (strcmp(key, "lv2") == 0) cfg->fan.lv2 = strtod(value, NULL);
-                else if (strcmp(key, "lv3") == 0) cfg->fan.lv3 = strtod(value, NULL);
+                parse_fan_key(&cfg->profiles[0].fan, key, value);
             } else if (strcmp(section, "fan_ssd") == 0) {
-                if (strcmp(key, "lv0") == 0) cfg->fan_ssd.lv0 = strtod(value, NULL);
-                else if (strcmp(key, "lv1") == 0) cfg->fan_ssd.lv1 = strtod(value, NULL);
-                else if (strcmp(key, "lv2") == 0) cfg->fan_ssd.lv2 = strtod(value, NULL);
-                else if (strcmp(key, "lv3") == 0) cfg->fan_ssd.lv3 = strtod(value, NULL);
+                parse_fan_key(&cfg->profiles[0].fan_ssd, key, value);
             } else if (strcmp(section, "thermal") == 0) {
-                if (strcmp(key, "hysteresis") == 0) cfg->thermal.hysteresis_c = strtod(value, NULL);
-                else if (strcmp(key, "deadband") == 0) cfg->thermal.deadband_c = strtod(value, NULL);
-                else if (strcmp(key, "trend_heat") == 0) cfg->thermal.trend_heat_c = strtod(value, NULL);
-                else if (strcmp(key, "trend_fast_heat") == 0) cfg->thermal.trend_fast_heat_c = strtod(value, NULL);
-                else if (strcmp(key, "max_dc_change") == 0) cfg->thermal.max_dc_change_per_cycle = strtod(value, NULL);
-                else if (strcmp(key, "up_rate_base") == 0) cfg->thermal.up_rate_base_per_cycle = strtod(value, NULL);
-                else if (strcmp(key, "up_rate_trend_gain") == 0) cfg->thermal.up_rate_trend_gain = strtod(value, NULL);
-                else if (strcmp(key, "up_rate_max") == 0) cfg->thermal.up_rate_max_per_cycle = strtod(value, NULL);
-                else if (strcmp(key, "down_rate") == 0) cfg->thermal.down_rate_per_cycle = strtod(value, NULL);
-                else if (strcmp(key, "cooldown_hold_sec") == 0) cfg->thermal.cooldown_hold_sec = strtod(value, NULL);
+                parse_thermal_key(&cfg->profiles[0].thermal, key, value);
+            } else if (strncmp(section, "profile.", 8) == 0) {
+                profile_key_defer(cfg, &pending, section + 8, key, value);
+            } else if (strcmp(section, "schedule") == 0) {
+                schedule_defer(&pending, key, value);
+            } else if (strncmp(section, "unit.", 5) == 0) {
+                unit_key(cfg, section + 5, key, value);
+            } else if (strcmp(section, "metrics") == 0) {
+                if (strcmp(key, "enabled") == 0) cfg->metrics_enabled = parse_bool(value);
+                else if (strcmp(key, "listen") == 0) config_string(cfg->metrics_listen, sizeof(cfg->metrics_listen), section, key, value);
+            } else if (strcmp(section, "control") == 0) {
+                if (strcmp(key, "enabled") == 0) cfg->ctl_enabled = parse_bool(value);
+                else if (strcmp(key, "socket") == 0) config_string(cfg->ctl_socket, sizeof(cfg->ctl_socket), section, key, value);
+            } else if (strcmp(section, "status") == 0) {
+                if (strcmp(key, "shm") == 0) cfg->status_shm_enabled = parse_bool(value);
+            } else if (strcmp(section, "flightrec") == 0) {
+                if (strcmp(key, "records") == 0) cfg->flightrec_records = atoi(value);
+                else if (strcmp(key, "dir") == 0) config_string(cfg->flightrec_dir, sizeof(cfg->flightrec_dir), section, key, value);
+            } else if (strcmp(section, "history") == 0) {
+                if (strcmp(key, "enabled") == 0) cfg->history_enabled = parse_bool(value);
+                else if (strcmp(key, "path") == 0) config_string(cfg->history_path, sizeof(cfg->history_path), section, key, value);
+                else if (strcmp(key, "size_mb") == 0) cfg->history_size_mb = atoi(value);
+                else if (strcmp(key, "flush_sec") == 0) cfg->history_flush_sec = atoi(value);
+            } else if (strcmp(section, "usage") == 0) {
+                if (strcmp(key, "enabled") == 0) cfg->usage_enabled = parse_bool(value);
+                else if (strcmp(key, "path") == 0) config_string(cfg->usage_path, sizeof(cfg->usage_path), section, key, value);
+                else if (strcmp(key, "checkpoint_sec") == 0) cfg->usage_checkpoint_sec = atoi(value);
+            } else if (strcmp(section, "mqtt") == 0) {
+                if (strcmp(key, "enabled") == 0) cfg->mqtt_enabled = parse_bool(value);
+                else if (strcmp(key, "broker") == 0) config_string(cfg->mqtt_broker, sizeof(cfg->mqtt_broker), section, key, value);
+                else if (strcmp(key, "client_id") == 0) config_string(cfg->mqtt_client_id, sizeof(cfg->mqtt_client_id), section, key, value);
+                else if (strcmp(key, "username") == 0) config_string(cfg->mqtt_username, sizeof(cfg->mqtt_username), section, key, value);
+                else if (strcmp(key, "password") == 0) config_string(cfg->mqtt_password, sizeof(cfg->mqtt_password), section, key, value);
+                else if (strcmp(key, "topic") == 0) config_string(cfg->mqtt_topic, sizeof(cfg->mqtt_topic), section, key, value);
+                else if (strcmp(key, "discovery") == 0) cfg->mqtt_discovery = parse_bool(value);
+                else if (strcmp(key, "discovery_prefix") == 0) config_string(cfg->mqtt_discovery_prefix, sizeof(cfg->mqtt_discovery_prefix), section, key, value);
+                else if (strcmp(key, "keepalive_sec") == 0) cfg->mqtt_keepalive_sec = atoi(value);
+                else if (strcmp(key, "temp_deadband") == 0) cfg->mqtt_temp_deadband = strtod(value, NULL);
+                else if (strcmp(key, "duty_deadband") == 0) cfg->mqtt_duty_deadband = strtod(value, NULL);
+            } else if (strcmp(section, "log") == 0) {
+                if (strcmp(key, "level") == 0) config_string(cfg->log_level, sizeof(cfg->log_level), section, key, value);
+                else if (strcmp(key, "journal") == 0) cfg->log_journal = (strcmp(value, "auto") == 0) ? -1 : parse_bool(value);
+                else if (strcmp(key, "journal_socket") == 0) config_string(cfg->log_journal_socket, sizeof(cfg->log_journal_socket), section, key, value);
+            } else if (strcmp(section, "budget") == 0) {
+                if (strcmp(key, "cpu_percent") == 0) cfg->budget_cpu_percent = atof(value);
+            } else if (strcmp(section, "shadow") == 0) {
+                if (strcmp(key, "config") == 0) config_string(cfg->shadow_config, sizeof(cfg->shadow_config), section, key, value);
+                else if (strcmp(key, "divergence") == 0) cfg->shadow_divergence = atof(value);
+            } else if (strcmp(section, "smart") == 0) {
+                if (strcmp(key, "health_interval_sec") == 0) cfg->smart_health_interval_sec = atoi(value);
+                else if (strcmp(key, "json") == 0) cfg->smart_json = parse_bool(value);
+            } else if (strcmp(section, "sensors") == 0) {
+                if (strcmp(key, "io_uring") == 0) cfg->sensors_io_uring = parse_bool(value);
+            } else if (strcmp(section, "controller") == 0) {
+                if (strcmp(key, "plugin") == 0) config_string(cfg->controller_plugin, sizeof(cfg->controller_plugin), section, key, value);
+                else if (strcmp(key, "config") == 0) config_string(cfg->controller_config, sizeof(cfg->controller_config), section, key, value);
+            } else if (strcmp(section, "ambient") == 0) {
+                if (strcmp(key, "source") == 0) config_string(cfg->ambient_source, sizeof(cfg->ambient_source), section, key, value);
+                else if (strcmp(key, "interval_sec") == 0) cfg->ambient_interval_sec = atoi(value);
+                else if (strcmp(key, "drive_offset") == 0) cfg->ambient_drive_offset = atof(value);
+                else if (strcmp(key, "reference") == 0) cfg->ambient_reference = atof(value);
+                else if (strcmp(key, "relative") == 0) cfg->ambient_relative = parse_bool(value);
+                else if (strcmp(key, "rate_gain") == 0) cfg->ambient_rate_gain = atof(value);
             } else if (strcmp(section, "oled") == 0) {
                 if (strcmp(key, "rotate") == 0) {
                     cfg->oled_rotate = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0) ? 1 : 0;
@@ -159,6 +566,15 @@ int config_load(config_t *cfg) {
     }
     
     fclose(fp);
+    profiles_resolve(cfg, &pending);
+    units_resolve(cfg);
+
+    // The drives baseline warms with the drives' own load; thresholds on it
+    // would rise with that load and slow the fan that cools them
+    if (cfg->ambient_relative && strcmp(cfg->ambient_source, AMBIENT_SOURCE_DRIVES) == 0) {
+        fprintf(stderr, "Warning: [ambient] relative needs an air sensor, not drives; using absolute curves\n");
+        cfg->ambient_relative = 0;
+    }
 
     return 0;
 }
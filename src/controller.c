@@ -0,0 +1,263 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <dlfcn.h>
+#include "controller.h"
+#include "timebase.h"
+#include "logger.h"
+
+_Static_assert(MAX_DEVICES <= CONTROLLER_MAX_SSD, "controller input cannot carry every drive slot");
+
+// What the built-in serializes (diagnostics only, host byte order)
+typedef struct {
+    double dc_target;
+    double cpu_avg;
+    double cpu_trend;
+    double ssd_trend;
+    double stable_sec;
+    int32_t ssd_avg;
+    int32_t hold_active;
+    int32_t deadband_active;
+} builtin_snapshot_t;
+
+static int builtin_init(void *state, const char *config, size_t config_len) {
+    if (config_len != sizeof(controller_builtin_t)) return -1;
+    memcpy(state, config, sizeof(controller_builtin_t));
+    return 0;
+}
+
+static double builtin_step(void *state, const controller_input_t *in, double dt_sec) {
+    (void)in;       // Readings come in the state, as read
+    (void)dt_sec;   // The law keeps its own clock (thermal_step_interval)
+    controller_builtin_t *b = state;
+    return thermal_control_step(b->cfg, b->ts, b->cpu_mc, b->ssd_temps, b->ssd_count);
+}
+
+static size_t builtin_serialize(const void *state, void *buf, size_t len) {
+    const thermal_state_t *ts = ((const controller_builtin_t *)state)->ts;
+    builtin_snapshot_t s;
+    memset(&s, 0, sizeof(s));
+    s.dc_target = ts->dc_target;
+    s.cpu_avg = ts->cpu_avg;
+    s.cpu_trend = ts->cpu_trend;
+    s.ssd_trend = ts->ssd_trend;
+    s.stable_sec = ts->stable_sec;
+    s.ssd_avg = ts->ssd_avg;
+    s.hold_active = ts->hold_active;
+    s.deadband_active = ts->deadband_active;
+    if (len < sizeof(s)) return 0;
+    memcpy(buf, &s, sizeof(s));
+    return sizeof(s);
+}
+
+static const controller_plugin_t builtin_plugin = {
+    .abi_version = CONTROLLER_ABI_VERSION,
+    .name = "builtin",
+    .state_size = sizeof(controller_builtin_t),
+    .init = builtin_init,
+    .step = builtin_step,
+    .serialize = builtin_serialize,
+};
+
+static void controller_use_builtin(controller_t *c, config_t *cfg, thermal_state_t *ts) {
+    controller_builtin_t init = { cfg, ts, 0, NULL, 0 };
+    builtin_plugin.init(&c->builtin_state, (const char *)&init, sizeof(init));
+    c->ops = &builtin_plugin;
+    c->state = &c->builtin_state;
+    c->builtin = 1;
+}
+
+// Whole file, NUL-terminated; *len excludes the terminator
+static char *read_config_blob(const char *path, size_t *len) {
+    *len = 0;
+    char *blob = calloc(1, CONTROLLER_CONFIG_MAX + 1);
+    if (!blob) return NULL;
+    if (!path[0]) return blob;
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Warning: Cannot read controller config %s: %s\n", path, strerror(errno));
+        free(blob);
+        return NULL;
+    }
+    *len = fread(blob, 1, CONTROLLER_CONFIG_MAX, fp);
+    if (fgetc(fp) != EOF) {
+        fprintf(stderr, "Warning: Controller config %s is larger than %d bytes\n", path, CONTROLLER_CONFIG_MAX);
+        fclose(fp);
+        free(blob);
+        return NULL;
+    }
+    fclose(fp);
+    return blob;
+}
+
+static int controller_open_plugin(controller_t *c, const config_t *cfg, const char *label) {
+    const char *path = cfg->controller_plugin;
+    c->dl = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!c->dl) {
+        fprintf(stderr, "Warning: [%s] Cannot load controller plugin: %s\n", label, dlerror());
+        return -1;
+    }
+
+    // POSIX guarantees data/function pointer round trips through dlsym
+    controller_plugin_entry_t entry;
+    void *sym = dlsym(c->dl, CONTROLLER_PLUGIN_SYMBOL);
+    memcpy(&entry, &sym, sizeof(entry));
+    const controller_plugin_t *ops = entry ? entry() : NULL;
+    if (!ops) {
+        fprintf(stderr, "Warning: [%s] %s does not export %s\n", label, path, CONTROLLER_PLUGIN_SYMBOL);
+        return -1;
+    }
+    if (ops->abi_version != CONTROLLER_ABI_VERSION) {
+        fprintf(stderr, "Warning: [%s] %s was built for controller ABI %u, this daemon speaks %d\n",
+                label, path, ops->abi_version, CONTROLLER_ABI_VERSION);
+        return -1;
+    }
+    if (!ops->step || ops->state_size > CONTROLLER_STATE_MAX) {
+        fprintf(stderr, "Warning: [%s] %s: missing step() or state larger than %d bytes\n",
+                label, path, CONTROLLER_STATE_MAX);
+        return -1;
+    }
+
+    // At least one byte so a stateless plugin still gets a valid pointer
+    c->state = calloc(1, ops->state_size ? ops->state_size : 1);
+    if (!c->state) {
+        fprintf(stderr, "Warning: [%s] Cannot allocate %zu bytes of controller state\n", label, ops->state_size);
+        return -1;
+    }
+
+    size_t len;
+    char *blob = read_config_blob(cfg->controller_config, &len);
+    if (!blob) return -1;
+    int rc = ops->init ? ops->init(c->state, blob, len) : 0;
+    free(blob);
+    if (rc != 0) {
+        fprintf(stderr, "Warning: [%s] %s init failed (%d)\n", label, path, rc);
+        return -1;
+    }
+    c->ops = ops;
+    return 0;
+}
+
+int controller_load(controller_t *c, config_t *cfg, thermal_state_t *ts, const char *label) {
+    memset(c, 0, sizeof(controller_t));
+    c->thermal = ts;
+    if (!label) label = "main";
+
+    if (!cfg->controller_plugin[0]) {
+        controller_use_builtin(c, cfg, ts);
+        return 0;
+    }
+    if (controller_open_plugin(c, cfg, label) == 0) {
+        logger_log(LOGGER_INFO, NULL, "[%s] Controller plugin '%s' from %s",
+                   label, c->ops->name ? c->ops->name : "?", cfg->controller_plugin);
+        return 0;
+    }
+
+    controller_unload(c);
+    fprintf(stderr, "Warning: [%s] Falling back to the built-in controller\n", label);
+    controller_use_builtin(c, cfg, ts);
+    return -1;
+}
+
+static void controller_fill_input(controller_t *c, const config_t *cfg, double cpu_temp,
+                                  const int *ssd_temps, int ssd_count) {
+    const thermal_state_t *ts = c->thermal;
+    fan_config_t cpu_curve, ssd_curve;
+    thermal_curves(cfg, cfg->active, c->thermal, &cpu_curve, &ssd_curve);
+    controller_input_t *in = &c->in;
+
+    in->now = timebase_mono_sec();
+    in->cpu_temp = cpu_temp;
+    in->cpu_avg = ts->cpu_avg;
+    in->cpu_trend = ts->cpu_trend;
+    for (int i = 0; i < CONTROLLER_MAX_SSD; i++) {
+        in->ssd_temps[i] = i < MAX_DEVICES ? ssd_temps[i] : 0;
+    }
+    in->ssd_count = (uint32_t)ssd_count;
+    in->ssd_avg = ts->ssd_avg;
+    in->ssd_trend = ts->ssd_trend;
+    in->cpu_levels[0] = cpu_curve.lv0;
+    in->cpu_levels[1] = cpu_curve.lv1;
+    in->cpu_levels[2] = cpu_curve.lv2;
+    in->cpu_levels[3] = cpu_curve.lv3;
+    in->ssd_levels[0] = ssd_curve.lv0;
+    in->ssd_levels[1] = ssd_curve.lv1;
+    in->ssd_levels[2] = ssd_curve.lv2;
+    in->ssd_levels[3] = ssd_curve.lv3;
+    in->last_duty = c->last_duty;
+}
+
+double controller_step(controller_t *c, config_t *cfg, int32_t cpu_mc, const int *ssd_temps, int ssd_count) {
+    double dt = THERMAL_REFERENCE_PERIOD_SEC;
+    if (c->builtin) {
+        c->builtin_state.cpu_mc = cpu_mc;
+        c->builtin_state.ssd_temps = ssd_temps;
+        c->builtin_state.ssd_count = ssd_count;
+    } else {
+        double cpu_temp = (double)cpu_mc / 1000.0;
+        thermal_observe(cfg, c->thermal, cpu_temp, ssd_temps, ssd_count);
+        dt = c->thermal->step_sec;
+        controller_fill_input(c, cfg, cpu_temp, ssd_temps, ssd_count);
+    }
+
+    uint64_t start = timebase_raw_ns();
+    double dc = c->ops->step(c->state, &c->in, dt);
+    uint64_t took = timebase_raw_ns() - start;
+
+    c->steps++;
+    if (took > c->max_step_ns) c->max_step_ns = took;
+    if (took > CONTROLLER_STEP_BUDGET_NS && c->slow_steps++ == 0) {
+        logger_log(LOGGER_WARNING, NULL, "Warning: Controller '%s' step took %.0f us (budget %.0f us)",
+                   c->ops->name ? c->ops->name : "?", (double)took / 1e3, (double)CONTROLLER_STEP_BUDGET_NS / 1e3);
+    }
+
+    // A broken plugin must not stop the fan: NaN means full speed
+    if (isnan(dc) || dc < 0.0 || dc > 1.0) {
+        if (c->bad_outputs++ == 0) {
+            logger_log(LOGGER_WARNING, NULL, "Warning: Controller '%s' returned duty %g, clamping",
+                       c->ops->name ? c->ops->name : "?", dc);
+        }
+        dc = isnan(dc) ? 1.0 : dc < 0.0 ? 0.0 : 1.0;
+    }
+
+    // Thermal emergency floor: whatever a plugin decides, a sensor at lv3
+    // runs the fan flat out, as the built-in law does (and 100% also
+    // makes the daemon ignore manual and boost overrides)
+    if (!c->builtin && dc < 1.0) {
+        int cpu_critical, ssd_critical;
+        thermal_curve_critical(cfg, c->thermal, &cpu_critical, &ssd_critical);
+        if (cpu_critical || ssd_critical) {
+            if (c->forced_steps++ == 0) {
+                logger_log(LOGGER_WARNING, NULL, "Warning: Controller '%s' returned duty %.2f at lv3, forcing 100%%",
+                           c->ops->name ? c->ops->name : "?", dc);
+            }
+            dc = 1.0;
+        }
+    }
+
+    if (!c->builtin) thermal_record_duty(c->thermal, dc);
+    c->last_duty = dc;
+    return dc;
+}
+
+size_t controller_serialize(const controller_t *c, void *buf, size_t len) {
+    if (!c->ops || !c->ops->serialize) return 0;
+    size_t n = c->ops->serialize(c->state, buf, len);
+    return n > len ? len : n;
+}
+
+void controller_unload(controller_t *c) {
+    if (!c->builtin) free(c->state);
+    c->state = NULL;
+    if (c->dl) dlclose(c->dl);
+    c->dl = NULL;
+    c->ops = NULL;
+}
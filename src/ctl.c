@@ -0,0 +1,251 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include "ctl.h"
+#include "netutil.h"
+
+// Room kept free at the end of the output buffer for the final status line
+#define CTL_STATUS_RESERVE 64
+
+int ctl_init(ctl_server_t *ctl, const char *path, ctl_handler_fn handler, void *ctx) {
+    memset(ctl, 0, sizeof(ctl_server_t));
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++) {
+        ctl->clients[i].fd = -1;
+    }
+    ctl->handler = handler;
+    ctl->handler_ctx = ctx;
+
+    char spec[128];
+    snprintf(spec, sizeof(spec), "unix:%s", path);
+    ctl->listen_fd = netutil_listen(spec, ctl->path, sizeof(ctl->path));
+    if (ctl->listen_fd < 0) {
+        return -1;
+    }
+
+    // Overrides can drive the fan, so keep the socket root-only
+    chmod(ctl->path, 0600);
+
+    printf("Control socket listening on %s\n", ctl->path);
+    return 0;
+}
+
+static void client_close(ctl_client_t *c) {
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    c->fd = -1;
+    c->in_len = 0;
+    c->discarding = 0;
+    c->out_len = 0;
+    c->out_off = 0;
+}
+
+void ctl_cleanup(ctl_server_t *ctl) {
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++) {
+        client_close(&ctl->clients[i]);
+    }
+    if (ctl->listen_fd >= 0) {
+        close(ctl->listen_fd);
+        ctl->listen_fd = -1;
+        unlink(ctl->path);
+    }
+}
+
+static void reply_vappend(ctl_reply_t *reply, const char *prefix, const char *fmt, va_list ap) {
+    if (reply->overflow) return;
+
+    size_t avail = reply->size - reply->len;
+    int p = snprintf(reply->buf + reply->len, avail, "%s", prefix);
+    int n = (p >= 0 && (size_t)p < avail) ? vsnprintf(reply->buf + reply->len + (size_t)p, avail - (size_t)p, fmt, ap) : -1;
+    if (n < 0 || (size_t)(p + n) + 1 >= avail) {
+        reply->overflow = 1;
+        return;
+    }
+    reply->len += (size_t)(p + n);
+    if (reply->buf[reply->len - 1] != '\n') {
+        reply->buf[reply->len++] = '\n';
+    }
+}
+
+void ctl_reply_printf(ctl_reply_t *reply, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    reply_vappend(reply, "", fmt, ap);
+    va_end(ap);
+}
+
+void ctl_reply_error(ctl_reply_t *reply, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    reply_vappend(reply, "ERR ", fmt, ap);
+    va_end(ap);
+    reply->error = 1;
+}
+
+static void run_command(ctl_server_t *ctl, ctl_client_t *c, char *line) {
+    char *argv[CTL_MAX_ARGS];
+    int argc = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(line, " \t", &save); tok && argc < CTL_MAX_ARGS; tok = strtok_r(NULL, " \t", &save)) {
+        argv[argc++] = tok;
+    }
+    if (argc == 0) return;
+
+    // Replies are appended after any output still waiting to be sent. A
+    // client that pipelines faster than it reads gets a truncated reply.
+    size_t room = sizeof(c->out) - c->out_len;
+    ctl_reply_t reply = { c->out + c->out_len, room > CTL_STATUS_RESERVE ? room - CTL_STATUS_RESERVE : 0, 0, 0, 0 };
+
+    int rc = (reply.size > 0) ? ctl->handler(ctl->handler_ctx, argc, argv, &reply) : -1;
+    c->out_len += reply.len;
+
+    const char *status;
+    if (reply.overflow || reply.size == 0) {
+        status = "ERR reply truncated\n";
+    } else if (rc < 0 && reply.error) {
+        status = NULL; // Handler already wrote its ERR line
+    } else if (rc < 0) {
+        status = "ERR failed\n";
+    } else {
+        status = "OK\n";
+    }
+    if (status) {
+        size_t slen = strlen(status);
+        if (c->out_len + slen <= sizeof(c->out)) {
+            memcpy(c->out + c->out_len, status, slen);
+            c->out_len += slen;
+        }
+    }
+}
+
+static void client_read(ctl_server_t *ctl, ctl_client_t *c) {
+    ssize_t n = recv(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        client_close(c);
+        return;
+    }
+    if (n < 0) return;
+    c->in_len += (size_t)n;
+    c->in[c->in_len] = '\0';
+
+    char *start = c->in;
+    char *nl;
+    while ((nl = strchr(start, '\n')) != NULL) {
+        *nl = '\0';
+        if (nl > start && nl[-1] == '\r') nl[-1] = '\0';
+        if (c->discarding) {
+            c->discarding = 0;
+        } else {
+            run_command(ctl, c, start);
+        }
+        start = nl + 1;
+    }
+
+    size_t rest = c->in_len - (size_t)(start - c->in);
+    if (rest == sizeof(c->in) - 1) {
+        // Bounded input: reject the over-long line and drop bytes until newline
+        if (!c->discarding && c->out_len + 32 <= sizeof(c->out)) {
+            static const char msg[] = "ERR line too long\n";
+            memcpy(c->out + c->out_len, msg, sizeof(msg) - 1);
+            c->out_len += sizeof(msg) - 1;
+        }
+        c->discarding = 1;
+        rest = 0;
+    }
+    memmove(c->in, start, rest);
+    c->in_len = rest;
+}
+
+static void client_write(ctl_client_t *c) {
+    ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            client_close(c);
+        }
+        return;
+    }
+    c->out_off += (size_t)n;
+    if (c->out_off >= c->out_len) {
+        c->out_off = 0;
+        c->out_len = 0;
+    }
+}
+
+static void accept_clients(ctl_server_t *ctl) {
+    int fd;
+    while ((fd = netutil_accept(ctl->listen_fd)) >= 0) {
+        ctl_client_t *slot = NULL;
+        for (int i = 0; i < CTL_MAX_CLIENTS; i++) {
+            if (ctl->clients[i].fd < 0) {
+                slot = &ctl->clients[i];
+                break;
+            }
+        }
+        if (!slot) {
+            static const char busy[] = "ERR too many clients\n";
+            if (send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+                // Nothing to do; the connection is closed either way
+            }
+            close(fd);
+            continue;
+        }
+        client_close(slot);
+        slot->fd = fd;
+    }
+}
+
+int ctl_pollfds(ctl_server_t *ctl, struct pollfd *pfds, int max) {
+    int n = 0;
+    if (ctl->listen_fd < 0 || max <= 0) return 0;
+
+    pfds[n].fd = ctl->listen_fd;
+    pfds[n].events = POLLIN;
+    pfds[n].revents = 0;
+    n++;
+
+    for (int i = 0; i < CTL_MAX_CLIENTS && n < max; i++) {
+        ctl_client_t *c = &ctl->clients[i];
+        if (c->fd < 0) continue;
+        pfds[n].fd = c->fd;
+        // Stop reading while a reply is pending so output stays bounded
+        pfds[n].events = (c->out_len > 0) ? POLLOUT : POLLIN;
+        pfds[n].revents = 0;
+        n++;
+    }
+    return n;
+}
+
+void ctl_dispatch(ctl_server_t *ctl, const struct pollfd *pfds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (pfds[i].revents == 0) continue;
+
+        if (pfds[i].fd == ctl->listen_fd) {
+            accept_clients(ctl);
+            continue;
+        }
+
+        for (int j = 0; j < CTL_MAX_CLIENTS; j++) {
+            ctl_client_t *c = &ctl->clients[j];
+            if (c->fd != pfds[i].fd) continue;
+
+            if (pfds[i].revents & (POLLERR | POLLNVAL)) {
+                client_close(c);
+            } else if (c->out_len > 0 && (pfds[i].revents & POLLOUT)) {
+                client_write(c);
+            } else if (c->out_len == 0 && (pfds[i].revents & (POLLIN | POLLHUP))) {
+                client_read(ctl, c);
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// radxa-penta-ctl: command-line client for the daemon's control socket
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include "ctl.h"
+#include "status_shm.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-s socket] <command> [args...]\n"
+            "\n"
+            "Commands:\n"
+            "  status                         one-line summary\n"
+            "  dump                           full controller state\n"
+            "  set-manual-duty <0-100|auto>   fix the fan duty / return to automatic\n"
+            "  boost <seconds|off> [duty]     raise the duty floor for a while\n"
+            "  profile [name]                 list or select a fan profile\n"
+            "  history <series> <sec> [n]     averages of cpu/ssd/duty in n buckets\n"
+            "  help                           list the daemon's commands\n"
+            "  stages                         per-stage latency percentiles\n"
+            "  shadow                         shadow controller divergence (percent)\n"
+            "  usage                          lifetime time above curve levels, fan hours\n"
+            "  units                          per-HAT fan, duty, sensors and display\n"
+            "  controller                     controller plugin, step timing, state (hex)\n"
+            "  shm                            read the /dev/shm status segment (no socket)\n"
+            "\n"
+            "Default socket: %s\n",
+            prog, CTL_SOCKET_PATH);
+}
+
+static int send_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Read the shared-memory status segment directly: works for non-root users
+// and never touches the daemon.
+static int show_shm_status(void) {
+    int fd = shm_open(STATUS_SHM_NAME, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open /dev/shm%s: %s\n", STATUS_SHM_NAME, strerror(errno));
+        return 1;
+    }
+    void *p = mmap(NULL, sizeof(status_shm_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map status segment: %s\n", strerror(errno));
+        return 1;
+    }
+
+    status_shm_t st;
+    int rc = status_shm_read((const status_shm_t *)p, &st);
+    munmap(p, sizeof(status_shm_t));
+    if (rc < 0) {
+        fprintf(stderr, "Error: Status segment invalid or version mismatch\n");
+        return 1;
+    }
+
+    static const char *modes[] = {"auto", "manual", "boost"};
+    printf("pid=%d mode=%s duty=%.1f controller=%.1f target=%.1f\n", st.pid,
+           st.mode < 3 ? modes[st.mode] : "?",
+           st.duty_permille / 10.0, st.controller_permille / 10.0, st.target_permille / 10.0);
+    printf("cpu=%.1f cpu_avg=%.1f cpu_trend=%+.2f ssd_avg=%d ssd_trend=%+.2f\n",
+           st.cpu_temp_mc / 1000.0, st.cpu_avg_mc / 1000.0, st.cpu_trend_mc / 1000.0,
+           st.ssd_avg_c, st.ssd_trend_mc / 1000.0);
+    for (unsigned int i = 0; i < st.ssd_count && i < STATUS_SHM_MAX_SSD; i++) {
+        printf("ssd%u=%d%s", i, st.ssd_temp_c[i], i + 1 < st.ssd_count ? " " : "\n");
+    }
+    printf("flags=0x%08x ticks=%llu duty_changes=%llu fan_write_errors=%llu ssd_reads=%llu updated=%lld%s\n",
+           st.flags, (unsigned long long)st.ticks, (unsigned long long)st.duty_changes,
+           (unsigned long long)st.fan_write_errors, (unsigned long long)st.ssd_reads,
+           (long long)st.updated_wall_sec, (st.flags & STATUS_FLAG_STOPPED) ? " (stopped)" : "");
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = CTL_SOCKET_PATH;
+    int argi = 1;
+
+    if (argi + 1 < argc && strcmp(argv[argi], "-s") == 0) {
+        path = argv[argi + 1];
+        argi += 2;
+    }
+    if (argi >= argc || strcmp(argv[argi], "-h") == 0 || strcmp(argv[argi], "--help") == 0) {
+        usage(argv[0]);
+        return argi >= argc ? 2 : 0;
+    }
+
+    if (strcmp(argv[argi], "shm") == 0) {
+        return show_shm_status();
+    }
+
+    char line[CTL_IN_BUF];
+    size_t len = 0;
+    for (int i = argi; i < argc; i++) {
+        int n = snprintf(line + len, sizeof(line) - len, "%s%s", i > argi ? " " : "", argv[i]);
+        if (n < 0 || (size_t)n >= sizeof(line) - len - 1) {
+            fprintf(stderr, "Error: Command too long\n");
+            return 2;
+        }
+        len += (size_t)n;
+    }
+    line[len++] = '\n';
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long\n");
+        return 2;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Error: Cannot connect to %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    if (send_all(fd, line, len) < 0) {
+        fprintf(stderr, "Error: Send failed: %s\n", strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    // Print data lines until the terminating OK / ERR line
+    FILE *fp = fdopen(fd, "r");
+    if (!fp) {
+        close(fd);
+        return 1;
+    }
+    int rc = 1;
+    char buf[512];
+    while (fgets(buf, sizeof(buf), fp)) {
+        if (strcmp(buf, "OK\n") == 0) {
+            rc = 0;
+            break;
+        }
+        if (strncmp(buf, "ERR", 3) == 0) {
+            fprintf(stderr, "Error:%s", buf + 3);
+            break;
+        }
+        fputs(buf, stdout);
+    }
+    fclose(fp);
+    return rc;
+}
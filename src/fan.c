@@ -13,6 +13,7 @@
 #include <math.h>
 #include <time.h>
 #include "fan.h"
+#include "logger.h"
 
 // Check gpiod version
 #ifndef GPIOD_API_VERSION
@@ -21,23 +22,37 @@
 
 static void* gpio_pwm_thread(void *arg);
 
-int fan_init(fan_t *fan) {
+static const char *pwm_root = FAN_PWM_ROOT;
+
+void fan_set_pwm_root(const char *root) {
+    pwm_root = root ? root : FAN_PWM_ROOT;
+}
+
+// Sleep for ts and record how late the following edge is relative to the
+// requested interval (only when a jitter histogram is attached).
+static void pwm_sleep(fan_t *fan, const struct timespec *ts) {
+    if (!fan->edge_jitter) {
+        nanosleep(ts, NULL);
+        return;
+    }
+    struct timespec before, after;
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    nanosleep(ts, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    double elapsed = (double)(after.tv_sec - before.tv_sec) + (double)(after.tv_nsec - before.tv_nsec) / 1e9;
+    double wanted = (double)ts->tv_sec + (double)ts->tv_nsec / 1e9;
+    metrics_observe(fan->edge_jitter, elapsed - wanted);
+}
+
+int fan_init(fan_t *fan, const unit_config_t *unit) {
     memset(fan, 0, sizeof(fan_t));
+    int debug_verbose = logger_enabled(LOGGER_VERBOSE);
 
-    // Read environment variables
-    const char *hwpwm = getenv("HARDWARE_PWM");
-    const char *pwmchip = getenv("PWMCHIP");
-    const char *pwmchan = getenv("PWMCHAN");
-    const char *fan_chip = getenv("FAN_CHIP");
-    const char *fan_line = getenv("FAN_LINE");
-    const char *dbg = getenv("RADXA_DEBUG");
-    int debug_verbose = (dbg && strcmp(dbg, "2") == 0);
-
-    fan->use_hardware_pwm = (hwpwm && strcmp(hwpwm, "1") == 0);
-    fan->pwm_chip = pwmchip ? atoi(pwmchip) : 0;
-    fan->pwm_channel = pwmchan ? atoi(pwmchan) : 0;
-    fan->gpio_chip = fan_chip ? atoi(fan_chip) : 0;
-    fan->gpio_line = fan_line ? (unsigned int)strtoul(fan_line, NULL, 10) : 27u;
+    fan->use_hardware_pwm = (unit->fan == UNIT_FAN_PWM);
+    fan->pwm_chip = unit->pwm_chip;
+    fan->pwm_channel = unit->pwm_channel;
+    fan->gpio_chip = unit->fan_chip;
+    fan->gpio_line = (unsigned int)unit->fan_line;
     fan->period_s = GPIO_PERIOD_S;
     fan->duty_cycle = 0.0;
     fan->running = 1;
@@ -45,11 +60,11 @@ int fan_init(fan_t *fan) {
     if (fan->use_hardware_pwm) {
         // Hardware PWM setup
         snprintf(fan->pwm_path, sizeof(fan->pwm_path),
-                 "/sys/class/pwm/pwmchip%d/pwm%d", fan->pwm_chip, fan->pwm_channel);
+                 "%s/pwmchip%d/pwm%d", pwm_root, fan->pwm_chip, fan->pwm_channel);
 
-        char export_path[256];
+        char export_path[300];
         snprintf(export_path, sizeof(export_path),
-                 "/sys/class/pwm/pwmchip%d/export", fan->pwm_chip);
+                 "%s/pwmchip%d/export", pwm_root, fan->pwm_chip);
 
         // Try to export PWM channel
         FILE *fp = fopen(export_path, "w");
@@ -91,7 +106,7 @@ int fan_init(fan_t *fan) {
             snprintf(dbg_enable_path, sizeof(dbg_enable_path), "%s/enable", fan->pwm_path);
             pf = fopen(dbg_enable_path, "r");
             int enabled = -1; if (pf) { if (fscanf(pf, "%d", &enabled) == 1) {} fclose(pf); }
-            printf("[DEBUG][PWM/HW] path=%s period_ns=%ld enabled=%d\n", fan->pwm_path, cur_period, enabled);
+            logger_log(LOGGER_VERBOSE, NULL, "[DEBUG][PWM/HW] path=%s period_ns=%ld enabled=%d", fan->pwm_path, cur_period, enabled);
         }
     } else {
         // GPIO software PWM setup
@@ -160,7 +175,7 @@ int fan_init(fan_t *fan) {
         printf("Fan initialized with software PWM (GPIO chip %d, line %d)\n",
                fan->gpio_chip, fan->gpio_line);
         if (debug_verbose) {
-            printf("[DEBUG][PWM/SW] period_s=%.3f initial_duty=%.0f%%\n", fan->period_s, fan->duty_cycle * 100.0);
+            logger_log(LOGGER_VERBOSE, NULL, "[DEBUG][PWM/SW] period_s=%.3f initial_duty=%.0f%%", fan->period_s, fan->duty_cycle * 100.0);
         }
     }
 
@@ -168,11 +183,9 @@ int fan_init(fan_t *fan) {
 }
 
 int fan_set_duty_cycle(fan_t *fan, double duty) {
-    const char *dbg = getenv("RADXA_DEBUG");
-    int debug_verbose = (dbg && strcmp(dbg, "2") == 0);
+    int debug_verbose = logger_enabled(LOGGER_VERBOSE);
     double requested = duty;
-    if (duty < 0.0) duty = 0.0;
-    if (duty > 1.0) duty = 1.0;
+    duty = fan_pwm_clamp(duty);
 
     fan->duty_cycle = duty;
 
@@ -185,8 +198,7 @@ int fan_set_duty_cycle(fan_t *fan, double duty) {
             return -1;
         }
 
-        // Standard PWM duty cycle for Noctua 4-pin PWM fans
-        int duty_ns = (int)((double)fan->pwm_period_ns * duty);
+        int duty_ns = fan_pwm_duty_ns(fan->pwm_period_ns, duty);
         fprintf(fp, "%d", duty_ns);
         fclose(fp);
         if (debug_verbose) {
@@ -198,13 +210,13 @@ int fan_set_duty_cycle(fan_t *fan, double duty) {
             snprintf(enable_path, sizeof(enable_path), "%s/enable", fan->pwm_path);
             fp = fopen(enable_path, "r");
             int enabled = -1; if (fp) { if (fscanf(fp, "%d", &enabled) == 1) {} fclose(fp); }
-         printf("[DEBUG][PWM/HW] req=%.0f%% clamp=%.0f%% duty_ns=%d read_duty_ns=%ld enabled=%d\n",
+         logger_log(LOGGER_VERBOSE, NULL, "[DEBUG][PWM/HW] req=%.0f%% clamp=%.0f%% duty_ns=%d read_duty_ns=%ld enabled=%d",
              requested * 100.0, duty * 100.0, duty_ns, read_duty, enabled);
         }
     }
     // For GPIO PWM, the thread will pick up the new duty_cycle value
     else if (debug_verbose) {
-     printf("[DEBUG][PWM/SW] req=%.0f%% clamp=%.0f%% period=%.0fms hi=%.1fms lo=%.1fms\n",
+     logger_log(LOGGER_VERBOSE, NULL, "[DEBUG][PWM/SW] req=%.0f%% clamp=%.0f%% period=%.0fms hi=%.1fms lo=%.1fms",
          requested * 100.0, duty * 100.0,
          fan->period_s * 1000.0,
          fan->duty_cycle * fan->period_s * 1000.0,
@@ -219,40 +231,30 @@ static void* gpio_pwm_thread(void *arg) {
     struct gpiod_line_request *request = (struct gpiod_line_request *)fan->line;
 
     // Pre-calculate timing structures
-    struct timespec ts_high, ts_low, ts_full;
+    fan_pwm_timing_t ts;
     double last_duty = -1.0;
 
     while (fan->running) {
         // Only recalculate timings if duty cycle changed
         if (fabs(fan->duty_cycle - last_duty) > 0.001) {
-            double period_ns = fan->period_s * 1e9;
-            double high_ns = fan->duty_cycle * period_ns;
-            double low_ns = (1.0 - fan->duty_cycle) * period_ns;
-
-            ts_high.tv_sec = 0;
-            ts_high.tv_nsec = (long)high_ns;
-            ts_low.tv_sec = 0;
-            ts_low.tv_nsec = (long)low_ns;
-            ts_full.tv_sec = 0;
-            ts_full.tv_nsec = (long)period_ns;
-
+            fan_pwm_timing(fan->period_s, fan->duty_cycle, &ts);
             last_duty = fan->duty_cycle;
         }
 
         if (fan->duty_cycle <= 0.001) {
             // Fan off - sleep full period
             gpiod_line_request_set_value(request, fan->gpio_line, GPIOD_LINE_VALUE_INACTIVE);
-            nanosleep(&ts_full, NULL);
+            nanosleep(&ts.full, NULL);
         } else if (fan->duty_cycle >= 0.999) {
             // Fan full speed - keep high
             gpiod_line_request_set_value(request, fan->gpio_line, GPIOD_LINE_VALUE_ACTIVE);
-            nanosleep(&ts_full, NULL);
+            nanosleep(&ts.full, NULL);
         } else {
             // Normal PWM
             gpiod_line_request_set_value(request, fan->gpio_line, GPIOD_LINE_VALUE_ACTIVE);
-            nanosleep(&ts_high, NULL);
+            pwm_sleep(fan, &ts.high);
             gpiod_line_request_set_value(request, fan->gpio_line, GPIOD_LINE_VALUE_INACTIVE);
-            nanosleep(&ts_low, NULL);
+            pwm_sleep(fan, &ts.low);
         }
     }
 
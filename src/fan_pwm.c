@@ -0,0 +1,30 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include "fan_pwm.h"
+
+double fan_pwm_clamp(double duty) {
+    if (duty < 0.0) return 0.0;
+    if (duty > 1.0) return 1.0;
+    return duty;
+}
+
+int fan_pwm_duty_ns(int period_ns, double duty) {
+    // Standard PWM duty cycle for Noctua 4-pin PWM fans
+    return (int)((double)period_ns * fan_pwm_clamp(duty));
+}
+
+void fan_pwm_timing(double period_s, double duty, fan_pwm_timing_t *t) {
+    double period_ns = period_s * 1e9;
+    double high_ns = duty * period_ns;
+    double low_ns = (1.0 - duty) * period_ns;
+
+    t->high.tv_sec = 0;
+    t->high.tv_nsec = (long)high_ns;
+    t->low.tv_sec = 0;
+    t->low.tv_nsec = (long)low_ns;
+    t->full.tv_sec = 0;
+    t->full.tv_nsec = (long)period_ns;
+}
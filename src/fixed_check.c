@@ -0,0 +1,372 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// radxa-penta-fixed-check: replay temperature traces through the double
+// and the fixed-point control law side by side and compare them step by
+// step. Traces are flight recorder dumps (binary, or CSV from
+// radxa-penta-flightrec), simulator traces (radxa-penta-sim -t), or a
+// built-in synthetic day (with a room swinging between 15 and 35 °C, as
+// an [ambient] sensor reads it) when no file is given. An ambient_c column
+// in a CSV trace is replayed the same way. Every profile of the
+// configuration is replayed. The decisions (curve target, cooldown hold,
+// dead-band, stable count, SSD average) must match exactly. The duty must
+// match to the ppb whenever a step lands on its curve target; during a
+// rate-limited ramp it may only drift by the fixed law's rounding of each
+// ramp step, and the ambient ramp factor by its single rounding.
+//
+// Readings are whole milli-degrees, so an average, trend or stable time can
+// sit exactly on a threshold. The fixed law decides such a tie exactly and
+// flags it (THERMAL_TIE_*); the double law decides it through rounding, as
+// it does when its ramp lands an ulp off the target (a residue the next
+// step counts as a change). A mismatch on such a step is reported as a
+// known divergence and the fixed law is resynchronized onto the double
+// law's duty, stable time and hold. Exit status 1 on any other mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "config.h"
+#include "flightrec.h"
+#include "logger.h"
+#include "thermal.h"
+#include "timebase.h"
+
+#define CHECK_START_WALL 1735689600     // 2025-01-01 00:00:00 UTC
+#define CHECK_SYNTHETIC_SEC (24 * 3600)
+#define CHECK_DEFAULT_SEED 0x5eed
+#define CHECK_MAX_COLUMNS 32
+#define CHECK_DUTY_PPB 1e9
+#define CHECK_RAMP_PPB_PER_SEC 2.0      // Fixed ramp rounding: rate and ambient factor, per second of step
+#define CHECK_RAMP_PPB_PER_STEP 0.5     // and the step itself
+#define CHECK_FLOAT_PPB 1e-3            // Double rounding, in ppb
+#define CHECK_RESIDUE 1e-12             // A double duty this close to (but off) the fixed one is a residue
+#define CHECK_REPORT_MAX 10             // Known divergences printed per trace and profile
+
+typedef struct {
+    int64_t t_ms;
+    int32_t cpu_mc;
+    int ssd[MAX_DEVICES];
+    int32_t ambient_mc;
+    int ambient_valid;
+} trace_row_t;
+
+typedef struct {
+    trace_row_t *rows;
+    size_t count;
+    size_t capacity;
+} trace_t;
+
+typedef struct {
+    long steps;
+    long decision_mismatches;   // Decisions taken differently off a tie
+    long duty_mismatches;       // Duty or ambient factor beyond the fixed law's rounding
+    long ties;                  // Known divergences: the fixed law decided an exact tie
+    long residues;              // Known divergences: the double ramp ended an ulp off its target
+    double max_err_ppb;         // Largest |fixed - double| duty outside known divergences
+    long first_mismatch;        // Step, -1 = none
+} check_result_t;
+
+static trace_row_t *trace_add(trace_t *t) {
+    if (t->count == t->capacity) {
+        size_t cap = t->capacity ? t->capacity * 2 : 4096;
+        trace_row_t *rows = realloc(t->rows, cap * sizeof(*rows));
+        if (!rows) return NULL;
+        t->rows = rows;
+        t->capacity = cap;
+    }
+    trace_row_t *r = &t->rows[t->count++];
+    memset(r, 0, sizeof(*r));
+    return r;
+}
+
+static int load_flightrec(trace_t *t, FILE *fp, const char *path) {
+    flightrec_header_t hdr;
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.version != FLIGHTREC_VERSION ||
+        hdr.record_size != sizeof(flightrec_record_t)) {
+        fprintf(stderr, "Error: %s: unsupported flight recorder dump\n", path);
+        return -1;
+    }
+    flightrec_record_t rec;
+    for (uint32_t n = 0; n < hdr.count && fread(&rec, sizeof(rec), 1, fp) == 1; n++) {
+        trace_row_t *r = trace_add(t);
+        if (!r) return -1;
+        r->t_ms = (int64_t)rec.t_ms;
+        r->cpu_mc = rec.cpu_raw_cc * 10;
+        r->ssd[0] = rec.ssd_max_c;
+    }
+    return 0;
+}
+
+static int column_index(char **cols, int n, const char *const *names) {
+    for (int i = 0; i < n; i++) {
+        for (const char *const *name = names; *name; name++) {
+            if (strcmp(cols[i], *name) == 0) return i;
+        }
+    }
+    return -1;
+}
+
+// CSV with a header naming the time, CPU and hottest-drive columns
+static int load_csv(trace_t *t, FILE *fp, const char *path) {
+    static const char *const time_names[] = { "time_unix", "t_sec", NULL };
+    static const char *const cpu_names[] = { "cpu_raw_c", "cpu_meas_c", "cpu_c", NULL };
+    static const char *const ssd_names[] = { "ssd_max_c", "ssd_c", NULL };
+    static const char *const ambient_names[] = { "ambient_c", NULL };
+    char line[1024];
+    int time_col = -1, cpu_col = -1, ssd_col = -1, ambient_col = -1;
+    double t0 = 0.0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char *cols[CHECK_MAX_COLUMNS];
+        int n = 0;
+        char *save = NULL;
+        for (char *tok = strtok_r(line, ",\r\n", &save); tok; tok = strtok_r(NULL, ",\r\n", &save)) {
+            if (n == CHECK_MAX_COLUMNS) break;
+            cols[n++] = tok;
+        }
+        if (time_col < 0) {
+            time_col = column_index(cols, n, time_names);
+            cpu_col = column_index(cols, n, cpu_names);
+            ssd_col = column_index(cols, n, ssd_names);
+            ambient_col = column_index(cols, n, ambient_names);
+            if (time_col < 0 || cpu_col < 0 || ssd_col < 0) {
+                fprintf(stderr, "Error: %s: no time, CPU and SSD columns in the header\n", path);
+                return -1;
+            }
+            continue;
+        }
+        if (time_col >= n || cpu_col >= n || ssd_col >= n) continue;
+        double sec = atof(cols[time_col]);
+        if (t->count == 0) t0 = sec;
+        trace_row_t *r = trace_add(t);
+        if (!r) return -1;
+        r->t_ms = llround((sec - t0) * 1e3);
+        r->cpu_mc = (int32_t)lround(atof(cols[cpu_col]) * 1e3);
+        r->ssd[0] = (int)lround(atof(cols[ssd_col]));
+        if (ambient_col >= 0 && ambient_col < n) {
+            r->ambient_mc = (int32_t)lround(atof(cols[ambient_col]) * 1e3);
+            r->ambient_valid = 1;
+        }
+    }
+    return t->count > 0 ? 0 : -1;
+}
+
+static int load_trace(trace_t *t, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    uint32_t magic = 0;
+    int binary = fread(&magic, sizeof(magic), 1, fp) == 1 && magic == FLIGHTREC_MAGIC;
+    rewind(fp);
+    int rc = binary ? load_flightrec(t, fp, path) : load_csv(t, fp, path);
+    fclose(fp);
+    return rc;
+}
+
+static double rng_uniform(uint64_t *s) {
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return (double)(*s >> 11) / 9007199254740992.0;
+}
+
+// A day of load bursts, scrubs and idle stretches at irregular control
+// periods (0.5 to 10 s, like the adaptive period), CPU in 0.001 °C steps,
+// drives in whole degrees refreshed every SSD_TEMP_CACHE_SEC
+static int synthetic_trace(trace_t *t, uint64_t seed) {
+    double cpu = 42.0, cage = 36.0, load = 0.0, heat = 0.0;
+    int64_t ms = 0, ssd_at = -SSD_TEMP_CACHE_SEC * 1000;
+    int ssd[MAX_DEVICES] = { 0 };
+    static const int64_t periods_ms[] = { 500, 1000, 1000, 1000, 2000, 4000, 10000 };
+
+    while (ms < (int64_t)CHECK_SYNTHETIC_SEC * 1000) {
+        if (rng_uniform(&seed) < 0.002) load = rng_uniform(&seed) * 35.0;
+        if (rng_uniform(&seed) < 0.001) heat = rng_uniform(&seed) * 14.0;
+        cpu += (40.0 + load - cpu) * 0.05 + (rng_uniform(&seed) - 0.5) * 0.6;
+        cage += (34.0 + heat - cage) * 0.01;
+        if (ms - ssd_at >= SSD_TEMP_CACHE_SEC * 1000) {
+            ssd_at = ms;
+            for (int i = 0; i < SSD_DEVICE_COUNT; i++) {
+                ssd[i] = (int)lround(cage + i * 0.7);
+            }
+        }
+        trace_row_t *r = trace_add(t);
+        if (!r) return -1;
+        r->t_ms = ms;
+        r->cpu_mc = (int32_t)lround(cpu * 1e3);
+        memcpy(r->ssd, ssd, sizeof(ssd));
+        r->ambient_mc = (int32_t)lround(25000.0 - 10000.0 * cos((double)ms / (CHECK_SYNTHETIC_SEC * 1e3) * 2.0 * M_PI));
+        r->ambient_valid = 1;
+        ms += periods_ms[(size_t)(rng_uniform(&seed) * (sizeof(periods_ms) / sizeof(periods_ms[0])))];
+    }
+    return 0;
+}
+
+static int decisions_equal(const thermal_state_t *d, const thermal_state_t *f) {
+    return d->hold_active == f->hold_active && d->deadband_active == f->deadband_active &&
+           d->hold_until == f->hold_until && d->stable_cycles == f->stable_cycles && d->ssd_avg == f->ssd_avg &&
+           (d->deadband_active || llround(d->dc_target * CHECK_DUTY_PPB) == llround(f->dc_target * CHECK_DUTY_PPB));
+}
+
+// Continue the fixed law from the double law's duty after a known
+// divergence, so the steps after it are still compared exactly (the
+// history rings only depend on the readings and never differ)
+static void resync(const thermal_state_t *d, thermal_state_t *f) {
+    f->fixed.duty_ppb = (int32_t)llround(d->last_duty_cycle * CHECK_DUTY_PPB);
+    f->fixed.stable_ms = llround(d->stable_sec * 1e3);
+    f->stable_cycles = d->stable_cycles;
+    f->hold_until = d->hold_until;
+}
+
+static void report(const char *what, const char *name, const config_t *cfg, size_t i, const trace_row_t *r,
+                   double dc, const thermal_state_t *sd, const thermal_state_t *sf) {
+    fprintf(stderr,
+            "%s/%s: %s at step %zu (t=%.3fs cpu=%.3f ssd=%d ties=0x%x): "
+            "double duty=%.9f target=%.6f hold=%d deadband=%d stable=%d | "
+            "fixed duty=%.9f target=%.6f hold=%d deadband=%d stable=%d\n",
+            name, cfg->active->name, what, i, (double)r->t_ms / 1e3, (double)r->cpu_mc / 1e3, r->ssd[0],
+            sf->fixed.ties, dc, sd->dc_target, sd->hold_active, sd->deadband_active, sd->stable_cycles,
+            (double)sf->fixed.duty_ppb / CHECK_DUTY_PPB, sf->dc_target, sf->hold_active, sf->deadband_active,
+            sf->stable_cycles);
+}
+
+static void check_trace(config_t *cfg, const trace_t *t, const char *name, check_result_t *res) {
+    static thermal_state_t sd, sf;
+    thermal_state_init(&sd);
+    thermal_state_init(&sf);
+    sd.quiet = 1;
+    sf.quiet = 1;
+    memset(res, 0, sizeof(*res));
+    res->first_mismatch = -1;
+    double ramp_bound = 0.0;    // ppb the duties may be apart after the ramp steps since the last landing
+
+    timebase_virtual_enable(CHECK_START_WALL);
+    int64_t prev_ms = t->count ? t->rows[0].t_ms : 0;
+    for (size_t i = 0; i < t->count; i++) {
+        const trace_row_t *r = &t->rows[i];
+        if (r->t_ms > prev_ms) timebase_virtual_advance((double)(r->t_ms - prev_ms) / 1e3);
+        prev_ms = r->t_ms;
+
+        sd.ambient_mc = sf.ambient_mc = r->ambient_mc;
+        sd.ambient_valid = sf.ambient_valid = r->ambient_valid;
+        int ssd_count = 0;
+        for (int d = 0; d < MAX_DEVICES; d++) {
+            if (r->ssd[d] > 0) ssd_count++;
+        }
+        // The double duty an ulp off where the fixed law landed (held there
+        // through dead-band and hold steps until the next change)
+        double fixed_duty = (double)sf.fixed.duty_ppb / CHECK_DUTY_PPB;
+        int residue = sd.last_duty_cycle != fixed_duty && fabs(sd.last_duty_cycle - fixed_duty) < CHECK_RESIDUE;
+        double dc = thermal_control_step_double(cfg, &sd, (double)r->cpu_mc / 1e3, r->ssd, ssd_count);
+        thermal_control_step_fixed(cfg, &sf, r->cpu_mc, r->ssd, ssd_count);
+        res->steps++;
+
+        // A step landing on its curve target puts both laws on it exactly;
+        // a rate-limited one adds its rounding to what they may be apart
+        int landed = !sf.deadband_active && sf.fixed.duty_ppb == llround(sf.dc_target * CHECK_DUTY_PPB);
+        if (landed) {
+            ramp_bound = 0.0;
+        } else if (sf.stable_cycles == 0) {
+            ramp_bound += CHECK_RAMP_PPB_PER_SEC * sf.step_sec + CHECK_RAMP_PPB_PER_STEP;
+        }
+        double err = fabs(dc * CHECK_DUTY_PPB - (double)sf.fixed.duty_ppb);
+        int decisions = decisions_equal(&sd, &sf);
+        int duty = err <= ramp_bound + CHECK_FLOAT_PPB &&
+                   fabs(sd.ambient_rate - sf.ambient_rate) * CHECK_DUTY_PPB <= 0.5 + CHECK_FLOAT_PPB;
+        if (decisions && duty) {
+            if (err > res->max_err_ppb) res->max_err_ppb = err;
+            continue;
+        }
+
+        if (sf.fixed.ties || residue) {
+            long known = res->ties + res->residues;
+            if (sf.fixed.ties) {
+                res->ties++;
+            } else {
+                res->residues++;
+            }
+            if (known < CHECK_REPORT_MAX) {
+                report(sf.fixed.ties ? "known divergence (tie)" : "known divergence (residue)",
+                       name, cfg, i, r, dc, &sd, &sf);
+            }
+            resync(&sd, &sf);
+            ramp_bound = CHECK_RAMP_PPB_PER_STEP;
+            continue;
+        }
+        if (err > res->max_err_ppb) res->max_err_ppb = err;
+        if (!decisions) res->decision_mismatches++;
+        if (!duty) res->duty_mismatches++;
+        if (res->first_mismatch < 0) {
+            res->first_mismatch = (long)i;
+            report("first mismatch", name, cfg, i, r, dc, &sd, &sf);
+        }
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-c config] [-s seed] [trace...]\n"
+            "  -c  configuration whose profiles are replayed (default %s)\n"
+            "  -s  seed of the synthetic day (default %d)\n"
+            "  trace  flight recorder dump (.bin or its CSV) or radxa-penta-sim -t trace;\n"
+            "         without one a synthetic day is replayed\n",
+            prog, CONFIG_FILE, CHECK_DEFAULT_SEED);
+}
+
+int main(int argc, char *argv[]) {
+    const char *config_path = CONFIG_FILE;
+    uint64_t seed = CHECK_DEFAULT_SEED;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:s:h")) != -1) {
+        switch (opt) {
+            case 'c': config_path = optarg; break;
+            case 's': seed = strtoull(optarg, NULL, 0); break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    logger_init("warning", 0, NULL);
+
+    // Config chatter goes to stderr so that stdout is only the CSV
+    static config_t cfg;
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    if (saved_stdout >= 0) dup2(STDERR_FILENO, STDOUT_FILENO);
+    config_load_file(&cfg, config_path);
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    printf("trace,profile,steps,decision_mismatches,duty_mismatches,known_ties,known_residues,max_err_ppb\n");
+    int failed = 0;
+    int traces = optind < argc ? argc - optind : 1;
+    for (int i = 0; i < traces; i++) {
+        trace_t t = { NULL, 0, 0 };
+        const char *name = optind < argc ? argv[optind + i] : "synthetic";
+        int rc = optind < argc ? load_trace(&t, name) : synthetic_trace(&t, seed);
+        if (rc < 0 || t.count == 0) {
+            fprintf(stderr, "Error: %s: no samples\n", name);
+            free(t.rows);
+            failed = 1;
+            continue;
+        }
+        for (int p = 0; p < cfg.profile_count; p++) {
+            cfg.active = &cfg.profiles[p];
+            check_result_t res;
+            check_trace(&cfg, &t, name, &res);
+            printf("%s,%s,%ld,%ld,%ld,%ld,%ld,%.3f\n", name, cfg.active->name, res.steps, res.decision_mismatches,
+                   res.duty_mismatches, res.ties, res.residues, res.max_err_ppb);
+            if (res.decision_mismatches || res.duty_mismatches) failed = 1;
+        }
+        free(t.rows);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "flightrec.h"
+#include "timebase.h"
+#include "logger.h"
+
+int flightrec_init(flightrec_t *fr, size_t capacity, const char *dir) {
+    memset(fr, 0, sizeof(flightrec_t));
+    if (capacity == 0) {
+        return -1;
+    }
+
+    fr->ring = calloc(capacity, sizeof(flightrec_record_t));
+    if (!fr->ring) {
+        fprintf(stderr, "Warning: Cannot allocate flight recorder (%zu records)\n", capacity);
+        return -1;
+    }
+    fr->capacity = capacity;
+    fr->start_mono = timebase_mono_sec();
+    fr->start_wall_sec = (int64_t)timebase_wall_sec();
+    snprintf(fr->dir, sizeof(fr->dir), "%s", dir);
+
+    printf("Flight recorder: %zu records (%zu KiB), dumps to %s\n",
+           capacity, capacity * sizeof(flightrec_record_t) / 1024, fr->dir);
+    return 0;
+}
+
+void flightrec_cleanup(flightrec_t *fr) {
+    free(fr->ring);
+    fr->ring = NULL;
+    fr->capacity = 0;
+}
+
+flightrec_record_t *flightrec_next(flightrec_t *fr) {
+    flightrec_record_t *rec = &fr->ring[fr->written % fr->capacity];
+    fr->written++;
+    memset(rec, 0, sizeof(*rec));
+    rec->t_ms = (uint64_t)((timebase_mono_sec() - fr->start_mono) * 1000.0);
+    return rec;
+}
+
+static int write_all(FILE *fp, const void *buf, size_t size, size_t count) {
+    return (count == 0 || fwrite(buf, size, count, fp) == count) ? 0 : -1;
+}
+
+int flightrec_dump(flightrec_t *fr, uint32_t reason) {
+    if (!fr->ring) return -1;
+
+    if (mkdir(fr->dir, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: Cannot create %s: %s\n", fr->dir, strerror(errno));
+        return -1;
+    }
+
+    int64_t now = (int64_t)timebase_wall_sec();
+    char path[128], tmp[128];
+    snprintf(tmp, sizeof(tmp), "%s/flightrec.tmp", fr->dir);
+
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) {
+        fprintf(stderr, "Warning: Cannot write %s: %s\n", tmp, strerror(errno));
+        return -1;
+    }
+
+    size_t count = fr->written < fr->capacity ? (size_t)fr->written : fr->capacity;
+    size_t oldest = fr->written < fr->capacity ? 0 : (size_t)(fr->written % fr->capacity);
+
+    flightrec_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = FLIGHTREC_MAGIC;
+    hdr.version = FLIGHTREC_VERSION;
+    hdr.record_size = (uint16_t)sizeof(flightrec_record_t);
+    hdr.count = (uint32_t)count;
+    hdr.reason = reason;
+    hdr.start_wall_sec = fr->start_wall_sec;
+    hdr.dump_wall_sec = now;
+
+    // Oldest-first: the tail of the ring, then the wrapped head
+    int err = write_all(fp, &hdr, sizeof(hdr), 1);
+    if (!err) err = write_all(fp, &fr->ring[oldest], sizeof(flightrec_record_t), count - oldest);
+    if (!err) err = write_all(fp, fr->ring, sizeof(flightrec_record_t), oldest);
+    if (fclose(fp) != 0) err = -1;
+
+    // link() refuses a taken name, so two dumps in one second (or one of an
+    // earlier run) each keep their file: the next sequence number is tried
+    int published = 0;
+    for (int i = 0; !err && !published && i < FLIGHTREC_NAME_TRIES; i++) {
+        snprintf(path, sizeof(path), "%s/flightrec-%lld-%u.bin", fr->dir, (long long)now, fr->dump_seq++);
+        if (link(tmp, path) == 0) {
+            published = 1;
+        } else if (errno != EEXIST) {
+            break;
+        }
+    }
+    if (!published) {
+        fprintf(stderr, "Warning: Flight recorder dump failed: %s\n", strerror(errno));
+        unlink(tmp);
+        return -1;
+    }
+    unlink(tmp);
+
+    logger_log(LOGGER_INFO, NULL, "[FlightRec] Dumped %zu records to %s", count, path);
+    return 0;
+}
+
+void flightrec_check_alarm(flightrec_t *fr, int alarm) {
+    if (alarm && !fr->alarm_latched) {
+        int64_t now = (int64_t)timebase_wall_sec();
+        if (fr->last_alarm_dump == 0 || now - fr->last_alarm_dump >= FLIGHTREC_ALARM_MIN_INTERVAL_SEC) {
+            fr->last_alarm_dump = now;
+            flightrec_dump(fr, FR_REASON_ALARM);
+        }
+    }
+    fr->alarm_latched = alarm;
+}
@@ -0,0 +1,75 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// radxa-penta-flightrec: convert a flight recorder dump to CSV
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flightrec.h"
+
+static const char *reason_name(uint32_t reason) {
+    switch (reason) {
+        case FR_REASON_SIGNAL: return "signal";
+        case FR_REASON_ALARM: return "alarm";
+        default: return "unknown";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        fprintf(stderr, "Usage: %s <flightrec-*.bin>   (CSV on stdout)\n", argv[0]);
+        return 2;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    flightrec_header_t hdr;
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != FLIGHTREC_MAGIC) {
+        fprintf(stderr, "Error: %s is not a flight recorder dump\n", argv[1]);
+        fclose(fp);
+        return 1;
+    }
+    if (hdr.version != FLIGHTREC_VERSION || hdr.record_size != sizeof(flightrec_record_t)) {
+        fprintf(stderr, "Error: Unsupported dump version %u (record size %u)\n",
+                (unsigned)hdr.version, (unsigned)hdr.record_size);
+        fclose(fp);
+        return 1;
+    }
+
+    printf("# reason=%s records=%u recorder_start=%lld dumped=%lld\n",
+           reason_name(hdr.reason), hdr.count, (long long)hdr.start_wall_sec, (long long)hdr.dump_wall_sec);
+    printf("tick,time_unix,cpu_raw_c,cpu_avg_c,cpu_trend_c,ssd_max_c,ssd_avg_c,ssd_trend_c,"
+           "target_pct,controller_pct,applied_pct,mode,hold,deadband,rate_limited,ssd_fresh,fan_error,alarm,"
+           "tick_us,cpu_read_us,ssd_read_us\n");
+
+    flightrec_record_t r;
+    uint32_t n = 0;
+    while (n < hdr.count && fread(&r, sizeof(r), 1, fp) == 1) {
+        printf("%u,%.3f,%.2f,%.2f,%+.2f,%d,%d,%+.2f,%.1f,%.1f,%.1f,%u,%d,%d,%d,%d,%d,%d,%u,%u,%u\n",
+               r.tick,
+               (double)hdr.start_wall_sec + (double)r.t_ms / 1000.0,
+               r.cpu_raw_cc / 100.0, r.cpu_avg_cc / 100.0, r.cpu_trend_cc / 100.0,
+               r.ssd_max_c, r.ssd_avg_c, r.ssd_trend_cc / 100.0,
+               r.target_pm / 10.0, r.controller_pm / 10.0, r.applied_pm / 10.0,
+               (unsigned)r.mode,
+               !!(r.flags & FR_FLAG_HOLD), !!(r.flags & FR_FLAG_DEADBAND),
+               !!(r.flags & FR_FLAG_RATE_LIMITED), !!(r.flags & FR_FLAG_SSD_FRESH),
+               !!(r.flags & FR_FLAG_FAN_ERROR), !!(r.flags & FR_FLAG_ALARM),
+               r.tick_us, (unsigned)r.cpu_read_us, r.ssd_read_us);
+        n++;
+    }
+    fclose(fp);
+
+    if (n != hdr.count) {
+        fprintf(stderr, "Warning: Dump truncated (%u of %u records)\n", n, hdr.count);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,597 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// GPIO benchmark: runs the daemon's software PWM thread (fan.c) and button
+// watch thread (button.c) against a gpio-sim chip created through configfs,
+// or against real lines wired back to an input ("loopback"). PWM edges are
+// timestamped (gpiod edge events on a loopback input; sysfs polling of the
+// simulated line otherwise, since gpio-sim cannot route an output to another
+// line's input) to report duty error and period jitter, and
+// simulated presses report the latency until the page is rendered. The
+// display is a link-time mock: oled_show_page() below renders the page
+// into a frame with the real composition code and timestamps it.
+// Optional spinning threads add synthetic CPU load. Results are CSV.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <gpiod.h>
+#include "fan.h"
+#include "button.h"
+#include "oled_render.h"
+#include "logger.h"
+#include "timebase.h"
+
+#define GPIO_SIM_CONFIGFS "/sys/kernel/config/gpio-sim"
+#define GPIO_SIM_NAME "radxa-penta-gpio-bench"
+#define GPIO_SIM_FAN_LINE 0
+#define GPIO_SIM_BUTTON_LINE 1
+#define BENCH_DEFAULT_SEC 3
+#define BENCH_DEFAULT_PRESSES 20
+#define BENCH_DEFAULT_POLL_US 20    // gpio-sim sysfs poll interval: the edge timestamp resolution
+#define BENCH_MAX_POLLS (1 << 20)
+#define BENCH_SETTLE_US 500000
+#define BENCH_PRESS_MS 200          // Short press: below BUTTON_LONG_PRESS_MS
+#define BENCH_RENDER_TIMEOUT_MS 3000
+#define BENCH_MAX_EDGES (1 << 16)
+#define BENCH_MAX_LOAD_THREADS 64
+#define BENCH_PATH_LEN 192
+
+static const double bench_duties[] = { 0.25, 0.50, 0.75 };
+
+typedef struct {
+    uint64_t ns;
+    int level;
+} edge_t;
+
+typedef struct {
+    int chip;
+    unsigned int line;
+} line_spec_t;
+
+typedef struct {
+    // gpio-sim
+    int sim;
+    char sim_dir[BENCH_PATH_LEN];
+    char sim_sysfs[BENCH_PATH_LEN];     // /sys/devices/platform/<dev>/<chip>
+
+    // Lines: fan output, its loopback input, button input, press driver
+    line_spec_t fan;
+    line_spec_t fan_in;
+    line_spec_t button;
+    line_spec_t press;
+    int have_fan_in;
+    int have_press;
+
+    // Edge capture (one producer thread at a time)
+    edge_t *edges;
+    size_t edge_count;
+    volatile int capturing;
+    int poll_us;                        // gpio-sim poll interval
+    double *poll_gaps;                  // Time between polls, µs
+    size_t poll_count;
+    struct gpiod_chip *in_chip;
+    struct gpiod_line_request *in_req;
+    struct gpiod_chip *press_chip;
+    struct gpiod_line_request *press_req;
+
+    volatile int load_running;
+} gpio_bench_t;
+
+// Mock display: what the button's page advance waits for
+static pthread_mutex_t render_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t render_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long render_count;
+static uint64_t render_done_ns;
+
+void oled_show_page(oled_t *oled, oled_page_t page) {
+    oled_frame_t frame;
+    oled_render_page(oled, page, &frame);
+    pthread_mutex_lock(&render_lock);
+    render_done_ns = timebase_raw_ns();
+    render_count++;
+    pthread_cond_broadcast(&render_cond);
+    pthread_mutex_unlock(&render_lock);
+}
+
+static int write_file(const char *path, const char *value) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    size_t len = strlen(value);
+    ssize_t n = write(fd, value, len);
+    close(fd);
+    return n == (ssize_t)len ? 0 : -1;
+}
+
+static int read_file(const char *path, char *buf, size_t len) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t n = read(fd, buf, len - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+static int parse_line_spec(const char *s, line_spec_t *spec) {
+    int chip;
+    unsigned int line;
+    if (sscanf(s, "%d:%u", &chip, &line) != 2 || chip < 0) return -1;
+    spec->chip = chip;
+    spec->line = line;
+    return 0;
+}
+
+// --- gpio-sim ---
+
+static void sim_destroy(gpio_bench_t *b) {
+    char path[BENCH_PATH_LEN + 16];
+    snprintf(path, sizeof(path), "%s/live", b->sim_dir);
+    write_file(path, "0");
+    snprintf(path, sizeof(path), "%s/bank0", b->sim_dir);
+    rmdir(path);
+    rmdir(b->sim_dir);
+    b->sim = 0;
+}
+
+// One simulated chip with two lines: 0 = fan, 1 = button
+static int sim_create(gpio_bench_t *b) {
+    char path[BENCH_PATH_LEN + 16];
+    char chip_name[32], dev_name[32];
+
+    snprintf(b->sim_dir, sizeof(b->sim_dir), "%s/%s", GPIO_SIM_CONFIGFS, GPIO_SIM_NAME);
+    if (mkdir(b->sim_dir, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Cannot create %s: %s (modprobe gpio-sim; configfs mounted; root)\n",
+                b->sim_dir, strerror(errno));
+        return -1;
+    }
+    b->sim = 1;
+    snprintf(path, sizeof(path), "%s/bank0", b->sim_dir);
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Cannot create %s: %s\n", path, strerror(errno));
+        sim_destroy(b);
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/bank0/num_lines", b->sim_dir);
+    if (write_file(path, "2") < 0) {
+        fprintf(stderr, "Error: Cannot set %s\n", path);
+        sim_destroy(b);
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/live", b->sim_dir);
+    if (write_file(path, "1") < 0) {
+        fprintf(stderr, "Error: Cannot bring the simulated chip live\n");
+        sim_destroy(b);
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/bank0/chip_name", b->sim_dir);
+    int ok = read_file(path, chip_name, sizeof(chip_name)) == 0;
+    snprintf(path, sizeof(path), "%s/dev_name", b->sim_dir);
+    ok = ok && read_file(path, dev_name, sizeof(dev_name)) == 0;
+    if (!ok || sscanf(chip_name, "gpiochip%d", &b->fan.chip) != 1) {
+        fprintf(stderr, "Error: Cannot identify the simulated chip\n");
+        sim_destroy(b);
+        return -1;
+    }
+    snprintf(b->sim_sysfs, sizeof(b->sim_sysfs), "/sys/devices/platform/%s/%s", dev_name, chip_name);
+    b->fan.line = GPIO_SIM_FAN_LINE;
+    b->button.chip = b->fan.chip;
+    b->button.line = GPIO_SIM_BUTTON_LINE;
+    return 0;
+}
+
+static int sim_set_pull(const gpio_bench_t *b, unsigned int line, int high) {
+    char path[BENCH_PATH_LEN + 32];
+    snprintf(path, sizeof(path), "%s/sim_gpio%u/pull", b->sim_sysfs, line);
+    return write_file(path, high ? "pull-up" : "pull-down");
+}
+
+// --- Edge capture ---
+
+static void record_edge(gpio_bench_t *b, uint64_t ns, int level) {
+    if (b->edge_count >= BENCH_MAX_EDGES) return;
+    b->edges[b->edge_count].ns = ns;
+    b->edges[b->edge_count].level = level;
+    b->edge_count++;
+}
+
+// gpio-sim: the output value the PWM thread drives, polled through sysfs
+// every poll_us on an absolute schedule rather than in a busy loop (which
+// would compete with the PWM thread it measures). An edge is known to
+// within the gap since the previous poll; the gaps are reported.
+static void *sim_capture_thread(void *arg) {
+    gpio_bench_t *b = arg;
+    char path[BENCH_PATH_LEN + 32];
+    snprintf(path, sizeof(path), "%s/sim_gpio%u/value", b->sim_sysfs, b->fan.line);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    // The first reading only sets the level: it is not an edge
+    int last = -1;
+    char c;
+    uint64_t prev_ns = 0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (b->capturing) {
+        if (pread(fd, &c, 1, 0) != 1) break;
+        uint64_t now_ns = timebase_raw_ns();
+        if (prev_ns && b->poll_count < BENCH_MAX_POLLS) {
+            b->poll_gaps[b->poll_count++] = (double)(now_ns - prev_ns) / 1e3;
+        }
+        prev_ns = now_ns;
+        int level = c == '1';
+        if (last < 0) {
+            last = level;
+        } else if (level != last) {
+            record_edge(b, now_ns, level);
+            last = level;
+        }
+
+        next.tv_nsec += (long)b->poll_us * 1000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    close(fd);
+    return NULL;
+}
+
+// Loopback: kernel-timestamped edge events on the input wired to the fan line
+static void *loopback_capture_thread(void *arg) {
+    gpio_bench_t *b = arg;
+    struct gpiod_edge_event_buffer *buf = gpiod_edge_event_buffer_new(64);
+    if (!buf) return NULL;
+    while (b->capturing) {
+        if (gpiod_line_request_wait_edge_events(b->in_req, 100000000) <= 0) continue;
+        int n = gpiod_line_request_read_edge_events(b->in_req, buf, 64);
+        for (int i = 0; i < n; i++) {
+            struct gpiod_edge_event *ev = gpiod_edge_event_buffer_get_event(buf, (unsigned long)i);
+            record_edge(b, gpiod_edge_event_get_timestamp_ns(ev),
+                        gpiod_edge_event_get_event_type(ev) == GPIOD_EDGE_EVENT_RISING_EDGE);
+        }
+    }
+    gpiod_edge_event_buffer_free(buf);
+    return NULL;
+}
+
+static struct gpiod_line_request *request_line(struct gpiod_chip **chip, const line_spec_t *spec, int output) {
+    char path[32];
+    snprintf(path, sizeof(path), "/dev/gpiochip%d", spec->chip);
+    *chip = gpiod_chip_open(path);
+    if (!*chip) return NULL;
+
+    struct gpiod_line_settings *settings = gpiod_line_settings_new();
+    struct gpiod_line_config *line_cfg = gpiod_line_config_new();
+    struct gpiod_request_config *req_cfg = gpiod_request_config_new();
+    struct gpiod_line_request *req = NULL;
+    if (settings && line_cfg && req_cfg) {
+        if (output) {
+            gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+            gpiod_line_settings_set_output_value(settings, GPIOD_LINE_VALUE_INACTIVE);
+        } else {
+            gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+            gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+            gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+        }
+        gpiod_line_config_add_line_settings(line_cfg, &spec->line, 1, settings);
+        gpiod_request_config_set_consumer(req_cfg, "radxa-penta-gpio-bench");
+        req = gpiod_chip_request_lines(*chip, req_cfg, line_cfg);
+    }
+    if (req_cfg) gpiod_request_config_free(req_cfg);
+    if (line_cfg) gpiod_line_config_free(line_cfg);
+    if (settings) gpiod_line_settings_free(settings);
+    if (!req) {
+        gpiod_chip_close(*chip);
+        *chip = NULL;
+    }
+    return req;
+}
+
+// --- Statistics ---
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double q) {
+    size_t i = (size_t)(q * (double)(n - 1) + 0.5);
+    return sorted[i < n ? i : n - 1];
+}
+
+static void print_stats(FILE *out, const char *name, double *v, size_t n) {
+    if (n == 0) {
+        fprintf(out, "%s,0,,,,,\n", name);
+        return;
+    }
+    qsort(v, n, sizeof(double), cmp_double);
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) sum += v[i];
+    fprintf(out, "%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f\n", name, n, sum / (double)n, percentile(v, n, 0.50),
+            percentile(v, n, 0.99), percentile(v, n, 0.999), v[n - 1]);
+}
+
+// Rising-to-rising periods and the high time inside each
+static void report_pwm(FILE *out, const gpio_bench_t *b, double duty, double period_s) {
+    size_t max = b->edge_count;
+    double *jitter = calloc(max + 1, sizeof(double));
+    double *error = calloc(max + 1, sizeof(double));
+    size_t n = 0;
+    if (!jitter || !error) {
+        free(jitter);
+        free(error);
+        return;
+    }
+
+    size_t rise = max;
+    uint64_t fall_ns = 0;
+    for (size_t i = 0; i < max; i++) {
+        const edge_t *e = &b->edges[i];
+        if (e->level) {
+            if (rise < max && fall_ns > b->edges[rise].ns) {
+                double period = (double)(e->ns - b->edges[rise].ns) / 1e9;
+                double high = (double)(fall_ns - b->edges[rise].ns) / 1e9;
+                jitter[n] = fabs(period - period_s) * 1e6;
+                error[n] = fabs(high / period - duty) * 100.0;
+                n++;
+            }
+            rise = i;
+        } else {
+            fall_ns = e->ns;
+        }
+    }
+
+    char name[48];
+    snprintf(name, sizeof(name), "pwm_period_jitter_us_d%02d", (int)lround(duty * 100.0));
+    print_stats(out, name, jitter, n);
+    snprintf(name, sizeof(name), "pwm_duty_error_pct_d%02d", (int)lround(duty * 100.0));
+    print_stats(out, name, error, n);
+    free(jitter);
+    free(error);
+}
+
+// --- Benchmarks ---
+
+static void bench_pwm(FILE *out, gpio_bench_t *b, int seconds) {
+    unit_config_t unit;
+    memset(&unit, 0, sizeof(unit));
+    unit.fan = UNIT_FAN_GPIO;
+    unit.fan_chip = b->fan.chip;
+    unit.fan_line = (int)b->fan.line;
+
+    fan_t fan;
+    if (fan_init(&fan, &unit) < 0) {
+        fprintf(stderr, "Error: Cannot start the software PWM on %d:%u\n", b->fan.chip, b->fan.line);
+        return;
+    }
+    for (size_t d = 0; d < sizeof(bench_duties) / sizeof(bench_duties[0]); d++) {
+        fan_set_duty_cycle(&fan, bench_duties[d]);
+        usleep(BENCH_SETTLE_US);
+
+        b->edge_count = 0;
+        b->poll_count = 0;
+        b->capturing = 1;
+        pthread_t t;
+        if (pthread_create(&t, NULL, b->sim ? sim_capture_thread : loopback_capture_thread, b) != 0) {
+            b->capturing = 0;
+            break;
+        }
+        sleep((unsigned int)seconds);
+        b->capturing = 0;
+        pthread_join(t, NULL);
+        report_pwm(out, b, bench_duties[d], fan.period_s);
+        if (b->sim) {
+            char name[48];
+            snprintf(name, sizeof(name), "sim_poll_gap_us_d%02d", (int)lround(bench_duties[d] * 100.0));
+            print_stats(out, name, b->poll_gaps, b->poll_count);
+        }
+    }
+    fan_cleanup(&fan);
+}
+
+static void drive_button(gpio_bench_t *b, int pressed) {
+    // button.c reads an active line as pressed
+    if (b->sim) {
+        sim_set_pull(b, b->button.line, pressed);
+    } else {
+        gpiod_line_request_set_value(b->press_req, b->press.line,
+                                     pressed ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE);
+    }
+}
+
+static void bench_button(FILE *out, gpio_bench_t *b, int presses) {
+    static oled_t oled;
+    memset(&oled, 0, sizeof(oled));
+    oled.initialized = 1;
+    oled.disks = ~0u;
+
+    button_t button;
+    if (button_init(&button, b->button.chip, b->button.line, &oled) < 0) return;
+    drive_button(b, 0);     // After the request: its pull-up bias sets the simulated pull
+    pthread_t t;
+    if (pthread_create(&t, NULL, button_watch_thread, &button) != 0) {
+        button_cleanup(&button);
+        return;
+    }
+    usleep(BENCH_SETTLE_US);
+
+    double *from_release = calloc((size_t)presses, sizeof(double));
+    double *from_press = calloc((size_t)presses, sizeof(double));
+    size_t n = 0;
+    unsigned int seed = 1;
+    for (int i = 0; from_release && from_press && i < presses; i++) {
+        // Spread presses over the watch thread's poll phase
+        usleep(200000u + (unsigned int)(rand_r(&seed) % 200) * 1000u);
+        pthread_mutex_lock(&render_lock);
+        unsigned long before = render_count;
+        pthread_mutex_unlock(&render_lock);
+
+        uint64_t pressed_ns = timebase_raw_ns();
+        drive_button(b, 1);
+        usleep(BENCH_PRESS_MS * 1000);
+        uint64_t released_ns = timebase_raw_ns();
+        drive_button(b, 0);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += BENCH_RENDER_TIMEOUT_MS / 1000;
+        pthread_mutex_lock(&render_lock);
+        int waited = 0;
+        while (render_count == before && waited == 0) {
+            waited = pthread_cond_timedwait(&render_cond, &render_lock, &deadline);
+        }
+        if (render_count != before) {
+            from_release[n] = (double)(render_done_ns - released_ns) / 1e6;
+            from_press[n] = (double)(render_done_ns - pressed_ns) / 1e6;
+            n++;
+        }
+        pthread_mutex_unlock(&render_lock);
+    }
+
+    button.initialized = 0;
+    pthread_join(t, NULL);
+    gpiod_line_request_release(button.request);
+    gpiod_chip_close(button.chip);
+
+    if (from_release && from_press) {
+        print_stats(out, "button_release_to_render_ms", from_release, n);
+        print_stats(out, "button_press_to_render_ms", from_press, n);
+        if (n < (size_t)presses) fprintf(stderr, "Warning: %zu of %d presses were not rendered\n", (size_t)presses - n, presses);
+    }
+    free(from_release);
+    free(from_press);
+}
+
+static void *load_thread(void *arg) {
+    const gpio_bench_t *b = arg;
+    volatile double x = 1.0;
+    while (b->load_running) {
+        x = x * 1.0000001 + 1e-9;
+    }
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-d sec] [-p presses] [-L threads] [-s us] [-o chip:line -i chip:line] [-b chip:line -w chip:line]\n"
+            "  -d  capture time per PWM duty (default %d)\n"
+            "  -p  simulated button presses (default %d)\n"
+            "  -L  threads spinning as synthetic CPU load (default 0)\n"
+            "  -s  gpio-sim poll interval in µs, the PWM edge resolution (default %d)\n"
+            "  -o/-i  loopback: software PWM on -o, wired to input -i (edge events)\n"
+            "  -b/-w  loopback: button input -b, driven from output -w\n"
+            "Without -o/-b a gpio-sim chip is created through configfs (root, gpio-sim module).\n",
+            prog, BENCH_DEFAULT_SEC, BENCH_DEFAULT_PRESSES, BENCH_DEFAULT_POLL_US);
+}
+
+int main(int argc, char *argv[]) {
+    static gpio_bench_t b;
+    int seconds = BENCH_DEFAULT_SEC;
+    int presses = BENCH_DEFAULT_PRESSES;
+    int load_threads = 0;
+    int have_fan = 0, have_button = 0;
+    b.poll_us = BENCH_DEFAULT_POLL_US;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:p:L:s:o:i:b:w:h")) != -1) {
+        int bad = 0;
+        switch (opt) {
+            case 'd': seconds = atoi(optarg); break;
+            case 'p': presses = atoi(optarg); break;
+            case 'L': load_threads = atoi(optarg); break;
+            case 's': b.poll_us = atoi(optarg); break;
+            case 'o': bad = parse_line_spec(optarg, &b.fan); have_fan = 1; break;
+            case 'i': bad = parse_line_spec(optarg, &b.fan_in); b.have_fan_in = 1; break;
+            case 'b': bad = parse_line_spec(optarg, &b.button); have_button = 1; break;
+            case 'w': bad = parse_line_spec(optarg, &b.press); b.have_press = 1; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+        if (bad) {
+            fprintf(stderr, "Error: Bad line '%s' (expected chip:line)\n", optarg);
+            return 2;
+        }
+    }
+    if (seconds <= 0 || presses < 0 || load_threads < 0 || load_threads > BENCH_MAX_LOAD_THREADS || b.poll_us <= 0) {
+        fprintf(stderr, "Error: Bad -d, -p, -L or -s value\n");
+        return 2;
+    }
+    if (have_fan != b.have_fan_in || have_button != b.have_press) {
+        fprintf(stderr, "Error: Loopback needs both ends (-o with -i, -b with -w)\n");
+        return 2;
+    }
+    logger_init("warning", 0, NULL);
+
+    b.edges = calloc(BENCH_MAX_EDGES, sizeof(edge_t));
+    if (!b.edges) return 1;
+    if (!have_fan && !have_button) {
+        if (sim_create(&b) < 0) return 1;
+        have_fan = have_button = 1;
+        b.poll_gaps = calloc(BENCH_MAX_POLLS, sizeof(double));
+        if (!b.poll_gaps) {
+            sim_destroy(&b);
+            return 1;
+        }
+    }
+    if (!b.sim && b.have_fan_in && !(b.in_req = request_line(&b.in_chip, &b.fan_in, 0))) {
+        fprintf(stderr, "Error: Cannot request input %d:%u for edge events\n", b.fan_in.chip, b.fan_in.line);
+        return 1;
+    }
+    if (!b.sim && b.have_press && !(b.press_req = request_line(&b.press_chip, &b.press, 1))) {
+        fprintf(stderr, "Error: Cannot request output %d:%u\n", b.press.chip, b.press.line);
+        return 1;
+    }
+
+    // fan.c and button.c report on stdout; keep stdout for the CSV only
+    fflush(stdout);
+    int csv_fd = dup(STDOUT_FILENO);
+    FILE *out = csv_fd >= 0 ? fdopen(csv_fd, "w") : NULL;
+    if (!out) return 1;
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    pthread_t load[BENCH_MAX_LOAD_THREADS];
+    int loaded = 0;
+    b.load_running = 1;
+    for (int i = 0; i < load_threads; i++) {
+        if (pthread_create(&load[loaded], NULL, load_thread, &b) == 0) loaded++;
+    }
+
+    if (b.sim) {
+        fprintf(out, "# mode=gpio-sim load_threads=%d sim_poll_us=%d (PWM edges to within one poll gap)\n",
+                loaded, b.poll_us);
+    } else {
+        fprintf(out, "# mode=loopback load_threads=%d\n", loaded);
+    }
+    fprintf(out, "benchmark,samples,mean,p50,p99,p999,max\n");
+    if (have_fan) bench_pwm(out, &b, seconds);
+    if (have_button && presses > 0) bench_button(out, &b, presses);
+    fflush(out);
+
+    b.load_running = 0;
+    for (int i = 0; i < loaded; i++) {
+        pthread_join(load[i], NULL);
+    }
+    if (b.in_req) gpiod_line_request_release(b.in_req);
+    if (b.in_chip) gpiod_chip_close(b.in_chip);
+    if (b.press_req) gpiod_line_request_release(b.press_req);
+    if (b.press_chip) gpiod_chip_close(b.press_chip);
+    if (b.sim) sim_destroy(&b);
+    free(b.edges);
+    free(b.poll_gaps);
+    fclose(out);
+    return 0;
+}
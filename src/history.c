@@ -0,0 +1,453 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "history.h"
+#include "timebase.h"
+
+#define HISTORY_FILE_MAGIC 0x53485052u   // "RPHS"
+#define HISTORY_BLOCK_MAGIC 0x4b4c4248u  // "HBLK"
+#define HISTORY_VERSION 1
+#define HISTORY_MAX_BUCKETS 256
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t nseries;
+    uint32_t block_size;
+    uint32_t nblocks;
+} history_file_hdr_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;           // Increases with every new block; 0 = never written
+    int64_t first_ts;
+    int64_t last_ts;
+    uint16_t count;
+    uint16_t reserved;
+    uint32_t nbits;         // Payload bits in use
+} history_block_hdr_t;
+
+#define PAYLOAD_BYTES (HISTORY_BLOCK_SIZE - sizeof(history_block_hdr_t))
+#define PAYLOAD_BITS ((uint32_t)(PAYLOAD_BYTES * 8))
+// Worst case for one row: 4+32 timestamp bits, 2+5+6+64 bits per value
+#define MAX_ROW_BITS (4u + 32u + (uint32_t)HISTORY_SERIES * (2u + 5u + 6u + 64u))
+
+// Values are stored as integer-valued doubles (deci-°C, °C, per-mille):
+// consecutive readings then differ in only a few mantissa bits, which is
+// what makes XOR encoding effective.
+static const double series_scale[HISTORY_SERIES] = { 10.0, 1.0, 1000.0 };
+static const char *series_names[HISTORY_SERIES] = { "cpu", "ssd", "duty" };
+
+const char *history_series_name(history_series_t series) {
+    return (series >= 0 && series < HISTORY_SERIES) ? series_names[series] : "?";
+}
+
+int history_series_from_name(const char *name) {
+    for (int i = 0; i < HISTORY_SERIES; i++) {
+        if (strcmp(name, series_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// --- Bit stream helpers (MSB first) ---
+
+static void put_bits(uint8_t *p, uint32_t *nbits, uint64_t v, int n) {
+    while (n > 0) {
+        uint32_t pos = *nbits;
+        int room = 8 - (int)(pos & 7u);
+        int take = n < room ? n : room;
+        uint8_t chunk = (uint8_t)((v >> (n - take)) & ((1u << take) - 1u));
+        p[pos >> 3] |= (uint8_t)(chunk << (room - take));
+        *nbits += (uint32_t)take;
+        n -= take;
+    }
+}
+
+typedef struct {
+    const uint8_t *p;
+    uint32_t pos;
+    uint32_t end;
+    int err;
+} bitreader_t;
+
+static uint64_t get_bits(bitreader_t *r, int n) {
+    if (r->pos + (uint32_t)n > r->end) {
+        r->err = 1;
+        return 0;
+    }
+    uint64_t v = 0;
+    while (n > 0) {
+        int avail = 8 - (int)(r->pos & 7u);
+        int take = n < avail ? n : avail;
+        uint8_t bits = (uint8_t)((r->p[r->pos >> 3] >> (avail - take)) & ((1u << take) - 1u));
+        v = (v << take) | bits;
+        r->pos += (uint32_t)take;
+        n -= take;
+    }
+    return v;
+}
+
+static uint64_t double_bits(double v) {
+    uint64_t b;
+    memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+static double bits_double(uint64_t b) {
+    double v;
+    memcpy(&v, &b, sizeof(v));
+    return v;
+}
+
+// --- Block management ---
+
+static uint8_t *block_ptr(history_t *h, uint32_t index) {
+    return h->map + (size_t)(index + 1) * HISTORY_BLOCK_SIZE;
+}
+
+static void block_start(history_t *h) {
+    memset(h->cur, 0, sizeof(h->cur));
+    history_block_hdr_t *bh = (history_block_hdr_t *)h->cur;
+    bh->magic = HISTORY_BLOCK_MAGIC;
+    bh->seq = h->next_seq++;
+    if (h->next_seq == 0) h->next_seq = 1; // seq 0 means "unused"
+    h->prev_ts = 0;
+    h->prev_delta = 0;
+    for (int s = 0; s < HISTORY_SERIES; s++) {
+        h->prev_bits[s] = 0;
+        h->prev_lead[s] = -1;
+        h->prev_trail[s] = 0;
+    }
+}
+
+static void block_flush(history_t *h) {
+    history_block_hdr_t *bh = (history_block_hdr_t *)h->cur;
+    if (bh->count == 0) return;
+
+    uint8_t *dst = block_ptr(h, h->head);
+    memcpy(dst, h->cur, HISTORY_BLOCK_SIZE);
+    msync(dst, HISTORY_BLOCK_SIZE, MS_ASYNC);
+    h->dirty = 0;
+}
+
+static void block_seal(history_t *h) {
+    block_flush(h);
+    h->head = (h->head + 1) % h->nblocks;
+    block_start(h);
+}
+
+// --- Open / close ---
+
+static int ensure_parent_dir(const char *path) {
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (!slash || slash == dir) return 0;
+    *slash = '\0';
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+int history_open(history_t *h, const char *path, size_t size_mb, int flush_sec) {
+    memset(h, 0, sizeof(history_t));
+    h->fd = -1;
+    h->flush_sec = flush_sec > 0 ? flush_sec : HISTORY_DEFAULT_FLUSH_SEC;
+
+    size_t total_blocks = size_mb * 1024u * 1024u / HISTORY_BLOCK_SIZE;
+    if (total_blocks < 3) {
+        fprintf(stderr, "Warning: History size too small (%zu MB)\n", size_mb);
+        return -1;
+    }
+    h->nblocks = (uint32_t)(total_blocks - 1);
+    h->map_size = total_blocks * HISTORY_BLOCK_SIZE;
+
+    if (ensure_parent_dir(path) < 0) {
+        fprintf(stderr, "Warning: Cannot create directory for %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    h->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (h->fd < 0) {
+        fprintf(stderr, "Warning: Cannot open history file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    history_file_hdr_t want = { HISTORY_FILE_MAGIC, HISTORY_VERSION, HISTORY_SERIES, HISTORY_BLOCK_SIZE, h->nblocks };
+    history_file_hdr_t have;
+    struct stat st;
+    int reuse = (fstat(h->fd, &st) == 0 && (size_t)st.st_size == h->map_size &&
+                 pread(h->fd, &have, sizeof(have), 0) == (ssize_t)sizeof(have) &&
+                 memcmp(&have, &want, sizeof(want)) == 0);
+
+    if (!reuse) {
+        // New file or changed geometry: start over with a preallocated file
+        // so later writes never need to allocate blocks on the filesystem.
+        if (ftruncate(h->fd, 0) < 0 ||
+            (posix_fallocate(h->fd, 0, (off_t)h->map_size) != 0 && ftruncate(h->fd, (off_t)h->map_size) < 0) ||
+            pwrite(h->fd, &want, sizeof(want), 0) != (ssize_t)sizeof(want)) {
+            fprintf(stderr, "Warning: Cannot preallocate history file %s: %s\n", path, strerror(errno));
+            close(h->fd);
+            h->fd = -1;
+            return -1;
+        }
+    }
+
+    void *p = mmap(NULL, h->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, h->fd, 0);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "Warning: Cannot map history file: %s\n", strerror(errno));
+        close(h->fd);
+        h->fd = -1;
+        return -1;
+    }
+    h->map = (uint8_t *)p;
+
+    // Resume after the newest block; the partially filled block from the
+    // previous run stays readable as-is.
+    uint32_t max_seq = 0, max_idx = h->nblocks - 1, used = 0;
+    for (uint32_t i = 0; i < h->nblocks; i++) {
+        const history_block_hdr_t *bh = (const history_block_hdr_t *)block_ptr(h, i);
+        if (bh->magic != HISTORY_BLOCK_MAGIC || bh->seq == 0) continue;
+        used++;
+        if (bh->seq > max_seq) {
+            max_seq = bh->seq;
+            max_idx = i;
+        }
+    }
+    h->head = (max_idx + 1) % h->nblocks;
+    h->next_seq = max_seq + 1;
+    block_start(h);
+    h->last_flush = timebase_mono_sec();
+
+    pthread_mutex_init(&h->lock, NULL);
+
+    printf("History store: %s (%zu MB, %u blocks, %u in use%s)\n",
+           path, size_mb, h->nblocks, used, reuse ? "" : ", new");
+    return 0;
+}
+
+void history_close(history_t *h) {
+    if (!h->map) return;
+
+    pthread_mutex_lock(&h->lock);
+    block_flush(h);
+    msync(h->map, h->map_size, MS_SYNC);
+    munmap(h->map, h->map_size);
+    h->map = NULL;
+    close(h->fd);
+    h->fd = -1;
+    pthread_mutex_unlock(&h->lock);
+    // The mutex is left initialized: a detached reader may still take it
+}
+
+// --- Append ---
+
+static void encode_value(history_t *h, uint8_t *payload, uint32_t *nbits, int s, uint64_t bits) {
+    uint64_t x = bits ^ h->prev_bits[s];
+    h->prev_bits[s] = bits;
+
+    if (x == 0) {
+        put_bits(payload, nbits, 0, 1);
+        return;
+    }
+
+    int lead = __builtin_clzll(x);
+    int trail = __builtin_ctzll(x);
+    if (lead > 31) lead = 31;
+
+    if (h->prev_lead[s] >= 0 && lead >= h->prev_lead[s] && trail >= h->prev_trail[s]) {
+        // Meaningful bits fit in the previous window
+        int len = 64 - h->prev_lead[s] - h->prev_trail[s];
+        put_bits(payload, nbits, 2, 2);
+        put_bits(payload, nbits, x >> h->prev_trail[s], len);
+    } else {
+        int len = 64 - lead - trail;
+        put_bits(payload, nbits, 3, 2);
+        put_bits(payload, nbits, (uint64_t)lead, 5);
+        put_bits(payload, nbits, (uint64_t)(len - 1), 6);
+        put_bits(payload, nbits, x >> trail, len);
+        h->prev_lead[s] = lead;
+        h->prev_trail[s] = trail;
+    }
+}
+
+void history_append(history_t *h, int64_t ts, const double *values) {
+    if (!h->map) return;
+
+    pthread_mutex_lock(&h->lock);
+
+    history_block_hdr_t *bh = (history_block_hdr_t *)h->cur;
+    if (bh->count > 0) {
+        int64_t dod = (ts - h->prev_ts) - h->prev_delta;
+        if (bh->nbits + MAX_ROW_BITS > PAYLOAD_BITS || bh->count == UINT16_MAX ||
+            dod > INT32_MAX || dod < INT32_MIN) {
+            block_seal(h);
+            bh = (history_block_hdr_t *)h->cur;
+        }
+    }
+
+    uint8_t *payload = h->cur + sizeof(history_block_hdr_t);
+    uint32_t nbits = bh->nbits;
+    uint64_t bits[HISTORY_SERIES];
+    for (int s = 0; s < HISTORY_SERIES; s++) {
+        bits[s] = double_bits(round(values[s] * series_scale[s]));
+    }
+
+    if (bh->count == 0) {
+        bh->first_ts = ts;
+        for (int s = 0; s < HISTORY_SERIES; s++) {
+            put_bits(payload, &nbits, bits[s], 64);
+            h->prev_bits[s] = bits[s];
+        }
+        h->prev_delta = 0;
+    } else {
+        int64_t delta = ts - h->prev_ts;
+        int64_t dod = delta - h->prev_delta;
+        if (dod == 0) {
+            put_bits(payload, &nbits, 0, 1);
+        } else if (dod >= -63 && dod <= 64) {
+            put_bits(payload, &nbits, 2, 2);
+            put_bits(payload, &nbits, (uint64_t)(dod + 63), 7);
+        } else if (dod >= -255 && dod <= 256) {
+            put_bits(payload, &nbits, 6, 3);
+            put_bits(payload, &nbits, (uint64_t)(dod + 255), 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            put_bits(payload, &nbits, 14, 4);
+            put_bits(payload, &nbits, (uint64_t)(dod + 2047), 12);
+        } else {
+            put_bits(payload, &nbits, 15, 4);
+            put_bits(payload, &nbits, (uint64_t)(uint32_t)(int32_t)dod, 32);
+        }
+        h->prev_delta = delta;
+        for (int s = 0; s < HISTORY_SERIES; s++) {
+            encode_value(h, payload, &nbits, s, bits[s]);
+        }
+    }
+
+    h->prev_ts = ts;
+    bh->nbits = nbits;
+    bh->last_ts = ts;
+    bh->count++;
+    h->dirty = 1;
+
+    pthread_mutex_unlock(&h->lock);
+}
+
+void history_maybe_flush(history_t *h, double now_mono) {
+    if (!h->map || !h->dirty || now_mono - h->last_flush < (double)h->flush_sec) return;
+
+    pthread_mutex_lock(&h->lock);
+    block_flush(h);
+    h->last_flush = now_mono;
+    pthread_mutex_unlock(&h->lock);
+}
+
+// --- Query ---
+
+typedef struct {
+    int series;
+    int64_t from;
+    int64_t to;
+    size_t nbuckets;
+    double *sums;
+    uint32_t *counts;
+    size_t samples;
+} query_t;
+
+static int64_t sign_extend(uint64_t v, int bits) {
+    uint64_t m = 1ull << (bits - 1);
+    return (int64_t)((v ^ m) - m);
+}
+
+static void query_block(query_t *q, const uint8_t *block) {
+    const history_block_hdr_t *bh = (const history_block_hdr_t *)block;
+    if (bh->magic != HISTORY_BLOCK_MAGIC || bh->seq == 0 || bh->count == 0) return;
+    if (bh->last_ts < q->from || bh->first_ts >= q->to) return;
+
+    bitreader_t r = { block + sizeof(history_block_hdr_t), 0, bh->nbits, 0 };
+    if (r.end > PAYLOAD_BITS) return;
+
+    uint64_t prev[HISTORY_SERIES];
+    int lead[HISTORY_SERIES], trail[HISTORY_SERIES];
+    int64_t ts = bh->first_ts, delta = 0;
+
+    for (uint32_t i = 0; i < bh->count && !r.err; i++) {
+        if (i == 0) {
+            for (int s = 0; s < HISTORY_SERIES; s++) {
+                prev[s] = get_bits(&r, 64);
+                lead[s] = 0;
+                trail[s] = 0;
+            }
+        } else {
+            int64_t dod;
+            if (get_bits(&r, 1) == 0) dod = 0;
+            else if (get_bits(&r, 1) == 0) dod = (int64_t)get_bits(&r, 7) - 63;
+            else if (get_bits(&r, 1) == 0) dod = (int64_t)get_bits(&r, 9) - 255;
+            else if (get_bits(&r, 1) == 0) dod = (int64_t)get_bits(&r, 12) - 2047;
+            else dod = sign_extend(get_bits(&r, 32), 32);
+            delta += dod;
+            ts += delta;
+
+            for (int s = 0; s < HISTORY_SERIES; s++) {
+                if (get_bits(&r, 1) == 0) continue;
+                if (get_bits(&r, 1) == 1) {
+                    lead[s] = (int)get_bits(&r, 5);
+                    int len = (int)get_bits(&r, 6) + 1;
+                    trail[s] = 64 - lead[s] - len;
+                    if (trail[s] < 0) { r.err = 1; break; }
+                }
+                int len = 64 - lead[s] - trail[s];
+                prev[s] ^= get_bits(&r, len) << trail[s];
+            }
+        }
+        if (r.err) break;
+
+        if (ts >= q->from && ts < q->to) {
+            size_t b = (size_t)((double)(ts - q->from) * (double)q->nbuckets / (double)(q->to - q->from));
+            if (b >= q->nbuckets) b = q->nbuckets - 1;
+            q->sums[b] += bits_double(prev[q->series]) / series_scale[q->series];
+            q->counts[b]++;
+            q->samples++;
+        }
+    }
+}
+
+size_t history_query(history_t *h, history_series_t series, int64_t from, int64_t to,
+                     double *out, size_t nbuckets) {
+    if (nbuckets > HISTORY_MAX_BUCKETS) nbuckets = HISTORY_MAX_BUCKETS;
+    for (size_t i = 0; i < nbuckets; i++) out[i] = (double)NAN;
+    if (series < 0 || series >= HISTORY_SERIES || nbuckets == 0 || to <= from) return 0;
+
+    uint32_t counts[HISTORY_MAX_BUCKETS];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < nbuckets; i++) out[i] = 0.0;
+
+    query_t q = { (int)series, from, to, nbuckets, out, counts, 0 };
+
+    pthread_mutex_lock(&h->lock);
+    if (!h->map) { // Closed while the OLED thread was still drawing
+        pthread_mutex_unlock(&h->lock);
+        return 0;
+    }
+    for (uint32_t i = 0; i < h->nblocks; i++) {
+        if (i == h->head) continue; // Superseded by the RAM block
+        query_block(&q, block_ptr(h, i));
+    }
+    query_block(&q, h->cur);
+    pthread_mutex_unlock(&h->lock);
+
+    for (size_t i = 0; i < nbuckets; i++) {
+        out[i] = counts[i] ? out[i] / counts[i] : (double)NAN;
+    }
+    return q.samples;
+}
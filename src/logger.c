@@ -0,0 +1,248 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "logger.h"
+#include "timebase.h"
+
+typedef struct {
+    const char *site;           // Format string pointer identifies the call site
+    logger_level_t level;
+    double window_start;
+    unsigned int count;         // Messages emitted in the current window
+    unsigned long suppressed;   // Dropped by the rate limit in this window
+    uint64_t last_hash;         // Last emitted message text
+    double last_at;
+    unsigned long repeats;      // Identical messages folded since last_at
+} logger_site_t;
+
+static pthread_mutex_t logger_lock = PTHREAD_MUTEX_INITIALIZER;
+static logger_level_t threshold = LOGGER_INFO;
+static int journal_fd = -1;
+static logger_site_t sites[LOGGER_SITES];
+
+static const struct {
+    const char *name;
+    logger_level_t level;
+} level_names[] = {
+    { "error", LOGGER_ERROR },
+    { "warning", LOGGER_WARNING },
+    { "info", LOGGER_INFO },
+    { "debug", LOGGER_DEBUG },
+    { "verbose", LOGGER_VERBOSE },
+};
+
+int logger_parse_level(const char *name) {
+    for (size_t i = 0; i < sizeof(level_names) / sizeof(level_names[0]); i++) {
+        if (strcmp(name, level_names[i].name) == 0) return (int)level_names[i].level;
+    }
+    return -1;
+}
+
+int logger_enabled(logger_level_t level) {
+    return level <= threshold;
+}
+
+void logger_init(const char *level_name, int journal, const char *journal_socket) {
+    int level = -1;
+    if (level_name && strcmp(level_name, "auto") != 0) {
+        level = logger_parse_level(level_name);
+        if (level < 0) {
+            fprintf(stderr, "Warning: Unknown log level '%s', using RADXA_DEBUG\n", level_name);
+        }
+    }
+    if (level < 0) {
+        // Legacy switch: RADXA_DEBUG=1 debug, =2 verbose (parsed once here)
+        const char *dbg = getenv("RADXA_DEBUG");
+        if (dbg && strcmp(dbg, "2") == 0) level = LOGGER_VERBOSE;
+        else if (dbg && strcmp(dbg, "1") == 0) level = LOGGER_DEBUG;
+        else level = LOGGER_INFO;
+    }
+    threshold = (logger_level_t)level;
+
+    if (journal < 0) {
+        journal = getenv("JOURNAL_STREAM") != NULL;
+    }
+    if (!journal || !journal_socket || !*journal_socket) return;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(journal_socket) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Warning: Journal socket path too long: %s\n", journal_socket);
+        return;
+    }
+    strcpy(addr.sun_path, journal_socket);
+
+    // Non-blocking: a stalled journald must never delay the control loop
+    journal_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (journal_fd < 0 || connect(journal_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Warning: Cannot connect to journal socket %s: %s (logging to stdout/stderr)\n",
+                journal_socket, strerror(errno));
+        if (journal_fd >= 0) close(journal_fd);
+        journal_fd = -1;
+    }
+}
+
+void logger_fields_init(logger_fields_t *f) {
+    f->len = 0;
+    f->buf[0] = '\0';
+}
+
+void logger_field(logger_fields_t *f, const char *key, const char *fmt, ...) {
+    size_t room = sizeof(f->buf) - f->len;
+    int n = snprintf(f->buf + f->len, room, "%s=", key);
+    if (n < 0 || (size_t)n >= room) {
+        f->buf[f->len] = '\0';
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    int v = vsnprintf(f->buf + f->len + (size_t)n, room - (size_t)n, fmt, ap);
+    va_end(ap);
+    // Drop the whole field if it (plus its newline) does not fit
+    if (v < 0 || (size_t)n + (size_t)v + 1 >= room) {
+        f->buf[f->len] = '\0';
+        return;
+    }
+    f->len += (size_t)n + (size_t)v;
+    f->buf[f->len++] = '\n';
+    f->buf[f->len] = '\0';
+}
+
+// One record = one sendmsg() datagram (journald native protocol) or one
+// write of a complete line; caller holds logger_lock.
+static void emit(logger_level_t level, const logger_fields_t *fields, const char *msg) {
+    if (journal_fd >= 0) {
+        char priority[16];
+        snprintf(priority, sizeof(priority), "PRIORITY=%d\n", level > LOGGER_DEBUG ? (int)LOGGER_DEBUG : (int)level);
+        static const char ident[] = "SYSLOG_IDENTIFIER=" LOGGER_IDENTIFIER "\n";
+        static const char msg_key[] = "MESSAGE=";
+
+        struct iovec iov[6];
+        int n = 0;
+        iov[n].iov_base = priority; iov[n++].iov_len = strlen(priority);
+        iov[n].iov_base = (void *)(uintptr_t)ident; iov[n++].iov_len = sizeof(ident) - 1;
+        iov[n].iov_base = (void *)(uintptr_t)msg_key; iov[n++].iov_len = sizeof(msg_key) - 1;
+        iov[n].iov_base = (void *)(uintptr_t)msg; iov[n++].iov_len = strlen(msg);
+        iov[n].iov_base = (void *)(uintptr_t)"\n"; iov[n++].iov_len = 1;
+        if (fields && fields->len > 0) {
+            iov[n].iov_base = (void *)(uintptr_t)fields->buf; iov[n++].iov_len = fields->len;
+        }
+
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = iov;
+        mh.msg_iovlen = (size_t)n;
+        if (sendmsg(journal_fd, &mh, MSG_NOSIGNAL) >= 0) return;
+    }
+
+    char line[LOGGER_MESSAGE_SIZE + 1];
+    int len = snprintf(line, sizeof(line), "%s\n", msg);
+    if (len < 0) return;
+    if ((size_t)len >= sizeof(line)) len = (int)sizeof(line) - 1;
+    fwrite(line, 1, (size_t)len, level <= LOGGER_WARNING ? stderr : stdout);
+}
+
+static uint64_t hash_text(const char *s) {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (; *s; s++) {
+        h ^= (uint8_t)*s;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static logger_site_t *site_for(const char *fmt) {
+    for (size_t i = 0; i < LOGGER_SITES; i++) {
+        if (sites[i].site == fmt) return &sites[i];
+        if (!sites[i].site) {
+            sites[i].site = fmt;
+            return &sites[i];
+        }
+    }
+    return NULL; // Table full: this site is not limited
+}
+
+static void site_report(logger_site_t *s, double now, int window_over) {
+    char msg[96];
+    if (s->repeats > 0) {
+        snprintf(msg, sizeof(msg), "[Log] Previous message repeated %lu times", s->repeats);
+        emit(s->level, NULL, msg);
+        s->repeats = 0;
+    }
+    if (window_over) {
+        if (s->suppressed > 0) {
+            snprintf(msg, sizeof(msg), "[Log] %lu similar messages suppressed (rate limit)", s->suppressed);
+            emit(s->level, NULL, msg);
+        }
+        s->window_start = now;
+        s->count = 0;
+        s->suppressed = 0;
+    }
+}
+
+void logger_log(logger_level_t level, const logger_fields_t *fields, const char *fmt, ...) {
+    if (level > threshold) return;
+
+    char msg[LOGGER_MESSAGE_SIZE];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    // journald's simple KEY=value form cannot carry newlines
+    for (char *p = msg; *p; p++) {
+        if (*p == '\n') *p = ' ';
+    }
+
+    uint64_t hash = hash_text(msg);
+    double now = timebase_mono_sec();
+
+    pthread_mutex_lock(&logger_lock);
+    logger_site_t *s = site_for(fmt);
+    if (s) {
+        s->level = level;
+        if (s->last_at > 0.0 && s->last_hash == hash && now - s->last_at < LOGGER_DEDUP_SEC) {
+            s->repeats++;
+            pthread_mutex_unlock(&logger_lock);
+            return;
+        }
+        site_report(s, now, now - s->window_start >= LOGGER_RATE_INTERVAL_SEC);
+        if (s->count >= LOGGER_RATE_BURST) {
+            s->suppressed++;
+            pthread_mutex_unlock(&logger_lock);
+            return;
+        }
+        s->count++;
+        s->last_hash = hash;
+        s->last_at = now;
+    }
+    emit(level, fields, msg);
+    pthread_mutex_unlock(&logger_lock);
+}
+
+void logger_close(void) {
+    pthread_mutex_lock(&logger_lock);
+    double now = timebase_mono_sec();
+    for (size_t i = 0; i < LOGGER_SITES && sites[i].site; i++) {
+        site_report(&sites[i], now, 1);
+    }
+    if (journal_fd >= 0) {
+        close(journal_fd);
+        journal_fd = -1;
+    }
+    pthread_mutex_unlock(&logger_lock);
+}
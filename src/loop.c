@@ -0,0 +1,717 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <math.h>
+#include "loop.h"
+#include "thermal.h"
+#include "timebase.h"
+#include "commands.h"
+#include "profile.h"
+#include "logger.h"
+
+static const double stage_quantiles[] = { 0.5, 0.9, 0.99 };
+_Static_assert(sizeof(stage_quantiles) / sizeof(stage_quantiles[0]) == LOOP_STAGE_QUANTILES, "one series per quantile");
+
+static const double latency_buckets[] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+    0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0
+};
+static const double jitter_buckets[] = {
+    0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01
+};
+
+static void loop_metrics_register(loop_t *l, fan_t *fan) {
+    metrics_t *m = &l->metrics;
+    loop_metrics_t *lm = &l->series;
+    const config_t *cfg = l->cfg;
+    char labels[METRICS_LABELS_LEN];
+
+    lm->temp_cpu = metrics_gauge(m, "radxa_penta_temperature_celsius", "Last raw sensor reading", "sensor=\"cpu\"");
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        snprintf(labels, sizeof(labels), "sensor=\"%s\"", thermal_ssd_device_name(i));
+        lm->temp_ssd[i] = metrics_gauge(m, "radxa_penta_temperature_celsius", "Last raw sensor reading", labels);
+    }
+    lm->temp_ambient = cfg->ambient_source[0]
+        ? metrics_gauge(m, "radxa_penta_temperature_celsius", "Last raw sensor reading", "sensor=\"ambient\"")
+        : NULL;
+    // SMART health; NaN until a drive reports the field
+    static const char *const health_names[5][2] = {
+        { "radxa_penta_ssd_reallocated_sectors", "Reallocated sectors (SMART 5)" },
+        { "radxa_penta_ssd_pending_sectors", "Current pending sectors (SMART 197)" },
+        { "radxa_penta_ssd_wear_leveling_normalized", "Normalized wear indicator, 100 = new (SMART 177/231/233)" },
+        { "radxa_penta_ssd_percentage_used", "NVMe percentage of rated endurance used" },
+        { "radxa_penta_ssd_media_errors", "NVMe media and data integrity errors" },
+    };
+    for (int f = 0; f < 5; f++) {
+        for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+            snprintf(labels, sizeof(labels), "device=\"%s\"", thermal_ssd_device_name(i));
+            lm->health[f][i] = metrics_gauge(m, health_names[f][0], health_names[f][1], labels);
+        }
+    }
+    lm->filtered_cpu = metrics_gauge(m, "radxa_penta_filtered_temperature_celsius", "Moving-average temperature used by the controller", "sensor=\"cpu\"");
+    lm->filtered_ssd = metrics_gauge(m, "radxa_penta_filtered_temperature_celsius", "Moving-average temperature used by the controller", "sensor=\"ssd_max\"");
+    lm->age_cpu = metrics_gauge(m, "radxa_penta_sample_age_seconds", "Age of the sample the controller last acted on", "sensor=\"cpu\"");
+    lm->age_ssd = metrics_gauge(m, "radxa_penta_sample_age_seconds", "Age of the sample the controller last acted on", "sensor=\"ssd\"");
+    lm->duty = metrics_gauge(m, "radxa_penta_fan_duty_ratio", "Duty cycle applied to the fan (0-1)", NULL);
+    lm->duty_target = metrics_gauge(m, "radxa_penta_fan_target_duty_ratio", "Curve target before rate limiting (0-1)", NULL);
+    lm->hold = metrics_gauge(m, "radxa_penta_cooldown_hold_active", "1 while the cooldown hold blocks decreases", NULL);
+    lm->deadband = metrics_gauge(m, "radxa_penta_deadband_active", "1 when the last tick was suppressed by the dead-band", NULL);
+    lm->ticks = metrics_counter(m, "radxa_penta_control_ticks_total", "Control loop iterations", NULL);
+    lm->period = metrics_gauge(m, "radxa_penta_control_period_seconds", "Current adaptive control period", NULL);
+
+    lm->tick_duration = metrics_histogram(m, "radxa_penta_tick_duration_seconds", "Control tick duration", NULL,
+                                          latency_buckets, sizeof(latency_buckets) / sizeof(latency_buckets[0]));
+    lm->read_cpu = metrics_histogram(m, "radxa_penta_sensor_read_seconds", "Sensor read latency", "sensor=\"cpu\"",
+                                     latency_buckets, sizeof(latency_buckets) / sizeof(latency_buckets[0]));
+    lm->read_ssd = metrics_histogram(m, "radxa_penta_sensor_read_seconds", "Sensor read latency", "sensor=\"ssd\"",
+                                     latency_buckets, sizeof(latency_buckets) / sizeof(latency_buckets[0]));
+
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        for (size_t q = 0; q < LOOP_STAGE_QUANTILES; q++) {
+            snprintf(labels, sizeof(labels), "stage=\"%s\",quantile=\"%g\"", stages_name((stage_id_t)s), stage_quantiles[q]);
+            lm->stage_latency[s][q] = metrics_gauge(m, "radxa_penta_stage_latency_seconds",
+                                                    "Pipeline stage latency percentile since start (CLOCK_MONOTONIC_RAW)", labels);
+        }
+    }
+
+    lm->cpu_self = metrics_gauge(m, "radxa_penta_self_cpu_percent", "Daemon CPU use over the last budget window (% of one core)", "scope=\"process\"");
+    lm->cpu_children = metrics_gauge(m, "radxa_penta_self_cpu_percent", "Daemon CPU use over the last budget window (% of one core)", "scope=\"children\"");
+    lm->cpu_loop = metrics_gauge(m, "radxa_penta_self_cpu_percent", "Daemon CPU use over the last budget window (% of one core)", "scope=\"loop_thread\"");
+    lm->cpu_oled = metrics_gauge(m, "radxa_penta_self_cpu_percent", "Daemon CPU use over the last budget window (% of one core)", "scope=\"oled_thread\"");
+    lm->wakeups = metrics_gauge(m, "radxa_penta_wakeups_per_second", "Voluntary context switches per second", NULL);
+    lm->spawns = metrics_gauge(m, "radxa_penta_spawns_per_minute", "Child processes started per minute", NULL);
+    lm->budget_level = metrics_gauge(m, "radxa_penta_budget_level", "Overhead degradation level (slow paths stretched 2^level)", NULL);
+
+    if (l->use_shadow) {
+        lm->shadow_duty = metrics_gauge(m, "radxa_penta_shadow_duty_ratio", "Duty the shadow controller would apply (never written)", NULL);
+        lm->shadow_delta = metrics_gauge(m, "radxa_penta_shadow_duty_delta_ratio", "Shadow minus active controller duty", NULL);
+        lm->shadow_divergent = metrics_counter(m, "radxa_penta_shadow_divergent_seconds_total", "Time the shadow differed by more than the divergence threshold", NULL);
+        lm->energy_active = metrics_gauge(m, "radxa_penta_fan_energy_estimate_wh", "Cube-law fan energy estimate since start", "controller=\"active\"");
+        lm->energy_shadow = metrics_gauge(m, "radxa_penta_fan_energy_estimate_wh", "Cube-law fan energy estimate since start", "controller=\"shadow\"");
+    }
+
+    for (int i = 0; i < cfg->profile_count; i++) {
+        snprintf(labels, sizeof(labels), "profile=\"%s\"", cfg->profiles[i].name);
+        lm->profile[i] = metrics_gauge(m, "radxa_penta_profile_active", "1 for the fan profile in force", labels);
+    }
+
+    if (l->use_usage) {
+        for (int s = 0; s < USAGE_SENSORS; s++) {
+            for (int lv = 0; lv < USAGE_LEVELS; lv++) {
+                snprintf(labels, sizeof(labels), "sensor=\"%s\",level=\"lv%d\"", usage_sensor_name(s), lv);
+                lm->above_level[s][lv] = metrics_counter(m, "radxa_penta_temperature_above_level_seconds_total",
+                                                        "Lifetime time at or above each default-profile curve level", labels);
+            }
+        }
+        for (int b = 0; b < USAGE_DUTY_BANDS; b++) {
+            snprintf(labels, sizeof(labels), "band=\"%s\"", usage_band_name(b));
+            lm->duty_band[b] = metrics_counter(m, "radxa_penta_fan_duty_band_seconds_total", "Lifetime fan run time per duty band (%)", labels);
+        }
+        lm->fan_starts = metrics_counter(m, "radxa_penta_fan_starts_total", "Lifetime fan off-to-on transitions", NULL);
+    }
+
+    if (l->use_mqtt) {
+        lm->mqtt_connected = metrics_gauge(m, "radxa_penta_mqtt_connected", "1 while the MQTT session is up", NULL);
+        lm->mqtt_dropped = metrics_counter(m, "radxa_penta_mqtt_dropped_total", "MQTT messages dropped because the broker was too slow", NULL);
+    }
+
+    // Per-unit series only with several HATs; the unlabelled ones above
+    // always describe the primary unit
+    if (l->unit_count > 1) {
+        for (int i = 0; i < l->unit_count; i++) {
+            const char *name = l->units[i].cfg->name;
+            snprintf(labels, sizeof(labels), "unit=\"%s\"", name);
+            lm->unit_duty[i] = metrics_gauge(m, "radxa_penta_unit_fan_duty_ratio", "Duty cycle applied to each unit's fan (0-1)", labels);
+            snprintf(labels, sizeof(labels), "unit=\"%s\",sensor=\"cpu\"", name);
+            lm->unit_cpu[i] = metrics_gauge(m, "radxa_penta_unit_filtered_temperature_celsius", "Moving-average temperature each unit's controller uses", labels);
+            snprintf(labels, sizeof(labels), "unit=\"%s\",sensor=\"ssd_max\"", name);
+            lm->unit_ssd[i] = metrics_gauge(m, "radxa_penta_unit_filtered_temperature_celsius", "Moving-average temperature each unit's controller uses", labels);
+        }
+    }
+
+    if (fan && !fan->use_hardware_pwm) {
+        fan->edge_jitter = metrics_histogram(m, "radxa_penta_pwm_edge_jitter_seconds", "Software PWM edge lateness", NULL,
+                                             jitter_buckets, sizeof(jitter_buckets) / sizeof(jitter_buckets[0]));
+    }
+}
+
+static void loop_metrics_publish(loop_t *l, const thermal_state_t *ts, double applied_dc, double tick_sec) {
+    loop_metrics_t *lm = &l->series;
+    const config_t *cfg = l->cfg;
+    double now = timebase_mono_sec();
+
+    metrics_gauge_set(lm->temp_cpu, ts->cpu_temp_raw);
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        metrics_gauge_set(lm->temp_ssd[i], (double)l->daemon.sample.ssd_temps[i]);
+    }
+    if (lm->temp_ambient) {
+        metrics_gauge_set(lm->temp_ambient, ts->ambient_valid ? (double)ts->ambient_mc / 1000.0 : (double)NAN);
+    }
+    ssd_health_t health[SSD_DEVICE_COUNT];
+    thermal_ssd_health(health, SSD_DEVICE_COUNT);
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        const ssd_health_t *h = &health[i];
+        metrics_gauge_set(lm->health[0][i], h->reallocated >= 0 ? (double)h->reallocated : (double)NAN);
+        metrics_gauge_set(lm->health[1][i], h->pending >= 0 ? (double)h->pending : (double)NAN);
+        metrics_gauge_set(lm->health[2][i], h->wear_leveling >= 0 ? (double)h->wear_leveling : (double)NAN);
+        metrics_gauge_set(lm->health[3][i], h->percent_used >= 0 ? (double)h->percent_used : (double)NAN);
+        metrics_gauge_set(lm->health[4][i], h->media_errors >= 0 ? (double)h->media_errors : (double)NAN);
+    }
+    metrics_gauge_set(lm->filtered_cpu, ts->cpu_avg);
+    metrics_gauge_set(lm->filtered_ssd, (double)ts->ssd_avg);
+    metrics_gauge_set(lm->age_cpu, now - ts->cpu_sampled_at);
+    metrics_gauge_set(lm->age_ssd, ts->ssd_sampled_at > 0.0 ? now - ts->ssd_sampled_at : -1.0);
+    metrics_gauge_set(lm->duty, applied_dc);
+    metrics_gauge_set(lm->duty_target, ts->dc_target);
+    metrics_gauge_set(lm->hold, ts->hold_active ? 1.0 : 0.0);
+    metrics_gauge_set(lm->deadband, ts->deadband_active ? 1.0 : 0.0);
+    metrics_counter_add(lm->ticks, 1.0);
+    metrics_gauge_set(lm->period, ts->period_sec);
+    for (int i = 0; i < cfg->profile_count; i++) {
+        metrics_gauge_set(lm->profile[i], &cfg->profiles[i] == cfg->active ? 1.0 : 0.0);
+    }
+
+    metrics_observe(lm->tick_duration, tick_sec);
+    metrics_observe(lm->read_cpu, ts->cpu_read_sec);
+    if (ts->ssd_read_fresh) {
+        metrics_observe(lm->read_ssd, ts->ssd_read_sec);
+    }
+
+    metrics_gauge_set(lm->cpu_self, l->budget.self_pct);
+    metrics_gauge_set(lm->cpu_children, l->budget.child_pct);
+    metrics_gauge_set(lm->cpu_loop, l->budget.loop_pct);
+    metrics_gauge_set(lm->cpu_oled, l->budget.oled_pct);
+    metrics_gauge_set(lm->wakeups, l->budget.wakeups_per_sec);
+    metrics_gauge_set(lm->spawns, l->budget.spawns_per_min);
+    metrics_gauge_set(lm->budget_level, (double)l->budget.level);
+
+    if (l->use_shadow) {
+        metrics_gauge_set(lm->shadow_duty, l->shadow.dc);
+        metrics_gauge_set(lm->shadow_delta, l->shadow.delta);
+        metrics_gauge_set(lm->shadow_divergent, l->shadow.divergent_sec);  // Mirrors a monotonic total
+        metrics_gauge_set(lm->energy_active, l->shadow.active_wh);
+        metrics_gauge_set(lm->energy_shadow, l->shadow.shadow_wh);
+    }
+
+    if (l->use_usage) {
+        // Persisted lifetime totals, mirrored like the shadow counter
+        for (int s = 0; s < USAGE_SENSORS; s++) {
+            for (int lv = 0; lv < USAGE_LEVELS; lv++) {
+                metrics_gauge_set(lm->above_level[s][lv], l->usage.c.above_sec[s][lv]);
+            }
+        }
+        for (int b = 0; b < USAGE_DUTY_BANDS; b++) {
+            metrics_gauge_set(lm->duty_band[b], l->usage.c.band_sec[b]);
+        }
+        metrics_gauge_set(lm->fan_starts, (double)l->usage.c.fan_starts);
+    }
+
+    if (l->use_mqtt) {
+        metrics_gauge_set(lm->mqtt_connected, l->mqtt.state == MQTT_CONNECTED ? 1.0 : 0.0);
+        metrics_gauge_set(lm->mqtt_dropped, (double)l->mqtt.dropped);
+    }
+
+    if (l->unit_count > 1) {
+        for (int i = 0; i < l->unit_count; i++) {
+            metrics_gauge_set(lm->unit_duty[i], l->units[i].applied_dc);
+            metrics_gauge_set(lm->unit_cpu[i], l->units[i].thermal.cpu_avg);
+            metrics_gauge_set(lm->unit_ssd[i], (double)l->units[i].thermal.ssd_avg);
+        }
+    }
+
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        for (size_t q = 0; q < LOOP_STAGE_QUANTILES; q++) {
+            metrics_gauge_set(lm->stage_latency[s][q],
+                              (double)stages_percentile_ns(&l->stages, (stage_id_t)s, stage_quantiles[q]) / 1e9);
+        }
+    }
+}
+
+static int32_t to_milli(double v) {
+    return (int32_t)(v * 1000.0 + (v >= 0.0 ? 0.5 : -0.5));
+}
+
+static uint16_t to_permille(double dc) {
+    return (uint16_t)(dc * 1000.0 + 0.5);
+}
+
+// Over lv3 on any unit, each against its own curves and readings
+static void daemon_critical(const daemon_t *d, int *cpu, int *ssd) {
+    *cpu = *ssd = 0;
+    for (int i = 0; i < d->unit_count; i++) {
+        int unit_cpu, unit_ssd;
+        thermal_curve_critical(d->cfg, &d->units[i].thermal, &unit_cpu, &unit_ssd);
+        *cpu |= unit_cpu;
+        *ssd |= unit_ssd;
+    }
+}
+
+// Copy this tick's state into the shared-memory segment (one seqlock window)
+static void status_publish(status_pub_t *pub, const daemon_t *d) {
+    const thermal_state_t *ts = d->thermal;
+    double now = timebase_mono_sec();
+
+    uint32_t flags = 0;
+    if (ts->hold_active) flags |= STATUS_FLAG_HOLD;
+    if (ts->deadband_active) flags |= STATUS_FLAG_DEADBAND;
+    if (now - ts->cpu_sampled_at > 2.0 * ts->period_sec) flags |= STATUS_FLAG_CPU_STALE;
+    if (ts->ssd_sampled_at > 0.0 && now - ts->ssd_sampled_at > 3.0 * thermal_ssd_interval()) flags |= STATUS_FLAG_SSD_STALE;
+    int cpu_critical, ssd_critical;
+    daemon_critical(d, &cpu_critical, &ssd_critical);
+    if (cpu_critical) flags |= STATUS_FLAG_CPU_CRITICAL;
+    if (ssd_critical) flags |= STATUS_FLAG_SSD_CRITICAL;
+    if (d->fan_error) flags |= STATUS_FLAG_FAN_ERROR;
+
+    uint32_t mode = STATUS_MODE_AUTO;
+    switch (commands_mode(d, now)) {
+        case DAEMON_MODE_MANUAL: mode = STATUS_MODE_MANUAL; break;
+        case DAEMON_MODE_BOOST: mode = STATUS_MODE_BOOST; break;
+        case DAEMON_MODE_AUTO: mode = STATUS_MODE_AUTO; break;
+        default: break;
+    }
+
+    status_shm_t *s = status_pub_begin(pub);
+    s->updated_mono_ns = (uint64_t)(now * 1e9);
+    s->updated_wall_sec = (int64_t)time(NULL);
+    s->ticks = d->ticks;
+    s->duty_changes = d->duty_changes;
+    s->fan_write_errors = d->fan_write_errors;
+    s->ssd_reads = d->ssd_reads;
+    s->flags = flags;
+    s->mode = mode;
+    s->duty_permille = to_permille(d->applied_dc);
+    s->controller_permille = to_permille(d->controller_dc);
+    s->target_permille = to_permille(ts->dc_target);
+    s->ssd_count = SSD_DEVICE_COUNT;
+    s->cpu_temp_mc = to_milli(ts->cpu_temp_raw);
+    s->cpu_avg_mc = to_milli(ts->cpu_avg);
+    s->cpu_trend_mc = to_milli(ts->cpu_trend);
+    s->ssd_avg_c = ts->ssd_avg;
+    s->ssd_trend_mc = to_milli(ts->ssd_trend);
+    for (size_t i = 0; i < STATUS_SHM_MAX_SSD; i++) {
+        s->ssd_temp_c[i] = (i < SSD_DEVICE_COUNT) ? d->sample.ssd_temps[i] : 0;
+    }
+    status_pub_end(pub);
+}
+
+static int16_t to_centi(double v) {
+    double c = v * 100.0 + (v >= 0.0 ? 0.5 : -0.5);
+    if (c > 32767.0) c = 32767.0;
+    if (c < -32768.0) c = -32768.0;
+    return (int16_t)c;
+}
+
+static uint32_t to_us(double sec) {
+    double us = sec * 1e6;
+    return us > 4294967295.0 ? UINT32_MAX : (uint32_t)us;
+}
+
+// Append this tick to the in-memory flight recorder; returns the alarm state
+static int flightrec_record_tick(flightrec_t *fr, const daemon_t *d, double tick_sec) {
+    const thermal_state_t *ts = d->thermal;
+    flightrec_record_t *r = flightrec_next(fr);
+
+    int ssd_max = 0;
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        if (d->sample.ssd_temps[i] > ssd_max) ssd_max = d->sample.ssd_temps[i];
+    }
+    int cpu_critical, ssd_critical;
+    daemon_critical(d, &cpu_critical, &ssd_critical);
+    int alarm = cpu_critical || ssd_critical;
+
+    r->tick = (uint32_t)d->ticks;
+    r->cpu_raw_cc = to_centi(ts->cpu_temp_raw);
+    r->cpu_avg_cc = to_centi(ts->cpu_avg);
+    r->cpu_trend_cc = to_centi(ts->cpu_trend);
+    r->ssd_max_c = (int16_t)ssd_max;
+    r->ssd_avg_c = (int16_t)ts->ssd_avg;
+    r->ssd_trend_cc = to_centi(ts->ssd_trend);
+    r->target_pm = to_permille(ts->dc_target);
+    r->controller_pm = to_permille(d->controller_dc);
+    r->applied_pm = to_permille(d->applied_dc);
+    if (ts->hold_active) r->flags |= FR_FLAG_HOLD;
+    if (ts->deadband_active) r->flags |= FR_FLAG_DEADBAND;
+    if (r->controller_pm != r->target_pm) r->flags |= FR_FLAG_RATE_LIMITED;
+    if (ts->ssd_read_fresh) r->flags |= FR_FLAG_SSD_FRESH;
+    if (d->fan_error) r->flags |= FR_FLAG_FAN_ERROR;
+    if (alarm) r->flags |= FR_FLAG_ALARM;
+    r->mode = (uint8_t)commands_mode(d, timebase_mono_sec());
+    r->tick_us = to_us(tick_sec);
+    r->ssd_read_us = ts->ssd_read_fresh ? to_us(ts->ssd_read_sec) : 0;
+    double cpu_us = ts->cpu_read_sec * 1e6;
+    r->cpu_read_us = cpu_us > 65535.0 ? UINT16_MAX : (uint16_t)cpu_us;
+
+    return alarm || d->fan_error;
+}
+
+// Publish this tick's values (each only past its deadband) and run the
+// MQTT connection timers
+static void mqtt_publish_tick(mqtt_t *mqtt, const daemon_t *d, double now) {
+    const thermal_state_t *ts = d->thermal;
+    const config_t *cfg = d->cfg;
+    mqtt_state_t s;
+    s.cpu_temp = ts->cpu_avg;
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        s.ssd_temps[i] = d->sample.ssd_temps[i];
+    }
+    s.duty = d->applied_dc;
+    s.mode = commands_mode_name(commands_mode(d, now));
+    s.profile = cfg->active->name;
+    int cpu_critical, ssd_critical;
+    daemon_critical(d, &cpu_critical, &ssd_critical);
+    s.alarm = cpu_critical || ssd_critical || d->fan_error;
+    mqtt_publish_state(mqtt, &s);
+    mqtt_service(mqtt, now);
+}
+
+int loop_poll(loop_t *l, int timeout_ms) {
+    struct pollfd pfds[LOOP_MAX_POLL_FDS];
+    int n = 0;
+    int metrics_n = 0;
+    int ctl_n = 0;
+    int mqtt_n = 0;
+    int sysinfo_n = 0;
+    if (l->use_metrics) {
+        metrics_n = metrics_pollfds(&l->metrics, pfds + n, LOOP_MAX_POLL_FDS - n);
+        n += metrics_n;
+    }
+    if (l->use_ctl) {
+        ctl_n = ctl_pollfds(&l->ctl, pfds + n, LOOP_MAX_POLL_FDS - n);
+        n += ctl_n;
+    }
+    if (l->use_mqtt) {
+        mqtt_n = mqtt_pollfds(&l->mqtt, pfds + n, LOOP_MAX_POLL_FDS - n);
+        n += mqtt_n;
+    }
+    sysinfo_n = sysinfo_pollfds(&l->sysinfo, pfds + n, LOOP_MAX_POLL_FDS - n);
+    n += sysinfo_n;
+
+    int ready = poll(pfds, (nfds_t)n, timeout_ms);
+    if (ready <= 0) return 0; // Timeout or EINTR (signal): the caller re-checks
+
+    int changed = 0;
+    if (l->use_metrics) {
+        metrics_dispatch(&l->metrics, pfds, metrics_n);
+    }
+    if (l->use_ctl) {
+        override_t before = l->daemon.override;
+        ctl_dispatch(&l->ctl, pfds + metrics_n, ctl_n);
+        changed = memcmp(&before, &l->daemon.override, sizeof(before)) != 0;
+    }
+    if (l->use_mqtt) {
+        mqtt_dispatch(&l->mqtt, pfds + metrics_n + ctl_n, mqtt_n);
+    }
+    sysinfo_dispatch(&l->sysinfo, pfds + metrics_n + ctl_n + mqtt_n, sysinfo_n);
+    return changed || profile_pending();
+}
+
+int loop_open(loop_t *l, config_t *cfg, const char *status_name) {
+    memset(l, 0, sizeof(loop_t));
+    l->cfg = cfg;
+
+    // Shadow controller: same inputs, own tuning, output never applied
+    if (cfg->shadow_config[0]) {
+        if (shadow_init(&l->shadow, cfg->shadow_config, cfg->shadow_divergence) == 0) {
+            l->use_shadow = 1;
+            printf("Shadow controller: %s (divergence > %.0f%%)\n\n", cfg->shadow_config, l->shadow.divergence * 100.0);
+        } else {
+            fprintf(stderr, "Warning: Shadow controller disabled\n");
+        }
+    }
+
+    // Compressed on-disk history (opened first: the OLED graph page reads it)
+    if (cfg->history_enabled && cfg->history_size_mb > 0) {
+        if (history_open(&l->history, cfg->history_path, (size_t)cfg->history_size_mb, cfg->history_flush_sec) == 0) {
+            l->use_history = 1;
+        } else {
+            fprintf(stderr, "Warning: History store disabled\n");
+        }
+    }
+
+    // Lifetime thermal SLO / fan-usage counters
+    if (cfg->usage_enabled) {
+        usage_open(&l->usage, cfg->usage_path, cfg->usage_checkpoint_sec, timebase_mono_sec());
+        l->use_usage = 1;
+    }
+
+    // MQTT telemetry (connects from the event loop, never blocking a tick)
+    if (cfg->mqtt_enabled) {
+        if (mqtt_init(&l->mqtt, cfg) == 0) {
+            l->use_mqtt = 1;
+            printf("MQTT: %s, topic %s%s\n", l->mqtt.broker_spec, l->mqtt.topic,
+                   l->mqtt.discovery_prefix[0] ? ", Home Assistant discovery" : "");
+        } else {
+            fprintf(stderr, "Warning: MQTT disabled\n");
+        }
+    }
+
+    stages_init(&l->stages);
+    budget_init(&l->budget, cfg->budget_cpu_percent, timebase_mono_sec());
+    thermal_set_health_interval(cfg->smart_health_interval_sec);
+    thermal_set_smartctl_json(cfg->smart_json);
+
+    // Sensor files stay open and are read in one batch per tick
+    sensors_init(&l->sensors, cfg->sensors_io_uring);
+    int batched = thermal_use_sensors(&l->sensors) == 0;
+
+    // Room/intake sensor for ambient-compensated curves and ramp rates: an
+    // hwmon file joins the batch, a 1-wire one gets a reader thread
+    ambient_init(&l->ambient, cfg);
+    if (l->ambient.enabled) {
+        ambient_start(&l->ambient, batched ? &l->sensors : NULL);
+        thermal_use_ambient(&l->ambient);
+        printf("Ambient: %s every %ds, reference %.1f°C, %s curves, rate gain %.3f/°C\n",
+               cfg->ambient_source, l->ambient.interval_sec, cfg->ambient_reference,
+               cfg->ambient_relative ? "relative" : "absolute", cfg->ambient_rate_gain);
+    }
+    if (batched) {
+        printf("Sensors: %d file(s) read via %s\n", l->sensors.count, sensors_backend_name(&l->sensors));
+    }
+
+    // Address/hostname/mount cache the display pages read (change-driven)
+    sysinfo_init(&l->sysinfo);
+
+    // One fan/display/button set per unit, all served from this loop
+    for (int i = 0; i < cfg->unit_count; i++) {
+        const unit_config_t *uc = &cfg->units[i];
+        printf("Unit %s: fan %s, display %s, CPU %s, disks 0x%x\n", uc->name,
+               uc->fan == UNIT_FAN_PWM ? "pwm" : uc->fan == UNIT_FAN_GPIO ? "gpio" : "none",
+               uc->oled ? "yes" : "no", uc->cpu ? "yes" : "no", uc->disks);
+        if (unit_start(&l->units[i], cfg, uc, l->use_history ? &l->history : NULL, &l->stages,
+                       i == 0 ? &l->budget : NULL, &l->sysinfo) < 0) {
+            // unit_start() released what it had claimed of the failed unit
+            loop_close(l);
+            return -1;
+        }
+        l->unit_count++;
+    }
+    printf("\n");
+    if (l->unit_count > 1) {
+        for (int i = 0; i < l->unit_count; i++) {
+            l->units[i].thermal.label = l->units[i].cfg->name;
+        }
+    }
+
+    // Optional Prometheus exporter, served from this loop (no extra threads)
+    if (cfg->metrics_enabled) {
+        if (metrics_init(&l->metrics, cfg->metrics_listen) == 0) {
+            l->use_metrics = 1;
+            loop_metrics_register(l, l->units[0].has_fan ? &l->units[0].fan : NULL);
+        } else {
+            fprintf(stderr, "Warning: Metrics exporter disabled\n");
+        }
+    }
+
+    daemon_t *d = &l->daemon;
+    d->cfg = cfg;
+    d->units = l->units;
+    d->unit_count = l->unit_count;
+    d->thermal = &l->units[0].thermal;
+    d->fan = l->units[0].has_fan ? &l->units[0].fan : NULL;
+    d->history = l->use_history ? &l->history : NULL;
+    d->stages = &l->stages;
+    d->budget = &l->budget;
+    d->shadow = l->use_shadow ? &l->shadow : NULL;
+    d->usage = l->use_usage ? &l->usage : NULL;
+    d->mqtt = l->use_mqtt ? &l->mqtt : NULL;
+    d->sensors = &l->sensors;
+    d->sysinfo = &l->sysinfo;
+    d->override.manual_duty = -1.0;
+    d->started_at = timebase_mono_sec();
+
+    // In-memory flight recorder, dumped on request or when an alarm first appears
+    if (cfg->flightrec_records > 0 &&
+        flightrec_init(&l->flightrec, (size_t)cfg->flightrec_records, cfg->flightrec_dir) == 0) {
+        l->use_flightrec = 1;
+    }
+
+    // Shared-memory status segment for local zero-copy readers
+    if (cfg->status_shm_enabled && status_pub_init(&l->status_pub, status_name) == 0) {
+        l->use_status_shm = 1;
+    }
+
+    // Runtime control socket (status queries, manual duty, boost)
+    if (cfg->ctl_enabled) {
+        if (ctl_init(&l->ctl, cfg->ctl_socket, commands_handle, d) == 0) {
+            l->use_ctl = 1;
+        } else {
+            fprintf(stderr, "Warning: Control socket disabled\n");
+        }
+    }
+
+    l->last_tick_start = timebase_mono_sec() - THERMAL_REFERENCE_PERIOD_SEC;
+    l->last_period = THERMAL_REFERENCE_PERIOD_SEC;
+    return 0;
+}
+
+double loop_tick(loop_t *l) {
+    config_t *cfg = l->cfg;
+    daemon_t *d = &l->daemon;
+    thermal_state_t *primary = &l->units[0].thermal;
+    double tick_start = timebase_mono_sec();
+    uint64_t tick_raw = timebase_raw_ns();
+    // Profile swaps happen only here, between controller steps
+    profile_tick(cfg, timebase_wall_sec());
+
+    // One sensor pass feeds every unit's controller
+    thermal_sample_t sample = {0};
+    if (cfg->fan_enabled) {
+        thermal_sample(&sample);
+    }
+    double compute_sec = 0.0;
+    int fan_error = 0;
+    for (int i = 0; i < l->unit_count; i++) {
+        unit_t *u = &l->units[i];
+        double udc = unit_control(u, cfg, &sample);
+        compute_sec += u->thermal.compute_sec;
+        double applied = commands_apply_overrides(d, udc, tick_start);
+        if (unit_actuate(u, applied, &l->stages)) {
+            d->duty_changes++;
+            if (u->fan_error) d->fan_write_errors++;
+        }
+        fan_error |= u->fan_error;
+    }
+    double controller_dc = l->units[0].controller_dc;
+    double dc = l->units[0].applied_dc;
+    double tick_dt = tick_start - l->last_tick_start;
+    l->last_tick_start = tick_start;
+    if (l->use_shadow && cfg->fan_enabled) {
+        // Same snapshot the active controller just used; never actuated
+        shadow_step(&l->shadow, primary, controller_dc, tick_dt);
+    }
+
+    stages_record(&l->stages, STAGE_READ_CPU, (uint64_t)(sample.cpu_read_sec * 1e9));
+    if (sample.ssd_read_fresh) {
+        stages_record(&l->stages, STAGE_READ_SSD, (uint64_t)(sample.ssd_read_sec * 1e9));
+    }
+    stages_record(&l->stages, STAGE_COMPUTE, (uint64_t)(compute_sec * 1e9));
+
+    d->sample = sample;
+    d->fan_error = fan_error;
+    d->controller_dc = controller_dc;
+    d->applied_dc = dc;
+    d->ticks++;
+    if (sample.ssd_read_fresh) {
+        d->ssd_reads++;
+    }
+    if (l->use_status_shm) {
+        status_publish(&l->status_pub, d);
+    }
+
+    double tick_end = timebase_mono_sec();
+    stages_record(&l->stages, STAGE_TICK, timebase_raw_ns() - tick_raw);
+    if (l->use_metrics) {
+        loop_metrics_publish(l, primary, dc, tick_end - tick_start);
+    }
+    time_t wall_sec = timebase_wall_sec();
+    if (l->use_history && wall_sec != l->last_history_sec) {
+        l->last_history_sec = wall_sec;
+        double row[HISTORY_SERIES];
+        row[HISTORY_CPU_TEMP] = primary->cpu_avg;
+        row[HISTORY_SSD_TEMP] = (double)primary->ssd_avg;
+        row[HISTORY_DUTY] = dc;
+        history_append(&l->history, (int64_t)wall_sec, row);
+        history_maybe_flush(&l->history, tick_end);
+    }
+    if (l->use_mqtt) {
+        mqtt_publish_tick(&l->mqtt, d, tick_end);
+    }
+    if (l->use_usage) {
+        usage_tick(&l->usage, cfg, primary, dc, tick_dt);
+        usage_maybe_checkpoint(&l->usage, tick_end);
+    }
+    if (l->use_flightrec) {
+        int alarm = flightrec_record_tick(&l->flightrec, d, tick_end - tick_start);
+        flightrec_check_alarm(&l->flightrec, alarm);
+    }
+
+    // Over budget: stretch only the slow, non-safety paths
+    if (budget_update(&l->budget, tick_end)) {
+        unsigned int scale = budget_scale(&l->budget);
+        thermal_set_ssd_interval(SSD_TEMP_CACHE_SEC * (int)scale);
+        for (int i = 0; i < l->unit_count; i++) {
+            unit_set_scroll_interval(&l->units[i], OLED_SCROLL_INTERVAL_SEC * scale);
+        }
+        logger_log(LOGGER_INFO, NULL, "[Budget] OLED page every %us, SSD temperatures every %ds",
+                   OLED_SCROLL_INTERVAL_SEC * scale, thermal_ssd_interval());
+    }
+    l->tick_end = tick_end;
+
+    // Adaptive schedule: long when cold and steady, short while ramping.
+    // Ramp limits are per second, so only the wakeup count changes.
+    // Overrides keep at least the reference cadence.
+    // The hottest unit sets the pace for all of them
+    double period = thermal_next_period(cfg, primary);
+    for (int i = 1; i < l->unit_count; i++) {
+        double p = thermal_next_period(cfg, &l->units[i].thermal);
+        if (p < period) period = p;
+    }
+    if (period > THERMAL_REFERENCE_PERIOD_SEC && commands_mode(d, tick_end) != DAEMON_MODE_AUTO) {
+        period = THERMAL_REFERENCE_PERIOD_SEC;
+    }
+    if (period != l->last_period) {
+        logger_log(LOGGER_DEBUG, NULL, "[Main] Control period %.1fs -> %.1fs", l->last_period, period);
+        l->last_period = period;
+    }
+    return period;
+}
+
+void loop_close(loop_t *l) {
+    if (l->use_shadow) {
+        logger_log(LOGGER_INFO, NULL, "[Shadow] %.0fs compared: mean |delta| %.1f%%, max %.0f%%, divergent %.0fs, fan energy active %.3f Wh / shadow %.3f Wh",
+                   l->shadow.seconds, shadow_mean_abs_delta(&l->shadow) * 100.0, l->shadow.max_abs_delta * 100.0,
+                   l->shadow.divergent_sec, l->shadow.active_wh, l->shadow.shadow_wh);
+    }
+
+    if (l->use_usage) {
+        usage_close(&l->usage);
+        l->use_usage = 0;
+    }
+
+    if (l->use_mqtt) {
+        mqtt_cleanup(&l->mqtt);
+        l->use_mqtt = 0;
+    }
+
+    for (int i = 0; i < l->unit_count; i++) {
+        unit_stop(&l->units[i]);
+    }
+    l->unit_count = 0;
+
+    if (l->use_metrics) {
+        metrics_cleanup(&l->metrics);
+        l->use_metrics = 0;
+    }
+
+    if (l->use_ctl) {
+        ctl_cleanup(&l->ctl);
+        l->use_ctl = 0;
+    }
+
+    if (l->use_status_shm) {
+        status_pub_cleanup(&l->status_pub);
+        l->use_status_shm = 0;
+    }
+
+    if (l->use_flightrec) {
+        flightrec_cleanup(&l->flightrec);
+        l->use_flightrec = 0;
+    }
+
+    thermal_use_sensors(NULL);
+    thermal_use_ambient(NULL);
+    ambient_stop(&l->ambient);
+    sensors_close(&l->sensors);
+
+    // After the displays: their threads may still be drawing the graph page
+    if (l->use_history) {
+        history_close(&l->history);
+        l->use_history = 0;
+    }
+    sysinfo_cleanup(&l->sysinfo);
+}
@@ -8,22 +8,32 @@
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
-#include <pthread.h>
 #include "config.h"
-#include "fan.h"
-#include "thermal.h"
-#include "oled.h"
-#include "button.h"
+#include "loop.h"
+#include "timebase.h"
+#include "profile.h"
+#include "logger.h"
 
 static volatile int running = 1;
-static int use_oled = 0;
-static int use_button = 0;
+static volatile sig_atomic_t flightrec_dump_requested = 0;
+static volatile sig_atomic_t stages_log_requested = 0;
+
+// Static: the metrics registry inside is fixed-size
+static loop_t loop;
 
 static void signal_handler(int signum) {
     printf("\nReceived signal %d, shutting down...\n", signum);
     running = 0;
 }
 
+static void request_signal_handler(int signum) {
+    if (signum == SIGUSR2) {
+        stages_log_requested = 1;
+    } else {
+        flightrec_dump_requested = 1;
+    }
+}
+
 static void load_env_file(const char *path) {
     FILE *fp = fopen(path, "r");
     if (!fp) {
@@ -52,20 +62,28 @@ static void load_env_file(const char *path) {
     fclose(fp);
 }
 
+// Sleep until the monotonic deadline while serving any event-loop sockets.
+// Returns 1 early when a control command changed the overrides or queued a
+// profile switch, so a long idle period never delays either.
+static int wait_until(double deadline) {
+    while (running) {
+        double remaining = deadline - timebase_mono_sec();
+        if (remaining <= 0.0) break;
+        if (profile_pending()) return 1;
+        if (loop_poll(&loop, (int)(remaining * 1000.0) + 1)) return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     (void)argc;
     (void)argv;
 
-    // Disable stdout buffering for immediate log output to systemd/journald
-    setbuf(stdout, NULL);
+    // Line-buffered: one write() per startup line. Runtime messages go
+    // through the logger (journald native protocol or one write per record).
+    setvbuf(stdout, NULL, _IOLBF, 0);
 
     config_t cfg;
-    fan_t fan;
-    oled_t oled;
-    button_t button;
-    thermal_state_t thermal_state;
-    pthread_t oled_thread;
-    pthread_t button_thread;
 
     printf("Radxa Penta Fan Controller v1.0.2\n");
     printf("===============================\n\n");
@@ -84,112 +102,70 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    logger_init(cfg.log_level, cfg.log_journal, cfg.log_journal_socket);
+
     printf("Configuration loaded:\n");
+    printf("  Units: %d\n", cfg.unit_count);
+    printf("  Profiles: %d (schedule entries: %d)\n", cfg.profile_count, cfg.schedule_count);
     printf("  CPU Fan: %.1f°C/%.1f°C/%.1f°C/%.1f°C\n",
-           cfg.fan.lv0, cfg.fan.lv1, cfg.fan.lv2, cfg.fan.lv3);
+           cfg.active->fan.lv0, cfg.active->fan.lv1, cfg.active->fan.lv2, cfg.active->fan.lv3);
     printf("  SSD Fan: %.1f°C/%.1f°C/%.1f°C/%.1f°C\n\n",
-           cfg.fan_ssd.lv0, cfg.fan_ssd.lv1, cfg.fan_ssd.lv2, cfg.fan_ssd.lv3);
+           cfg.active->fan_ssd.lv0, cfg.active->fan_ssd.lv1, cfg.active->fan_ssd.lv2, cfg.active->fan_ssd.lv3);
 
-    // Initialize thermal state for smart control
-    thermal_state_init(&thermal_state);
     printf("Smart thermal control enabled\n");
     printf("  - Moving average filter (10 samples)\n");
-    printf("  - Hysteresis (%.1f°C cooling)\n", cfg.thermal.hysteresis_c);
-    printf("  - Dead-band zone (±%.1f°C)\n", cfg.thermal.deadband_c);
-    printf("  - Rate limiting (max %.0f%%/cycle)\n", cfg.thermal.max_dc_change_per_cycle * 100.0);
-    printf("  - Minimum effective duty: %.0f%%\n", cfg.thermal.min_effective_dc * 100.0);
+    printf("  - Hysteresis (%.1f°C cooling)\n", cfg.active->thermal.hysteresis_c);
+    printf("  - Dead-band zone (±%.1f°C)\n", cfg.active->thermal.deadband_c);
+    printf("  - Rate limiting (max %.0f%%/cycle)\n", cfg.active->thermal.max_dc_change_per_cycle * 100.0);
+    printf("  - Minimum effective duty: %.0f%%\n", cfg.active->thermal.min_effective_dc * 100.0);
     printf("  - Temperature trend analysis (heat>%.2f°C, fast>%.2f°C)\n\n",
-           cfg.thermal.trend_heat_c, cfg.thermal.trend_fast_heat_c);
-
-    // Try to initialize OLED
-    if (oled_init(&oled) == 0) {
-        // Apply OLED rotation from config
-        oled_set_rotation(&oled, cfg.oled_rotate);
-        if (getenv("RADXA_DEBUG")) {
-            fprintf(stderr, "[Main] OLED rotation applied: %d\n", cfg.oled_rotate);
-        }
-
-        use_oled = 1;
-        oled_welcome(&oled);
-
-        // Start OLED auto-scroll thread
-        if (pthread_create(&oled_thread, NULL, oled_auto_scroll_thread, &oled) != 0) {
-            fprintf(stderr, "Warning: Failed to create OLED thread\n");
-            use_oled = 0;
-        } else {
-            pthread_detach(oled_thread);
-        }
+           cfg.active->thermal.trend_heat_c, cfg.active->thermal.trend_fast_heat_c);
 
-        // Initialize button (requires OLED reference)
-        const char *button_chip_env = getenv("BUTTON_CHIP");
-        const char *button_line_env = getenv("BUTTON_LINE");
-
-        if (button_chip_env && button_line_env) {
-            int button_chip = atoi(button_chip_env);
-            unsigned int button_line = (unsigned int)atoi(button_line_env);
-
-            if (button_init(&button, button_chip, button_line, &oled) == 0) {
-                use_button = 1;
-
-                // Start button watch thread
-                if (pthread_create(&button_thread, NULL, button_watch_thread, &button) != 0) {
-                    fprintf(stderr, "Warning: Failed to create button thread\n");
-                    button_cleanup(&button);
-                    use_button = 0;
-                } else {
-                    pthread_detach(button_thread);
-                }
-            }
-        } else {
-            printf("Button GPIO not configured in environment\n");
-        }
-    } else {
-        printf("OLED not available, continuing without display\n\n");
-        use_oled = 0;
-    }
-
-    // Initialize fan
-    if (fan_init(&fan) < 0) {
-        fprintf(stderr, "Error initializing fan\n");
-        if (use_oled) oled_cleanup(&oled);
+    if (loop_open(&loop, &cfg, STATUS_SHM_NAME) < 0) {
         return 1;
     }
 
     // Setup signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR2, request_signal_handler);
+    if (loop.use_flightrec) {
+        signal(SIGUSR1, request_signal_handler);
+    }
 
     printf("Fan control started. Press Ctrl+C to stop.\n\n");
 
     // Main control loop - use smart thermal control
-    double last_dc = -1.0;
+    double next_tick = timebase_mono_sec();
     while (running) {
-        double dc = thermal_calculate_duty_cycle_smart(&cfg, &thermal_state);
+        double period = loop_tick(&loop);
 
-        if (dc != last_dc) {
-            if (fan_set_duty_cycle(&fan, dc) < 0) {
-                fprintf(stderr, "Warning: Failed to set duty cycle\n");
-            }
-            last_dc = dc;
+        // If a tick overran (slow smartctl), restart from now
+        next_tick += period;
+        if (next_tick < loop.tick_end) {
+            next_tick = loop.tick_end;
+        }
+        if (wait_until(next_tick)) {
+            next_tick = timebase_mono_sec(); // Override or profile changed: act on it now
         }
 
-        sleep(1);
+        if (flightrec_dump_requested) {
+            flightrec_dump_requested = 0;
+            if (loop.use_flightrec) {
+                flightrec_dump(&loop.flightrec, FR_REASON_SIGNAL);
+            }
+        }
+        if (stages_log_requested) {
+            stages_log_requested = 0;
+            stages_log(&loop.stages);
+        }
     }
 
     // Cleanup
     printf("\nStopping fan...\n");
-    fan_set_duty_cycle(&fan, 0.0);
-    fan_cleanup(&fan);
-
-    if (use_button) {
-        button_cleanup(&button);
-    }
-
-    if (use_oled) {
-        oled_goodbye(&oled);
-        oled_cleanup(&oled);
-    }
+    loop_close(&loop);
 
+    logger_close();
     printf("Shutdown complete.\n");
     return 0;
 }
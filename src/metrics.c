@@ -0,0 +1,349 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include "metrics.h"
+#include "netutil.h"
+
+int metrics_init(metrics_t *m, const char *listen) {
+    memset(m, 0, sizeof(metrics_t));
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        m->clients[i].fd = -1;
+    }
+
+    m->listen_fd = netutil_listen(listen, m->unix_path, sizeof(m->unix_path));
+    if (m->listen_fd < 0) {
+        return -1;
+    }
+    m->is_unix = (m->unix_path[0] != '\0');
+
+    printf("Metrics exporter listening on %s\n", listen);
+    return 0;
+}
+
+static void client_close(metrics_client_t *c) {
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    c->fd = -1;
+    c->in_len = 0;
+    c->out_len = 0;
+    c->out_off = 0;
+    c->responding = 0;
+}
+
+void metrics_cleanup(metrics_t *m) {
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        client_close(&m->clients[i]);
+    }
+    if (m->listen_fd >= 0) {
+        close(m->listen_fd);
+        m->listen_fd = -1;
+    }
+    if (m->is_unix) {
+        unlink(m->unix_path);
+    }
+}
+
+// Bounded names, help and labels keep every line within METRICS_SAMPLE_LINE_MAX
+static int register_fits(const char *name, const char *help, const char *labels) {
+    if (strlen(name) > METRICS_NAME_MAX || strlen(help) > METRICS_HELP_MAX ||
+        (labels && strlen(labels) >= METRICS_LABELS_LEN)) {
+        fprintf(stderr, "Warning: Metric name, help or labels too long, dropping %s\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+static metrics_gauge_t *register_gauge(metrics_t *m, const char *name, const char *help,
+                                       const char *labels, const char *type) {
+    if (m->gauge_count >= METRICS_MAX_GAUGES) {
+        fprintf(stderr, "Warning: Metrics registry full, dropping %s\n", name);
+        return NULL;
+    }
+    if (!register_fits(name, help, labels)) return NULL;
+    metrics_gauge_t *g = &m->gauges[m->gauge_count++];
+    g->name = name;
+    g->help = help;
+    g->type = type;
+    snprintf(g->labels, sizeof(g->labels), "%s", labels ? labels : "");
+    g->value = 0.0;
+    return g;
+}
+
+metrics_gauge_t *metrics_gauge(metrics_t *m, const char *name, const char *help, const char *labels) {
+    return register_gauge(m, name, help, labels, "gauge");
+}
+
+metrics_gauge_t *metrics_counter(metrics_t *m, const char *name, const char *help, const char *labels) {
+    return register_gauge(m, name, help, labels, "counter");
+}
+
+metrics_histogram_t *metrics_histogram(metrics_t *m, const char *name, const char *help, const char *labels,
+                                       const double *bounds, size_t nbounds) {
+    if (m->histogram_count >= METRICS_MAX_HISTOGRAMS || nbounds > METRICS_MAX_BUCKETS) {
+        fprintf(stderr, "Warning: Metrics registry full, dropping %s\n", name);
+        return NULL;
+    }
+    if (!register_fits(name, help, labels)) return NULL;
+    metrics_histogram_t *h = &m->histograms[m->histogram_count++];
+    memset(h, 0, sizeof(*h));
+    h->name = name;
+    h->help = help;
+    snprintf(h->labels, sizeof(h->labels), "%s", labels ? labels : "");
+    h->bounds = bounds;
+    h->nbounds = nbounds;
+    return h;
+}
+
+void metrics_gauge_set(metrics_gauge_t *g, double value) {
+    if (g) g->value = value;
+}
+
+void metrics_counter_add(metrics_gauge_t *g, double delta) {
+    if (g) g->value += delta;
+}
+
+void metrics_observe(metrics_histogram_t *h, double seconds) {
+    if (!h) return;
+    if (seconds < 0.0) seconds = 0.0;
+
+    size_t i = 0;
+    while (i < h->nbounds && seconds > h->bounds[i]) {
+        i++;
+    }
+    __atomic_fetch_add(&h->buckets[i], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_ns, (uint64_t)(seconds * 1e9), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+}
+
+// Bounded appender: once the buffer is full, further output is dropped and
+// the length is rolled back to the last complete line.
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    size_t line_start;
+    int full;
+} render_buf_t;
+
+__attribute__((format(printf, 2, 3)))
+static void rb_printf(render_buf_t *rb, const char *fmt, ...) {
+    if (rb->full) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(rb->buf + rb->len, rb->size - rb->len, fmt, ap);
+    va_end(ap);
+
+    if (n < 0 || (size_t)n >= rb->size - rb->len) {
+        rb->full = 1;
+        rb->len = rb->line_start;
+        rb->buf[rb->len] = '\0';
+        return;
+    }
+    rb->len += (size_t)n;
+    if (rb->len > 0 && rb->buf[rb->len - 1] == '\n') {
+        rb->line_start = rb->len;
+    }
+}
+
+static void rb_labels(render_buf_t *rb, const char *name, const char *suffix,
+                      const char *labels, const char *extra) {
+    int has_labels = (labels[0] != '\0');
+    int has_extra = (extra && extra[0] != '\0');
+    if (!has_labels && !has_extra) {
+        rb_printf(rb, "%s%s ", name, suffix);
+    } else {
+        rb_printf(rb, "%s%s{%s%s%s} ", name, suffix,
+                  labels, (has_labels && has_extra) ? "," : "", has_extra ? extra : "");
+    }
+}
+
+size_t metrics_render(metrics_t *m, char *buf, size_t size) {
+    render_buf_t rb = { buf, size, 0, 0, 0 };
+    if (size == 0) return 0;
+    buf[0] = '\0';
+
+    // Entries sharing a family name are registered consecutively, so HELP/TYPE
+    // is emitted only when the name changes.
+    const char *prev = NULL;
+    for (size_t i = 0; i < m->gauge_count; i++) {
+        metrics_gauge_t *g = &m->gauges[i];
+        if (!prev || strcmp(prev, g->name) != 0) {
+            rb_printf(&rb, "# HELP %s %s\n# TYPE %s %s\n", g->name, g->help, g->name, g->type);
+            prev = g->name;
+        }
+        rb_labels(&rb, g->name, "", g->labels, NULL);
+        if (isnan(g->value)) {
+            rb_printf(&rb, "NaN\n");   // Exposition-format spelling (unreported values)
+        } else {
+            rb_printf(&rb, "%.6g\n", g->value);
+        }
+    }
+
+    prev = NULL;
+    for (size_t i = 0; i < m->histogram_count; i++) {
+        metrics_histogram_t *h = &m->histograms[i];
+        if (!prev || strcmp(prev, h->name) != 0) {
+            rb_printf(&rb, "# HELP %s %s\n# TYPE %s histogram\n", h->name, h->help, h->name);
+            prev = h->name;
+        }
+
+        uint64_t cumulative = 0;
+        char le[32];
+        for (size_t b = 0; b <= h->nbounds; b++) {
+            cumulative += __atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED);
+            if (b < h->nbounds) {
+                snprintf(le, sizeof(le), "le=\"%g\"", h->bounds[b]);
+            } else {
+                snprintf(le, sizeof(le), "le=\"+Inf\"");
+            }
+            rb_labels(&rb, h->name, "_bucket", h->labels, le);
+            rb_printf(&rb, "%llu\n", (unsigned long long)cumulative);
+        }
+        rb_labels(&rb, h->name, "_sum", h->labels, NULL);
+        rb_printf(&rb, "%.9f\n", (double)__atomic_load_n(&h->sum_ns, __ATOMIC_RELAXED) / 1e9);
+        rb_labels(&rb, h->name, "_count", h->labels, NULL);
+        rb_printf(&rb, "%llu\n", (unsigned long long)__atomic_load_n(&h->count, __ATOMIC_RELAXED));
+    }
+
+    if (rb.full && !m->truncated) {
+        fprintf(stderr, "Warning: Metrics output truncated at %zu of %zu bytes\n", rb.len, size);
+        m->truncated = 1;
+    }
+    return rb.len;
+}
+
+static void client_prepare_response(metrics_t *m, metrics_client_t *c) {
+    if (strncmp(c->in, "GET ", 4) != 0) {
+        static const char bad[] = "HTTP/1.0 405 Method Not Allowed\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+        memcpy(c->out, bad, sizeof(bad) - 1);
+        c->out_len = sizeof(bad) - 1;
+    } else {
+        // Render the body behind a header-sized gap, then slide it up against
+        // the real header once Content-Length is known.
+        size_t body = metrics_render(m, c->out + METRICS_HTTP_HEADER_MAX, sizeof(c->out) - METRICS_HTTP_HEADER_MAX);
+        char header[METRICS_HTTP_HEADER_MAX];
+        int hlen = snprintf(header, sizeof(header),
+                            "HTTP/1.0 200 OK\r\n"
+                            "Content-Type: text/plain; version=0.0.4\r\n"
+                            "Connection: close\r\n"
+                            "Content-Length: %zu\r\n\r\n", body);
+        if (hlen < 0 || hlen >= METRICS_HTTP_HEADER_MAX) {
+            client_close(c);
+            return;
+        }
+        memmove(c->out + hlen, c->out + METRICS_HTTP_HEADER_MAX, body);
+        memcpy(c->out, header, (size_t)hlen);
+        c->out_len = (size_t)hlen + body;
+    }
+    c->out_off = 0;
+    c->responding = 1;
+}
+
+static void client_read(metrics_t *m, metrics_client_t *c) {
+    ssize_t n = recv(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        client_close(c);
+        return;
+    }
+    if (n < 0) return;
+
+    c->in_len += (size_t)n;
+    c->in[c->in_len] = '\0';
+
+    // Only the request line matters; answer once headers are complete or the
+    // bounded buffer is full (oversized headers are simply not read further).
+    if (strstr(c->in, "\r\n\r\n") || strstr(c->in, "\n\n") || c->in_len >= sizeof(c->in) - 1) {
+        client_prepare_response(m, c);
+    }
+}
+
+static void client_write(metrics_client_t *c) {
+    ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            client_close(c);
+        }
+        return;
+    }
+    c->out_off += (size_t)n;
+    if (c->out_off >= c->out_len) {
+        client_close(c);
+    }
+}
+
+static void accept_clients(metrics_t *m) {
+    int fd;
+    while ((fd = netutil_accept(m->listen_fd)) >= 0) {
+        metrics_client_t *slot = NULL;
+        for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+            if (m->clients[i].fd < 0) {
+                slot = &m->clients[i];
+                break;
+            }
+        }
+        if (!slot) {
+            close(fd); // Scrapers retry; never grow past the fixed client table
+            continue;
+        }
+        slot->fd = fd;
+        slot->in_len = 0;
+        slot->responding = 0;
+    }
+}
+
+int metrics_pollfds(metrics_t *m, struct pollfd *pfds, int max) {
+    int n = 0;
+    if (m->listen_fd < 0 || max <= 0) return 0;
+
+    pfds[n].fd = m->listen_fd;
+    pfds[n].events = POLLIN;
+    pfds[n].revents = 0;
+    n++;
+
+    for (int i = 0; i < METRICS_MAX_CLIENTS && n < max; i++) {
+        metrics_client_t *c = &m->clients[i];
+        if (c->fd < 0) continue;
+        pfds[n].fd = c->fd;
+        pfds[n].events = c->responding ? POLLOUT : POLLIN;
+        pfds[n].revents = 0;
+        n++;
+    }
+    return n;
+}
+
+void metrics_dispatch(metrics_t *m, const struct pollfd *pfds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (pfds[i].revents == 0) continue;
+
+        if (pfds[i].fd == m->listen_fd) {
+            accept_clients(m);
+            continue;
+        }
+
+        for (int j = 0; j < METRICS_MAX_CLIENTS; j++) {
+            metrics_client_t *c = &m->clients[j];
+            if (c->fd != pfds[i].fd) continue;
+
+            if (pfds[i].revents & (POLLERR | POLLNVAL)) {
+                client_close(c);
+            } else if (c->responding && (pfds[i].revents & POLLOUT)) {
+                client_write(c);
+            } else if (!c->responding && (pfds[i].revents & (POLLIN | POLLHUP))) {
+                client_read(m, c);
+            }
+            break;
+        }
+    }
+}
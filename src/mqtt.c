@@ -0,0 +1,507 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+#include <ctype.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "mqtt.h"
+#include "netutil.h"
+#include "timebase.h"
+#include "logger.h"
+
+#define MQTT_CONNECT_TIMEOUT_SEC 10.0
+#define MQTT_MIN_KEEPALIVE_SEC 20       // Ticks can be 10 s apart
+
+// Fixed-header packet types
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+
+// CONNECT flags
+#define MQTT_FLAG_CLEAN 0x02
+#define MQTT_FLAG_WILL 0x04
+#define MQTT_FLAG_WILL_RETAIN 0x20
+#define MQTT_FLAG_PASSWORD 0x40
+#define MQTT_FLAG_USERNAME 0x80
+
+static size_t put_u16(uint8_t *p, size_t len) {
+    p[0] = (uint8_t)(len >> 8);
+    p[1] = (uint8_t)(len & 0xFF);
+    return 2;
+}
+
+static size_t put_str(uint8_t *p, const char *s) {
+    size_t len = strlen(s);
+    put_u16(p, len);
+    memcpy(p + 2, s, len);
+    return 2 + len;
+}
+
+// Remaining-length varint (at most 2 bytes for MQTT_PACKET_MAX)
+static size_t put_remaining(uint8_t *p, size_t len) {
+    size_t n = 0;
+    do {
+        uint8_t byte = (uint8_t)(len % 128);
+        len /= 128;
+        if (len > 0) byte |= 0x80;
+        p[n++] = byte;
+    } while (len > 0);
+    return n;
+}
+
+// Slot for a new packet at the tail. When the ring is full the oldest
+// packet not yet started goes: the head itself, or the one after a
+// partially written head.
+static mqtt_packet_t *queue_push(mqtt_t *m) {
+    if (m->count == MQTT_QUEUE_LEN) {
+        if (m->head_off > 0) {
+            size_t next = (m->head + 1) % MQTT_QUEUE_LEN;
+            m->queue[next] = m->queue[m->head];
+            m->head = next;
+        } else {
+            m->head = (m->head + 1) % MQTT_QUEUE_LEN;
+        }
+        m->count--;
+        m->dropped++;
+        logger_log(LOGGER_WARNING, NULL, "[MQTT] Broker too slow, dropped oldest message (%lu total)", m->dropped);
+    }
+    mqtt_packet_t *pkt = &m->queue[(m->head + m->count) % MQTT_QUEUE_LEN];
+    m->count++;
+    return pkt;
+}
+
+static void queue_clear(mqtt_t *m) {
+    m->head = 0;
+    m->count = 0;
+    m->head_off = 0;
+}
+
+static void mqtt_disconnect(mqtt_t *m, const char *reason) {
+    if (m->fd >= 0) {
+        close(m->fd);
+        m->fd = -1;
+    }
+    netutil_lookup_free(m->lookup);
+    m->lookup = NULL;
+    double now = timebase_mono_sec();
+    if (m->state == MQTT_CONNECTED) {
+        m->backoff = 1.0;   // Was working: retry quickly
+    }
+    logger_log(LOGGER_WARNING, NULL, "[MQTT] %s: %s (retry in %.0fs)", m->broker_spec, reason, m->backoff);
+    m->state = MQTT_DISCONNECTED;
+    m->next_attempt = now + m->backoff;
+    m->backoff = fmin(m->backoff * 2.0, MQTT_RECONNECT_MAX_SEC);
+    m->ping_sent = 0.0;
+    m->in_len = 0;
+    queue_clear(m);
+}
+
+// Write as much of the ring as the socket takes without blocking
+static void mqtt_flush(mqtt_t *m) {
+    while (m->count > 0 && m->fd >= 0) {
+        mqtt_packet_t *pkt = &m->queue[m->head];
+        ssize_t n = send(m->fd, pkt->data + m->head_off, pkt->len - m->head_off, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+            mqtt_disconnect(m, strerror(errno));
+            return;
+        }
+        m->last_tx = timebase_mono_sec();
+        m->head_off += (size_t)n;
+        if (m->head_off < pkt->len) return;
+        m->head = (m->head + 1) % MQTT_QUEUE_LEN;
+        m->count--;
+        m->head_off = 0;
+    }
+}
+
+static void queue_simple(mqtt_t *m, uint8_t type) {
+    mqtt_packet_t *pkt = queue_push(m);
+    pkt->data[0] = type;
+    pkt->data[1] = 0;
+    pkt->len = 2;
+}
+
+static void queue_publish(mqtt_t *m, const char *topic, const char *payload, int retain) {
+    size_t topic_len = strlen(topic);
+    size_t payload_len = strlen(payload);
+    size_t remaining = 2 + topic_len + payload_len;
+    if (remaining + 3 > MQTT_PACKET_MAX) {
+        logger_log(LOGGER_WARNING, NULL, "[MQTT] Message for %s too large, skipped", topic);
+        return;
+    }
+    mqtt_packet_t *pkt = queue_push(m);
+    size_t n = 0;
+    pkt->data[n++] = (uint8_t)(MQTT_PUBLISH | (retain ? 1 : 0));
+    n += put_remaining(pkt->data + n, remaining);
+    n += put_str(pkt->data + n, topic);
+    memcpy(pkt->data + n, payload, payload_len);
+    pkt->len = (uint16_t)(n + payload_len);
+    m->published++;
+}
+
+static void publish_value(mqtt_t *m, const char *name, const char *payload) {
+    char topic[MQTT_TOPIC_LEN + 32];
+    snprintf(topic, sizeof(topic), "%s/%s", m->topic, name);
+    queue_publish(m, topic, payload, 1);
+}
+
+static void queue_connect(mqtt_t *m) {
+    char will_topic[MQTT_TOPIC_LEN + 8];
+    snprintf(will_topic, sizeof(will_topic), "%s/status", m->topic);
+
+    uint8_t flags = MQTT_FLAG_CLEAN | MQTT_FLAG_WILL | MQTT_FLAG_WILL_RETAIN;
+    size_t remaining = 10 + 2 + strlen(m->client_id) + 2 + strlen(will_topic) + 2 + strlen("offline");
+    if (m->username[0]) {
+        flags |= MQTT_FLAG_USERNAME;
+        remaining += 2 + strlen(m->username);
+        if (m->password[0]) {
+            flags |= MQTT_FLAG_PASSWORD;
+            remaining += 2 + strlen(m->password);
+        }
+    }
+
+    mqtt_packet_t *pkt = queue_push(m);
+    size_t n = 0;
+    pkt->data[n++] = MQTT_CONNECT;
+    n += put_remaining(pkt->data + n, remaining);
+    n += put_str(pkt->data + n, "MQTT");
+    pkt->data[n++] = 4;     // Protocol level 3.1.1
+    pkt->data[n++] = flags;
+    n += put_u16(pkt->data + n, (size_t)m->keepalive_sec);
+    n += put_str(pkt->data + n, m->client_id);
+    n += put_str(pkt->data + n, will_topic);
+    n += put_str(pkt->data + n, "offline");
+    if (flags & MQTT_FLAG_USERNAME) n += put_str(pkt->data + n, m->username);
+    if (flags & MQTT_FLAG_PASSWORD) n += put_str(pkt->data + n, m->password);
+    pkt->len = (uint16_t)n;
+}
+
+static void queue_discovery_entity(mqtt_t *m, const char *component, const char *object, const char *name,
+                                   const char *extra) {
+    char topic[MQTT_TOPIC_LEN + 64];
+    char payload[MQTT_PACKET_MAX - MQTT_TOPIC_LEN - 72];
+    snprintf(topic, sizeof(topic), "%s/%s/radxa_penta_%s/%s/config", m->discovery_prefix, component, m->node_id, object);
+    int len = snprintf(payload, sizeof(payload),
+             "{\"name\":\"%s\",\"unique_id\":\"radxa_penta_%s_%s\",\"state_topic\":\"%s/%s\","
+             "\"availability_topic\":\"%s/status\",%s"
+             "\"device\":{\"identifiers\":[\"radxa_penta_%s\"],\"name\":\"Radxa Penta %s\","
+             "\"manufacturer\":\"Radxa\",\"model\":\"Penta SATA HAT\"}}",
+             name, m->node_id, object, m->topic, object, m->topic, extra, m->node_id, m->node_id);
+    if (len < 0 || (size_t)len >= sizeof(payload)) {
+        logger_log(LOGGER_WARNING, NULL, "[MQTT] Discovery config for %s too large, skipped", object);
+        return;
+    }
+    queue_publish(m, topic, payload, 1);
+}
+
+static void queue_discovery(mqtt_t *m) {
+    static const char *temp = "\"device_class\":\"temperature\",\"state_class\":\"measurement\",\"unit_of_measurement\":\"\xC2\xB0" "C\",";
+
+    queue_discovery_entity(m, "sensor", "cpu_temp", "CPU temperature", temp);
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        char object[32], name[48];
+        snprintf(object, sizeof(object), "%s_temp", thermal_ssd_device_name(i));
+        snprintf(name, sizeof(name), "%s temperature", thermal_ssd_device_name(i));
+        queue_discovery_entity(m, "sensor", object, name, temp);
+    }
+    queue_discovery_entity(m, "sensor", "fan_duty", "Fan duty",
+                           "\"state_class\":\"measurement\",\"unit_of_measurement\":\"%\",\"icon\":\"mdi:fan\",");
+    queue_discovery_entity(m, "sensor", "mode", "Fan mode", "\"icon\":\"mdi:tune\",");
+    queue_discovery_entity(m, "sensor", "profile", "Fan profile", "\"icon\":\"mdi:tune-variant\",");
+    queue_discovery_entity(m, "binary_sensor", "alarm", "Thermal alarm", "\"device_class\":\"problem\",");
+}
+
+static void forget_published(mqtt_t *m) {
+    m->pub_cpu = NAN;
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) m->pub_ssd[i] = -1000;
+    m->pub_duty = NAN;
+    m->pub_mode[0] = '\0';
+    m->pub_profile[0] = '\0';
+    m->pub_alarm = -1;
+}
+
+static void on_connack(mqtt_t *m, uint8_t rc) {
+    if (rc != 0) {
+        char reason[48];
+        snprintf(reason, sizeof(reason), "connection refused (code %u)", rc);
+        mqtt_disconnect(m, reason);
+        return;
+    }
+    m->state = MQTT_CONNECTED;
+    m->connects++;
+    m->connected_at = timebase_mono_sec();
+    m->backoff = 1.0;
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &m->broker.sin_addr, ip, sizeof(ip));
+    logger_log(LOGGER_INFO, NULL, "[MQTT] Connected to %s (%s) as %s", m->broker_spec, ip, m->client_id);
+
+    publish_value(m, "status", "online");
+    if (m->discovery_prefix[0]) {
+        queue_discovery(m);
+    }
+    forget_published(m);    // Next mqtt_publish_state() sends every value
+    mqtt_flush(m);
+}
+
+static void mqtt_read(mqtt_t *m) {
+    uint8_t buf[64];
+    ssize_t n = recv(m->fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n == 0) {
+        mqtt_disconnect(m, "closed by broker");
+        return;
+    }
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) mqtt_disconnect(m, strerror(errno));
+        return;
+    }
+
+    // Only CONNACK (4 bytes) and PINGRESP (2 bytes) are expected
+    for (ssize_t i = 0; i < n; i++) {
+        m->in[m->in_len++] = buf[i];
+        if (m->in_len < 2) continue;
+        if (m->in[1] > sizeof(m->in) - 2) {
+            mqtt_disconnect(m, "unexpected packet");
+            return;
+        }
+        if (m->in_len < 2u + m->in[1]) continue;
+
+        uint8_t type = m->in[0] & 0xF0;
+        if (type == MQTT_CONNACK && m->in[1] == 2 && m->state == MQTT_HANDSHAKE) {
+            m->in_len = 0;
+            on_connack(m, m->in[3]);
+            if (m->state != MQTT_CONNECTED) return;
+        } else if (type == MQTT_PINGRESP) {
+            m->ping_sent = 0.0;
+            m->in_len = 0;
+        } else {
+            mqtt_disconnect(m, "unexpected packet");
+            return;
+        }
+    }
+}
+
+int mqtt_init(mqtt_t *m, const config_t *cfg) {
+    memset(m, 0, sizeof(mqtt_t));
+    m->fd = -1;
+    m->state = MQTT_DISCONNECTED;
+    m->backoff = 1.0;
+    forget_published(m);
+
+    // Started now so the first attempt rarely waits; a name that does not
+    // resolve yet (DNS not up at boot) is retried like a refused connect
+    snprintf(m->broker_spec, sizeof(m->broker_spec), "%s", cfg->mqtt_broker);
+    m->lookup = netutil_lookup_start(m->broker_spec, MQTT_DEFAULT_PORT);
+    if (!m->lookup) {
+        return -1;
+    }
+    m->state = MQTT_RESOLVING;
+
+    // Node id: the hostname reduced to [a-z0-9_] for topics and unique ids
+    char host[64] = "";
+    gethostname(host, sizeof(host) - 1);
+    size_t j = 0;
+    for (size_t i = 0; host[i] && j < sizeof(m->node_id) - 1; i++) {
+        unsigned char c = (unsigned char)host[i];
+        m->node_id[j++] = isalnum(c) ? (char)tolower(c) : '_';
+    }
+    if (j == 0) snprintf(m->node_id, sizeof(m->node_id), "penta");
+
+    if (cfg->mqtt_topic[0]) {
+        snprintf(m->topic, sizeof(m->topic), "%s", cfg->mqtt_topic);
+    } else {
+        snprintf(m->topic, sizeof(m->topic), "radxa-penta/%s", m->node_id);
+    }
+    if (cfg->mqtt_client_id[0]) {
+        snprintf(m->client_id, sizeof(m->client_id), "%s", cfg->mqtt_client_id);
+    } else {
+        snprintf(m->client_id, sizeof(m->client_id), "radxa-penta-%s", m->node_id);
+    }
+    snprintf(m->username, sizeof(m->username), "%s", cfg->mqtt_username);
+    snprintf(m->password, sizeof(m->password), "%s", cfg->mqtt_password);
+    snprintf(m->discovery_prefix, sizeof(m->discovery_prefix), "%s", cfg->mqtt_discovery ? cfg->mqtt_discovery_prefix : "");
+
+    m->keepalive_sec = cfg->mqtt_keepalive_sec < MQTT_MIN_KEEPALIVE_SEC ? MQTT_MIN_KEEPALIVE_SEC : cfg->mqtt_keepalive_sec;
+    m->temp_deadband = cfg->mqtt_temp_deadband;
+    m->duty_deadband = cfg->mqtt_duty_deadband;
+    return 0;
+}
+
+void mqtt_cleanup(mqtt_t *m) {
+    if (m->fd >= 0 && m->state == MQTT_CONNECTED) {
+        // One non-blocking attempt; the broker's last will covers failure
+        publish_value(m, "status", "offline");
+        queue_simple(m, MQTT_DISCONNECT);
+        mqtt_flush(m);
+    }
+    if (m->fd >= 0) {
+        close(m->fd);
+        m->fd = -1;
+    }
+    netutil_lookup_free(m->lookup);
+    m->lookup = NULL;
+    m->state = MQTT_DISCONNECTED;
+}
+
+void mqtt_publish_state(mqtt_t *m, const mqtt_state_t *s) {
+    if (m->state != MQTT_CONNECTED) return;
+
+    char payload[320];  // Worst-case %f width
+    if (isnan(m->pub_cpu) || fabs(s->cpu_temp - m->pub_cpu) >= m->temp_deadband) {
+        m->pub_cpu = s->cpu_temp;
+        snprintf(payload, sizeof(payload), "%.1f", s->cpu_temp);
+        publish_value(m, "cpu_temp", payload);
+    }
+    for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+        if (fabs((double)(s->ssd_temps[i] - m->pub_ssd[i])) >= m->temp_deadband) {
+            char name[32];
+            m->pub_ssd[i] = s->ssd_temps[i];
+            snprintf(name, sizeof(name), "%s_temp", thermal_ssd_device_name(i));
+            snprintf(payload, sizeof(payload), "%d", s->ssd_temps[i]);
+            publish_value(m, name, payload);
+        }
+    }
+    // Always report reaching 0 or 100% exactly, whatever the deadband
+    if (isnan(m->pub_duty) || fabs(s->duty - m->pub_duty) >= m->duty_deadband ||
+        (s->duty != m->pub_duty && (s->duty <= 0.0 || s->duty >= 1.0))) {
+        m->pub_duty = s->duty;
+        snprintf(payload, sizeof(payload), "%.0f", s->duty * 100.0);
+        publish_value(m, "fan_duty", payload);
+    }
+    if (strcmp(s->mode, m->pub_mode) != 0) {
+        snprintf(m->pub_mode, sizeof(m->pub_mode), "%s", s->mode);
+        publish_value(m, "mode", s->mode);
+    }
+    if (strcmp(s->profile, m->pub_profile) != 0) {
+        snprintf(m->pub_profile, sizeof(m->pub_profile), "%s", s->profile);
+        publish_value(m, "profile", s->profile);
+    }
+    if (s->alarm != m->pub_alarm) {
+        m->pub_alarm = s->alarm;
+        publish_value(m, "alarm", s->alarm ? "ON" : "OFF");
+    }
+    mqtt_flush(m);
+}
+
+// Connect once the lookup is done (the resolver's own timeouts bound it)
+static void mqtt_resolved(mqtt_t *m, double now) {
+    const char *error = NULL;
+    int rc = netutil_lookup_poll(m->lookup, &m->broker, &error);
+    if (rc == 0) return;
+    if (rc < 0) {
+        mqtt_disconnect(m, error);
+        return;
+    }
+    netutil_lookup_free(m->lookup);
+    m->lookup = NULL;
+    m->fd = netutil_connect(&m->broker);
+    m->next_attempt = now;  // Start of this attempt, for the timeout
+    if (m->fd < 0) {
+        mqtt_disconnect(m, strerror(errno));
+    } else {
+        m->state = MQTT_CONNECTING;
+    }
+}
+
+void mqtt_service(mqtt_t *m, double now) {
+    switch (m->state) {
+        case MQTT_DISCONNECTED:
+            if (now < m->next_attempt) break;
+            // Look the name up again each attempt: the broker may have moved
+            m->lookup = netutil_lookup_start(m->broker_spec, MQTT_DEFAULT_PORT);
+            if (!m->lookup) {
+                mqtt_disconnect(m, "cannot start lookup");
+                break;
+            }
+            m->state = MQTT_RESOLVING;
+            mqtt_resolved(m, now);
+            break;
+        case MQTT_RESOLVING:
+            mqtt_resolved(m, now);
+            break;
+        case MQTT_CONNECTING:
+        case MQTT_HANDSHAKE:
+            if (now - m->next_attempt > MQTT_CONNECT_TIMEOUT_SEC) {
+                mqtt_disconnect(m, "connect timeout");
+            }
+            break;
+        case MQTT_CONNECTED:
+            if (m->ping_sent > 0.0) {
+                if (now - m->ping_sent > (double)m->keepalive_sec) {
+                    mqtt_disconnect(m, "no PINGRESP");
+                }
+            } else if (now - m->last_tx >= (double)m->keepalive_sec / 2.0) {
+                queue_simple(m, MQTT_PINGREQ);
+                m->ping_sent = now;
+                mqtt_flush(m);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+int mqtt_pollfds(mqtt_t *m, struct pollfd *pfds, int max) {
+    if (m->fd < 0 || max < 1) return 0;
+    pfds[0].fd = m->fd;
+    pfds[0].revents = 0;
+    if (m->state == MQTT_CONNECTING) {
+        pfds[0].events = POLLOUT;
+    } else {
+        pfds[0].events = (short)(POLLIN | (m->count > 0 ? POLLOUT : 0));
+    }
+    return 1;
+}
+
+void mqtt_dispatch(mqtt_t *m, const struct pollfd *pfds, int count) {
+    if (count < 1 || m->fd < 0 || pfds[0].fd != m->fd) return;
+    short re = pfds[0].revents;
+
+    if (m->state == MQTT_CONNECTING) {
+        if (!(re & (POLLOUT | POLLERR | POLLHUP))) return;
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(m->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+        if (err != 0) {
+            mqtt_disconnect(m, strerror(err));
+            return;
+        }
+        m->state = MQTT_HANDSHAKE;
+        queue_connect(m);
+        mqtt_flush(m);
+        return;
+    }
+
+    if (re & POLLIN) {
+        mqtt_read(m);
+        if (m->fd < 0) return;
+    }
+    if (re & (POLLERR | POLLHUP | POLLNVAL)) {
+        mqtt_disconnect(m, "connection lost");
+        return;
+    }
+    if (re & POLLOUT) {
+        mqtt_flush(m);
+    }
+}
+
+const char *mqtt_state_name(const mqtt_t *m) {
+    switch (m->state) {
+        case MQTT_DISCONNECTED: return "disconnected";
+        case MQTT_RESOLVING: return "resolving";
+        case MQTT_CONNECTING: return "connecting";
+        case MQTT_HANDSHAKE: return "handshake";
+        case MQTT_CONNECTED: return "connected";
+        default: return "?";
+    }
+}
@@ -0,0 +1,205 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#define _GNU_SOURCE  // accept4(), getaddrinfo_a()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include "netutil.h"
+
+#define NETUTIL_BACKLOG 8
+
+static int listen_unix(const char *path, char *unix_path, size_t unix_path_size) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Warning: Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Warning: Cannot create Unix socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    unlink(path); // Remove stale socket from a previous run
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, NETUTIL_BACKLOG) < 0) {
+        fprintf(stderr, "Warning: Cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    snprintf(unix_path, unix_path_size, "%s", path);
+    return fd;
+}
+
+// Split "host:port" (port optional when default_port > 0)
+static int split_host_port(const char *spec, char *host, size_t host_size, long *port, long default_port) {
+    const char *colon = strrchr(spec, ':');
+    if (!colon && default_port > 0) {
+        if (strlen(spec) >= host_size) return -1;
+        snprintf(host, host_size, "%s", spec);
+        *port = default_port;
+        return 0;
+    }
+    if (!colon || (size_t)(colon - spec) >= host_size) {
+        fprintf(stderr, "Warning: Invalid address '%s' (expected host:port)\n", spec);
+        return -1;
+    }
+    memcpy(host, spec, (size_t)(colon - spec));
+    host[colon - spec] = '\0';
+
+    char *end;
+    *port = strtol(colon + 1, &end, 10);
+    if (*end != '\0' || *port <= 0 || *port > 65535) {
+        fprintf(stderr, "Warning: Invalid port in '%s'\n", spec);
+        return -1;
+    }
+    return 0;
+}
+
+static int listen_tcp(const char *spec) {
+    char host[64];
+    long port;
+    if (split_host_port(spec, host, sizeof(host), &port, 0) < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (host[0] == '\0' || strcmp(host, "localhost") == 0) {
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    } else if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "Warning: Invalid IPv4 address '%s'\n", host);
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Warning: Cannot create TCP socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, NETUTIL_BACKLOG) < 0) {
+        fprintf(stderr, "Warning: Cannot listen on %s: %s\n", spec, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int netutil_listen(const char *spec, char *unix_path, size_t unix_path_size) {
+    if (unix_path_size > 0) unix_path[0] = '\0';
+
+    if (strncmp(spec, "unix:", 5) == 0) {
+        return listen_unix(spec + 5, unix_path, unix_path_size);
+    }
+    return listen_tcp(spec);
+}
+
+int netutil_accept(int listen_fd) {
+    return accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+}
+
+struct netutil_lookup {
+    struct gaicb cb;
+    struct gaicb *list[1];
+    struct addrinfo hints;
+    char host[64];
+    struct sockaddr_in addr;
+    int pending;                // getaddrinfo_a() still owns cb
+    const char *error;          // Set once the lookup failed
+};
+
+netutil_lookup_t *netutil_lookup_start(const char *spec, int default_port) {
+    char host[64];
+    long port;
+    if (split_host_port(spec, host, sizeof(host), &port, default_port) < 0) {
+        return NULL;
+    }
+
+    netutil_lookup_t *l = calloc(1, sizeof(*l));
+    if (!l) return NULL;
+    l->addr.sin_family = AF_INET;
+    l->addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host, &l->addr.sin_addr) == 1) {
+        return l;   // Literal: nothing to look up
+    }
+
+    memcpy(l->host, host, sizeof(l->host));
+    l->hints.ai_family = AF_INET;
+    l->hints.ai_socktype = SOCK_STREAM;
+    l->cb.ar_name = l->host;
+    l->cb.ar_request = &l->hints;
+    l->list[0] = &l->cb;
+    int rc = getaddrinfo_a(GAI_NOWAIT, l->list, 1, NULL);
+    if (rc != 0) {
+        fprintf(stderr, "Warning: Cannot resolve '%s': %s\n", host, gai_strerror(rc));
+        free(l);
+        return NULL;
+    }
+    l->pending = 1;
+    return l;
+}
+
+int netutil_lookup_poll(netutil_lookup_t *l, struct sockaddr_in *addr, const char **error) {
+    if (l->pending) {
+        int rc = gai_error(&l->cb);
+        if (rc == EAI_INPROGRESS) return 0;
+        l->pending = 0;
+        struct addrinfo *res = l->cb.ar_result;
+        l->cb.ar_result = NULL;
+        if (rc == 0 && res) {
+            l->addr.sin_addr = ((struct sockaddr_in *)(void *)res->ai_addr)->sin_addr;
+        } else {
+            l->error = gai_strerror(rc != 0 ? rc : EAI_NONAME);
+        }
+        if (res) freeaddrinfo(res);
+    }
+    if (l->error) {
+        *error = l->error;
+        return -1;
+    }
+    *addr = l->addr;
+    return 1;
+}
+
+void netutil_lookup_free(netutil_lookup_t *l) {
+    if (!l) return;
+    if (l->pending && gai_cancel(&l->cb) == EAI_NOTCANCELED) {
+        // The resolver thread still writes into cb: wait it out
+        const struct gaicb *const wait[1] = { &l->cb };
+        while (gai_error(&l->cb) == EAI_INPROGRESS) gai_suspend(wait, 1, NULL);
+    }
+    if (l->cb.ar_result) freeaddrinfo(l->cb.ar_result);
+    free(l);
+}
+
+int netutil_connect(const struct sockaddr_in *addr) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -0,0 +1,319 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <ctype.h>
+#include <sys/statvfs.h>
+#include "oled_render.h"
+#include "thermal.h"
+#include "budget.h"
+
+static void get_uptime(char *buffer, size_t size) {
+    FILE *fp = fopen("/proc/uptime", "r");
+    if (!fp) {
+        snprintf(buffer, size, "Uptime: N/A");
+        return;
+    }
+    
+    double uptime_seconds;
+    if (fscanf(fp, "%lf", &uptime_seconds) == 1) {
+        int days = (int)(uptime_seconds / 86400);
+        int hours = (int)((uptime_seconds - days * 86400) / 3600);
+        int minutes = (int)((uptime_seconds - days * 86400 - hours * 3600) / 60);
+        
+        if (days > 0) {
+            snprintf(buffer, size, "Up %dd %dh %dm", days, hours, minutes);
+        } else if (hours > 0) {
+            snprintf(buffer, size, "Up %dh %dm", hours, minutes);
+        } else {
+            snprintf(buffer, size, "Up %dm", minutes);
+        }
+    } else {
+        snprintf(buffer, size, "Uptime: N/A");
+    }
+    fclose(fp);
+}
+
+static void get_ip_address(oled_t *oled, char *buffer, size_t size) {
+    sysinfo_t *si = oled->sysinfo;
+    if (si && (si->nl_fd >= 0 || si->fixed)) {
+        char addr[SYSINFO_ADDR_LEN];
+        if (sysinfo_primary_address(si, addr, sizeof(addr)) == 0) {
+            snprintf(buffer, size, "IP %s", addr);
+        } else {
+            snprintf(buffer, size, "IP: N/A");
+        }
+        return;
+    }
+
+    budget_count_spawn();
+    FILE *fp = popen("hostname -I | awk '{printf \"IP %s\", $1}'", "r");
+    if (!fp || !fgets(buffer, (int)size, fp)) {
+        snprintf(buffer, size, "IP: N/A");
+    } else {
+        buffer[strcspn(buffer, "\n")] = 0; // Remove newline
+    }
+    if (fp) pclose(fp);
+}
+
+static void get_cpu_load(char *buffer, size_t size) {
+    budget_count_spawn();
+    FILE *fp = popen("uptime | awk '{printf \"CPU: %.2f\", $(NF-2)}'", "r");
+    if (!fp || !fgets(buffer, (int)size, fp)) {
+        snprintf(buffer, size, "CPU Load: N/A");
+    } else {
+        buffer[strcspn(buffer, "\n")] = 0;
+    }
+    if (fp) pclose(fp);
+}
+
+static void get_memory_info(char *buffer, size_t size) {
+    budget_count_spawn();
+    FILE *fp = popen("free -m | awk 'NR==2{printf \"Mem:%s/%sMB\", $3,$2}'", "r");
+    if (!fp || !fgets(buffer, (int)size, fp)) {
+        snprintf(buffer, size, "Memory: N/A");
+    } else {
+        buffer[strcspn(buffer, "\n")] = 0;
+    }
+    if (fp) pclose(fp);
+}
+
+// df -h style: binary units, one decimal below 10
+static void format_size(char *buf, size_t len, double bytes) {
+    static const char units[] = "BKMGTPE";
+    size_t u = 0;
+    while (bytes >= 1024.0 && u < sizeof(units) - 2) {
+        bytes /= 1024.0;
+        u++;
+    }
+    snprintf(buf, len, bytes < 10.0 && u > 0 ? "%.1f%c" : "%.0f%c", bytes, units[u]);
+}
+
+// RAID usage from the cached mount point: one statvfs(), no df spawn
+static int get_raid_usage(oled_t *oled, char *buffer, size_t size) {
+    char mount[SYSINFO_PATH_LEN];
+    struct statvfs st;
+    if (sysinfo_raid_mount(oled->sysinfo, mount, sizeof(mount)) < 0 || statvfs(mount, &st) < 0) {
+        return -1;
+    }
+    double frsize = (double)st.f_frsize;
+    double used = (double)(st.f_blocks - st.f_bfree) * frsize;
+    double avail = (double)st.f_bavail * frsize;
+    double total = (double)st.f_blocks * frsize;
+    int pct = used + avail > 0.0 ? (int)ceil(used * 100.0 / (used + avail)) : 0;
+
+    char used_s[16], total_s[16];
+    format_size(used_s, sizeof(used_s), used);
+    format_size(total_s, sizeof(total_s), total);
+    snprintf(buffer, size, "RAID:%s/%s(%d%%)", used_s, total_s, pct);
+    return 0;
+}
+
+// One drive in at most 9 characters: remaining life, or the first
+// problem counter (reallocated, pending, media errors) when non-zero
+static void format_health(char *buf, size_t len, const char *name, const ssd_health_t *h) {
+    char dev[4] = { (char)toupper(name[0]), (char)toupper(name[1]), (char)toupper(name[2]), '\0' };
+    long bad = 0;
+    char kind = '\0';
+    if (h->reallocated > 0) {
+        bad = h->reallocated;
+        kind = 'R';
+    } else if (h->pending > 0) {
+        bad = h->pending;
+        kind = 'P';
+    } else if (h->media_errors > 0) {
+        bad = h->media_errors;
+        kind = 'M';
+    }
+
+    if (!h->valid) {
+        snprintf(buf, len, "%s:--", dev);
+    } else if (kind) {
+        snprintf(buf, len, "%s:!%c%ld", dev, kind, bad > 999 ? 999 : bad);
+    } else if (h->wear_leveling >= 0) {
+        snprintf(buf, len, "%s:%d%%", dev, h->wear_leveling);
+    } else if (h->percent_used >= 0) {
+        snprintf(buf, len, "%s:%d%%", dev, h->percent_used < 100 ? 100 - h->percent_used : 0);
+    } else {
+        snprintf(buf, len, "%s:OK", dev);
+    }
+}
+
+static void frame_text(oled_frame_t *frame, uint8_t x, uint8_t y, const char *text, int bold) {
+    if (frame->text_count >= OLED_FRAME_MAX_TEXT) return;
+    oled_text_t *t = &frame->text[frame->text_count++];
+    t->x = x;
+    t->y = y;
+    t->bold = bold;
+    size_t n = strlen(text);
+    if (n >= sizeof(t->text)) n = sizeof(t->text) - 1;
+    memcpy(t->text, text, n);
+    t->text[n] = '\0';
+}
+
+// CPU temperature over the last OLED_GRAPH_SPAN_SEC as one bar per column
+// below a one-line caption (bars stay out of the text's 8-pixel page).
+static void render_graph(oled_t *oled, oled_frame_t *frame) {
+    double values[OLED_WIDTH];
+    int64_t to = (int64_t)time(NULL) + 1;
+    size_t samples = history_query(oled->history, HISTORY_CPU_TEMP, to - OLED_GRAPH_SPAN_SEC, to,
+                                   values, OLED_WIDTH);
+    if (samples == 0) {
+        frame_text(frame, 0, 12, "No history yet", 0);
+        return;
+    }
+
+    double lo = INFINITY, hi = -INFINITY;
+    for (int x = 0; x < OLED_WIDTH; x++) {
+        if (isnan(values[x])) continue;
+        if (values[x] < lo) lo = values[x];
+        if (values[x] > hi) hi = values[x];
+    }
+    // Keep at least a 5°C range so sensor noise does not fill the screen
+    if (hi - lo < 5.0) {
+        double mid = (hi + lo) / 2.0;
+        lo = mid - 2.5;
+        hi = mid + 2.5;
+    }
+
+    char caption[40];
+    snprintf(caption, sizeof(caption), "CPU 2h %d-%dC", (int)floor(lo), (int)ceil(hi));
+    frame_text(frame, 0, 0, caption, 0);
+
+    const int top = 8, bottom = OLED_HEIGHT - 1;
+    for (int x = 0; x < OLED_WIDTH; x++) {
+        if (isnan(values[x])) continue;
+        int y = bottom - (int)((values[x] - lo) / (hi - lo) * (bottom - top) + 0.5);
+        if (y < top) y = top;
+        if (y > bottom) y = bottom;
+        frame->bar_top[x] = (uint8_t)y;
+    }
+}
+
+void oled_render_page(oled_t *oled, oled_page_t page, oled_frame_t *frame) {
+    char line1[64], line2[320], line3[64];
+
+    frame->text_count = 0;
+    memset(frame->bar_top, OLED_NO_BAR, sizeof(frame->bar_top));
+
+    switch (page) {
+        case PAGE_SYSTEM: {
+            get_uptime(line1, sizeof(line1));
+            
+            double cpu_temp = thermal_read_cpu_temp();
+            snprintf(line2, sizeof(line2), "CPU: %.1fC", cpu_temp);
+            
+            get_ip_address(oled, line3, sizeof(line3));
+            
+            frame_text(frame, 0, 0, line1, 0);
+            frame_text(frame, 0, 10, line2, 0);
+            frame_text(frame, 0, 20, line3, 0);
+            break;
+        }
+        
+        case PAGE_RESOURCES: {
+            get_cpu_load(line1, sizeof(line1));
+            get_memory_info(line2, sizeof(line2));
+            
+            frame_text(frame, 0, 4, line1, 0);
+            frame_text(frame, 0, 18, line2, 0);
+            break;
+        }
+        
+        case PAGE_DISKS: {
+            // Last smartctl pass of the control loop; never spawns here
+            int temps[MAX_DEVICES];
+            int count = thermal_ssd_cached(temps, MAX_DEVICES);
+            char *lines[2] = { line1, line2 };
+            size_t len[2] = { 0, 0 };
+            size_t shown = 0;
+            line1[0] = line2[0] = '\0';
+
+            for (size_t i = 0; i < SSD_DEVICE_COUNT && shown < 4; i++) {
+                if (!(oled->disks & (1u << i))) continue;
+                const char *name = thermal_ssd_device_name(i);
+                size_t row = shown / 2;
+                len[row] += (size_t)snprintf(lines[row] + len[row], 32, "%s%c%c%c:%dC", shown % 2 ? " " : "",
+                                             toupper(name[0]), toupper(name[1]), toupper(name[2]),
+                                             temps[i] > 0 ? temps[i] : 0);
+                shown++;
+            }
+
+            if (count > 0 && shown > 0) {
+                frame_text(frame, 0, 2, line1, 0);
+                frame_text(frame, 0, 14, line2, 0);
+            } else {
+                frame_text(frame, 0, 12, "No SSD data", 0);
+            }
+            break;
+        }
+        
+        case PAGE_HEALTH: {
+            // Last health pass of the control loop's smartctl runs
+            ssd_health_t health[SSD_DEVICE_COUNT];
+            int valid = thermal_ssd_health(health, SSD_DEVICE_COUNT);
+            char *lines[2] = { line1, line2 };
+            size_t len[2] = { 0, 0 };
+            size_t shown = 0;
+            line1[0] = line2[0] = '\0';
+
+            for (size_t i = 0; i < SSD_DEVICE_COUNT && shown < 4; i++) {
+                if (!(oled->disks & (1u << i))) continue;
+                char token[16];
+                format_health(token, sizeof(token), thermal_ssd_device_name(i), &health[i]);
+                size_t row = shown / 2;
+                len[row] += (size_t)snprintf(lines[row] + len[row], 32, "%s%s", shown % 2 ? " " : "", token);
+                shown++;
+            }
+
+            if (valid > 0 && shown > 0) {
+                frame_text(frame, 0, 2, line1, 0);
+                frame_text(frame, 0, 14, line2, 0);
+            } else {
+                frame_text(frame, 0, 12, "No SMART health", 0);
+            }
+            break;
+        }
+
+        case PAGE_RAID: {
+            if (oled->sysinfo && (oled->sysinfo->mounts_fd >= 0 || oled->sysinfo->fixed)) {
+                if (get_raid_usage(oled, line1, sizeof(line1)) < 0) {
+                    snprintf(line1, sizeof(line1), "RAID: N/A");
+                }
+                frame_text(frame, 0, 12, line1, 0);
+                break;
+            }
+            budget_count_spawn();
+            FILE *fp = popen("df -h /dev/md0 2>/dev/null | awk 'NR==2 {printf \"RAID:%s/%s(%s)\", $3, $2, $5}'", "r");
+            if (fp && fgets(line1, sizeof(line1), fp)) {
+                line1[strcspn(line1, "\n")] = 0;
+                frame_text(frame, 0, 12, line1, 0);
+            } else {
+                frame_text(frame, 0, 12, "RAID: N/A", 0);
+            }
+            if (fp) pclose(fp);
+            break;
+        }
+        
+        case PAGE_GRAPH:
+            if (oled->history) {
+                render_graph(oled, frame);
+            } else {
+                frame_text(frame, 0, 12, "History disabled", 0);
+            }
+            break;
+
+        case PAGE_COUNT:
+            // Not a real page, just used for counting
+            break;
+        
+        default:
+            break;
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include "profile.h"
+#include "logger.h"
+
+static int pending_request = PROFILE_REQUEST_NONE;
+static int last_entry = -1;         // Schedule entry in force at the last tick
+
+// Index of the schedule entry in force at now, or -1 without a schedule
+static int schedule_entry(const config_t *cfg, time_t now) {
+    if (cfg->schedule_count == 0) return -1;
+
+    struct tm tm;
+    localtime_r(&now, &tm);
+    int minute = tm.tm_hour * 60 + tm.tm_min;
+
+    // Before the first entry of the day, yesterday's last entry still holds
+    int entry = cfg->schedule_count - 1;
+    for (int i = 0; i < cfg->schedule_count; i++) {
+        if (cfg->schedule[i].minute <= minute) entry = i;
+    }
+    return entry;
+}
+
+int profile_scheduled(const config_t *cfg, time_t now) {
+    int entry = schedule_entry(cfg, now);
+    return entry < 0 ? -1 : cfg->schedule[entry].profile;
+}
+
+void profile_request(int idx) {
+    __atomic_store_n(&pending_request, idx, __ATOMIC_RELEASE);
+}
+
+int profile_pending(void) {
+    return __atomic_load_n(&pending_request, __ATOMIC_ACQUIRE) != PROFILE_REQUEST_NONE;
+}
+
+static int profile_switch(config_t *cfg, int idx, const char *source) {
+    if (idx < 0 || idx >= cfg->profile_count || &cfg->profiles[idx] == cfg->active) return 0;
+
+    const char *from = cfg->active->name;
+    cfg->active = &cfg->profiles[idx];
+
+    logger_fields_t fields;
+    logger_fields_init(&fields);
+    logger_field(&fields, "PROFILE", "%s", cfg->active->name);
+    logger_log(LOGGER_INFO, &fields, "[Profile] Switched from %s to %s (%s)", from, cfg->active->name, source);
+    return 1;
+}
+
+int profile_tick(config_t *cfg, time_t now) {
+    int changed = 0;
+
+    int entry = schedule_entry(cfg, now);
+    if (entry != last_entry) {
+        last_entry = entry;
+        if (entry >= 0) {
+            changed |= profile_switch(cfg, cfg->schedule[entry].profile, "schedule");
+        }
+    }
+
+    int req = __atomic_exchange_n(&pending_request, PROFILE_REQUEST_NONE, __ATOMIC_ACQ_REL);
+    if (req == PROFILE_REQUEST_NEXT) {
+        int next = (int)(cfg->active - cfg->profiles + 1) % cfg->profile_count;
+        changed |= profile_switch(cfg, next, "button");
+    } else if (req >= 0) {
+        changed |= profile_switch(cfg, req, "ctl");
+    }
+    return changed;
+}
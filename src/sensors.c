@@ -0,0 +1,230 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "sensors.h"
+#include "logger.h"
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SENSORS_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef SENSORS_HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#ifdef SENSORS_HAVE_IO_URING
+// Raw syscalls: the ring is small enough not to need liburing
+static int sensors_ring_open(sensors_ring_t *r, unsigned int entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0) return -1;
+    r->fd = fd;
+
+    r->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    r->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_size > r->sq_size) r->sq_size = r->cq_size;
+    }
+    r->sq_ptr = mmap(NULL, r->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED) {
+        r->sq_ptr = NULL;
+        return -1;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_ptr = r->sq_ptr;
+    } else {
+        r->cq_ptr = mmap(NULL, r->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (r->cq_ptr == MAP_FAILED) {
+            r->cq_ptr = NULL;
+            return -1;
+        }
+    }
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        r->sqes = NULL;
+        return -1;
+    }
+
+    char *sq = r->sq_ptr;
+    char *cq = r->cq_ptr;
+    r->sq_tail = (unsigned int *)(void *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned int *)(void *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned int *)(void *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned int *)(void *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned int *)(void *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned int *)(void *)(cq + p.cq_off.ring_mask);
+    r->cqes = cq + p.cq_off.cqes;
+    return 0;
+}
+
+// Queue one read per file, one enter to submit and wait for all of them.
+// -1 if the ring (or IORING_OP_READ, kernel < 5.6) does not work.
+static int sensors_ring_read(sensors_t *s) {
+    sensors_ring_t *r = &s->ring;
+    struct io_uring_sqe *sqes = r->sqes;
+    struct io_uring_cqe *cqes = r->cqes;
+    unsigned int mask = *r->sq_mask;
+    unsigned int tail = *r->sq_tail;
+
+    for (int i = 0; i < s->count; i++) {
+        unsigned int idx = tail & mask;
+        struct io_uring_sqe *sqe = &sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = s->files[i].fd;
+        sqe->addr = (uint64_t)(uintptr_t)s->files[i].buf;
+        sqe->len = SENSORS_BUF_LEN - 1;
+        sqe->off = 0;
+        sqe->user_data = (unsigned int)i;
+        r->sq_array[idx] = idx;
+        tail++;
+    }
+    __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+
+    unsigned int pending = (unsigned int)s->count;
+    unsigned int to_submit = pending;
+    while (pending > 0) {
+        long ret = syscall(__NR_io_uring_enter, r->fd, to_submit, pending, IORING_ENTER_GETEVENTS, NULL, 0);
+        s->syscalls++;
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        to_submit -= (unsigned int)ret < to_submit ? (unsigned int)ret : to_submit;
+
+        unsigned int head = *r->cq_head;
+        unsigned int ctail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != ctail) {
+            const struct io_uring_cqe *cqe = &cqes[head & *r->cq_mask];
+            if (cqe->res == -EINVAL) {
+                __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+                return -1;
+            }
+            if (cqe->user_data < (uint64_t)s->count) {
+                s->files[cqe->user_data].len = cqe->res;
+            }
+            head++;
+            pending--;
+        }
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+#endif
+
+static void sensors_ring_close(sensors_ring_t *r) {
+#ifdef SENSORS_HAVE_IO_URING
+    if (r->sqes) munmap(r->sqes, r->sqes_size);
+    if (r->cq_ptr && r->cq_ptr != r->sq_ptr) munmap(r->cq_ptr, r->cq_size);
+    if (r->sq_ptr) munmap(r->sq_ptr, r->sq_size);
+#endif
+    if (r->fd >= 0) close(r->fd);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+int sensors_init(sensors_t *s, int use_io_uring) {
+    memset(s, 0, sizeof(sensors_t));
+    s->backend = SENSORS_PREAD;
+    s->ring.fd = -1;
+    if (!use_io_uring) return 0;
+
+#ifdef SENSORS_HAVE_IO_URING
+    if (sensors_ring_open(&s->ring, SENSORS_MAX_FILES) == 0) {
+        s->backend = SENSORS_IO_URING;
+        return 0;
+    }
+    fprintf(stderr, "Warning: io_uring unavailable (%s), reading sensors with pread\n", strerror(errno));
+    sensors_ring_close(&s->ring);
+#else
+    fprintf(stderr, "Warning: Built without io_uring, reading sensors with pread\n");
+#endif
+    return 0;
+}
+
+int sensors_add(sensors_t *s, const char *path) {
+    if (s->count >= SENSORS_MAX_FILES) return -1;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    sensors_file_t *f = &s->files[s->count];
+    snprintf(f->path, sizeof(f->path), "%s", path);
+    f->fd = fd;
+    f->len = -ENODATA;
+    f->buf[0] = '\0';
+    return s->count++;
+}
+
+static void sensors_pread_all(sensors_t *s) {
+    for (int i = 0; i < s->count; i++) {
+        sensors_file_t *f = &s->files[i];
+        f->len = pread(f->fd, f->buf, SENSORS_BUF_LEN - 1, 0);
+        if (f->len < 0) f->len = -errno;
+        s->syscalls++;
+    }
+}
+
+int sensors_read_all(sensors_t *s) {
+    if (s->count == 0) return 0;
+    s->batches++;
+
+#ifdef SENSORS_HAVE_IO_URING
+    if (s->backend == SENSORS_IO_URING && sensors_ring_read(s) < 0) {
+        logger_log(LOGGER_WARNING, NULL, "Warning: io_uring sensor read failed, switching to pread");
+        sensors_ring_close(&s->ring);
+        s->backend = SENSORS_PREAD;
+    }
+#endif
+    if (s->backend == SENSORS_PREAD) {
+        sensors_pread_all(s);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < s->count; i++) {
+        sensors_file_t *f = &s->files[i];
+        if (f->len < 0) {
+            f->buf[0] = '\0';
+            failed++;
+        } else {
+            f->buf[f->len] = '\0';
+        }
+    }
+    return failed;
+}
+
+int sensors_long(const sensors_t *s, int id, long *out) {
+    if (id < 0 || id >= s->count || s->files[id].len <= 0) return -1;
+    char *end;
+    long v = strtol(s->files[id].buf, &end, 10);
+    if (end == s->files[id].buf) return -1;
+    *out = v;
+    return 0;
+}
+
+void sensors_close(sensors_t *s) {
+    for (int i = 0; i < s->count; i++) {
+        close(s->files[i].fd);
+    }
+    s->count = 0;
+    sensors_ring_close(&s->ring);
+    s->backend = SENSORS_PREAD;
+}
+
+const char *sensors_backend_name(const sensors_t *s) {
+    return s->backend == SENSORS_IO_URING ? "io_uring" : "pread";
+}
@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// Sensor read benchmark: syscalls and CPU time per tick for the pread and
+// io_uring backends of the batched reader, with open/read/close per file
+// (what a plain fopen() sensor does) as the reference.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <sys/resource.h>
+#include "sensors.h"
+#include "timebase.h"
+#include "logger.h"
+
+#define BENCH_DEFAULT_TICKS 10000
+
+// A realistic per-tick set once every sensor is polled
+static const char *default_globs[] = {
+    "/sys/class/thermal/thermal_zone*/temp",
+    "/sys/devices/system/cpu/cpu*/cpufreq/scaling_cur_freq",
+    "/proc/diskstats",
+    "/proc/meminfo",
+    "/proc/loadavg",
+    "/proc/stat",
+};
+
+typedef struct {
+    double wall_us;
+    double user_us;
+    double sys_us;
+    double syscalls;
+    int failed;
+} bench_result_t;
+
+static double tv_us(struct timeval tv) {
+    return (double)tv.tv_sec * 1e6 + (double)tv.tv_usec;
+}
+
+static void add_paths(char paths[][SENSORS_PATH_LEN], int *count, const char *pattern) {
+    glob_t g;
+    if (glob(pattern, 0, NULL, &g) != 0) return;
+    for (size_t i = 0; i < g.gl_pathc && *count < SENSORS_MAX_FILES; i++) {
+        snprintf(paths[*count], SENSORS_PATH_LEN, "%s", g.gl_pathv[i]);
+        (*count)++;
+    }
+    globfree(&g);
+}
+
+static void bench_begin(struct rusage *ru, uint64_t *t0) {
+    getrusage(RUSAGE_SELF, ru);
+    *t0 = timebase_raw_ns();
+}
+
+static void bench_end(bench_result_t *r, const struct rusage *ru0, uint64_t t0, long ticks) {
+    uint64_t t1 = timebase_raw_ns();
+    struct rusage ru1;
+    getrusage(RUSAGE_SELF, &ru1);
+    r->wall_us = (double)(t1 - t0) / 1e3 / (double)ticks;
+    r->user_us = (tv_us(ru1.ru_utime) - tv_us(ru0->ru_utime)) / (double)ticks;
+    r->sys_us = (tv_us(ru1.ru_stime) - tv_us(ru0->ru_stime)) / (double)ticks;
+}
+
+// Reference: every file opened, read and closed each tick
+static void bench_reopen(char paths[][SENSORS_PATH_LEN], int count, long ticks, bench_result_t *r) {
+    static char buf[SENSORS_BUF_LEN];
+    struct rusage ru0;
+    uint64_t t0;
+    unsigned long syscalls = 0;
+    memset(r, 0, sizeof(*r));
+
+    bench_begin(&ru0, &t0);
+    for (long t = 0; t < ticks; t++) {
+        for (int i = 0; i < count; i++) {
+            int fd = open(paths[i], O_RDONLY | O_CLOEXEC);
+            syscalls++;
+            if (fd < 0) {
+                r->failed++;
+                continue;
+            }
+            if (read(fd, buf, sizeof(buf) - 1) < 0) r->failed++;
+            close(fd);
+            syscalls += 2;
+        }
+    }
+    bench_end(r, &ru0, t0, ticks);
+    r->syscalls = (double)syscalls / (double)ticks;
+}
+
+static int bench_backend(char paths[][SENSORS_PATH_LEN], int count, int use_io_uring, long ticks, bench_result_t *r) {
+    static sensors_t s;
+    struct rusage ru0;
+    uint64_t t0;
+    memset(r, 0, sizeof(*r));
+
+    sensors_init(&s, use_io_uring);
+    if (use_io_uring && s.backend != SENSORS_IO_URING) return -1;
+    for (int i = 0; i < count; i++) {
+        sensors_add(&s, paths[i]);
+    }
+    sensors_read_all(&s);   // Warm up (and catch a kernel without IORING_OP_READ)
+    if (use_io_uring && s.backend != SENSORS_IO_URING) {
+        sensors_close(&s);
+        return -1;
+    }
+    s.syscalls = 0;
+    s.batches = 0;
+
+    bench_begin(&ru0, &t0);
+    for (long t = 0; t < ticks; t++) {
+        r->failed += sensors_read_all(&s);
+    }
+    bench_end(r, &ru0, t0, ticks);
+    r->syscalls = (double)s.syscalls / (double)s.batches;
+    sensors_close(&s);
+    return 0;
+}
+
+static void print_result(const char *name, const bench_result_t *r) {
+    printf("%-18s %10.1f %10.2f %10.2f %10.2f %10.2f%s\n", name, r->syscalls, r->wall_us,
+           r->user_us, r->sys_us, r->user_us + r->sys_us, r->failed ? "  (read errors)" : "");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-n ticks] [-f path]...\n"
+            "  -n  ticks per backend (default %d)\n"
+            "  -f  read this file instead of the default set (repeatable)\n",
+            prog, BENCH_DEFAULT_TICKS);
+}
+
+int main(int argc, char *argv[]) {
+    static char paths[SENSORS_MAX_FILES][SENSORS_PATH_LEN];
+    int count = 0;
+    long ticks = BENCH_DEFAULT_TICKS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:f:h")) != -1) {
+        switch (opt) {
+            case 'n': ticks = strtol(optarg, NULL, 10); break;
+            case 'f':
+                if (count < SENSORS_MAX_FILES) {
+                    snprintf(paths[count++], SENSORS_PATH_LEN, "%s", optarg);
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (ticks <= 0) {
+        fprintf(stderr, "Error: Ticks must be positive\n");
+        return 2;
+    }
+    if (count == 0) {
+        for (size_t i = 0; i < sizeof(default_globs) / sizeof(default_globs[0]); i++) {
+            add_paths(paths, &count, default_globs[i]);
+        }
+    }
+    if (count == 0) {
+        fprintf(stderr, "Error: No sensor files found\n");
+        return 1;
+    }
+    logger_init("warning", 0, NULL);
+
+    printf("%d files, %ld ticks per backend\n", count, ticks);
+    printf("%-18s %10s %10s %10s %10s %10s\n", "backend", "syscalls", "wall_us", "user_us", "sys_us", "cpu_us");
+
+    bench_result_t r;
+    bench_reopen(paths, count, ticks, &r);
+    print_result("open+read+close", &r);
+    bench_backend(paths, count, 0, ticks, &r);
+    print_result("pread", &r);
+    if (bench_backend(paths, count, 1, ticks, &r) == 0) {
+        print_result("io_uring", &r);
+    } else {
+        printf("%-18s unavailable on this kernel\n", "io_uring");
+    }
+    return 0;
+}
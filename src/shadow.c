@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "shadow.h"
+
+int shadow_init(shadow_t *s, const char *config_path, double divergence) {
+    memset(s, 0, sizeof(shadow_t));
+    // config_load_file() falls back to defaults; a shadow of the defaults
+    // would silently compare the wrong thing, so require the file
+    if (access(config_path, R_OK) != 0) {
+        fprintf(stderr, "Warning: Cannot read shadow config %s\n", config_path);
+        return -1;
+    }
+    config_load_file(&s->cfg, config_path);
+    thermal_state_init(&s->state);
+    s->state.quiet = 1;
+    s->divergence = divergence > 0.0 ? divergence : SHADOW_DEFAULT_DIVERGENCE;
+    return 0;
+}
+
+void shadow_step(shadow_t *s, const thermal_state_t *active, double active_dc, double dt_sec) {
+    s->state.ambient_mc = active->ambient_mc;
+    s->state.ambient_valid = active->ambient_valid;
+    s->dc = s->cfg.fan_enabled
+        ? thermal_control_step(&s->cfg, &s->state, active->cpu_mc_raw,
+                               active->ssd_temps_raw, active->ssd_count_raw)
+        : 0.0;
+    s->delta = s->dc - active_dc;
+    s->ticks++;
+
+    double abs_delta = fabs(s->delta);
+    s->seconds += dt_sec;
+    s->abs_delta_sum += abs_delta * dt_sec;
+    s->delta_sum += s->delta * dt_sec;
+    if (abs_delta > s->max_abs_delta) s->max_abs_delta = abs_delta;
+    if (abs_delta > s->divergence) s->divergent_sec += dt_sec;
+    s->active_wh += SHADOW_FAN_WATTS * active_dc * active_dc * active_dc * dt_sec / 3600.0;
+    s->shadow_wh += SHADOW_FAN_WATTS * s->dc * s->dc * s->dc * dt_sec / 3600.0;
+}
+
+double shadow_mean_abs_delta(const shadow_t *s) {
+    return s->seconds > 0.0 ? s->abs_delta_sum / s->seconds : 0.0;
+}
@@ -0,0 +1,481 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// radxa-penta-sim: run the real controller against a lumped thermal model
+// of the Penta SATA HAT on a virtual clock, so days of operation replay in
+// seconds and controller or tuning changes can be compared by the numbers.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "config.h"
+#include "profile.h"
+#include "thermal.h"
+#include "timebase.h"
+#include "logger.h"
+
+#define SIM_STEP_SEC 0.1            // Euler step (and control period resolution)
+#define SIM_STEPS_PER_SEC 10
+#define SIM_WARMUP_SEC (4 * 3600)   // Idle, fan off, before the run starts
+#define SIM_SETTLED_SEC 300         // Tail of a segment averaged as the settled value
+#define SIM_SEGMENT_MAX_SEC (6 * 3600)
+#define SIM_CPU_BAND_C 0.5          // Settling bands
+#define SIM_SSD_BAND_C 1.0
+#define SIM_CPU_QUANT_MC 50         // Thermal zone resolution, milli-°C
+#define SIM_FAN_STALL_DC 0.10       // Below this duty the fan does not spin
+#define SIM_START_WALL 1735689600   // 2025-01-01 00:00:00 UTC
+
+// Lumped-capacitance model: CPU die+heatsink and drive cage as two nodes,
+// each losing heat to ambient through a still-air and a fan-driven
+// conductance, with a small CPU -> cage coupling through the board.
+typedef struct {
+    double amb;         // Ambient (°C)
+    double cpu_c;       // CPU heat capacity (J/K)
+    double cpu_g;       // CPU still-air conductance (W/K)
+    double cpu_gfan;    // Extra CPU conductance at full airflow (W/K)
+    double cage_c;      // Drive cage heat capacity (J/K)
+    double cage_g;
+    double cage_gfan;
+    double couple;      // CPU <-> cage conductance (W/K)
+    double fan_tau;     // Fan spin-up/down time constant (s)
+    double fan_w;       // Fan electrical power at 100% (W); scales with duty^3
+    double noise;       // CPU sensor noise, 1 sigma (°C)
+} sim_model_t;
+
+static const struct {
+    const char *name;
+    size_t offset;
+} model_keys[] = {
+    { "amb", offsetof(sim_model_t, amb) },
+    { "cpu_c", offsetof(sim_model_t, cpu_c) },
+    { "cpu_g", offsetof(sim_model_t, cpu_g) },
+    { "cpu_gfan", offsetof(sim_model_t, cpu_gfan) },
+    { "cage_c", offsetof(sim_model_t, cage_c) },
+    { "cage_g", offsetof(sim_model_t, cage_g) },
+    { "cage_gfan", offsetof(sim_model_t, cage_gfan) },
+    { "couple", offsetof(sim_model_t, couple) },
+    { "fan_tau", offsetof(sim_model_t, fan_tau) },
+    { "fan_w", offsetof(sim_model_t, fan_w) },
+    { "noise", offsetof(sim_model_t, noise) },
+};
+
+// Per-drive offset from the cage node (the middle bays run warmer)
+static const double drive_offset_c[SSD_DEVICE_COUNT] = { 0.0, 2.0, 1.5, -1.0 };
+
+typedef enum {
+    PROFILE_IDLE,
+    PROFILE_SCRUB,
+    PROFILE_COMPILE,
+    PROFILE_STEP,
+    PROFILE_COUNT
+} sim_profile_t;
+
+static const char *profile_names[PROFILE_COUNT] = { "idle", "scrub", "compile", "step" };
+
+typedef struct {
+    double cpu;
+    double cage;
+    double fan;         // Effective airflow 0..1
+} sim_plant_t;
+
+// Samples of one constant-load segment
+typedef struct {
+    long start;
+    double p_cpu;
+    double p_ssd;
+    double cpu[SIM_SEGMENT_MAX_SEC];
+    double ssd[SIM_SEGMENT_MAX_SEC];
+    long n;
+} sim_segment_t;
+
+typedef struct {
+    long segments;
+    long unsettled;
+    double cpu_overshoot_max;
+    double ssd_overshoot_max;
+    double cpu_settle_sum;
+    double ssd_settle_sum;
+    long cpu_settle_max;
+    long ssd_settle_max;
+} sim_segment_stats_t;
+
+static uint64_t rng_state;
+
+static double rng_uniform(void) {
+    // xorshift64*: deterministic for a given seed on every platform
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (double)((rng_state * 2685821657736338717ull) >> 11) / 9007199254740992.0;
+}
+
+static double rng_gauss(void) {
+    // Irwin-Hall approximation is plenty for sensor noise
+    double s = 0.0;
+    for (int i = 0; i < 12; i++) s += rng_uniform();
+    return s - 6.0;
+}
+
+static void model_defaults(sim_model_t *m) {
+    m->amb = 25.0;
+    m->cpu_c = 15.0;
+    m->cpu_g = 0.15;
+    m->cpu_gfan = 0.5;
+    m->cage_c = 200.0;
+    m->cage_g = 0.25;
+    m->cage_gfan = 0.8;
+    m->couple = 0.05;
+    m->fan_tau = 2.0;
+    m->fan_w = 1.2;
+    m->noise = 0.1;
+}
+
+static int model_set(sim_model_t *m, const char *arg) {
+    const char *eq = strchr(arg, '=');
+    if (!eq) return -1;
+    size_t klen = (size_t)(eq - arg);
+    for (size_t i = 0; i < sizeof(model_keys) / sizeof(model_keys[0]); i++) {
+        if (strlen(model_keys[i].name) == klen && strncmp(arg, model_keys[i].name, klen) == 0) {
+            char *end;
+            double v = strtod(eq + 1, &end);
+            if (end == eq + 1 || *end != '\0') return -1;
+            memcpy((char *)m + model_keys[i].offset, &v, sizeof(v));
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Heat input (W) at time t seconds into the run
+static void profile_load(sim_profile_t p, long t, double *p_cpu, double *p_ssd) {
+    long in_hour = t % 3600;
+    long in_day = t % 86400;
+    *p_cpu = 3.0;
+    *p_ssd = 4.0;
+    switch (p) {
+        case PROFILE_SCRUB:
+            // Nightly 6 h scrub from 01:00: all drives busy, CPU checksumming
+            if (in_day >= 3600 && in_day < 7 * 3600) {
+                *p_cpu = 4.5;
+                *p_ssd = 14.0;
+            }
+            break;
+        case PROFILE_COMPILE:
+            // 20 min build every hour
+            if (in_hour < 1200) {
+                *p_cpu = 9.0;
+                *p_ssd = 5.0;
+            }
+            break;
+        case PROFILE_STEP:
+            // 30 min on, 30 min off
+            if (in_hour >= 1800) {
+                *p_cpu = 8.0;
+                *p_ssd = 10.0;
+            }
+            break;
+        case PROFILE_IDLE:
+        case PROFILE_COUNT:
+            break;
+    }
+}
+
+static void plant_step(const sim_model_t *m, sim_plant_t *s, double duty, double p_cpu, double p_ssd, double dt) {
+    double fan_target = duty >= SIM_FAN_STALL_DC ? duty : 0.0;
+    s->fan += (fan_target - s->fan) * dt / (m->fan_tau > dt ? m->fan_tau : dt);
+
+    double q_couple = m->couple * (s->cpu - s->cage);
+    double q_cpu = (m->cpu_g + m->cpu_gfan * s->fan) * (s->cpu - m->amb) + q_couple;
+    double q_cage = (m->cage_g + m->cage_gfan * s->fan) * (s->cage - m->amb) - q_couple;
+    s->cpu += (p_cpu - q_cpu) * dt / m->cpu_c;
+    s->cage += (p_ssd - q_cage) * dt / m->cage_c;
+}
+
+static double drives_max(const sim_plant_t *s) {
+    double max = s->cage + drive_offset_c[0];
+    for (int i = 1; i < SSD_DEVICE_COUNT; i++) {
+        if (s->cage + drive_offset_c[i] > max) max = s->cage + drive_offset_c[i];
+    }
+    return max;
+}
+
+// Peak above the settled value (tail mean) and time until the signal last
+// left the band around it. Returns 0 when the tail is still drifting.
+static int series_analyze(const double *x, long n, double band, double *overshoot, long *settle) {
+    double settled = 0.0;
+    for (long i = n - SIM_SETTLED_SEC; i < n; i++) settled += x[i];
+    settled /= SIM_SETTLED_SEC;
+
+    double peak = x[0];
+    long last_out = -1;
+    for (long i = 0; i < n; i++) {
+        if (x[i] > peak) peak = x[i];
+        if (fabs(x[i] - settled) > band) last_out = i;
+    }
+    *overshoot = peak > settled ? peak - settled : 0.0;
+    *settle = last_out + 1;
+    return last_out < n - SIM_SETTLED_SEC;
+}
+
+static void segment_close(const sim_segment_t *seg, sim_segment_stats_t *st, int verbose) {
+    if (seg->n < 2 * SIM_SETTLED_SEC) return;
+
+    double cpu_os, ssd_os;
+    long cpu_settle, ssd_settle;
+    int cpu_ok = series_analyze(seg->cpu, seg->n, SIM_CPU_BAND_C, &cpu_os, &cpu_settle);
+    int ssd_ok = series_analyze(seg->ssd, seg->n, SIM_SSD_BAND_C, &ssd_os, &ssd_settle);
+
+    st->segments++;
+    if (!cpu_ok || !ssd_ok) st->unsettled++;
+    if (cpu_os > st->cpu_overshoot_max) st->cpu_overshoot_max = cpu_os;
+    if (ssd_os > st->ssd_overshoot_max) st->ssd_overshoot_max = ssd_os;
+    st->cpu_settle_sum += (double)cpu_settle;
+    st->ssd_settle_sum += (double)ssd_settle;
+    if (cpu_settle > st->cpu_settle_max) st->cpu_settle_max = cpu_settle;
+    if (ssd_settle > st->ssd_settle_max) st->ssd_settle_max = ssd_settle;
+
+    if (verbose) {
+        printf("  segment t=%6lds load=%4.1f/%4.1fW len=%5lds | CPU overshoot %.2f°C settle %lds%s | SSD overshoot %.2f°C settle %lds%s\n",
+               seg->start, seg->p_cpu, seg->p_ssd, seg->n,
+               cpu_os, cpu_settle, cpu_ok ? "" : " (drifting)",
+               ssd_os, ssd_settle, ssd_ok ? "" : " (drifting)");
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-c config] [-f fan-profile] [-p idle|scrub|compile|step] [-d days]\n"
+            "          [-s seed] [-m key=value]... [-t trace.csv] [-v]\n"
+            "  -c  controller configuration (default %s)\n"
+            "  -f  fixed fan profile (default: follow the [schedule], else default)\n"
+            "  -p  load profile (default step)\n"
+            "  -d  simulated days (default 1; fractions allowed)\n"
+            "  -s  sensor noise seed (default 1)\n"
+            "  -m  model parameter: amb cpu_c cpu_g cpu_gfan cage_c cage_g cage_gfan\n"
+            "      couple fan_tau fan_w noise\n"
+            "  -t  write a per-tick CSV trace\n"
+            "  -v  print every load segment\n",
+            prog, CONFIG_FILE);
+}
+
+int main(int argc, char *argv[]) {
+    const char *config_path = CONFIG_FILE;
+    const char *trace_path = NULL;
+    const char *fan_profile = NULL;
+    sim_profile_t profile = PROFILE_STEP;
+    double days = 1.0;
+    unsigned long seed = 1;
+    int verbose = 0;
+    sim_model_t model;
+    model_defaults(&model);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:f:p:d:s:m:t:vh")) != -1) {
+        switch (opt) {
+            case 'c': config_path = optarg; break;
+            case 'f': fan_profile = optarg; break;
+            case 't': trace_path = optarg; break;
+            case 'v': verbose = 1; break;
+            case 'd': days = strtod(optarg, NULL); break;
+            case 's': seed = strtoul(optarg, NULL, 10); break;
+            case 'p': {
+                int found = 0;
+                for (int i = 0; i < PROFILE_COUNT; i++) {
+                    if (strcmp(optarg, profile_names[i]) == 0) {
+                        profile = (sim_profile_t)i;
+                        found = 1;
+                    }
+                }
+                if (!found) {
+                    fprintf(stderr, "Error: Unknown profile '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            }
+            case 'm':
+                if (model_set(&model, optarg) < 0) {
+                    fprintf(stderr, "Error: Bad model parameter '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (days <= 0.0 || days > 365.0) {
+        fprintf(stderr, "Error: Days must be in (0, 365]\n");
+        return 2;
+    }
+
+    config_t cfg;
+    config_load_file(&cfg, config_path);
+    if (fan_profile) {
+        int idx = config_find_profile(&cfg, fan_profile);
+        if (idx < 0) {
+            fprintf(stderr, "Error: Unknown fan profile '%s'\n", fan_profile);
+            return 2;
+        }
+        cfg.active = &cfg.profiles[idx];
+    }
+    // Keep the controller's own [Fan] lines out of the report
+    logger_init("warning", 0, NULL);
+    timebase_virtual_enable(SIM_START_WALL);
+    rng_state = seed * 0x9E3779B97F4A7C15ull + 1ull;
+
+    FILE *trace = NULL;
+    if (trace_path) {
+        trace = fopen(trace_path, "w");
+        if (!trace) {
+            perror(trace_path);
+            return 1;
+        }
+        fprintf(trace, "t_sec,p_cpu_w,p_ssd_w,cpu_c,ssd_max_c,cpu_meas_c,ssd_avg_c,duty,airflow,period_sec\n");
+    }
+
+    static sim_segment_t seg;
+    sim_segment_stats_t seg_stats;
+    memset(&seg_stats, 0, sizeof(seg_stats));
+
+    thermal_state_t state;
+    thermal_state_init(&state);
+    // With an [ambient] source the sensor reads the modelled room
+    if (cfg.ambient_source[0]) {
+        state.ambient_mc = (int32_t)lround(model.amb * 1000.0);
+        state.ambient_valid = 1;
+    }
+    fan_config_t cpu_curve, ssd_curve;
+    thermal_curves(&cfg, cfg.active, &state, &cpu_curve, &ssd_curve);
+
+    // Start from the idle, fan-off equilibrium rather than from ambient
+    sim_plant_t plant = { model.amb, model.amb, 0.0 };
+    for (long i = 0; i < SIM_WARMUP_SEC * SIM_STEPS_PER_SEC; i++) {
+        plant_step(&model, &plant, 0.0, 3.0, 4.0, SIM_STEP_SEC);
+    }
+
+    long total_sec = (long)(days * 86400.0);
+    long ticks = 0;
+    double duty = 0.0;
+    double last_delta = 0.0;
+    long reversals = 0, changes = 0;
+    double fan_wh = 0.0, duty_sum = 0.0;
+    double cpu_max = plant.cpu, ssd_max = drives_max(&plant);
+    long cpu_hot_sec = 0, ssd_hot_sec = 0;
+    int ssd_meas[MAX_DEVICES] = {0};
+    long ssd_read_at = -SSD_TEMP_CACHE_SEC;
+    double cpu_meas = 0.0;
+    seg.start = -1;
+
+    clock_t cpu_start = clock();
+
+    // Time advances in SIM_STEP_SEC plant steps; the controller runs at
+    // whatever period thermal_next_period() asks for, and statistics are
+    // sampled once per simulated second.
+    long step = 0;
+    long total_steps = total_sec * SIM_STEPS_PER_SEC;
+    while (step < total_steps) {
+        long now_sec = step / SIM_STEPS_PER_SEC;
+
+        // Sensors as the daemon sees them: quantized, noisy CPU every tick,
+        // whole-degree drive temps refreshed at the smartctl cache interval
+        cpu_meas = plant.cpu + model.noise * rng_gauss();
+        int32_t cpu_mc = (int32_t)lround(cpu_meas * 1000.0 / SIM_CPU_QUANT_MC) * SIM_CPU_QUANT_MC;
+        cpu_meas = (double)cpu_mc / 1000.0;
+        if (now_sec - ssd_read_at >= SSD_TEMP_CACHE_SEC) {
+            ssd_read_at = now_sec;
+            for (int i = 0; i < SSD_DEVICE_COUNT; i++) {
+                ssd_meas[i] = (int)lround(plant.cage + drive_offset_c[i]);
+            }
+        }
+
+        if (!fan_profile) {
+            profile_tick(&cfg, timebase_wall_sec());
+        }
+        // The CPU reading as thermal_sample_view() leaves it for the period
+        state.cpu_temp_raw = cpu_meas;
+        double dc = thermal_control_step(&cfg, &state, cpu_mc, ssd_meas, SSD_DEVICE_COUNT);
+        thermal_curves(&cfg, cfg.active, &state, &cpu_curve, &ssd_curve);
+        ticks++;
+        double delta = dc - duty;
+        if (delta != 0.0) {
+            changes++;
+            if (last_delta != 0.0 && (delta > 0.0) != (last_delta > 0.0)) reversals++;
+            last_delta = delta;
+        }
+        duty = dc;
+
+        long period_steps = lround(thermal_next_period(&cfg, &state) * SIM_STEPS_PER_SEC);
+        if (period_steps < 1) period_steps = 1;
+
+        for (long k = 0; k < period_steps && step < total_steps; k++) {
+            long t = step / SIM_STEPS_PER_SEC;
+            double p_cpu, p_ssd;
+            profile_load(profile, t, &p_cpu, &p_ssd);
+            plant_step(&model, &plant, duty, p_cpu, p_ssd, SIM_STEP_SEC);
+            timebase_virtual_advance(SIM_STEP_SEC);
+            step++;
+            if (step % SIM_STEPS_PER_SEC != 0) continue;
+
+            if (seg.start < 0 || p_cpu != seg.p_cpu || p_ssd != seg.p_ssd || seg.n >= SIM_SEGMENT_MAX_SEC) {
+                if (seg.start >= 0) segment_close(&seg, &seg_stats, verbose);
+                seg.start = t;
+                seg.p_cpu = p_cpu;
+                seg.p_ssd = p_ssd;
+                seg.n = 0;
+            }
+
+            double ssd_true = drives_max(&plant);
+            double fan_power = duty >= SIM_FAN_STALL_DC ? model.fan_w * duty * duty * duty : 0.0;
+            fan_wh += fan_power / 3600.0;
+            duty_sum += duty;
+            if (plant.cpu > cpu_max) cpu_max = plant.cpu;
+            if (ssd_true > ssd_max) ssd_max = ssd_true;
+            if (plant.cpu >= cpu_curve.lv3) cpu_hot_sec++;
+            if (ssd_true >= ssd_curve.lv3) ssd_hot_sec++;
+            seg.cpu[seg.n] = plant.cpu;
+            seg.ssd[seg.n] = ssd_true;
+            seg.n++;
+
+            if (trace) {
+                fprintf(trace, "%ld,%.1f,%.1f,%.3f,%.3f,%.2f,%d,%.3f,%.3f,%.1f\n",
+                        t, p_cpu, p_ssd, plant.cpu, ssd_true, cpu_meas, state.ssd_avg, duty, plant.fan,
+                        state.period_sec);
+            }
+        }
+    }
+    segment_close(&seg, &seg_stats, verbose);
+
+    double run_sec = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+    if (trace) fclose(trace);
+
+    printf("Profile %s, %.2f days in %.2fs CPU, seed %lu, config %s (fan profile %s)\n",
+           profile_names[profile], days, run_sec, seed, config_path, cfg.active->name);
+    printf("Model: amb=%.1f cpu_c=%.1f cpu_g=%.3f cpu_gfan=%.3f cage_c=%.1f cage_g=%.3f cage_gfan=%.3f couple=%.3f fan_tau=%.1f fan_w=%.2f noise=%.2f\n",
+           model.amb, model.cpu_c, model.cpu_g, model.cpu_gfan, model.cage_c, model.cage_g,
+           model.cage_gfan, model.couple, model.fan_tau, model.fan_w, model.noise);
+    printf("Control ticks:    %ld (%.0f/h, mean period %.2fs)\n",
+           ticks, (double)ticks / ((double)total_sec / 3600.0), (double)total_sec / (double)ticks);
+    printf("Fan energy:       %.3f Wh (mean duty %.1f%%)\n", fan_wh, duty_sum / (double)total_sec * 100.0);
+    printf("Duty changes:     %ld (%ld direction reversals, %.1f/h)\n",
+           changes, reversals, (double)reversals / ((double)total_sec / 3600.0));
+    printf("Peak temps:       CPU %.1f°C, SSD %.1f°C\n", cpu_max, ssd_max);
+    printf("Time at/over lv3: CPU %lds (%.0f°C), SSD %lds (%.0f°C)\n",
+           cpu_hot_sec, cpu_curve.lv3, ssd_hot_sec, ssd_curve.lv3);
+    if (seg_stats.segments > 0) {
+        printf("Load segments:    %ld (%ld still drifting at the end)\n", seg_stats.segments, seg_stats.unsettled);
+        printf("Overshoot (max):  CPU %.2f°C, SSD %.2f°C\n", seg_stats.cpu_overshoot_max, seg_stats.ssd_overshoot_max);
+        printf("Settling:         CPU mean %.0fs max %lds (±%.1f°C), SSD mean %.0fs max %lds (±%.1f°C)\n",
+               seg_stats.cpu_settle_sum / (double)seg_stats.segments, seg_stats.cpu_settle_max, SIM_CPU_BAND_C,
+               seg_stats.ssd_settle_sum / (double)seg_stats.segments, seg_stats.ssd_settle_max, SIM_SSD_BAND_C);
+    }
+
+    logger_close();
+    return 0;
+}
@@ -0,0 +1,391 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <string.h>
+#include <limits.h>
+#include "smart.h"
+
+#define RAW_VALUE_COL 9         // ID# ATTRIBUTE_NAME FLAG VALUE WORST THRESH TYPE UPDATED WHEN_FAILED RAW_VALUE
+#define NORM_VALUE_COL 3
+#define TEMP_MAX 200
+
+enum {
+    KEY_OTHER,
+    KEY_TEMPERATURE,
+    KEY_CURRENT,
+    KEY_ATA_ATTRIBUTES,
+    KEY_TABLE,
+    KEY_ID,
+    KEY_VALUE,
+    KEY_RAW,
+    KEY_NVME_LOG,
+    KEY_PERCENTAGE_USED,
+    KEY_MEDIA_ERRORS
+};
+
+static const struct {
+    const char *name;
+    int id;
+} json_keys[] = {
+    {"temperature", KEY_TEMPERATURE},
+    {"current", KEY_CURRENT},
+    {"ata_smart_attributes", KEY_ATA_ATTRIBUTES},
+    {"table", KEY_TABLE},
+    {"id", KEY_ID},
+    {"value", KEY_VALUE},
+    {"raw", KEY_RAW},
+    {"nvme_smart_health_information_log", KEY_NVME_LOG},
+    {"percentage_used", KEY_PERCENTAGE_USED},
+    {"media_errors", KEY_MEDIA_ERRORS},
+};
+
+static long accumulate(long v, char c) {
+    int d = c - '0';
+    if (v > (LONG_MAX - d) / 10) return LONG_MAX;
+    return v * 10 + d;
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int tok_is(const smart_parser_t *p, const char *s) {
+    size_t n = strlen(s);
+    return p->tok_len == n && memcmp(p->tok, s, n) == 0;
+}
+
+static int key_is(const smart_parser_t *p, const char *s) {
+    size_t n = strlen(s);
+    return p->key_len == n && memcmp(p->key, s, n) == 0;
+}
+
+static void set_temp(smart_parser_t *p, long v) {
+    if ((p->found & SMART_TEMP) || v <= 0 || v >= TEMP_MAX) return;
+    p->temp = (int)v;
+    p->found |= SMART_TEMP;
+}
+
+// One ATA attribute; JSON raw values of 190/194 pack min/max into the
+// upper bytes, so temperature.current is used there instead
+static void apply_attribute(smart_parser_t *p, long id, long norm, long raw, int json) {
+    switch (id) {
+        case 190:
+        case 194:
+            if (!json) set_temp(p, raw);
+            break;
+        case 5:
+            if (raw < 0) break;
+            p->reallocated = raw;
+            p->found |= SMART_REALLOCATED;
+            break;
+        case 197:
+            if (raw < 0) break;
+            p->pending = raw;
+            p->found |= SMART_PENDING;
+            break;
+        case 177:
+        case 231:
+        case 233:
+            if (norm < 0 || norm > INT_MAX) break;
+            p->wear = (int)norm;
+            p->found |= SMART_WEAR;
+            break;
+        default:
+            break;
+    }
+}
+
+static void set_used(smart_parser_t *p, long v) {
+    p->percent_used = v > INT_MAX ? INT_MAX : (int)v;
+    p->found |= SMART_USED;
+}
+
+static void set_media_errors(smart_parser_t *p, long v) {
+    p->media_errors = v;
+    p->found |= SMART_MEDIA_ERRORS;
+}
+
+static void token_start(smart_parser_t *p) {
+    p->in_token = 1;
+    p->tok_len = 0;
+    p->lead = 0;
+    p->lead_digits = 0;
+    p->lead_open = 1;
+    p->all_digits = 1;
+}
+
+static void token_char(smart_parser_t *p, char c) {
+    if (p->tok_len < SMART_KEY_LEN) p->tok[p->tok_len] = c;
+    p->tok_len++;
+    if (p->lead_open && is_digit(c)) {
+        p->lead = accumulate(p->lead, c);
+        p->lead_digits++;
+    } else {
+        p->lead_open = 0;
+        p->all_digits = 0;
+    }
+}
+
+// --- Text report ---
+
+static void text_line_reset(smart_parser_t *p) {
+    p->in_token = 0;
+    p->col = 0;
+    p->header = 0;
+    p->row = 0;
+    p->id = -1;
+    p->norm = -1;
+    p->raw = -1;
+    p->key_len = 0;
+    p->colon = 0;
+    p->kv = 0;
+    p->kv_state = 0;
+}
+
+static void text_token_end(smart_parser_t *p) {
+    if (!p->in_token) return;
+    p->in_token = 0;
+
+    if (p->col == 0) {
+        if (p->all_digits) {
+            p->row = 1;
+            p->id = p->lead;
+        } else if (tok_is(p, "ID#")) {
+            p->header = 1;
+        }
+    }
+    if (p->header && tok_is(p, "RAW_VALUE")) p->raw_col = p->col;
+    if (p->row) {
+        if (p->col == NORM_VALUE_COL && p->all_digits) p->norm = p->lead;
+        if (p->col == p->raw_col && p->lead_digits) p->raw = p->lead;
+    }
+    p->col++;
+}
+
+static void text_line_end(smart_parser_t *p) {
+    text_token_end(p);
+    if (p->row) {
+        apply_attribute(p, p->id, p->norm, p->raw, 0);
+    } else if (p->colon && (p->kv_state == 1 || p->kv_state == 2)) {
+        if (key_is(p, "Temperature") || key_is(p, "Composite Temperature") ||
+            key_is(p, "Current Drive Temperature")) {
+            set_temp(p, p->kv);
+        } else if (key_is(p, "Percentage Used")) {
+            set_used(p, p->kv);
+        } else if (key_is(p, "Media and Data Integrity Errors")) {
+            set_media_errors(p, p->kv);
+        }
+    }
+    text_line_reset(p);
+}
+
+// "Data Units Read:  1,234 [...]" style: first number, separators skipped
+static void text_value_char(smart_parser_t *p, char c) {
+    if (p->kv_state >= 2) return;
+    if (is_digit(c)) {
+        p->kv = accumulate(p->kv, c);
+        p->kv_state = 1;
+    } else if (c == ',' || (p->kv_state == 0 && (c == ' ' || c == '\t'))) {
+        return;
+    } else {
+        p->kv_state = p->kv_state ? 2 : 3;
+    }
+}
+
+static void text_char(smart_parser_t *p, char c) {
+    if (c == '\n') {
+        text_line_end(p);
+        return;
+    }
+    if (p->colon) {
+        text_value_char(p, c);
+        return;
+    }
+    if (is_space(c)) {
+        text_token_end(p);
+        return;
+    }
+    if (c == ':' && !p->row) {
+        text_token_end(p);
+        p->colon = 1;
+        return;
+    }
+    if (!p->in_token) {
+        token_start(p);
+        if (!p->row && p->key_len && p->key_len < SMART_KEY_LEN) p->key[p->key_len++] = ' ';
+    }
+    token_char(p, c);
+    if (!p->row && p->key_len < SMART_KEY_LEN) p->key[p->key_len++] = c;
+}
+
+// --- JSON ---
+
+static int json_key_id(const smart_parser_t *p) {
+    if (p->tok_len >= SMART_KEY_LEN) return KEY_OTHER;
+    for (size_t i = 0; i < sizeof(json_keys) / sizeof(json_keys[0]); i++) {
+        if (tok_is(p, json_keys[i].name)) return json_keys[i].id;
+    }
+    return KEY_OTHER;
+}
+
+static int json_level_key(const smart_parser_t *p, unsigned int depth) {
+    if (depth < 1 || depth > SMART_JSON_DEPTH) return KEY_OTHER;
+    return p->key_id[depth];
+}
+
+// Inside an ata_smart_attributes.table[] entry (depth of the entry object)
+static int json_in_table_item(const smart_parser_t *p, unsigned int depth) {
+    return depth == 4 && json_level_key(p, 3) == KEY_TABLE && p->is_array[3] &&
+           json_level_key(p, 2) == KEY_ATA_ATTRIBUTES;
+}
+
+static void json_number(smart_parser_t *p, long v) {
+    unsigned int d = p->depth;
+    int parent = json_level_key(p, d);
+
+    if (d == 2 && parent == KEY_TEMPERATURE && p->cur_key == KEY_CURRENT) {
+        set_temp(p, v);
+    } else if (d == 2 && parent == KEY_NVME_LOG) {
+        if (p->cur_key == KEY_TEMPERATURE) set_temp(p, v);
+        else if (p->cur_key == KEY_PERCENTAGE_USED) set_used(p, v);
+        else if (p->cur_key == KEY_MEDIA_ERRORS) set_media_errors(p, v);
+    } else if (json_in_table_item(p, d)) {
+        if (p->cur_key == KEY_ID) p->item_id = v;
+        else if (p->cur_key == KEY_VALUE) p->item_value = v;
+    } else if (json_in_table_item(p, d - 1) && parent == KEY_RAW && p->cur_key == KEY_VALUE) {
+        p->item_raw = v;
+    }
+}
+
+static void json_number_end(smart_parser_t *p) {
+    p->in_number = 0;
+    if (p->lead_digits && !p->negative) json_number(p, p->lead);
+    p->cur_key = KEY_OTHER;
+}
+
+static void json_open(smart_parser_t *p, int array) {
+    p->depth++;
+    if (p->depth <= SMART_JSON_DEPTH) {
+        p->key_id[p->depth] = p->cur_key;
+        p->is_array[p->depth] = array;
+    }
+    p->cur_key = KEY_OTHER;
+    p->expect_key = !array;
+    if (!array && json_in_table_item(p, p->depth)) {
+        p->item_id = -1;
+        p->item_value = -1;
+        p->item_raw = -1;
+    }
+}
+
+static void json_close(smart_parser_t *p) {
+    if (p->depth == 0) return;
+    if (json_in_table_item(p, p->depth)) apply_attribute(p, p->item_id, p->item_value, p->item_raw, 1);
+    p->depth--;
+    p->cur_key = KEY_OTHER;
+    p->expect_key = 0;
+}
+
+static void json_char(smart_parser_t *p, char c) {
+    if (p->in_string) {
+        if (p->escape) {
+            p->escape = 0;
+        } else if (c == '\\') {
+            p->escape = 1;
+            return;
+        } else if (c == '"') {
+            p->in_string = 0;
+            if (p->expect_key) {
+                p->cur_key = json_key_id(p);
+                p->expect_key = 0;
+            } else {
+                p->cur_key = KEY_OTHER;
+            }
+            return;
+        }
+        token_char(p, c);
+        return;
+    }
+
+    if (p->in_number) {
+        if (is_digit(c)) {
+            if (!p->number_frac) token_char(p, c);
+            return;
+        }
+        if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+            p->number_frac = 1;
+            return;
+        }
+        json_number_end(p);
+    }
+
+    switch (c) {
+        case '"':
+            p->in_string = 1;
+            token_start(p);
+            break;
+        case '{':
+            json_open(p, 0);
+            break;
+        case '[':
+            json_open(p, 1);
+            break;
+        case '}':
+        case ']':
+            json_close(p);
+            break;
+        case ',': {
+            unsigned int d = p->depth;
+            p->expect_key = d >= 1 && d <= SMART_JSON_DEPTH ? !p->is_array[d] : 1;
+            p->cur_key = KEY_OTHER;
+            break;
+        }
+        default:
+            if (is_digit(c) || c == '-') {
+                p->in_number = 1;
+                p->number_frac = 0;
+                p->negative = c == '-';
+                token_start(p);
+                if (!p->negative) token_char(p, c);
+            }
+            break;
+    }
+}
+
+void smart_parser_init(smart_parser_t *p, unsigned int want) {
+    memset(p, 0, sizeof(*p));
+    p->want = want;
+    p->temp = 0;
+    p->reallocated = -1;
+    p->pending = -1;
+    p->wear = -1;
+    p->percent_used = -1;
+    p->media_errors = -1;
+    p->mode = SMART_MODE_UNKNOWN;
+    p->raw_col = RAW_VALUE_COL;
+    text_line_reset(p);
+}
+
+int smart_parser_feed(smart_parser_t *p, const char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = buf[i];
+        if (p->mode == SMART_MODE_UNKNOWN) {
+            if (is_space(c)) continue;
+            p->mode = c == '{' ? SMART_MODE_JSON : SMART_MODE_TEXT;
+        }
+        if (p->mode == SMART_MODE_JSON) json_char(p, c);
+        else text_char(p, c);
+        if ((p->found & p->want) == p->want) return 1;
+    }
+    return 0;
+}
+
+void smart_parser_finish(smart_parser_t *p) {
+    if (p->mode == SMART_MODE_TEXT) text_line_end(p);
+}
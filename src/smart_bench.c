@@ -0,0 +1,171 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// smartctl parse benchmark: feeds captured `smartctl -A` outputs (text or
+// --json) through the streaming parser in pipe-sized chunks, the way the
+// daemon reads them, and reports throughput for a temperature-only pass
+// and a full health pass along with what was parsed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "smart.h"
+#include "thermal.h"
+#include "timebase.h"
+
+#define BENCH_DEFAULT_ROUNDS 100000
+#define BENCH_MAX_FILES 32
+#define BENCH_MAX_OUTPUT (256 * 1024)
+#define BENCH_PATH_LEN 512
+#ifndef RADXA_PENTA_SMART_CORPUS
+#define RADXA_PENTA_SMART_CORPUS "tests/smart-corpus"
+#endif
+
+typedef struct {
+    const char *path;
+    char *owned;        // path, when load_corpus() built it
+    char *data;
+    size_t len;
+} capture_t;
+
+static int load_capture(capture_t *c, const char *path);
+
+// Every file of the corpus directory, in name order; returns the count
+static int load_corpus(capture_t *caps, int max, const char *dir) {
+    struct dirent **names;
+    int n = scandir(dir, &names, NULL, alphasort);
+    if (n < 0) {
+        fprintf(stderr, "Warning: Cannot read corpus %s\n", dir);
+        return 0;
+    }
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        char path[BENCH_PATH_LEN];
+        int len = snprintf(path, sizeof(path), "%s/%s", dir, names[i]->d_name);
+        if (names[i]->d_name[0] != '.' && count < max && len > 0 && (size_t)len < sizeof(path)) {
+            char *owned = strdup(path);
+            if (owned && load_capture(&caps[count], owned) == 0) caps[count++].owned = owned;
+            else free(owned);
+        }
+        free(names[i]);
+    }
+    free(names);
+    return count;
+}
+
+static int load_capture(capture_t *c, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    c->path = path;
+    c->data = malloc(BENCH_MAX_OUTPUT);
+    if (!c->data) {
+        fclose(fp);
+        return -1;
+    }
+    c->len = fread(c->data, 1, BENCH_MAX_OUTPUT, fp);
+    fclose(fp);
+    return 0;
+}
+
+// One parse as thermal_read_ssd() does it; returns bytes consumed
+static size_t parse_capture(const capture_t *c, unsigned int want, smart_parser_t *p) {
+    size_t off = 0;
+    int done = 0;
+    smart_parser_init(p, want);
+    while (!done && off < c->len) {
+        size_t n = c->len - off < SMARTCTL_READ_CHUNK ? c->len - off : SMARTCTL_READ_CHUNK;
+        done = smart_parser_feed(p, c->data + off, n);
+        off += n;
+    }
+    if (!done) smart_parser_finish(p);
+    return off;
+}
+
+static void print_fields(const capture_t *c, const smart_parser_t *p) {
+    printf("%s: %s, temp=%d reallocated=%ld pending=%ld wear=%d used=%d media_errors=%ld\n", c->path,
+           p->mode == SMART_MODE_JSON ? "json" : "text", (p->found & SMART_TEMP) ? p->temp : -1,
+           p->reallocated, p->pending, p->wear, p->percent_used, p->media_errors);
+}
+
+static void bench(const char *name, const capture_t *caps, int count, unsigned int want, long rounds) {
+    smart_parser_t p;
+    size_t bytes = 0;
+    uint64_t t0 = timebase_raw_ns();
+    for (long r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            bytes += parse_capture(&caps[i], want, &p);
+        }
+    }
+    double ns = (double)(timebase_raw_ns() - t0);
+    double parses = (double)rounds * (double)count;
+    printf("%-8s %12.1f %12.1f %12.1f\n", name, ns / parses, (double)bytes / parses,
+           (double)bytes / ns * 1e3);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-n rounds] [file...]\n"
+            "  -n  parses of every file per pass (default %d)\n"
+            "  file  captured `smartctl -A /dev/sdX` or `smartctl -A -j /dev/sdX` output\n"
+            "        (default: every capture in %s)\n",
+            prog, BENCH_DEFAULT_ROUNDS, RADXA_PENTA_SMART_CORPUS);
+}
+
+int main(int argc, char *argv[]) {
+    static capture_t caps[BENCH_MAX_FILES];
+    int count = 0;
+    long rounds = BENCH_DEFAULT_ROUNDS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n': rounds = strtol(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (rounds <= 0) {
+        fprintf(stderr, "Error: Rounds must be positive\n");
+        return 2;
+    }
+    for (int i = optind; i < argc; i++) {
+        if (count == BENCH_MAX_FILES) {
+            fprintf(stderr, "Warning: Only the first %d files are used\n", BENCH_MAX_FILES);
+            break;
+        }
+        if (load_capture(&caps[count], argv[i]) != 0) {
+            fprintf(stderr, "Warning: Cannot read %s\n", argv[i]);
+            continue;
+        }
+        count++;
+    }
+    if (optind == argc) {
+        count = load_corpus(caps, BENCH_MAX_FILES, RADXA_PENTA_SMART_CORPUS);
+    }
+    if (count == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        smart_parser_t p;
+        parse_capture(&caps[i], SMART_TEMP | SMART_HEALTH, &p);
+        print_fields(&caps[i], &p);
+    }
+
+    printf("%d files, %ld rounds per pass\n", count, rounds);
+    printf("%-8s %12s %12s %12s\n", "pass", "ns/parse", "bytes/parse", "MB/s");
+    bench("temp", caps, count, SMART_TEMP, rounds);
+    bench("health", caps, count, SMART_TEMP | SMART_HEALTH, rounds);
+
+    for (int i = 0; i < count; i++) {
+        free(caps[i].data);
+        free(caps[i].owned);
+    }
+    return 0;
+}
@@ -0,0 +1,386 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// Accelerated soak test: the daemon's own tick (loop_tick(): sensor pass,
+// controller step, PWM write, shadow controller, status segment, metrics,
+// history, MQTT, usage checkpoints, flight recorder, ambient) on a virtual
+// clock against the mock backends of tests/mock_backend.c, as fast as the
+// machine allows. Every one of those surfaces is switched on, with its
+// sockets and files in the scratch directory and MQTT talking to the mock
+// broker; after each tick the loop's sockets are polled once, as the
+// daemon's wait does, and every SOAK_CLIENT_TICKS ticks a client asks the
+// control socket for "status" and the exporter for /metrics. Pages are
+// rendered on the scroll interval. At every checkpoint it counts open fds,
+// child processes and anonymous RSS, which must stay at their post-warm-up
+// values, and the allocations made per tick. smartctl is this binary under
+// another name, so the popen()/pclose() path runs for real. Results are
+// CSV on stdout; exit status 1 on a leak or an unanswered request.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "config.h"
+#include "fan.h"
+#include "logger.h"
+#include "loop.h"
+#include "oled_render.h"
+#include "thermal.h"
+#include "timebase.h"
+#include "mock_backend.h"
+
+#define SOAK_DEFAULT_TICKS 1000000
+#define SOAK_DEFAULT_CHECKPOINT 10000
+#define SOAK_DEFAULT_WARMUP 2000
+#define SOAK_DEFAULT_RSS_SLACK_KB 64
+#define SOAK_START_WALL 1735689600    // 2025-01-01 00:00:00 UTC
+#define SOAK_HEALTH_INTERVAL_SEC 60   // Health passes every minute instead of hourly
+#define SOAK_CLIENT_TICKS 100        // Ticks between control socket and /metrics requests
+#define SOAK_CLIENT_POLLS 64         // Loop polls a request may take to be answered
+#define SOAK_REPLY_LEN 65536
+
+// --- Allocation counter ---
+// malloc and friends are interposed in this binary and forward to glibc,
+// so allocations made inside libc (popen, stdio buffers) count too
+
+#ifdef __GLIBC__
+#define SOAK_COUNT_ALLOCS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static unsigned long alloc_calls;
+static unsigned long free_calls;
+
+void *malloc(size_t size) {
+    __atomic_fetch_add(&alloc_calls, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    __atomic_fetch_add(&alloc_calls, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (!ptr) __atomic_fetch_add(&alloc_calls, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    if (ptr) __atomic_fetch_add(&free_calls, 1, __ATOMIC_RELAXED);
+    __libc_free(ptr);
+}
+#else
+#define SOAK_COUNT_ALLOCS 0
+static unsigned long alloc_calls;
+static unsigned long free_calls;
+#endif
+
+typedef struct {
+    int fds;
+    int children;
+    long rss_anon_kb;
+    unsigned long allocs;
+    unsigned long frees;
+} soak_usage_t;
+
+// Wall-clock rate; timebase_raw_ns() follows the virtual clock here
+static uint64_t real_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int count_fds(void) {
+    DIR *d = opendir("/proc/self/fd");
+    if (!d) return -1;
+    int count = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] != '.') count++;
+    }
+    closedir(d);
+    return count - 1;   // The directory's own fd
+}
+
+// Processes whose parent is this one, zombies included
+static int count_children(void) {
+    DIR *d = opendir("/proc");
+    if (!d) return -1;
+    int self = (int)getpid();
+    int count = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] < '1' || e->d_name[0] > '9') continue;
+        char path[sizeof(e->d_name) + 16], buf[512];
+        snprintf(path, sizeof(path), "/proc/%s/stat", e->d_name);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        ssize_t n = read(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        if (n <= 0) continue;
+        buf[n] = '\0';
+        // pid (comm) state ppid ...; comm may hold spaces and parentheses
+        const char *p = strrchr(buf, ')');
+        int ppid;
+        char state;
+        if (p && sscanf(p + 1, " %c %d", &state, &ppid) == 2 && ppid == self) count++;
+    }
+    closedir(d);
+    return count;
+}
+
+static long rss_anon_kb(void) {
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (!fp) return -1;
+    char line[128];
+    long kb = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "RssAnon: %ld", &kb) == 1) break;
+    }
+    fclose(fp);
+    return kb;
+}
+
+// Allocation counters are read first so that the probes' own opendir and
+// fopen buffers fall outside the measured window
+static void usage_sample(soak_usage_t *u) {
+    u->allocs = __atomic_load_n(&alloc_calls, __ATOMIC_RELAXED);
+    u->frees = __atomic_load_n(&free_calls, __ATOMIC_RELAXED);
+    u->fds = count_fds();
+    u->children = count_children();
+    u->rss_anon_kb = rss_anon_kb();
+}
+
+// One request over one of the loop's unix sockets, served by polling the
+// loop as the daemon's wait does. The reply is complete at EOF or, with
+// end set, once it ends in end. Returns 0 once answered.
+static int soak_request(loop_t *l, const char *path, const char *request, const char *end) {
+    static char reply[SOAK_REPLY_LEN];
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    size_t len = strlen(request);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || send(fd, request, len, MSG_NOSIGNAL) != (ssize_t)len) {
+        close(fd);
+        return -1;
+    }
+    size_t got = 0;
+    size_t end_len = end ? strlen(end) : 0;
+    int done = 0;
+    for (int i = 0; i < SOAK_CLIENT_POLLS && !done; i++) {
+        loop_poll(l, 0);
+        for (;;) {
+            ssize_t n = recv(fd, reply + got, sizeof(reply) - 1 - got, 0);
+            if (n <= 0) {
+                done = n == 0;
+                break;
+            }
+            got += (size_t)n;
+            if (got == sizeof(reply) - 1) got = 0;  // Only the tail matters
+        }
+        if (end && got >= end_len && memcmp(reply + got - end_len, end, end_len) == 0) done = 1;
+    }
+    close(fd);
+    return done ? 0 : -1;
+}
+
+// One daemon tick, then what the daemon's wait would have served, and
+// every scroll interval the next page
+static int soak_tick(loop_t *l, mock_broker_t *broker, oled_t *oled, const char *metrics_path, long tick, double step) {
+    timebase_virtual_advance(step);
+    loop_tick(l);
+    loop_poll(l, 0);
+    mock_broker_service(broker);
+
+    int failed = 0;
+    if (tick % SOAK_CLIENT_TICKS == 0) {
+        if (soak_request(l, l->cfg->ctl_socket, "status\n", "OK\n") < 0) failed++;
+        if (soak_request(l, metrics_path, "GET /metrics HTTP/1.0\r\n\r\n", NULL) < 0) failed++;
+    }
+
+    long ticks_per_page = (long)(OLED_SCROLL_INTERVAL_SEC / step);
+    if (ticks_per_page < 1) ticks_per_page = 1;
+    if (tick % ticks_per_page == 0) {
+        oled_frame_t frame;
+        oled_render_page(oled, (oled_page_t)(tick / ticks_per_page % PAGE_COUNT), &frame);
+    }
+    return failed;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-c config] [-n ticks] [-t seconds] [-i ticks] [-w ticks] [-m kB]\n"
+            "  -c  config whose profile and [controller] are used (default %s)\n"
+            "  -n  ticks to run (default %d)\n"
+            "  -t  virtual seconds per tick (default %.1f)\n"
+            "  -i  ticks between checkpoints (default %d)\n"
+            "  -w  warm-up ticks before the baseline is taken (default %d)\n"
+            "  -m  anonymous RSS growth tolerated, kB (default %d)\n",
+            prog, CONFIG_FILE, SOAK_DEFAULT_TICKS, THERMAL_REFERENCE_PERIOD_SEC, SOAK_DEFAULT_CHECKPOINT,
+            SOAK_DEFAULT_WARMUP, SOAK_DEFAULT_RSS_SLACK_KB);
+}
+
+int main(int argc, char *argv[]) {
+    if (mock_is_smartctl(argv[0])) return mock_smartctl_main(argc, argv);
+
+    const char *config_path = CONFIG_FILE;
+    long ticks = SOAK_DEFAULT_TICKS;
+    long checkpoint = SOAK_DEFAULT_CHECKPOINT;
+    long warmup = SOAK_DEFAULT_WARMUP;
+    long rss_slack_kb = SOAK_DEFAULT_RSS_SLACK_KB;
+    double step = THERMAL_REFERENCE_PERIOD_SEC;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:t:i:w:m:h")) != -1) {
+        switch (opt) {
+            case 'c': config_path = optarg; break;
+            case 'n': ticks = strtol(optarg, NULL, 10); break;
+            case 't': step = atof(optarg); break;
+            case 'i': checkpoint = strtol(optarg, NULL, 10); break;
+            case 'w': warmup = strtol(optarg, NULL, 10); break;
+            case 'm': rss_slack_kb = strtol(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (ticks <= 0 || checkpoint <= 0 || warmup < 0 || rss_slack_kb < 0 || !(step > 0.0)) {
+        fprintf(stderr, "Error: Ticks, checkpoint interval and tick length must be positive\n");
+        return 2;
+    }
+    logger_init("warning", 0, NULL);
+
+    // Setup chatter (config, history and loop start-up messages) goes to
+    // stderr so that stdout is only the CSV
+    static config_t cfg;
+    static loop_t loop;
+    mock_backend_t mock;
+    mock_broker_t broker;
+    char status_name[64];
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    if (saved_stdout >= 0) dup2(STDERR_FILENO, STDOUT_FILENO);
+    config_load_file(&cfg, config_path);
+    timebase_virtual_enable(SOAK_START_WALL);
+    int mock_ok = mock_open(&mock, "soak", 0) == 0 && mock_install_smartctl(&mock) == 0 &&
+                  mock_broker_open(&broker) == 0 ? 0 : -1;
+    if (mock_ok == 0) {
+        // Every surface a tick feeds, in the scratch directory
+        mock_configure(&mock, &cfg);
+        fan_set_pwm_root(mock.pwm_root);
+        cfg.smart_health_interval_sec = SOAK_HEALTH_INTERVAL_SEC;
+        cfg.metrics_enabled = 1;
+        cfg.ctl_enabled = 1;
+        cfg.status_shm_enabled = 1;
+        if (cfg.flightrec_records <= 0) cfg.flightrec_records = FLIGHTREC_DEFAULT_RECORDS;
+        cfg.history_enabled = 1;
+        if (cfg.history_size_mb <= 0) cfg.history_size_mb = 1;
+        cfg.usage_enabled = 1;
+        cfg.mqtt_enabled = 1;
+        snprintf(cfg.mqtt_broker, sizeof(cfg.mqtt_broker), "127.0.0.1:%d", broker.port);
+        snprintf(cfg.shadow_config, sizeof(cfg.shadow_config), "%s", mock.shadow_config);
+        snprintf(status_name, sizeof(status_name), "/radxa-penta-soak.%d.status", (int)getpid());
+        mock_ok = loop_open(&loop, &cfg, status_name);
+    }
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+    if (mock_ok < 0) {
+        mock_close(&mock);
+        return 1;
+    }
+
+    const char *metrics_path = cfg.metrics_listen + strlen("unix:");
+    oled_t oled;
+    memset(&oled, 0, sizeof(oled));
+    oled.disks = ~0u;
+    oled.history = loop.use_history ? &loop.history : NULL;
+    oled.sysinfo = &loop.sysinfo;
+
+    printf("# config=%s profile=%s controller=%s tick=%.3fs alloc_counting=%s\n", config_path, cfg.active->name,
+           loop.units[0].controller.builtin ? "builtin" : "plugin", step, SOAK_COUNT_ALLOCS ? "yes" : "no");
+    printf("tick,virtual_sec,fds,children,rss_anon_kb,allocs_per_tick,live_allocs,ticks_per_sec,failed_requests\n");
+    fflush(stdout);
+
+    soak_usage_t base_usage, prev, cur;
+    int have_base = 0;
+    int failed = 0;
+    usage_sample(&prev);
+    uint64_t prev_ns = real_ns();
+    uint64_t start_ns = prev_ns;
+    long done = 0;
+    long failed_requests = 0;
+
+    while (done < ticks && !failed) {
+        long until = done + checkpoint < ticks ? done + checkpoint : ticks;
+        for (long tick = done; tick < until; tick++) {
+            failed_requests += soak_tick(&loop, &broker, &oled, metrics_path, tick, step);
+        }
+        uint64_t now_ns = real_ns();
+        usage_sample(&cur);
+        long span = until - done;
+        done = until;
+
+        double per_tick = (double)(cur.allocs - prev.allocs) / (double)span;
+        long live = (long)(cur.allocs - cur.frees);
+        printf("%ld,%.0f,%d,%d,%ld,%.2f,%ld,%.0f,%ld\n", done, (double)done * step, cur.fds, cur.children,
+               cur.rss_anon_kb, per_tick, live, (double)span * 1e9 / (double)(now_ns - prev_ns), failed_requests);
+        fflush(stdout);
+
+        if (failed_requests > 0) {
+            fprintf(stderr, "Error: %ld control socket or /metrics requests went unanswered by tick %ld\n",
+                    failed_requests, done);
+            failed = 1;
+        }
+
+        if (!have_base && done >= warmup) {
+            base_usage = cur;
+            have_base = 1;
+        } else if (have_base) {
+            if (cur.fds != base_usage.fds) {
+                fprintf(stderr, "Error: Open fds went from %d to %d by tick %ld\n", base_usage.fds, cur.fds, done);
+                failed = 1;
+            }
+            if (cur.children != base_usage.children) {
+                fprintf(stderr, "Error: Child processes went from %d to %d by tick %ld\n", base_usage.children,
+                        cur.children, done);
+                failed = 1;
+            }
+            if (cur.rss_anon_kb > base_usage.rss_anon_kb + rss_slack_kb) {
+                fprintf(stderr, "Error: Anonymous RSS grew from %ld kB to %ld kB by tick %ld\n",
+                        base_usage.rss_anon_kb, cur.rss_anon_kb, done);
+                failed = 1;
+            }
+        }
+        prev = cur;
+        prev_ns = now_ns;
+    }
+
+    double wall = (double)(real_ns() - start_ns) / 1e9;
+    printf("# result=%s ticks=%ld virtual_sec=%.0f wall_sec=%.1f ticks_per_sec=%.0f mqtt_connects=%lu mqtt_publishes=%lu\n",
+           failed ? "FAIL" : (have_base ? "PASS" : "NO_BASELINE"), done, (double)done * step, wall,
+           (double)done / wall, broker.connects, broker.publishes);
+    if (!have_base) fprintf(stderr, "Warning: Run ended within the warm-up; nothing was checked\n");
+
+    loop_close(&loop);
+    fan_set_pwm_root(NULL);
+    mock_broker_close(&broker);
+    mock_close(&mock);
+    return failed ? 1 : 0;
+}
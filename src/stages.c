@@ -0,0 +1,107 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <string.h>
+#include "stages.h"
+#include "logger.h"
+
+static const char *stage_names[STAGE_COUNT] = {
+    "read_cpu", "read_ssd", "compute", "actuate", "oled", "tick"
+};
+
+const char *stages_name(stage_id_t stage) {
+    return (stage >= 0 && stage < STAGE_COUNT) ? stage_names[stage] : "?";
+}
+
+void stages_init(stages_t *st) {
+    memset(st, 0, sizeof(stages_t));
+}
+
+// Values below STAGES_SUB map 1:1; above, the top STAGES_SUB_BITS bits after
+// the leading one select the sub-bucket within the value's power of two.
+static unsigned bucket_index(uint64_t v) {
+    if (v < STAGES_SUB) return (unsigned)v;
+    unsigned e = 63u - (unsigned)__builtin_clzll(v);
+    unsigned idx = (e - STAGES_SUB_BITS + 1u) * STAGES_SUB +
+                   (unsigned)((v >> (e - STAGES_SUB_BITS)) & (STAGES_SUB - 1u));
+    return idx < STAGES_BUCKETS ? idx : STAGES_BUCKETS - 1u;
+}
+
+// Highest value that maps to the bucket (reports never under-state latency)
+static uint64_t bucket_upper(unsigned idx) {
+    if (idx < STAGES_SUB) return idx;
+    unsigned group = idx / STAGES_SUB;
+    unsigned sub = idx % STAGES_SUB;
+    unsigned shift = group - 1u;
+    return (((uint64_t)(STAGES_SUB + sub + 1u)) << shift) - 1u;
+}
+
+void stages_record(stages_t *st, stage_id_t stage, uint64_t ns) {
+    if (!st || stage < 0 || stage >= STAGE_COUNT) return;
+    stage_hist_t *h = &st->hist[stage];
+
+    __atomic_fetch_add(&h->buckets[bucket_index(ns)], 1u, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+    while (ns > max && !__atomic_compare_exchange_n(&h->max_ns, &max, ns, 1,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+uint64_t stages_count(const stages_t *st, stage_id_t stage) {
+    const stage_hist_t *h = &st->hist[stage];
+    uint64_t total = 0;
+    for (unsigned i = 0; i < STAGES_BUCKETS; i++) {
+        total += __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+uint64_t stages_percentile_ns(const stages_t *st, stage_id_t stage, double q) {
+    const stage_hist_t *h = &st->hist[stage];
+
+    // Snapshot first so a concurrent record cannot push the rank past the end
+    uint32_t snap[STAGES_BUCKETS];
+    uint64_t total = 0;
+    for (unsigned i = 0; i < STAGES_BUCKETS; i++) {
+        snap[i] = __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+        total += snap[i];
+    }
+    if (total == 0) return 0;
+
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+    uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < STAGES_BUCKETS; i++) {
+        seen += snap[i];
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            uint64_t max = __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+            return (max != 0 && upper > max) ? max : upper;
+        }
+    }
+    return __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+}
+
+void stages_log(const stages_t *st) {
+    logger_log(LOGGER_INFO, NULL, "[Stages] Latency percentiles since start (µs):");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        stage_id_t id = (stage_id_t)s;
+        double p50 = (double)stages_percentile_ns(st, id, 0.50) / 1e3;
+        double p99 = (double)stages_percentile_ns(st, id, 0.99) / 1e3;
+        logger_fields_t fields;
+        logger_fields_init(&fields);
+        logger_field(&fields, "STAGE", "%s", stages_name(id));
+        logger_field(&fields, "P50_US", "%.1f", p50);
+        logger_field(&fields, "P99_US", "%.1f", p99);
+        logger_log(LOGGER_INFO, &fields, "[Stages] %-9s n=%-8llu p50=%-9.1f p90=%-9.1f p99=%-9.1f p99.9=%-9.1f max=%.1f",
+                   stages_name(id), (unsigned long long)stages_count(st, id), p50,
+                   (double)stages_percentile_ns(st, id, 0.90) / 1e3, p99,
+                   (double)stages_percentile_ns(st, id, 0.999) / 1e3,
+                   (double)__atomic_load_n(&st->hist[id].max_ns, __ATOMIC_RELAXED) / 1e3);
+    }
+}
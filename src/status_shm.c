@@ -0,0 +1,85 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "status_shm.h"
+
+int status_pub_init(status_pub_t *pub, const char *name) {
+    memset(pub, 0, sizeof(status_pub_t));
+    pub->fd = -1;
+    snprintf(pub->name, sizeof(pub->name), "%s", name);
+
+    int fd = shm_open(pub->name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Warning: Cannot create status segment %s: %s\n", pub->name, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)sizeof(status_shm_t)) < 0) {
+        fprintf(stderr, "Warning: Cannot size status segment: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    void *p = mmap(NULL, sizeof(status_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "Warning: Cannot map status segment: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    pub->fd = fd;
+    pub->shm = (status_shm_t *)p;
+
+    // Readers validate magic/version inside a stable seqlock window, so the
+    // header is written like any other update.
+    status_shm_t *s = status_pub_begin(pub);
+    uint32_t seq = s->seq;
+    memset(s, 0, sizeof(*s));
+    s->seq = seq;
+    s->magic = STATUS_SHM_MAGIC;
+    s->version = STATUS_SHM_VERSION;
+    s->size = (uint32_t)sizeof(status_shm_t);
+    s->pid = (int32_t)getpid();
+    status_pub_end(pub);
+
+    printf("Status segment published at /dev/shm%s\n", pub->name);
+    return 0;
+}
+
+status_shm_t *status_pub_begin(status_pub_t *pub) {
+    status_shm_t *s = pub->shm;
+    // Make seq odd before any field changes become visible
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return s;
+}
+
+void status_pub_end(status_pub_t *pub) {
+    status_shm_t *s = pub->shm;
+    // Publish the fields, then make seq even again
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+void status_pub_cleanup(status_pub_t *pub) {
+    if (pub->shm) {
+        status_shm_t *s = status_pub_begin(pub);
+        s->flags |= STATUS_FLAG_STOPPED;
+        status_pub_end(pub);
+        munmap(pub->shm, sizeof(status_shm_t));
+        pub->shm = NULL;
+    }
+    if (pub->fd >= 0) {
+        close(pub->fd);
+        pub->fd = -1;
+        // Readers that still hold a mapping see STATUS_FLAG_STOPPED; new
+        // readers get ENOENT instead of stale data.
+        shm_unlink(pub->name);
+    }
+}
@@ -0,0 +1,340 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include "sysinfo.h"
+#include "timebase.h"
+#include "logger.h"
+
+#define SYSINFO_NL_BUF 8192
+#define SYSINFO_DUMP_TIMEOUT_SEC 1.0
+#define SYSINFO_HOSTNAME_PATH "/proc/sys/kernel/hostname"
+#define SYSINFO_MOUNTINFO_PATH "/proc/self/mountinfo"
+
+typedef struct {
+    sysinfo_addr_t addrs[SYSINFO_MAX_ADDRS];
+    int count;
+} addr_table_t;
+
+static int addr_find(const addr_table_t *t, const sysinfo_addr_t *a) {
+    for (int i = 0; i < t->count; i++) {
+        if (t->addrs[i].ifindex == a->ifindex && t->addrs[i].family == a->family &&
+            strcmp(t->addrs[i].text, a->text) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Apply one RTM_NEWADDR/RTM_DELADDR; loopback and link-local scopes are
+// skipped like `hostname -I` does
+static void addr_apply(addr_table_t *t, struct nlmsghdr *nh) {
+    if (nh->nlmsg_type != RTM_NEWADDR && nh->nlmsg_type != RTM_DELADDR) return;
+    struct ifaddrmsg *ifa = NLMSG_DATA(nh);
+    if ((ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6) || ifa->ifa_scope >= RT_SCOPE_LINK) return;
+
+    if (nh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifaddrmsg))) return;
+
+    const void *local = NULL, *address = NULL;
+    size_t left = nh->nlmsg_len - NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    char *p = (char *)ifa + NLMSG_ALIGN(sizeof(struct ifaddrmsg));
+    while (left >= sizeof(struct rtattr)) {
+        struct rtattr *rta = (struct rtattr *)(void *)p;
+        if (rta->rta_len < sizeof(struct rtattr) || rta->rta_len > left) break;
+        if (rta->rta_type == IFA_LOCAL) local = RTA_DATA(rta);
+        else if (rta->rta_type == IFA_ADDRESS) address = RTA_DATA(rta);
+        size_t step = RTA_ALIGN(rta->rta_len);
+        if (step >= left) break;
+        p += step;
+        left -= step;
+    }
+    // IFA_LOCAL is the own end of a point-to-point IPv4 link
+    const void *raw = local ? local : address;
+    if (!raw) return;
+
+    sysinfo_addr_t a;
+    memset(&a, 0, sizeof(a));
+    a.ifindex = (int)ifa->ifa_index;
+    a.family = ifa->ifa_family;
+    a.prefix = ifa->ifa_prefixlen;
+    if (!inet_ntop(a.family, raw, a.text, sizeof(a.text))) return;
+
+    int i = addr_find(t, &a);
+    if (nh->nlmsg_type == RTM_DELADDR) {
+        if (i >= 0) {
+            memmove(&t->addrs[i], &t->addrs[i + 1], sizeof(sysinfo_addr_t) * (size_t)(t->count - i - 1));
+            t->count--;
+        }
+    } else if (i >= 0) {
+        t->addrs[i] = a;
+    } else if (t->count < SYSINFO_MAX_ADDRS) {
+        t->addrs[t->count++] = a;
+    }
+}
+
+// Returns 1 at the end of the dump this socket asked for
+static int addr_receive(sysinfo_t *si, addr_table_t *t, char *buf, ssize_t n) {
+    int done = 0;
+    size_t left = (size_t)n;
+    char *p = buf;
+    while (left >= sizeof(struct nlmsghdr)) {
+        struct nlmsghdr *nh = (struct nlmsghdr *)(void *)p;
+        if (nh->nlmsg_len < sizeof(struct nlmsghdr) || nh->nlmsg_len > left) break;
+        if (nh->nlmsg_type == NLMSG_DONE || nh->nlmsg_type == NLMSG_ERROR) {
+            if (nh->nlmsg_seq == si->seq) done = 1;
+        } else {
+            addr_apply(t, nh);
+        }
+        size_t step = NLMSG_ALIGN(nh->nlmsg_len);
+        if (step >= left) break;
+        p += step;
+        left -= step;
+    }
+    return done;
+}
+
+// Full address dump into a private table, swapped in at the end so readers
+// never see it half built. Notifications arriving meanwhile land in it too.
+static int sysinfo_dump_addrs(sysinfo_t *si) {
+    struct {
+        struct nlmsghdr nh;
+        struct ifaddrmsg ifa;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    req.nh.nlmsg_type = RTM_GETADDR;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = ++si->seq;
+    req.ifa.ifa_family = AF_UNSPEC;
+    if (send(si->nl_fd, &req, req.nh.nlmsg_len, 0) < 0) return -1;
+
+    static addr_table_t t;
+    static char buf[SYSINFO_NL_BUF] __attribute__((aligned(4)));
+    t.count = 0;
+    double deadline = timebase_mono_sec() + SYSINFO_DUMP_TIMEOUT_SEC;
+    int done = 0;
+    while (!done) {
+        double remaining = deadline - timebase_mono_sec();
+        if (remaining <= 0.0) return -1;
+        struct pollfd pfd = { .fd = si->nl_fd, .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, (int)(remaining * 1000.0) + 1) <= 0) continue;
+        ssize_t n = recv(si->nl_fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -1;
+        }
+        done = addr_receive(si, &t, buf, n);
+    }
+
+    pthread_mutex_lock(&si->lock);
+    memcpy(si->addrs, t.addrs, sizeof(sysinfo_addr_t) * (size_t)t.count);
+    si->addr_count = t.count;
+    pthread_mutex_unlock(&si->lock);
+    return 0;
+}
+
+static void sysinfo_read_hostname(sysinfo_t *si) {
+    struct utsname u;
+    if (uname(&u) < 0) return;
+    pthread_mutex_lock(&si->lock);
+    snprintf(si->hostname, sizeof(si->hostname), "%s", u.nodename);
+    pthread_mutex_unlock(&si->lock);
+}
+
+// mountinfo escapes blanks and backslashes as \ooo
+static void unescape_octal(char *s) {
+    char *out = s;
+    for (char *p = s; *p; p++) {
+        if (p[0] == '\\' && p[1] >= '0' && p[1] <= '7' && p[2] >= '0' && p[2] <= '7' && p[3] >= '0' && p[3] <= '7') {
+            *out++ = (char)(((p[1] - '0') << 6) | ((p[2] - '0') << 3) | (p[3] - '0'));
+            p += 3;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+}
+
+static void sysinfo_read_mounts(sysinfo_t *si) {
+    char mount[SYSINFO_PATH_LEN] = "";
+    FILE *fp = fopen(SYSINFO_MOUNTINFO_PATH, "r");
+    if (!fp) return;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), fp)) {
+        // id parent maj:min root mountpoint opts [optional...] - fstype source superopts
+        char point[SYSINFO_PATH_LEN], source[SYSINFO_PATH_LEN];
+        const char *sep = strstr(line, " - ");
+        if (!sep || sscanf(line, "%*s %*s %*s %*s %127s", point) != 1 ||
+            sscanf(sep + 3, "%*s %127s", source) != 1) {
+            continue;
+        }
+        if (strcmp(source, SYSINFO_RAID_DEVICE) == 0) {
+            unescape_octal(point);
+            snprintf(mount, sizeof(mount), "%s", point);
+            break;
+        }
+    }
+    fclose(fp);
+
+    pthread_mutex_lock(&si->lock);
+    snprintf(si->raid_mount, sizeof(si->raid_mount), "%s", mount);
+    pthread_mutex_unlock(&si->lock);
+}
+
+int sysinfo_init(sysinfo_t *si) {
+    memset(si, 0, sizeof(sysinfo_t));
+    pthread_mutex_init(&si->lock, NULL);
+    si->host_fd = -1;
+    si->mounts_fd = -1;
+
+    si->nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (si->nl_fd >= 0) {
+        struct sockaddr_nl sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.nl_family = AF_NETLINK;
+        sa.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+        if (bind(si->nl_fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 || sysinfo_dump_addrs(si) < 0) {
+            close(si->nl_fd);
+            si->nl_fd = -1;
+        }
+    }
+    if (si->nl_fd < 0) {
+        fprintf(stderr, "Warning: rtnetlink unavailable (%s), addresses are read on demand\n", strerror(errno));
+    }
+
+    // Both files signal POLLPRI|POLLERR on change; their contents are
+    // re-read elsewhere (uname, a fresh mountinfo pass)
+    si->host_fd = open(SYSINFO_HOSTNAME_PATH, O_RDONLY | O_CLOEXEC);
+    si->mounts_fd = open(SYSINFO_MOUNTINFO_PATH, O_RDONLY | O_CLOEXEC);
+    if (si->host_fd < 0 || si->mounts_fd < 0) {
+        fprintf(stderr, "Warning: Hostname or mount change notifications unavailable\n");
+    }
+    sysinfo_read_hostname(si);
+    sysinfo_read_mounts(si);
+    return 0;
+}
+
+void sysinfo_init_static(sysinfo_t *si, const char *hostname, const char *address, const char *raid_mount) {
+    memset(si, 0, sizeof(sysinfo_t));
+    pthread_mutex_init(&si->lock, NULL);
+    si->nl_fd = -1;
+    si->host_fd = -1;
+    si->mounts_fd = -1;
+    si->fixed = 1;
+    si->addr_count = 1;
+    si->addrs[0].ifindex = 1;
+    si->addrs[0].family = strchr(address, ':') ? AF_INET6 : AF_INET;
+    si->addrs[0].prefix = si->addrs[0].family == AF_INET ? 24 : 64;
+    snprintf(si->addrs[0].text, sizeof(si->addrs[0].text), "%s", address);
+    snprintf(si->hostname, sizeof(si->hostname), "%s", hostname);
+    snprintf(si->raid_mount, sizeof(si->raid_mount), "%s", raid_mount);
+}
+
+void sysinfo_cleanup(sysinfo_t *si) {
+    if (si->nl_fd >= 0) close(si->nl_fd);
+    if (si->host_fd >= 0) close(si->host_fd);
+    if (si->mounts_fd >= 0) close(si->mounts_fd);
+    si->nl_fd = si->host_fd = si->mounts_fd = -1;
+    pthread_mutex_destroy(&si->lock);
+}
+
+int sysinfo_pollfds(sysinfo_t *si, struct pollfd *pfds, int max) {
+    int n = 0;
+    int fds[SYSINFO_FDS] = { si->nl_fd, si->host_fd, si->mounts_fd };
+    for (int i = 0; i < SYSINFO_FDS && n < max; i++) {
+        pfds[n].fd = fds[i];
+        pfds[n].events = i == 0 ? POLLIN : POLLPRI;
+        pfds[n].revents = 0;
+        n++;
+    }
+    return n;
+}
+
+static void sysinfo_netlink_ready(sysinfo_t *si) {
+    static char buf[SYSINFO_NL_BUF] __attribute__((aligned(4)));
+    static addr_table_t t;
+
+    for (;;) {
+        ssize_t n = recv(si->nl_fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            // Missed notifications: the table can no longer be trusted
+            if (errno == ENOBUFS) si->resync = 1;
+            break;
+        }
+        pthread_mutex_lock(&si->lock);
+        memcpy(t.addrs, si->addrs, sizeof(si->addrs));
+        t.count = si->addr_count;
+        pthread_mutex_unlock(&si->lock);
+
+        addr_receive(si, &t, buf, n);
+
+        pthread_mutex_lock(&si->lock);
+        memcpy(si->addrs, t.addrs, sizeof(si->addrs));
+        si->addr_count = t.count;
+        pthread_mutex_unlock(&si->lock);
+        si->addr_events++;
+    }
+
+    if (si->resync) {
+        si->resync = 0;
+        logger_log(LOGGER_DEBUG, NULL, "[Sysinfo] Netlink overflow, re-reading addresses");
+        if (sysinfo_dump_addrs(si) < 0) si->resync = 1;
+    }
+}
+
+void sysinfo_dispatch(sysinfo_t *si, const struct pollfd *pfds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!pfds[i].revents || pfds[i].fd < 0) continue;
+        if (pfds[i].fd == si->nl_fd) {
+            sysinfo_netlink_ready(si);
+        } else if (pfds[i].fd == si->host_fd) {
+            si->host_events++;
+            sysinfo_read_hostname(si);
+        } else if (pfds[i].fd == si->mounts_fd) {
+            si->mount_events++;
+            sysinfo_read_mounts(si);
+        }
+    }
+}
+
+int sysinfo_primary_address(sysinfo_t *si, char *buf, size_t len) {
+    int found = -1;
+    pthread_mutex_lock(&si->lock);
+    for (int pass = 0; pass < 2 && found < 0; pass++) {
+        int family = pass == 0 ? AF_INET : AF_INET6;
+        for (int i = 0; i < si->addr_count; i++) {
+            if (si->addrs[i].family == family) {
+                found = i;
+                break;
+            }
+        }
+    }
+    if (found >= 0) snprintf(buf, len, "%s", si->addrs[found].text);
+    pthread_mutex_unlock(&si->lock);
+    return found >= 0 ? 0 : -1;
+}
+
+void sysinfo_hostname(sysinfo_t *si, char *buf, size_t len) {
+    pthread_mutex_lock(&si->lock);
+    snprintf(buf, len, "%s", si->hostname);
+    pthread_mutex_unlock(&si->lock);
+}
+
+int sysinfo_raid_mount(sysinfo_t *si, char *buf, size_t len) {
+    pthread_mutex_lock(&si->lock);
+    snprintf(buf, len, "%s", si->raid_mount);
+    pthread_mutex_unlock(&si->lock);
+    return buf[0] ? 0 : -1;
+}
@@ -8,95 +8,200 @@
 #include <string.h>
 #include <unistd.h>
 #include <math.h>
+#include <pthread.h>
 #include "thermal.h"
+#include "timebase.h"
+#include "budget.h"
+#include "logger.h"
+#include "sensors.h"
+#include "smart.h"
 
 typedef struct {
     int temps[MAX_DEVICES];
     int count;
     time_t last_read;
+    double sampled_at;   // Monotonic time of the last smartctl pass
+    double read_sec;     // How long that pass took
+    int interval_sec;    // Cache lifetime; stretched by the overhead budget
+    ssd_health_t health[SSD_DEVICE_COUNT];
+    double health_at;    // Monotonic time of the last health pass (0 = none)
+    int health_interval_sec;
 } ssd_temp_cache_t;
 
-static ssd_temp_cache_t ssd_cache = {0};
+static ssd_temp_cache_t ssd_cache = { .interval_sec = SSD_TEMP_CACHE_SEC, .health_interval_sec = SSD_HEALTH_INTERVAL_SEC };
+// The display threads copy health while the control loop refreshes it
+static pthread_mutex_t health_lock = PTHREAD_MUTEX_INITIALIZER;
 
-double thermal_read_cpu_temp(void) {
-    FILE *fp = fopen(THERMAL_ZONE_PATH, "r");
+// Batched reader the CPU zone is registered with (NULL = open/read/close)
+static sensors_t *cpu_sensors;
+static int cpu_sensor_id = -1;
+
+// Room/intake sensor refreshed with every sample (NULL = none)
+static ambient_t *ambient_source;
+
+static int smartctl_json;
+
+static const char *ssd_devices[SSD_DEVICE_COUNT] = {"sda", "sdb", "sdc", "sdd"};
+static const char *cpu_zone_path = THERMAL_ZONE_PATH;
+
+const char *thermal_ssd_device_name(size_t index) {
+    return index < SSD_DEVICE_COUNT ? ssd_devices[index] : NULL;
+}
+
+// The zone in milli-°C, as the kernel reports it (0 = no reading)
+static int32_t thermal_read_cpu_mc(void) {
+    FILE *fp = fopen(cpu_zone_path, "r");
     if (!fp) {
-        fprintf(stderr, "Warning: Cannot read CPU temperature\n");
-        return 0.0;
+        logger_log(LOGGER_WARNING, NULL, "Warning: Cannot read CPU temperature");
+        return 0;
     }
 
     int temp_millicelsius;
     if (fscanf(fp, "%d", &temp_millicelsius) != 1) {
         fclose(fp);
-        return 0.0;
+        return 0;
     }
 
     fclose(fp);
-    return (double)temp_millicelsius / 1000.0;
+    return (int32_t)temp_millicelsius;
 }
 
-static int parse_smartctl_temp(const char *line) {
-    if (strstr(line, "Temperature_Celsius") ||
-        strstr(line, "Airflow_Temperature_Cel") ||
-        strstr(line, "Composite Temperature")) {
+double thermal_read_cpu_temp(void) {
+    return (double)thermal_read_cpu_mc() / 1000.0;
+}
 
-        // Temperature is typically the 10th field
-        int temp, dummy;
-        if (sscanf(line, "%d %*s %*s %*s %*s %*s %*s %*s %*s %d", &dummy, &temp) == 2) {
-            if (temp > 0 && temp < 200) return temp;
-        }
+void thermal_set_zone_path(const char *path) {
+    cpu_zone_path = path ? path : THERMAL_ZONE_PATH;
+}
+
+int thermal_use_sensors(sensors_t *sensors) {
+    cpu_sensors = NULL;
+    cpu_sensor_id = -1;
+    if (!sensors) return 0;
+    int id = sensors_add(sensors, cpu_zone_path);
+    if (id < 0) return -1;
+    cpu_sensors = sensors;
+    cpu_sensor_id = id;
+    return 0;
+}
+
+void thermal_use_ambient(ambient_t *ambient) {
+    ambient_source = ambient;
+}
+
+// The tick's batch: every registered file is read here, the CPU zone among them
+static int32_t thermal_read_cpu_mc_batched(void) {
+    sensors_read_all(cpu_sensors);
+    long millicelsius;
+    if (sensors_long(cpu_sensors, cpu_sensor_id, &millicelsius) < 0) {
+        logger_log(LOGGER_WARNING, NULL, "Warning: Cannot read CPU temperature");
+        return 0;
     }
-    return -1;
+    return (int32_t)millicelsius;
 }
 
-int thermal_read_ssd_temps(int *temps, size_t max_count) {
-    const char *devices[] = {"sda", "sdb", "sdc", "sdd"};
-    size_t num_devices = sizeof(devices) / sizeof(devices[0]);
+static void health_reset(ssd_health_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->reallocated = -1;
+    h->pending = -1;
+    h->wear_leveling = -1;
+    h->percent_used = -1;
+    h->media_errors = -1;
+}
+
+// One smartctl run per drive, parsed in a single pass as it is read.
+// Temperature-only passes stop (and close the pipe) once the temperature
+// is seen; with health set the parser runs until every health field is
+// found or the output ends.
+static int thermal_read_ssd(int *temps, size_t max_count, ssd_health_t *health) {
     int found = 0;
 
-    for (size_t i = 0; i < num_devices && i < max_count; i++) {
+    for (size_t i = 0; i < SSD_DEVICE_COUNT && i < max_count; i++) {
         char cmd[256];
-        snprintf(cmd, sizeof(cmd), SMARTCTL_CMD, devices[i]);
+        snprintf(cmd, sizeof(cmd), smartctl_json ? SMARTCTL_JSON_CMD : SMARTCTL_CMD, ssd_devices[i]);
+        temps[i] = 0;
+        if (health) health_reset(&health[i]);
 
+        budget_count_spawn();
         FILE *fp = popen(cmd, "r");
         if (!fp) {
-            temps[i] = 0;
             continue;
         }
 
-        char line[256];
-        int temp_found = 0;
-        while (fgets(line, sizeof(line), fp)) {
-            int temp = parse_smartctl_temp(line);
-            if (temp > 0) {
-                temps[i] = temp;
-                temp_found = 1;
-                found++;
-                break;
-            }
+        smart_parser_t parser;
+        smart_parser_init(&parser, health ? SMART_TEMP | SMART_HEALTH : SMART_TEMP);
+        char buf[SMARTCTL_READ_CHUNK];
+        ssize_t n;
+        int done = 0;
+        while (!done && (n = read(fileno(fp), buf, sizeof(buf))) > 0) {
+            done = smart_parser_feed(&parser, buf, (size_t)n);
         }
+        if (!done) smart_parser_finish(&parser);
+        pclose(fp);
 
-        if (!temp_found) {
-            temps[i] = 0;
+        if (parser.found & SMART_TEMP) {
+            temps[i] = parser.temp;
+            found++;
+        }
+        if (health && (parser.found & SMART_HEALTH)) {
+            health[i].valid = 1;
+            health[i].reallocated = parser.reallocated;
+            health[i].pending = parser.pending;
+            health[i].wear_leveling = parser.wear;
+            health[i].percent_used = parser.percent_used;
+            health[i].media_errors = parser.media_errors;
         }
-
-        pclose(fp);
     }
 
     return found;
 }
 
+int thermal_read_ssd_temps(int *temps, size_t max_count) {
+    return thermal_read_ssd(temps, max_count, NULL);
+}
+
+void thermal_set_ssd_interval(int sec) {
+    ssd_cache.interval_sec = sec > 0 ? sec : SSD_TEMP_CACHE_SEC;
+}
+
+int thermal_ssd_interval(void) {
+    return ssd_cache.interval_sec;
+}
+
+void thermal_set_health_interval(int sec) {
+    ssd_cache.health_interval_sec = sec > 0 ? sec : SSD_HEALTH_INTERVAL_SEC;
+}
+
+void thermal_set_smartctl_json(int json) {
+    smartctl_json = json;
+}
+
 int thermal_read_ssd_temps_cached(int *temps, size_t max_count) {
-    time_t now = time(NULL);
+    time_t now = timebase_wall_sec();
 
     // Return cached values if less than 30 seconds old
-    if (ssd_cache.last_read != 0 && (now - ssd_cache.last_read) < SSD_TEMP_CACHE_SEC) {
+    if (ssd_cache.last_read != 0 && (now - ssd_cache.last_read) < ssd_cache.interval_sec) {
         memcpy(temps, ssd_cache.temps, sizeof(int) * max_count);
         return ssd_cache.count;
     }
 
-    // Actually read temps
-    ssd_cache.count = thermal_read_ssd_temps(ssd_cache.temps, MAX_DEVICES);
+    // Actually read temps; health rides along on the same runs when due
+    double mono = timebase_mono_sec();
+    int health_due = ssd_cache.health_at == 0.0 || mono - ssd_cache.health_at >= ssd_cache.health_interval_sec;
+    ssd_health_t health[SSD_DEVICE_COUNT];
+    uint64_t t0 = timebase_raw_ns();
+    ssd_cache.count = thermal_read_ssd(ssd_cache.temps, MAX_DEVICES, health_due ? health : NULL);
+    ssd_cache.read_sec = (double)(timebase_raw_ns() - t0) / 1e9;
+    ssd_cache.sampled_at = timebase_mono_sec();
+    if (health_due) {
+        for (size_t i = 0; i < SSD_DEVICE_COUNT; i++) {
+            health[i].updated_at = ssd_cache.sampled_at;
+        }
+        pthread_mutex_lock(&health_lock);
+        memcpy(ssd_cache.health, health, sizeof(health));
+        pthread_mutex_unlock(&health_lock);
+        ssd_cache.health_at = ssd_cache.sampled_at;
+    }
     ssd_cache.last_read = now;
     memcpy(temps, ssd_cache.temps, sizeof(int) * max_count);
 
@@ -111,7 +216,7 @@ double thermal_calculate_duty_cycle(config_t *cfg) {
 
     // Read CPU temperature
     double cpu_temp = thermal_read_cpu_temp();
-    double dc_cpu = config_temp_to_dc(&cfg->fan, cpu_temp);
+    double dc_cpu = config_temp_to_dc(&cfg->active->fan, cpu_temp);
 
     // Read SSD temperatures
     int ssd_temps[MAX_DEVICES];
@@ -125,15 +230,15 @@ double thermal_calculate_duty_cycle(config_t *cfg) {
         }
     }
 
-    double dc_ssd = config_temp_to_dc(&cfg->fan_ssd, (double)max_ssd_temp);
+    double dc_ssd = config_temp_to_dc(&cfg->active->fan_ssd, (double)max_ssd_temp);
 
     // Use the higher duty cycle
     double dc = (dc_cpu > dc_ssd) ? dc_cpu : dc_ssd;
 
     static int log_counter = 0;
     if (log_counter++ % 30 == 0) { // Log every 30 seconds
-        printf("[Fan] CPU: %.1f°C → DC %.2f | SSD: %d°C → DC %.2f | Final DC: %.2f\n",
-               cpu_temp, dc_cpu, max_ssd_temp, dc_ssd, dc);
+        logger_log(LOGGER_INFO, NULL, "[Fan] CPU: %.1f°C → DC %.2f | SSD: %d°C → DC %.2f | Final DC: %.2f",
+                   cpu_temp, dc_cpu, max_ssd_temp, dc_ssd, dc);
     }
 
     return dc;
@@ -145,6 +250,9 @@ void thermal_state_init(thermal_state_t *state) {
     state->last_cpu_temp = 0.0;
     state->last_ssd_temp = 0;
     state->hold_until = 0;
+    state->step_sec = THERMAL_REFERENCE_PERIOD_SEC;
+    state->period_sec = THERMAL_REFERENCE_PERIOD_SEC;
+    state->ambient_rate = 1.0;
 }
 
 static double calculate_moving_average(double *history, int count) {
@@ -207,6 +315,21 @@ static double calculate_temp_trend_int(int *history, int count) {
     return recent_avg - older_avg; // Positive = rising, negative = falling
 }
 
+// Factor turning a trend over samples taken at any period into the trend
+// the same signal would show at the reference period (1 at 1 Hz): the
+// trend scales with the mean spacing of the samples in the history.
+static double trend_time_scale(const double *sample_at, int count) {
+    if (count < 3) return 1.0;
+
+    double oldest = sample_at[0], newest = sample_at[0];
+    for (int i = 1; i < count; i++) {
+        if (sample_at[i] < oldest) oldest = sample_at[i];
+        if (sample_at[i] > newest) newest = sample_at[i];
+    }
+    double spacing = (newest - oldest) / (count - 1);
+    return spacing > 0.0 ? THERMAL_REFERENCE_PERIOD_SEC / spacing : 1.0;
+}
+
 // Calculate duty cycle with hysteresis (different thresholds for heating/cooling)
 static double config_temp_to_dc_with_hysteresis(fan_config_t *fan_cfg, double temp, double hysteresis_c, int is_heating) {
     // Use larger hysteresis when cooling down to prevent oscillation
@@ -221,21 +344,160 @@ static double config_temp_to_dc_with_hysteresis(fan_config_t *fan_cfg, double te
     return 0.0;
 }
 
+// Ambient the compensation works from: the reading, or the reference
+// while there is none
+static double thermal_ambient_c(const config_t *cfg, const thermal_state_t *state) {
+    return state->ambient_valid ? (double)state->ambient_mc / 1000.0 : cfg->ambient_reference;
+}
+
+// lv0-lv2 over base, lv3 over the reference and a ceiling for the others
+static void thermal_shift_curve(fan_config_t *c, double base, double reference) {
+    double ceiling = c->lv3 + reference;
+    c->lv0 = c->lv0 + base < ceiling ? c->lv0 + base : ceiling;
+    c->lv1 = c->lv1 + base < ceiling ? c->lv1 + base : ceiling;
+    c->lv2 = c->lv2 + base < ceiling ? c->lv2 + base : ceiling;
+    c->lv3 = ceiling;
+}
+
+void thermal_curves(const config_t *cfg, const fan_profile_t *profile, const thermal_state_t *state,
+                    fan_config_t *cpu, fan_config_t *ssd) {
+    *cpu = profile->fan;
+    *ssd = profile->fan_ssd;
+    if (!cfg->ambient_relative) return;
+    // One-sided: cooler air sheds heat better, so a cool room keeps the
+    // reference thresholds rather than running the fan harder
+    double base = thermal_ambient_c(cfg, state);
+    if (base < cfg->ambient_reference) base = cfg->ambient_reference;
+    thermal_shift_curve(cpu, base, cfg->ambient_reference);
+    thermal_shift_curve(ssd, base, cfg->ambient_reference);
+}
+
+void thermal_curve_critical(const config_t *cfg, const thermal_state_t *state, int *cpu, int *ssd) {
+    fan_config_t cpu_curve, ssd_curve;
+    thermal_curves(cfg, cfg->active, state, &cpu_curve, &ssd_curve);
+    *cpu = state->cpu_avg >= cpu_curve.lv3;
+    *ssd = (double)state->ssd_avg >= ssd_curve.lv3;
+}
+
+double thermal_ambient_rate(const config_t *cfg, const thermal_state_t *state) {
+    if (!state->ambient_valid) return 1.0;
+    double rate = 1.0 + cfg->ambient_rate_gain * (thermal_ambient_c(cfg, state) - cfg->ambient_reference);
+    if (rate < AMBIENT_RATE_MIN) rate = AMBIENT_RATE_MIN;
+    if (rate > AMBIENT_RATE_MAX) rate = AMBIENT_RATE_MAX;
+    return rate;
+}
+
+void thermal_sample(thermal_sample_t *sample) {
+    uint64_t t0 = timebase_raw_ns();
+    sample->cpu_mc = cpu_sensors ? thermal_read_cpu_mc_batched() : thermal_read_cpu_mc();
+    sample->cpu_temp = (double)sample->cpu_mc / 1000.0;
+    sample->cpu_read_sec = (double)(timebase_raw_ns() - t0) / 1e9;
+    sample->cpu_sampled_at = timebase_mono_sec();
+
+    double ssd_prev_sample = ssd_cache.sampled_at;
+    sample->ssd_count = thermal_read_ssd_temps_cached(sample->ssd_temps, MAX_DEVICES);
+    sample->ssd_read_fresh = (ssd_cache.sampled_at != ssd_prev_sample);
+    sample->ssd_sampled_at = ssd_cache.sampled_at;
+    sample->ssd_read_sec = ssd_cache.read_sec;
+
+    sample->ambient_mc = 0;
+    sample->ambient_valid = 0;
+    if (ambient_source) {
+        ambient_update(ambient_source, sample->ssd_temps, sample->cpu_sampled_at);
+        sample->ambient_valid = ambient_current(ambient_source, sample->cpu_sampled_at, &sample->ambient_mc);
+    }
+}
+
+int thermal_ssd_cached(int *temps, size_t max_count) {
+    size_t n = max_count < MAX_DEVICES ? max_count : MAX_DEVICES;
+    memcpy(temps, ssd_cache.temps, sizeof(int) * n);
+    return ssd_cache.count;
+}
+
+int thermal_ssd_health(ssd_health_t *health, size_t max_count) {
+    size_t n = max_count < SSD_DEVICE_COUNT ? max_count : SSD_DEVICE_COUNT;
+    int valid = 0;
+    pthread_mutex_lock(&health_lock);
+    for (size_t i = 0; i < n; i++) {
+        if (ssd_cache.health_at == 0.0) {
+            health_reset(&health[i]);
+        } else {
+            health[i] = ssd_cache.health[i];
+        }
+        if (health[i].valid) valid++;
+    }
+    pthread_mutex_unlock(&health_lock);
+    return valid;
+}
+
+int thermal_sample_view(thermal_state_t *state, const thermal_sample_t *sample, unsigned int disk_mask,
+                        int use_cpu, int32_t *cpu_mc, int *ssd_temps) {
+    state->cpu_read_sec = sample->cpu_read_sec;
+    state->cpu_sampled_at = sample->cpu_sampled_at;
+    state->ssd_read_fresh = sample->ssd_read_fresh;
+    state->ssd_sampled_at = sample->ssd_sampled_at;
+    state->ssd_read_sec = sample->ssd_read_sec;
+    state->ambient_mc = sample->ambient_mc;
+    state->ambient_valid = sample->ambient_valid;
+
+    int ssd_count = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        int mine = (disk_mask & (1u << i)) != 0;
+        ssd_temps[i] = mine ? sample->ssd_temps[i] : 0;
+        if (ssd_temps[i] > 0) ssd_count++;
+    }
+    *cpu_mc = use_cpu ? sample->cpu_mc : 0;
+    state->cpu_mc_raw = *cpu_mc;
+    state->cpu_temp_raw = use_cpu ? sample->cpu_temp : 0.0;
+    return ssd_count;
+}
+
+double thermal_step_sample(config_t *cfg, thermal_state_t *state, const thermal_sample_t *sample,
+                           unsigned int disk_mask, int use_cpu) {
+    int32_t cpu_mc;
+    int ssd_temps[MAX_DEVICES];
+    int ssd_count = thermal_sample_view(state, sample, disk_mask, use_cpu, &cpu_mc, ssd_temps);
+
+    uint64_t compute_start = timebase_raw_ns();
+    double dc = thermal_control_step(cfg, state, cpu_mc, ssd_temps, ssd_count);
+    state->compute_sec = (double)(timebase_raw_ns() - compute_start) / 1e9;
+    return dc;
+}
+
 // Smart thermal control with hysteresis, rate limiting, and trend analysis
 double thermal_calculate_duty_cycle_smart(config_t *cfg, thermal_state_t *state) {
     if (!cfg->fan_enabled) {
         return 0.0;
     }
-    time_t now = time(NULL);
 
-    // Read current temperatures
-    double cpu_temp = thermal_read_cpu_temp();
+    thermal_sample_t sample;
+    thermal_sample(&sample);
+    return thermal_step_sample(cfg, state, &sample, ~0u, 1);
+}
 
-    int ssd_temps[MAX_DEVICES];
-    int ssd_count = thermal_read_ssd_temps_cached(ssd_temps, MAX_DEVICES);
+// Time this step covers. Ramp limits are per reference period and get
+// scaled by it; capped so a stalled tick cannot allow a jump.
+static double thermal_step_interval(const config_t *cfg, thermal_state_t *state, double mono) {
+    double step = state->history_count > 0 ? mono - state->last_step_at : THERMAL_REFERENCE_PERIOD_SEC;
+    double step_max = cfg->active->thermal.period_max_sec > THERMAL_REFERENCE_PERIOD_SEC
+        ? cfg->active->thermal.period_max_sec : THERMAL_REFERENCE_PERIOD_SEC;
+    if (step <= 0.0) step = THERMAL_REFERENCE_PERIOD_SEC;
+    if (step > step_max) step = step_max;
+    state->last_step_at = mono;
+    state->step_sec = step;
+    return step;
+}
+
+// Raw observables, history ring, moving averages and trends: the part of a
+// step every controller shares. Returns the hottest drive.
+static int thermal_filter(thermal_state_t *state, double cpu_temp, const int *ssd_temps, int ssd_count, double mono) {
+    state->cpu_temp_raw = cpu_temp;
+    memcpy(state->ssd_temps_raw, ssd_temps, sizeof(state->ssd_temps_raw));
+    state->ssd_count_raw = ssd_count;
 
+    // Slots are positional (a missing sda must not hide sdb): scan them all
     int max_ssd_temp = 0;
-    for (int i = 0; i < ssd_count && i < MAX_DEVICES; i++) {
+    for (int i = 0; i < MAX_DEVICES; i++) {
         if (ssd_temps[i] > max_ssd_temp) {
             max_ssd_temp = ssd_temps[i];
         }
@@ -244,6 +506,7 @@ double thermal_calculate_duty_cycle_smart(config_t *cfg, thermal_state_t *state)
     // Update temperature history
     state->cpu_temps[state->history_index] = cpu_temp;
     state->ssd_temps[state->history_index] = max_ssd_temp;
+    state->sample_at[state->history_index] = mono;
     state->history_index = (state->history_index + 1) % TEMP_HISTORY_SIZE;
     if (state->history_count < TEMP_HISTORY_SIZE) {
         state->history_count++;
@@ -254,16 +517,156 @@ double thermal_calculate_duty_cycle_smart(config_t *cfg, thermal_state_t *state)
     int ssd_avg = calculate_moving_average_int(state->ssd_temps, state->history_count);
 
     // Calculate temperature trends (positive = heating, negative = cooling)
-    double cpu_trend = calculate_temp_trend(state->cpu_temps, state->history_count);
-    double ssd_trend = calculate_temp_trend_int(state->ssd_temps, state->history_count);
+    // (normalized to the reference period so thresholds hold at any cadence)
+    double trend_scale = trend_time_scale(state->sample_at, state->history_count);
+    state->cpu_avg = cpu_avg;
+    state->ssd_avg = ssd_avg;
+    state->cpu_trend = calculate_temp_trend(state->cpu_temps, state->history_count) * trend_scale;
+    state->ssd_trend = calculate_temp_trend_int(state->ssd_temps, state->history_count) * trend_scale;
+    return max_ssd_temp;
+}
+
+// Duty bookkeeping after a step: stability counters feed the dead-band
+// and the adaptive period
+static void thermal_track_duty(thermal_state_t *state, double dc_new, double step) {
+    if (dc_new == state->last_duty_cycle) {
+        state->stable_cycles++;
+        state->stable_sec += step;
+    } else {
+        state->stable_cycles = 0;
+        state->stable_sec = 0.0;
+    }
+}
+
+void thermal_observe(config_t *cfg, thermal_state_t *state, double cpu_temp, const int *ssd_temps, int ssd_count) {
+    double mono = timebase_mono_sec();
+    thermal_step_interval(cfg, state, mono);
+    thermal_filter(state, cpu_temp, ssd_temps, ssd_count, mono);
+}
+
+void thermal_record_duty(thermal_state_t *state, double dc) {
+    thermal_track_duty(state, dc, state->step_sec);
+    state->dc_target = dc;
+    state->last_duty_cycle = dc;
+    state->last_cpu_temp = state->cpu_avg;
+    state->last_ssd_temp = state->ssd_avg;
+    state->hold_active = 0;
+    state->deadband_active = 0;
+}
+
+// What a step decided, for its verbose and periodic log lines
+typedef struct {
+    double cpu_temp;
+    int max_ssd_temp;
+    int cpu_is_heating;
+    int ssd_is_heating;
+    double dc_cpu_target;
+    double dc_ssd_target;
+    double dc_target;
+    double heat_trend;
+    double up_rate;
+    double down_rate;
+    double ambient_rate;
+    double dc_change;
+    double dc_new;
+    int hold_active;
+    int skip_adjustment;
+    time_t now;
+} thermal_step_log_t;
+
+// Counts the step towards the periodic line; 1 if either line is due, so
+// the caller only builds the values then
+static int thermal_log_due(thermal_state_t *state, int *verbose, int *periodic) {
+    *verbose = !state->quiet && logger_enabled(LOGGER_VERBOSE);
+    // Logging (every 30 seconds or when duty cycle changes); a quiet
+    // instance stays out of the log
+    *periodic = !state->quiet &&
+                ((state->log_counter++ % 30 == 0) || (state->stable_cycles == 0));
+    return *verbose || *periodic;
+}
+
+static void thermal_log_step(const config_t *cfg, const thermal_state_t *state, const thermal_step_log_t *l,
+                             int verbose, int periodic) {
+    double cpu_avg = state->cpu_avg;
+    int ssd_avg = state->ssd_avg;
+    double cpu_trend = state->cpu_trend;
+    double ssd_trend = state->ssd_trend;
+
+    // Optional verbose debug block (only with RADXA_DEBUG=2 / level verbose)
+    if (verbose) {
+        fan_config_t cpu_curve, ssd_curve;
+        thermal_curves(cfg, cfg->active, state, &cpu_curve, &ssd_curve);
+        logger_log(LOGGER_VERBOSE, NULL, "[DEBUG][THERM] raw CPU=%.1fC SSDmax=%dC | avg CPU=%.1fC SSD=%dC | trend CPU=%+.2f SSD=%+.2f",
+                   l->cpu_temp, l->max_ssd_temp, cpu_avg, ssd_avg, cpu_trend, ssd_trend);
+        logger_log(LOGGER_VERBOSE, NULL, "[DEBUG][THERM] heat CPU=%d SSD=%d | thresholds CPU[%.0f/%.0f/%.0f/%.0f] SSD[%.0f/%.0f/%.0f/%.0f] hys=%.1f deadband=%.1f trend_heat=%.2f fast_heat=%.2f up_base=%.0f%% up_gain=%.0f%%/C up_max=%.0f%% down=%.0f%% hold=%ds min_eff=%.0f%%",
+                   l->cpu_is_heating, l->ssd_is_heating,
+                   cpu_curve.lv0, cpu_curve.lv1, cpu_curve.lv2, cpu_curve.lv3,
+                   ssd_curve.lv0, ssd_curve.lv1, ssd_curve.lv2, ssd_curve.lv3,
+                   cfg->active->thermal.hysteresis_c, cfg->active->thermal.deadband_c,
+                   cfg->active->thermal.trend_heat_c, cfg->active->thermal.trend_fast_heat_c,
+                   cfg->active->thermal.up_rate_base_per_cycle * 100.0,
+                   cfg->active->thermal.up_rate_trend_gain * 100.0,
+                   cfg->active->thermal.up_rate_max_per_cycle * 100.0,
+                   cfg->active->thermal.down_rate_per_cycle * 100.0,
+                   (int)cfg->active->thermal.cooldown_hold_sec,
+                   cfg->active->thermal.min_effective_dc * 100.0);
+        logger_log(LOGGER_VERBOSE, NULL, "[DEBUG][THERM] dc_cpu_tgt=%.0f%% dc_ssd_tgt=%.0f%% dc_target=%.0f%% | trend=%.2f up_rate=%.0f%% down_rate=%.0f%% ambient_rate=x%.2f hold=%s -> dc_delta=%+.0f%% dc_new=%.0f%%",
+                   l->dc_cpu_target * 100.0, l->dc_ssd_target * 100.0, l->dc_target * 100.0,
+                   l->heat_trend,
+                   l->up_rate * 100.0, l->down_rate * 100.0, l->ambient_rate,
+                   l->hold_active ? "ON" : "off",
+                   l->dc_change * 100.0, l->dc_new * 100.0);
+    }
+
+    if (periodic) {
+        logger_fields_t fields;
+        logger_fields_init(&fields);
+        logger_field(&fields, "CPU_TEMP", "%.1f", cpu_avg);
+        logger_field(&fields, "CPU_TREND", "%+.2f", cpu_trend);
+        logger_field(&fields, "SSD_TEMP", "%d", ssd_avg);
+        logger_field(&fields, "SSD_TREND", "%+.2f", ssd_trend);
+        logger_field(&fields, "DUTY", "%.0f", l->dc_new * 100.0);
+        logger_field(&fields, "DUTY_TARGET", "%.0f", l->dc_target * 100.0);
+        logger_field(&fields, "HOLD", "%d", l->hold_active);
+        logger_field(&fields, "DEADBAND", "%d", l->skip_adjustment);
+        if (state->label) {
+            logger_field(&fields, "UNIT", "%s", state->label);
+        }
+        logger_log(LOGGER_INFO, &fields,
+                   "[Fan%s%s] CPU: %.1f°C (Δ%+.1f°C) → DC %.0f%% | SSD: %d°C (Δ%+.1f°C) → DC %.0f%% | Active: %.0f%%%s%s%s",
+                   state->label ? " " : "", state->label ? state->label : "", cpu_avg, cpu_trend, l->dc_cpu_target * 100.0,
+                   ssd_avg, ssd_trend, l->dc_ssd_target * 100.0,
+                   l->dc_new * 100.0,
+                   (state->stable_cycles == 0) ? " [ADJUSTING]" : "",
+                   l->skip_adjustment ? " [DEADBAND]" : "",
+                   (state->hold_until != 0 && l->now < state->hold_until) ? " [HOLD]" : "");
+    }
+}
+
+// One controller step on a sensor snapshot (no I/O; time from the timebase)
+double thermal_control_step_double(config_t *cfg, thermal_state_t *state, double cpu_temp,
+                                   const int *ssd_temps, int ssd_count) {
+    time_t now = timebase_wall_sec();
+    double mono = timebase_mono_sec();
+    double step = thermal_step_interval(cfg, state, mono);
+    double rate_scale = step / THERMAL_REFERENCE_PERIOD_SEC;
+
+    int max_ssd_temp = thermal_filter(state, cpu_temp, ssd_temps, ssd_count, mono);
+    double cpu_avg = state->cpu_avg;
+    int ssd_avg = state->ssd_avg;
+    double cpu_trend = state->cpu_trend;
+    double ssd_trend = state->ssd_trend;
 
     // Determine if system is heating or cooling
-    int cpu_is_heating = (cpu_trend > cfg->thermal.trend_heat_c);
-    int ssd_is_heating = (ssd_trend > cfg->thermal.trend_heat_c);
+    int cpu_is_heating = (cpu_trend > cfg->active->thermal.trend_heat_c);
+    int ssd_is_heating = (ssd_trend > cfg->active->thermal.trend_heat_c);
 
-    // Calculate target duty cycles with hysteresis
-    double dc_cpu_target = config_temp_to_dc_with_hysteresis(&cfg->fan, cpu_avg, cfg->thermal.hysteresis_c, cpu_is_heating);
-    double dc_ssd_target = config_temp_to_dc_with_hysteresis(&cfg->fan_ssd, (double)ssd_avg, cfg->thermal.hysteresis_c, ssd_is_heating);
+    // Calculate target duty cycles with hysteresis, on the curves as they
+    // apply at this ambient
+    fan_config_t cpu_curve, ssd_curve;
+    thermal_curves(cfg, cfg->active, state, &cpu_curve, &ssd_curve);
+    double dc_cpu_target = config_temp_to_dc_with_hysteresis(&cpu_curve, cpu_avg, cfg->active->thermal.hysteresis_c, cpu_is_heating);
+    double dc_ssd_target = config_temp_to_dc_with_hysteresis(&ssd_curve, (double)ssd_avg, cfg->active->thermal.hysteresis_c, ssd_is_heating);
 
     // Use the higher duty cycle
     double dc_target = (dc_cpu_target > dc_ssd_target) ? dc_cpu_target : dc_ssd_target;
@@ -276,8 +679,8 @@ double thermal_calculate_duty_cycle_smart(config_t *cfg, thermal_state_t *state)
 
     // Skip adjustment if temperature change is small and we're stable
     int skip_adjustment = 0;
-    if (state->stable_cycles > 5 &&
-        fabs(max_temp_change) < cfg->thermal.deadband_c &&
+    if (state->stable_sec > THERMAL_DEADBAND_STABLE_SEC &&
+        fabs(max_temp_change) < cfg->active->thermal.deadband_c &&
         fabs(dc_target - state->last_duty_cycle) < 0.15) {
         skip_adjustment = 1;
         dc_target = state->last_duty_cycle;  // Keep current duty cycle
@@ -288,19 +691,23 @@ double thermal_calculate_duty_cycle_smart(config_t *cfg, thermal_state_t *state)
     double heat_trend = (cpu_trend > ssd_trend) ? cpu_trend : ssd_trend;
 
     // Upward rate scales with positive trend, capped by up_rate_max
-    double up_rate = cfg->thermal.up_rate_base_per_cycle;
+    double up_rate = cfg->active->thermal.up_rate_base_per_cycle;
     if (heat_trend > 0.0) {
-        up_rate += cfg->thermal.up_rate_trend_gain * heat_trend;
+        up_rate += cfg->active->thermal.up_rate_trend_gain * heat_trend;
     }
     // Respect legacy cap if set smaller, then clamp to new explicit max
-    if (cfg->thermal.max_dc_change_per_cycle > 0.0 && cfg->thermal.max_dc_change_per_cycle < up_rate) {
-        up_rate = cfg->thermal.max_dc_change_per_cycle;
+    if (cfg->active->thermal.max_dc_change_per_cycle > 0.0 && cfg->active->thermal.max_dc_change_per_cycle < up_rate) {
+        up_rate = cfg->active->thermal.max_dc_change_per_cycle;
     }
-    if (up_rate > cfg->thermal.up_rate_max_per_cycle) {
-        up_rate = cfg->thermal.up_rate_max_per_cycle;
+    if (up_rate > cfg->active->thermal.up_rate_max_per_cycle) {
+        up_rate = cfg->active->thermal.up_rate_max_per_cycle;
     }
 
-    double down_rate = cfg->thermal.down_rate_per_cycle;
+    // Gain-scheduled by ambient: faster up and slower down in a hot room
+    double ambient_rate = thermal_ambient_rate(cfg, state);
+    up_rate *= ambient_rate * rate_scale;
+
+    double down_rate = cfg->active->thermal.down_rate_per_cycle / ambient_rate * rate_scale;
     // Cooldown hold: prevent decreases while hold is active
     int hold_active = (state->hold_until != 0 && now < state->hold_until);
 
@@ -321,60 +728,392 @@ double thermal_calculate_duty_cycle_smart(config_t *cfg, thermal_state_t *state)
     if (dc_new > 1.0) dc_new = 1.0;
 
     // Count stable cycles (no change in duty cycle)
-    if (dc_new == state->last_duty_cycle) {
-        state->stable_cycles++;
-    } else {
-        state->stable_cycles = 0;
-    }
+    thermal_track_duty(state, dc_new, step);
 
     // Update state
     // If we increased duty, extend the cooldown hold to keep airflow going
     if (dc_new > state->last_duty_cycle) {
-        state->hold_until = now + (time_t)(cfg->thermal.cooldown_hold_sec);
+        state->hold_until = now + (time_t)(cfg->active->thermal.cooldown_hold_sec);
     }
     state->last_duty_cycle = dc_new;
     state->last_cpu_temp = cpu_avg;
     state->last_ssd_temp = ssd_avg;
+    state->cpu_avg = cpu_avg;
+    state->ssd_avg = ssd_avg;
+    state->cpu_trend = cpu_trend;
+    state->ssd_trend = ssd_trend;
+    state->dc_target = dc_target;
+    state->hold_active = hold_active;
+    state->deadband_active = skip_adjustment;
+    state->ambient_rate = ambient_rate;
+
+    int verbose, periodic;
+    if (thermal_log_due(state, &verbose, &periodic)) {
+        thermal_step_log_t l = {
+            cpu_temp, max_ssd_temp, cpu_is_heating, ssd_is_heating, dc_cpu_target, dc_ssd_target, dc_target,
+            heat_trend, up_rate, down_rate, ambient_rate, dc_change, dc_new, hold_active, skip_adjustment, now
+        };
+        thermal_log_step(cfg, state, &l, verbose, periodic);
+    }
 
-    // Optional verbose debug block (only with RADXA_DEBUG=2)
-    const char *dbg = getenv("RADXA_DEBUG");
-    int debug_verbose = (dbg && strcmp(dbg, "2") == 0);
-    if (debug_verbose) {
-        printf("[DEBUG][THERM] raw CPU=%.1fC SSDmax=%dC | avg CPU=%.1fC SSD=%dC | trend CPU=%+.2f SSD=%+.2f\n",
-               cpu_temp, max_ssd_temp, cpu_avg, ssd_avg, cpu_trend, ssd_trend);
-        printf("[DEBUG][THERM] heat CPU=%d SSD=%d | thresholds CPU[%.0f/%.0f/%.0f/%.0f] SSD[%.0f/%.0f/%.0f/%.0f] hys=%.1f deadband=%.1f trend_heat=%.2f fast_heat=%.2f up_base=%.0f%% up_gain=%.0f%%/C up_max=%.0f%% down=%.0f%% hold=%ds min_eff=%.0f%%\n",
-               cpu_is_heating, ssd_is_heating,
-               cfg->fan.lv0, cfg->fan.lv1, cfg->fan.lv2, cfg->fan.lv3,
-               cfg->fan_ssd.lv0, cfg->fan_ssd.lv1, cfg->fan_ssd.lv2, cfg->fan_ssd.lv3,
-               cfg->thermal.hysteresis_c, cfg->thermal.deadband_c,
-               cfg->thermal.trend_heat_c, cfg->thermal.trend_fast_heat_c,
-               cfg->thermal.up_rate_base_per_cycle * 100.0,
-               cfg->thermal.up_rate_trend_gain * 100.0,
-               cfg->thermal.up_rate_max_per_cycle * 100.0,
-               cfg->thermal.down_rate_per_cycle * 100.0,
-               (int)cfg->thermal.cooldown_hold_sec,
-               cfg->thermal.min_effective_dc * 100.0);
-        printf("[DEBUG][THERM] dc_cpu_tgt=%.0f%% dc_ssd_tgt=%.0f%% dc_target=%.0f%% | trend=%.2f up_rate=%.0f%% down_rate=%.0f%% hold=%s -> dc_delta=%+.0f%% dc_new=%.0f%%\n",
-               dc_cpu_target * 100.0, dc_ssd_target * 100.0, dc_target * 100.0,
-               heat_trend,
-               up_rate * 100.0, down_rate * 100.0,
-               hold_active ? "ON" : "off",
-               dc_change * 100.0, dc_new * 100.0);
-    }
-
-    // Logging (every 30 seconds or when duty cycle changes)
-    static int log_counter = 0;
-    int should_log = (log_counter++ % 30 == 0) || (state->stable_cycles == 0);
+    return dc_new;
+}
+
+// --- Fixed point ---
+// The double law above in integers: temperatures in milli-°C, time in
+// milliseconds, duty and ramp rates in ppb. Averages and trends stay
+// fractions (sum and count, numerator and denominator) and are compared
+// cross-multiplied, so a threshold test only differs from the double law
+// when the exact value sits on the threshold (recorded in fixed.ties).
+// Only the ramp is rounded, to the nearest ppb.
+
+#define FIXED_DUTY_FULL 1000000000      // ppb
+#define FIXED_PPB_PER_PPM 1000
+#define FIXED_DEADBAND_DUTY 150000000   // |target - duty| under which the dead-band may hold
+#define FIXED_DEADBAND_STABLE_MS ((int64_t)(THERMAL_DEADBAND_STABLE_SEC * 1000.0))
+#define FIXED_REFERENCE_MS ((int64_t)(THERMAL_REFERENCE_PERIOD_SEC * 1000.0))
+#define FIXED_RATE_ONE 1000000000   // Ambient ramp rate factor 1.0, in ppb
+#define FIXED_RATE_MIN ((int64_t)(AMBIENT_RATE_MIN * FIXED_RATE_ONE))
+#define FIXED_RATE_MAX ((int64_t)(AMBIENT_RATE_MAX * FIXED_RATE_ONE))
+
+// num / den milli-°C per second (or milli-°C), den > 0
+typedef struct {
+    int64_t num;
+    int64_t den;
+} thermal_ratio_t;
+
+static int64_t fixed_div_round(int64_t num, int64_t den) {
+    return num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+static int32_t fixed_scale(double v, double unit) {
+    return (int32_t)lround(v * unit);
+}
+
+static int ratio_gt(thermal_ratio_t a, thermal_ratio_t b) {
+    return a.num * b.den > b.num * a.den;
+}
 
-    if (should_log) {
-        printf("[Fan] CPU: %.1f°C (Δ%+.1f°C) → DC %.0f%% | SSD: %d°C (Δ%+.1f°C) → DC %.0f%% | Active: %.0f%%%s%s%s\n",
-               cpu_avg, cpu_trend, dc_cpu_target * 100.0,
-               ssd_avg, ssd_trend, dc_ssd_target * 100.0,
-               dc_new * 100.0,
-               (state->stable_cycles == 0) ? " [ADJUSTING]" : "",
-               skip_adjustment ? " [DEADBAND]" : "",
-               (state->hold_until != 0 && now < state->hold_until) ? " [HOLD]" : "");
+static double ratio_value(thermal_ratio_t r, double unit) {
+    return (double)r.num / (double)r.den / unit;
+}
+
+// |a - b| <= within, in unsigned arithmetic (a - b wraps instead of overflowing)
+static int fixed_near(int64_t a, int64_t b, int64_t within) {
+    return (uint64_t)a - (uint64_t)b + (uint64_t)within <= 2 * (uint64_t)within;
+}
+
+// Profile and [ambient] in integer units; converted only when the active
+// profile or the config generation (a load or config_changed()) differs
+static void fixed_tunables(const config_t *cfg, thermal_fixed_t *f) {
+    if (f->tunables_cfg == cfg && f->tunables_profile == cfg->active &&
+        f->tunables_generation == cfg->generation) return;
+    const fan_profile_t *p = cfg->active;
+    const thermal_tunables_t *t = &p->thermal;
+    const double cpu_lv[4] = { p->fan.lv0, p->fan.lv1, p->fan.lv2, p->fan.lv3 };
+    const double ssd_lv[4] = { p->fan_ssd.lv0, p->fan_ssd.lv1, p->fan_ssd.lv2, p->fan_ssd.lv3 };
+    for (int i = 0; i < 4; i++) {
+        f->cpu_lv_mc[i] = fixed_scale(cpu_lv[i], 1e3);
+        f->ssd_lv_mc[i] = fixed_scale(ssd_lv[i], 1e3);
     }
+    f->hysteresis_mc = fixed_scale(t->hysteresis_c, 1e3);
+    f->deadband_mc = fixed_scale(t->deadband_c, 1e3);
+    f->trend_heat_mcps = fixed_scale(t->trend_heat_c, 1e3);
+    f->up_base_ppm = fixed_scale(t->up_rate_base_per_cycle, 1e6);
+    f->up_gain_ppm = fixed_scale(t->up_rate_trend_gain, 1e6);
+    f->up_max_ppm = fixed_scale(t->up_rate_max_per_cycle, 1e6);
+    f->legacy_max_ppm = fixed_scale(t->max_dc_change_per_cycle, 1e6);
+    f->down_ppm = fixed_scale(t->down_rate_per_cycle, 1e6);
+    f->hold_sec = (int32_t)t->cooldown_hold_sec;
+    double step_max = t->period_max_sec > THERMAL_REFERENCE_PERIOD_SEC ? t->period_max_sec : THERMAL_REFERENCE_PERIOD_SEC;
+    f->step_max_ms = (int64_t)llround(step_max * 1e3);
+    f->ambient_relative = cfg->ambient_relative;
+    f->ambient_ref_mc = fixed_scale(cfg->ambient_reference, 1e3);
+    f->ambient_gain_ppb = (int64_t)llround(cfg->ambient_rate_gain * 1e9);
+    f->tunables_cfg = cfg;
+    f->tunables_profile = p;
+    f->tunables_generation = cfg->generation;
+}
 
-    return dc_new;
+// thermal_step_interval() in milliseconds
+static int64_t fixed_step_interval(thermal_state_t *state, int64_t mono_ms) {
+    thermal_fixed_t *f = &state->fixed;
+    int64_t step = state->history_count > 0 ? mono_ms - f->last_step_ms : FIXED_REFERENCE_MS;
+    if (step <= 0) step = FIXED_REFERENCE_MS;
+    if (step > f->step_max_ms) step = f->step_max_ms;
+    f->last_step_ms = mono_ms;
+    f->step_ms = step;
+    return step;
+}
+
+// calculate_temp_trend() times trend_time_scale(): the first half of the
+// ring against the second, per reference period of mean sample spacing
+static thermal_ratio_t fixed_trend(int64_t older_sum_mc, int64_t recent_sum_mc, int count, int64_t span_ms) {
+    thermal_ratio_t r = { 0, 1 };
+    if (count < 3) return r;
+    int64_t half = count / 2;
+    int64_t diff = recent_sum_mc - older_sum_mc;
+    if (span_ms > 0) {
+        r.num = diff * (count - 1) * FIXED_REFERENCE_MS;
+        r.den = half * span_ms;
+    } else {
+        r.num = diff;
+        r.den = half;
+    }
+    return r;
+}
+
+// thermal_curves() on one curve in milli-°C
+static void fixed_levels(const thermal_fixed_t *f, const thermal_state_t *state, const int32_t *lv_mc, int32_t *out) {
+    if (!f->ambient_relative) {
+        memcpy(out, lv_mc, 4 * sizeof(*out));
+        return;
+    }
+    int32_t base = state->ambient_valid && state->ambient_mc > f->ambient_ref_mc ? state->ambient_mc : f->ambient_ref_mc;
+    int32_t ceiling = lv_mc[3] + f->ambient_ref_mc;
+    for (int i = 0; i < 3; i++) {
+        out[i] = lv_mc[i] + base < ceiling ? lv_mc[i] + base : ceiling;
+    }
+    out[3] = ceiling;
+}
+
+// config_temp_to_dc_with_hysteresis() on an average of sum / count
+static int32_t fixed_curve(const int32_t *lv_mc, int64_t sum_mc, int64_t count,
+                           int32_t hysteresis_mc, int is_heating, unsigned int *ties) {
+    static const int32_t duty[4] = { FIXED_DUTY_FULL / 4, FIXED_DUTY_FULL / 2, FIXED_DUTY_FULL / 4 * 3, FIXED_DUTY_FULL };
+    int64_t shift = is_heating ? 0 : hysteresis_mc;
+    for (int i = 3; i >= 0; i--) {
+        int64_t level = (lv_mc[i] - shift) * count;
+        if (sum_mc == level) *ties |= THERMAL_TIE_CURVE;
+        if (sum_mc >= level) return duty[i];
+    }
+    return 0;
+}
+
+// thermal_ambient_rate() in ppb
+static int64_t fixed_ambient_rate(const thermal_fixed_t *f, const thermal_state_t *state) {
+    if (!state->ambient_valid) return FIXED_RATE_ONE;
+    int64_t rate = FIXED_RATE_ONE +
+                   fixed_div_round(f->ambient_gain_ppb * (state->ambient_mc - f->ambient_ref_mc), 1000);
+    if (rate < FIXED_RATE_MIN) rate = FIXED_RATE_MIN;
+    if (rate > FIXED_RATE_MAX) rate = FIXED_RATE_MAX;
+    return rate;
+}
+
+double thermal_control_step_fixed(config_t *cfg, thermal_state_t *state, int32_t cpu_mc,
+                                  const int *ssd_temps, int ssd_count) {
+    thermal_fixed_t *f = &state->fixed;
+    fixed_tunables(cfg, f);
+    time_t now = timebase_wall_sec();
+    int64_t mono_ms = timebase_mono_ms();
+    int64_t step = fixed_step_interval(state, mono_ms);
+
+    // Filter: raw observables and the history rings (the SSD ring is the
+    // double law's, already integer)
+    state->cpu_mc_raw = cpu_mc;
+    memcpy(state->ssd_temps_raw, ssd_temps, sizeof(state->ssd_temps_raw));
+    state->ssd_count_raw = ssd_count;
+    int max_ssd_temp = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (ssd_temps[i] > max_ssd_temp) {
+            max_ssd_temp = ssd_temps[i];
+        }
+    }
+    f->cpu_mc[state->history_index] = cpu_mc;
+    state->ssd_temps[state->history_index] = max_ssd_temp;
+    f->sample_ms[state->history_index] = mono_ms;
+    state->history_index = (state->history_index + 1) % TEMP_HISTORY_SIZE;
+    if (state->history_count < TEMP_HISTORY_SIZE) {
+        state->history_count++;
+    }
+    int count = state->history_count;
+
+    int64_t cpu_sum = 0, ssd_sum = 0;
+    int64_t cpu_older = 0, cpu_recent = 0, ssd_older = 0, ssd_recent = 0;
+    int64_t oldest = f->sample_ms[0], newest = f->sample_ms[0];
+    int half = count / 2;
+    for (int i = 0; i < count; i++) {
+        cpu_sum += f->cpu_mc[i];
+        ssd_sum += state->ssd_temps[i];
+        if (f->sample_ms[i] < oldest) oldest = f->sample_ms[i];
+        if (f->sample_ms[i] > newest) newest = f->sample_ms[i];
+        if (i < half) {
+            cpu_older += f->cpu_mc[i];
+            ssd_older += state->ssd_temps[i];
+        } else if (i < 2 * half) {
+            cpu_recent += f->cpu_mc[i];
+            ssd_recent += state->ssd_temps[i];
+        }
+    }
+    int ssd_avg = (int)(ssd_sum / count);
+    thermal_ratio_t cpu_trend = fixed_trend(cpu_older, cpu_recent, count, newest - oldest);
+    thermal_ratio_t ssd_trend = fixed_trend(ssd_older * 1000, ssd_recent * 1000, count, newest - oldest);
+
+    unsigned int ties = 0;
+    int64_t cpu_heat = (int64_t)f->trend_heat_mcps * cpu_trend.den;
+    int64_t ssd_heat = (int64_t)f->trend_heat_mcps * ssd_trend.den;
+    int cpu_is_heating = cpu_trend.num > cpu_heat;
+    int ssd_is_heating = ssd_trend.num > ssd_heat;
+    if (cpu_trend.num == cpu_heat || ssd_trend.num == ssd_heat) ties |= THERMAL_TIE_HEATING;
+    int32_t cpu_lv[4], ssd_lv[4];
+    fixed_levels(f, state, f->cpu_lv_mc, cpu_lv);
+    fixed_levels(f, state, f->ssd_lv_mc, ssd_lv);
+    int32_t dc_cpu_target = fixed_curve(cpu_lv, cpu_sum, count, f->hysteresis_mc, cpu_is_heating, &ties);
+    int32_t dc_ssd_target = fixed_curve(ssd_lv, (int64_t)ssd_avg * 1000, 1, f->hysteresis_mc, ssd_is_heating, &ties);
+    int32_t dc_target = dc_cpu_target > dc_ssd_target ? dc_cpu_target : dc_ssd_target;
+
+    // Dead-band: the larger of the two average changes since the last step
+    int64_t last_count = f->last_cpu_count > 0 ? f->last_cpu_count : 1;
+    thermal_ratio_t change = { cpu_sum * last_count - f->last_cpu_sum * count, count * last_count };
+    int64_t ssd_change_mc = (int64_t)(ssd_avg - state->last_ssd_temp) * 1000;
+    if (!(change.num > ssd_change_mc * change.den)) {
+        change.num = ssd_change_mc;
+        change.den = 1;
+    }
+    int64_t change_abs = change.num < 0 ? -change.num : change.num;
+    int64_t deadband = (int64_t)f->deadband_mc * change.den;
+    int32_t target_gap = dc_target - f->duty_ppb;
+    int32_t gap_abs = target_gap < 0 ? -target_gap : target_gap;
+    int stable_tie = f->stable_ms == FIXED_DEADBAND_STABLE_MS;
+    int change_tie = change_abs == deadband;
+    int gap_tie = fixed_near(gap_abs, FIXED_DEADBAND_DUTY, THERMAL_TIE_DUTY_PPB);
+    int skip_adjustment = 0;
+    if (f->stable_ms > FIXED_DEADBAND_STABLE_MS &&
+        change_abs < deadband &&
+        gap_abs < FIXED_DEADBAND_DUTY) {
+        skip_adjustment = 1;
+        dc_target = f->duty_ppb;
+    }
+    // A tie only matters when the other two conditions hold or tie as well
+    if ((stable_tie || change_tie || gap_tie) &&
+        (f->stable_ms > FIXED_DEADBAND_STABLE_MS || stable_tie) &&
+        (change_abs < deadband || change_tie) &&
+        (gap_abs < FIXED_DEADBAND_DUTY || gap_tie)) {
+        ties |= THERMAL_TIE_DEADBAND;
+    }
+
+    // Ramp limits
+    int32_t dc_change = dc_target - f->duty_ppb;
+    thermal_ratio_t heat_trend = ratio_gt(cpu_trend, ssd_trend) ? cpu_trend : ssd_trend;
+    // In ppb: ppm per °C/s times milli-°C/s is ppb
+    int64_t up_rate = (int64_t)f->up_base_ppm * FIXED_PPB_PER_PPM;
+    if (heat_trend.num > 0) {
+        up_rate += fixed_div_round((int64_t)f->up_gain_ppm * heat_trend.num, heat_trend.den);
+    }
+    if (f->legacy_max_ppm > 0 && (int64_t)f->legacy_max_ppm * FIXED_PPB_PER_PPM < up_rate) {
+        up_rate = (int64_t)f->legacy_max_ppm * FIXED_PPB_PER_PPM;
+    }
+    if (up_rate > (int64_t)f->up_max_ppm * FIXED_PPB_PER_PPM) {
+        up_rate = (int64_t)f->up_max_ppm * FIXED_PPB_PER_PPM;
+    }
+    // Ambient gain schedule, then the step (each product fits 64 bits)
+    int64_t ambient_rate = fixed_ambient_rate(f, state);
+    up_rate = fixed_div_round(fixed_div_round(up_rate * ambient_rate, FIXED_RATE_ONE) * step, FIXED_REFERENCE_MS);
+    int64_t down_rate = fixed_div_round((int64_t)f->down_ppm * FIXED_PPB_PER_PPM * FIXED_RATE_ONE, ambient_rate);
+    down_rate = fixed_div_round(down_rate * step, FIXED_REFERENCE_MS);
+    int hold_active = (state->hold_until != 0 && now < state->hold_until);
+    if ((dc_change > 0 && fixed_near(dc_change, up_rate, THERMAL_TIE_DUTY_PPB)) ||
+        (dc_change < 0 && !hold_active && fixed_near(dc_change, -down_rate, THERMAL_TIE_DUTY_PPB))) {
+        ties |= THERMAL_TIE_RAMP;
+    }
+
+    if (dc_change > up_rate) {
+        dc_change = (int32_t)up_rate;
+    } else if (dc_change < 0) {
+        if (hold_active) {
+            dc_change = 0;
+        } else if (dc_change < -down_rate) {
+            dc_change = (int32_t)-down_rate;
+        }
+    }
+    int32_t dc_new = f->duty_ppb + dc_change;
+    if (dc_new < 0) dc_new = 0;
+    if (dc_new > FIXED_DUTY_FULL) dc_new = FIXED_DUTY_FULL;
+
+    if (dc_new == f->duty_ppb) {
+        state->stable_cycles++;
+        f->stable_ms += step;
+    } else {
+        state->stable_cycles = 0;
+        f->stable_ms = 0;
+    }
+    if (dc_new > f->duty_ppb) {
+        state->hold_until = now + (time_t)f->hold_sec;
+    }
+    f->duty_ppb = dc_new;
+    f->last_cpu_sum = cpu_sum;
+    f->last_cpu_count = count;
+    f->ties = ties;
+
+    // Double observables for status, metrics and the adaptive period
+    double duty = (double)dc_new / FIXED_DUTY_FULL;
+    state->step_sec = (double)step / 1e3;
+    state->stable_sec = (double)f->stable_ms / 1e3;
+    state->last_duty_cycle = duty;
+    state->cpu_avg = (double)cpu_sum / (double)count / 1e3;
+    state->ssd_avg = ssd_avg;
+    state->last_cpu_temp = state->cpu_avg;
+    state->last_ssd_temp = ssd_avg;
+    state->cpu_trend = ratio_value(cpu_trend, 1e3);
+    state->ssd_trend = ratio_value(ssd_trend, 1e3);
+    state->dc_target = (double)dc_target / FIXED_DUTY_FULL;
+    state->hold_active = hold_active;
+    state->deadband_active = skip_adjustment;
+    state->ambient_rate = (double)ambient_rate / FIXED_RATE_ONE;
+
+    int verbose, periodic;
+    if (thermal_log_due(state, &verbose, &periodic)) {
+        thermal_step_log_t l = {
+            (double)cpu_mc / 1e3, max_ssd_temp, cpu_is_heating, ssd_is_heating,
+            (double)dc_cpu_target / FIXED_DUTY_FULL, (double)dc_ssd_target / FIXED_DUTY_FULL, state->dc_target,
+            ratio_value(heat_trend, 1e3), (double)up_rate / FIXED_DUTY_FULL, (double)down_rate / FIXED_DUTY_FULL,
+            state->ambient_rate,
+            (double)dc_change / FIXED_DUTY_FULL, duty, hold_active, skip_adjustment, now
+        };
+        thermal_log_step(cfg, state, &l, verbose, periodic);
+    }
+
+    return duty;
+}
+
+double thermal_control_step(config_t *cfg, thermal_state_t *state, int32_t cpu_mc,
+                            const int *ssd_temps, int ssd_count) {
+#ifdef RADXA_PENTA_FIXED_POINT
+    return thermal_control_step_fixed(cfg, state, cpu_mc, ssd_temps, ssd_count);
+#else
+    return thermal_control_step_double(cfg, state, (double)cpu_mc / 1000.0, ssd_temps, ssd_count);
+#endif
+}
+
+double thermal_next_period(const config_t *cfg, thermal_state_t *state) {
+    const thermal_tunables_t *t = &cfg->active->thermal;
+    double base = THERMAL_REFERENCE_PERIOD_SEC;
+    double fast = (t->period_min_sec > 0.0 && t->period_min_sec < base) ? t->period_min_sec : base;
+    double slow = t->period_max_sec > base ? t->period_max_sec : base;
+
+    int ssd_raw_max = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (state->ssd_temps_raw[i] > ssd_raw_max) ssd_raw_max = state->ssd_temps_raw[i];
+    }
+    double heat_trend = (state->cpu_trend > state->ssd_trend) ? state->cpu_trend : state->ssd_trend;
+    fan_config_t cpu_curve, ssd_curve;
+    thermal_curves(cfg, cfg->active, state, &cpu_curve, &ssd_curve);
+
+    double period = base;
+    if (state->dc_target > state->last_duty_cycle || heat_trend > t->trend_fast_heat_c) {
+        // Ramping up (rate limited) or heating fast: finer steps, same rate per second
+        period = fast;
+    } else if (state->stable_sec >= t->idle_after_sec &&
+               heat_trend <= t->trend_heat_c &&
+               state->cpu_avg < cpu_curve.lv0 - t->idle_margin_c &&
+               state->cpu_temp_raw < cpu_curve.lv0 - t->idle_margin_c &&
+               (double)state->ssd_avg < ssd_curve.lv0 - t->idle_margin_c &&
+               (double)ssd_raw_max < ssd_curve.lv0 - t->idle_margin_c) {
+        // Cold and steady: back off geometrically, so a brief lull stays cheap to leave
+        period = state->period_sec * 2.0;
+        if (period < base) period = base;
+        if (period > slow) period = slow;
+    }
+    state->period_sec = period;
+    return period;
 }
@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <time.h>
+#include "timebase.h"
+
+static int virtual_enabled = 0;
+static double virtual_mono = 0.0;
+static time_t virtual_wall0 = 0;
+
+double timebase_mono_sec(void) {
+    if (virtual_enabled) return virtual_mono;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+uint64_t timebase_raw_ns(void) {
+    if (virtual_enabled) return (uint64_t)(virtual_mono * 1e9);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int64_t timebase_mono_ms(void) {
+    if (virtual_enabled) return (int64_t)(virtual_mono * 1e3 + 0.5);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+time_t timebase_wall_sec(void) {
+    if (virtual_enabled) return virtual_wall0 + (time_t)virtual_mono;
+    return time(NULL);
+}
+
+void timebase_virtual_enable(time_t start_wall) {
+    virtual_enabled = 1;
+    virtual_mono = 0.0;
+    virtual_wall0 = start_wall;
+}
+
+void timebase_virtual_advance(double sec) {
+    virtual_mono += sec;
+}
@@ -0,0 +1,139 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unit.h"
+#include "timebase.h"
+#include "logger.h"
+
+static void unit_start_display(unit_t *u, history_t *history, stages_t *stages, budget_t *budget,
+                               sysinfo_t *sysinfo) {
+    const unit_config_t *c = u->cfg;
+
+    if (oled_init(&u->oled, c->oled_bus, c->oled_addr) != 0) {
+        printf("[%s] OLED not available, continuing without display\n", c->name);
+        return;
+    }
+    u->oled.history = history;
+    u->oled.stages = stages;
+    u->oled.sysinfo = sysinfo;
+    u->oled.disks = c->disks;
+    oled_set_rotation(&u->oled, c->oled_rotate);
+    logger_log(LOGGER_DEBUG, NULL, "[%s] OLED rotation applied: %d", c->name, c->oled_rotate);
+    oled_welcome(&u->oled);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, oled_auto_scroll_thread, &u->oled) != 0) {
+        fprintf(stderr, "Warning: [%s] Failed to create OLED thread\n", c->name);
+        return;
+    }
+    // The budget samples one display thread; they all do the same work
+    if (budget) budget_watch_oled_thread(budget, thread);
+    pthread_detach(thread);
+    u->has_oled = 1;
+
+    // Button (requires the OLED reference)
+    if (c->button_chip < 0 || c->button_line < 0) {
+        printf("[%s] Button GPIO not configured\n", c->name);
+        return;
+    }
+    if (button_init(&u->button, c->button_chip, (unsigned int)c->button_line, &u->oled) != 0) {
+        return;
+    }
+    if (pthread_create(&thread, NULL, button_watch_thread, &u->button) != 0) {
+        fprintf(stderr, "Warning: [%s] Failed to create button thread\n", c->name);
+        button_cleanup(&u->button);
+        return;
+    }
+    pthread_detach(thread);
+    u->has_button = 1;
+}
+
+int unit_start(unit_t *u, config_t *cfg, const unit_config_t *ucfg, history_t *history, stages_t *stages,
+               budget_t *budget, sysinfo_t *sysinfo) {
+    memset(u, 0, sizeof(unit_t));
+    u->cfg = ucfg;
+    u->last_dc = -1.0;
+    thermal_state_init(&u->thermal);
+    controller_load(&u->controller, cfg, &u->thermal, ucfg->name);
+
+    if (ucfg->oled) {
+        unit_start_display(u, history, stages, budget, sysinfo);
+    }
+
+    if (ucfg->fan != UNIT_FAN_NONE) {
+        if (fan_init(&u->fan, ucfg) < 0) {
+            fprintf(stderr, "Error initializing fan of unit '%s'\n", ucfg->name);
+            // Release the display, button and controller already claimed
+            unit_stop(u);
+            return -1;
+        }
+        u->has_fan = 1;
+    }
+    return 0;
+}
+
+double unit_control(unit_t *u, config_t *cfg, const thermal_sample_t *sample) {
+    if (!cfg->fan_enabled) {
+        u->controller_dc = 0.0;
+    } else {
+        int32_t cpu_mc;
+        int ssd_temps[MAX_DEVICES];
+        int ssd_count = thermal_sample_view(&u->thermal, sample, u->cfg->disks, u->cfg->cpu, &cpu_mc, ssd_temps);
+
+        uint64_t compute_start = timebase_raw_ns();
+        u->controller_dc = controller_step(&u->controller, cfg, cpu_mc, ssd_temps, ssd_count);
+        u->thermal.compute_sec = (double)(timebase_raw_ns() - compute_start) / 1e9;
+    }
+    return u->controller_dc;
+}
+
+int unit_actuate(unit_t *u, double dc, stages_t *stages) {
+    u->applied_dc = dc;
+    if (dc == u->last_dc) return 0;
+
+    u->duty_changes++;
+    u->last_dc = dc;
+    if (!u->has_fan) return 1;
+
+    uint64_t actuate_start = timebase_raw_ns();
+    u->fan_error = (fan_set_duty_cycle(&u->fan, dc) < 0);
+    stages_record(stages, STAGE_ACTUATE, timebase_raw_ns() - actuate_start);
+    if (u->fan_error) {
+        logger_fields_t fields;
+        logger_fields_init(&fields);
+        logger_field(&fields, "UNIT", "%s", u->cfg->name);
+        logger_field(&fields, "DUTY", "%.0f", dc * 100.0);
+        logger_log(LOGGER_WARNING, &fields, "Warning: Failed to set duty cycle");
+        u->fan_write_errors++;
+    }
+    return 1;
+}
+
+void unit_set_scroll_interval(unit_t *u, unsigned int sec) {
+    if (u->has_oled) {
+        u->oled.scroll_interval = sec;
+    }
+}
+
+void unit_stop(unit_t *u) {
+    if (u->has_fan) {
+        fan_set_duty_cycle(&u->fan, 0.0);
+        u->fan.edge_jitter = NULL;
+        fan_cleanup(&u->fan);
+        u->has_fan = 0;
+    }
+    if (u->has_button) {
+        button_cleanup(&u->button);
+        u->has_button = 0;
+    }
+    if (u->has_oled) {
+        oled_goodbye(&u->oled);
+        oled_cleanup(&u->oled);
+        u->has_oled = 0;
+    }
+    controller_unload(&u->controller);
+}
@@ -0,0 +1,212 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <math.h>
+#include <sys/stat.h>
+#include "usage.h"
+#include "timebase.h"
+#include "logger.h"
+
+#define USAGE_FILE_MAGIC 0x53555052u    // "RPUS"
+#define USAGE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t sensors;
+    uint16_t levels;
+    uint16_t bands;
+    uint32_t reserved;
+    int64_t saved_at;
+    usage_counters_t c;
+    uint32_t crc;               // CRC-32 of everything above
+} usage_file_t;
+
+static const char *band_names[USAGE_DUTY_BANDS] = { "off", "1-25", "26-50", "51-75", "76-100" };
+
+// Bitwise CRC-32 (IEEE): a few hundred bytes once per checkpoint
+static uint32_t crc32_update(const uint8_t *p, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static int ensure_parent_dir(const char *path) {
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (!slash || slash == dir) return 0;
+    *slash = '\0';
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+static int usage_load(usage_t *u) {
+    FILE *fp = fopen(u->path, "rb");
+    if (!fp) {
+        if (errno != ENOENT) {
+            fprintf(stderr, "Warning: Cannot read usage counters %s: %s\n", u->path, strerror(errno));
+        }
+        return -1;
+    }
+
+    usage_file_t f;
+    size_t n = fread(&f, 1, sizeof(f), fp);
+    fclose(fp);
+
+    if (n != sizeof(f) || f.magic != USAGE_FILE_MAGIC || f.version != USAGE_VERSION ||
+        f.sensors != USAGE_SENSORS || f.levels != USAGE_LEVELS || f.bands != USAGE_DUTY_BANDS ||
+        f.crc != crc32_update((const uint8_t *)&f, offsetof(usage_file_t, crc))) {
+        fprintf(stderr, "Warning: Usage counters %s are corrupt or from another version, starting over\n", u->path);
+        return -1;
+    }
+    u->c = f.c;
+    return 0;
+}
+
+int usage_open(usage_t *u, const char *path, int checkpoint_sec, double now_mono) {
+    memset(u, 0, sizeof(usage_t));
+    snprintf(u->path, sizeof(u->path), "%s", path);
+    u->checkpoint_sec = checkpoint_sec > 0 ? checkpoint_sec : USAGE_DEFAULT_CHECKPOINT_SEC;
+    u->last_checkpoint = now_mono;
+
+    if (usage_load(u) == 0) {
+        logger_log(LOGGER_INFO, NULL, "[Usage] Resumed %.1f h of counters (since %lld, fan %.1f h on, %llu starts)",
+                   u->c.total_sec / 3600.0, (long long)u->c.since,
+                   (u->c.total_sec - u->c.band_sec[0]) / 3600.0, (unsigned long long)u->c.fan_starts);
+    } else {
+        memset(&u->c, 0, sizeof(u->c));
+        u->c.since = (int64_t)timebase_wall_sec();
+    }
+    return 0;
+}
+
+void usage_tick(usage_t *u, const config_t *cfg, const thermal_state_t *ts, double duty, double dt_sec) {
+    if (dt_sec <= 0.0 || dt_sec > USAGE_MAX_TICK_SEC) {
+        u->last_duty = duty;
+        return;
+    }
+    usage_counters_t *c = &u->c;
+    fan_config_t cpu_curve, ssd_curve;
+    thermal_curves(cfg, &cfg->profiles[0], ts, &cpu_curve, &ssd_curve);
+    c->total_sec += dt_sec;
+
+    for (int s = 0; s < USAGE_SENSORS; s++) {
+        const fan_config_t *lv = s == 0 ? &cpu_curve : &ssd_curve;
+        double t = s == 0 ? ts->cpu_temp_raw : (double)ts->ssd_temps_raw[s - 1];
+        if (t > c->peak_c[s]) c->peak_c[s] = t;
+        if (t >= lv->lv0) c->above_sec[s][0] += dt_sec;
+        if (t >= lv->lv1) c->above_sec[s][1] += dt_sec;
+        if (t >= lv->lv2) c->above_sec[s][2] += dt_sec;
+        if (t >= lv->lv3) c->above_sec[s][3] += dt_sec;
+    }
+
+    // The interval ran at the duty applied at its start
+    int band = 0;
+    if (u->last_duty > 0.0) {
+        band = (int)ceil(u->last_duty * 4.0);
+        if (band < 1) band = 1;
+        if (band > USAGE_DUTY_BANDS - 1) band = USAGE_DUTY_BANDS - 1;
+    }
+    c->band_sec[band] += dt_sec;
+
+    if (u->last_duty <= 0.0 && duty > 0.0) c->fan_starts++;
+    u->last_duty = duty;
+}
+
+// Data reaches the disk before the rename makes it visible, so the old or
+// the new checkpoint survives a power cut, never a mix
+static int write_durable(const char *path, const void *data, size_t len) {
+    char tmp[136];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    if (ensure_parent_dir(path) < 0) return -1;
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    if (write(fd, data, len) != (ssize_t)len || fsync(fd) < 0) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    close(fd);
+    if (rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+
+    // Persist the rename itself
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash && slash != dir) {
+        *slash = '\0';
+        int dfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dfd >= 0) {
+            fsync(dfd);
+            close(dfd);
+        }
+    }
+    return 0;
+}
+
+int usage_checkpoint(usage_t *u) {
+    usage_file_t f;
+    memset(&f, 0, sizeof(f));
+    f.magic = USAGE_FILE_MAGIC;
+    f.version = USAGE_VERSION;
+    f.sensors = USAGE_SENSORS;
+    f.levels = USAGE_LEVELS;
+    f.bands = USAGE_DUTY_BANDS;
+    f.saved_at = (int64_t)timebase_wall_sec();
+    f.c = u->c;
+    f.crc = crc32_update((const uint8_t *)&f, offsetof(usage_file_t, crc));
+
+    if (write_durable(u->path, &f, sizeof(f)) < 0) {
+        u->checkpoint_errors++;
+        logger_log(LOGGER_WARNING, NULL, "Warning: Usage checkpoint to %s failed: %s", u->path, strerror(errno));
+        return -1;
+    }
+    logger_log(LOGGER_DEBUG, NULL, "[Usage] Checkpoint %s (%.1f h)", u->path, u->c.total_sec / 3600.0);
+    return 0;
+}
+
+void usage_maybe_checkpoint(usage_t *u, double now_mono) {
+    if (now_mono - u->last_checkpoint < (double)u->checkpoint_sec) return;
+    u->last_checkpoint = now_mono;
+    usage_checkpoint(u);
+}
+
+void usage_close(usage_t *u) {
+    usage_checkpoint(u);
+    const usage_counters_t *c = &u->c;
+    double ssd_hot = 0.0;
+    for (int s = 1; s < USAGE_SENSORS; s++) {
+        if (c->above_sec[s][USAGE_LEVELS - 1] > ssd_hot) ssd_hot = c->above_sec[s][USAGE_LEVELS - 1];
+    }
+    logger_log(LOGGER_INFO, NULL,
+               "[Usage] %.1f h: CPU >= lv3 %.0fs (peak %.0f°C), worst SSD >= lv3 %.0fs, fan on %.1f h, %llu starts",
+               c->total_sec / 3600.0, c->above_sec[0][USAGE_LEVELS - 1], c->peak_c[0], ssd_hot,
+               (c->total_sec - c->band_sec[0]) / 3600.0, (unsigned long long)c->fan_starts);
+}
+
+const char *usage_sensor_name(int sensor) {
+    return sensor == 0 ? "cpu" : thermal_ssd_device_name((size_t)(sensor - 1));
+}
+
+const char *usage_band_name(int band) {
+    return (band >= 0 && band < USAGE_DUTY_BANDS) ? band_names[band] : "?";
+}
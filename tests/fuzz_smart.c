@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// libFuzzer harness for the streaming smartctl parser (RADXA_PENTA_FUZZ).
+// The input is smartctl output as captured, so the corpus files are used
+// unchanged; its hash seeds the chunk splits, which change with every
+// mutation. Each input is parsed in a single feed and in random chunks of
+// 1..SMARTCTL_READ_CHUNK bytes, for a temperature-only and a full health
+// pass. The parser consumes bytes exactly once, so both must stop at the
+// same byte with the same fields. Start from tests/smart-corpus:
+//
+//   radxa-penta-fuzz-smart -max_len=65536 corpus/ ../tests/smart-corpus
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "smart.h"
+#include "thermal.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// xorshift32: cheap, deterministic per input
+static uint32_t next_rand(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *s = x;
+    return x;
+}
+
+static void parse_whole(smart_parser_t *p, unsigned int want, const char *buf, size_t len) {
+    smart_parser_init(p, want);
+    if (!smart_parser_feed(p, buf, len)) smart_parser_finish(p);
+}
+
+static void parse_split(smart_parser_t *p, unsigned int want, const char *buf, size_t len, uint32_t seed) {
+    size_t off = 0;
+    int done = 0;
+    smart_parser_init(p, want);
+    while (!done && off < len) {
+        size_t n = 1 + next_rand(&seed) % SMARTCTL_READ_CHUNK;
+        if (n > len - off) n = len - off;
+        done = smart_parser_feed(p, buf + off, n);
+        off += n;
+    }
+    if (!done) smart_parser_finish(p);
+}
+
+static void check_same(const smart_parser_t *a, const smart_parser_t *b) {
+    if (a->found != b->found || a->mode != b->mode) abort();
+    if ((a->found & SMART_TEMP) && a->temp != b->temp) abort();
+    if ((a->found & SMART_REALLOCATED) && a->reallocated != b->reallocated) abort();
+    if ((a->found & SMART_PENDING) && a->pending != b->pending) abort();
+    if ((a->found & SMART_WEAR) && a->wear != b->wear) abort();
+    if ((a->found & SMART_USED) && a->percent_used != b->percent_used) abort();
+    if ((a->found & SMART_MEDIA_ERRORS) && a->media_errors != b->media_errors) abort();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    // FNV-1a; xorshift needs a non-zero state
+    uint32_t seed = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        seed = (seed ^ data[i]) * 16777619u;
+    }
+    if (seed == 0) seed = 1;
+    const char *buf = (const char *)data;
+
+    static const unsigned int wants[] = { SMART_TEMP, SMART_TEMP | SMART_HEALTH };
+    for (size_t i = 0; i < sizeof(wants) / sizeof(wants[0]); i++) {
+        smart_parser_t whole, split;
+        parse_whole(&whole, wants[i], buf, size);
+        parse_split(&split, wants[i], buf, size, seed);
+        check_same(&whole, &split);
+    }
+    return 0;
+}
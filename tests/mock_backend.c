@@ -0,0 +1,285 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#define _GNU_SOURCE  // accept4(), nftw()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "mock_backend.h"
+#include "thermal.h"
+
+#define MOCK_HISTORY_FLUSH_SEC 60
+
+// %d is the drive temperature
+#define MOCK_SMART_TEXT \
+    "smartctl 7.3 2022-02-28 r5338 [aarch64-linux-6.1.0] (local build)\n" \
+    "\n" \
+    "=== START OF READ SMART DATA SECTION ===\n" \
+    "SMART Attributes Data Structure revision number: 16\n" \
+    "Vendor Specific SMART Attributes with Thresholds:\n" \
+    "ID# ATTRIBUTE_NAME          FLAG     VALUE WORST THRESH TYPE      UPDATED  WHEN_FAILED RAW_VALUE\n" \
+    "  1 Raw_Read_Error_Rate     0x002f   100   100   050    Pre-fail  Always       -       0\n" \
+    "  5 Reallocated_Sector_Ct   0x0032   100   100   010    Old_age   Always       -       0\n" \
+    "  9 Power_On_Hours          0x0032   099   099   000    Old_age   Always       -       5432\n" \
+    " 12 Power_Cycle_Count       0x0032   100   100   000    Old_age   Always       -       88\n" \
+    "177 Wear_Leveling_Count     0x0013   097   097   000    Pre-fail  Always       -       31\n" \
+    "194 Temperature_Celsius     0x0022   063   052   000    Old_age   Always       -       %d (Min/Max 20/48)\n" \
+    "197 Current_Pending_Sector  0x0032   100   100   000    Old_age   Always       -       0\n" \
+    "199 UDMA_CRC_Error_Count    0x003e   100   100   000    Old_age   Always       -       0\n"
+
+#define MOCK_SMART_JSON \
+    "{\"json_format_version\":[1,0],\"smartctl\":{\"version\":[7,3],\"exit_status\":0}," \
+    "\"device\":{\"name\":\"/dev/sda\",\"protocol\":\"NVMe\"}," \
+    "\"nvme_smart_health_information_log\":{\"critical_warning\":0,\"temperature\":%d," \
+    "\"available_spare\":100,\"percentage_used\":4,\"data_units_read\":12345678," \
+    "\"media_errors\":0,\"num_err_log_entries\":7}," \
+    "\"temperature\":{\"current\":%d},\"power_cycle_count\":5}\n"
+
+static int write_file(const char *path, const char *text) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot write %s\n", path);
+        return -1;
+    }
+    fputs(text, fp);
+    fclose(fp);
+    return 0;
+}
+
+int mock_open(mock_backend_t *m, const char *tag, int history_sec) {
+    memset(m, 0, sizeof(*m));
+    snprintf(m->dir, sizeof(m->dir), "/tmp/radxa-penta-%.14s.XXXXXX", tag);
+    if (!mkdtemp(m->dir)) {
+        fprintf(stderr, "Error: Cannot create scratch directory\n");
+        return -1;
+    }
+    char text[32];
+    snprintf(m->zone, sizeof(m->zone), "%s/temp", m->dir);
+    snprintf(text, sizeof(text), "%d\n", MOCK_CPU_MC);
+    if (write_file(m->zone, text) < 0) return -1;
+    snprintf(m->ambient, sizeof(m->ambient), "%s/ambient", m->dir);
+    snprintf(text, sizeof(text), "%d\n", MOCK_AMBIENT_MC);
+    if (write_file(m->ambient, text) < 0) return -1;
+    snprintf(m->shadow_config, sizeof(m->shadow_config), "%s/shadow.conf", m->dir);
+    if (write_file(m->shadow_config, "# Defaults\n") < 0) return -1;
+
+    // fan_init() writes export, period and enable itself
+    char path[MOCK_PATH_LEN + 32];
+    snprintf(m->pwm_root, sizeof(m->pwm_root), "%s/pwm", m->dir);
+    snprintf(path, sizeof(path), "%s/pwmchip%d", m->pwm_root, MOCK_PWM_CHIP);
+    if (mkdir(m->pwm_root, 0755) != 0 || mkdir(path, 0755) != 0) {
+        fprintf(stderr, "Error: Cannot create %s\n", path);
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/pwmchip%d/pwm%d", m->pwm_root, MOCK_PWM_CHIP, MOCK_PWM_CHANNEL);
+    if (mkdir(path, 0755) != 0) {
+        fprintf(stderr, "Error: Cannot create %s\n", path);
+        return -1;
+    }
+
+    sysinfo_init_static(&m->sysinfo, "penta", "192.0.2.10", m->dir);
+
+    snprintf(m->history_path, sizeof(m->history_path), "%s/history.dat", m->dir);
+    if (history_sec > 0 && history_open(&m->history, m->history_path, 1, MOCK_HISTORY_FLUSH_SEC) == 0) {
+        int64_t now = (int64_t)time(NULL);
+        for (int64_t t = 0; t < history_sec; t++) {
+            double row[HISTORY_SERIES] = {
+                50.0 + 10.0 * sin((double)t / 600.0), 40.0 + 5.0 * sin((double)t / 900.0), 0.4
+            };
+            history_append(&m->history, now - history_sec + t, row);
+        }
+        m->have_history = 1;
+    }
+    return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int type, struct FTW *ftw) {
+    (void)sb;
+    (void)type;
+    (void)ftw;
+    if (remove(path) != 0) fprintf(stderr, "Warning: Cannot remove %s\n", path);
+    return 0;
+}
+
+void mock_close(mock_backend_t *m) {
+    if (m->have_history) history_close(&m->history);
+    m->have_history = 0;
+    sysinfo_cleanup(&m->sysinfo);
+    thermal_set_zone_path(NULL);
+    // Everything the mock and the code under test left in the scratch directory
+    if (m->dir[0]) nftw(m->dir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+int mock_install_smartctl(mock_backend_t *m) {
+    char self[256];
+    ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    snprintf(m->smartctl, sizeof(m->smartctl), "%s/smartctl", m->dir);
+    if (n <= 0 || (self[n] = '\0', symlink(self, m->smartctl) != 0)) {
+        fprintf(stderr, "Error: Cannot link %s\n", m->smartctl);
+        return -1;
+    }
+    char path[1024];
+    const char *old_path = getenv("PATH");
+    snprintf(path, sizeof(path), "%s:%s", m->dir, old_path ? old_path : "/usr/bin:/bin");
+    setenv("PATH", path, 1);
+    return 0;
+}
+
+int mock_is_smartctl(const char *argv0) {
+    const char *base = strrchr(argv0, '/');
+    return strcmp(base ? base + 1 : argv0, "smartctl") == 0;
+}
+
+int mock_smartctl_main(int argc, char *argv[]) {
+    int json = 0;
+    int temp = MOCK_SMART_TEMP;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0) json = 1;
+        if (strncmp(argv[i], "/dev/sd", 7) == 0 && argv[i][7] >= 'a' && argv[i][7] <= 'z') {
+            temp += argv[i][7] - 'a';
+        }
+    }
+    char buf[2048];
+    mock_smart_report(buf, sizeof(buf), json, temp);
+    fputs(buf, stdout);
+    return 0;
+}
+
+int mock_smart_report(char *buf, size_t len, int json, int temp) {
+    if (json) return snprintf(buf, len, MOCK_SMART_JSON, temp, temp);
+    return snprintf(buf, len, MOCK_SMART_TEXT, temp);
+}
+
+void mock_configure(const mock_backend_t *m, config_t *cfg) {
+    thermal_set_zone_path(m->zone);
+    snprintf(cfg->ctl_socket, sizeof(cfg->ctl_socket), "%s/ctl.sock", m->dir);
+    snprintf(cfg->metrics_listen, sizeof(cfg->metrics_listen), "unix:%s/metrics.sock", m->dir);
+    snprintf(cfg->flightrec_dir, sizeof(cfg->flightrec_dir), "%s", m->dir);
+    snprintf(cfg->history_path, sizeof(cfg->history_path), "%s/history.dat", m->dir);
+    snprintf(cfg->usage_path, sizeof(cfg->usage_path), "%s/usage.dat", m->dir);
+    snprintf(cfg->ambient_source, sizeof(cfg->ambient_source), "%s", m->ambient);
+
+    unit_config_t *u = &cfg->units[0];
+    cfg->unit_count = 1;
+    u->fan = UNIT_FAN_PWM;
+    u->pwm_chip = MOCK_PWM_CHIP;
+    u->pwm_channel = MOCK_PWM_CHANNEL;
+    u->oled = 0;
+    u->button_chip = -1;
+    u->button_line = -1;
+}
+
+int mock_broker_open(mock_broker_t *b) {
+    memset(b, 0, sizeof(*b));
+    b->fd = -1;
+    b->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (b->listen_fd < 0) return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(b->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(b->listen_fd, 1) != 0 ||
+        getsockname(b->listen_fd, (struct sockaddr *)&addr, &len) != 0) {
+        fprintf(stderr, "Error: Cannot start the mock MQTT broker: %s\n", strerror(errno));
+        close(b->listen_fd);
+        b->listen_fd = -1;
+        return -1;
+    }
+    b->port = ntohs(addr.sin_port);
+    return 0;
+}
+
+static void broker_drop(mock_broker_t *b) {
+    if (b->fd >= 0) close(b->fd);
+    b->fd = -1;
+    b->in_len = 0;
+}
+
+static void broker_send(mock_broker_t *b, uint8_t type) {
+    const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    const uint8_t pingresp[] = { 0xD0, 0x00 };
+    const uint8_t *pkt = type == 0x10 ? connack : pingresp;
+    size_t len = type == 0x10 ? sizeof(connack) : sizeof(pingresp);
+    if (send(b->fd, pkt, len, MSG_NOSIGNAL) != (ssize_t)len) broker_drop(b);
+}
+
+// Complete packets off the front of the buffer
+static void broker_parse(mock_broker_t *b) {
+    while (b->fd >= 0 && b->in_len >= 2) {
+        size_t rem = 0;
+        size_t pos = 1;
+        unsigned int shift = 0;
+        int complete = 0;
+        while (pos < b->in_len && pos <= 4) {
+            uint8_t byte = b->in[pos++];
+            rem |= (size_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) {
+                complete = 1;
+                break;
+            }
+        }
+        if (!complete) return;
+        size_t total = pos + rem;
+        if (total > sizeof(b->in)) {
+            broker_drop(b);     // Larger than any packet the client sends
+            return;
+        }
+        if (b->in_len < total) return;
+
+        uint8_t type = b->in[0] & 0xF0;
+        if (type == 0x10) {
+            b->connects++;
+            broker_send(b, type);
+        } else if (type == 0xC0) {
+            b->pings++;
+            broker_send(b, type);
+        } else if (type == 0x30) {
+            b->publishes++;
+        } else if (type == 0xE0) {
+            broker_drop(b);
+            return;
+        }
+        memmove(b->in, b->in + total, b->in_len - total);
+        b->in_len -= total;
+    }
+}
+
+void mock_broker_service(mock_broker_t *b) {
+    if (b->listen_fd < 0) return;
+    int fd = accept4(b->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd >= 0) {
+        // A reconnect replaces the old session, as a broker does
+        broker_drop(b);
+        b->fd = fd;
+    }
+    while (b->fd >= 0) {
+        ssize_t n = recv(b->fd, b->in + b->in_len, sizeof(b->in) - b->in_len, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            broker_drop(b);
+            break;
+        }
+        if (n < 0) break;
+        b->in_len += (size_t)n;
+        broker_parse(b);
+    }
+}
+
+void mock_broker_close(mock_broker_t *b) {
+    broker_drop(b);
+    if (b->listen_fd >= 0) close(b->listen_fd);
+    b->listen_fd = -1;
+}
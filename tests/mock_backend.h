@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef MOCK_BACKEND_H
+#define MOCK_BACKEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "history.h"
+#include "sysinfo.h"
+
+#define MOCK_CPU_MC 47250           // What the thermal zone file reads
+#define MOCK_AMBIENT_MC 24000       // What the ambient file reads
+#define MOCK_SMART_TEMP 37          // Drive temperature in mock_smart_report() for sda
+#define MOCK_PWM_CHIP 0
+#define MOCK_PWM_CHANNEL 0
+#define MOCK_PATH_LEN 96
+#define MOCK_BROKER_BUF 4096
+
+// Hardware stand-ins for benchmarks, the soak and the tests, all in one
+// scratch directory under /tmp:
+//   temp              thermal zone (MOCK_CPU_MC), passed to thermal_set_zone_path()
+//   ambient           hwmon-style ambient file (MOCK_AMBIENT_MC)
+//   pwm/pwmchip0/     sysfs PWM tree for fan_set_pwm_root()
+//   smartctl          the running binary behind a symlink, first on PATH
+//                     (mock_install_smartctl())
+//   shadow.conf       an empty config (all defaults) for [shadow] config
+//   history.dat       history store, prefilled with a synthetic trace
+// plus a fixed address/hostname/mount cache.
+typedef struct {
+    char dir[40];                   // Short enough for the 64-byte socket paths in config_t
+    char zone[MOCK_PATH_LEN];
+    char ambient[MOCK_PATH_LEN];
+    char pwm_root[MOCK_PATH_LEN];
+    char smartctl[MOCK_PATH_LEN];
+    char shadow_config[MOCK_PATH_LEN];
+    char history_path[MOCK_PATH_LEN];
+    sysinfo_t sysinfo;
+    history_t history;
+    int have_history;
+} mock_backend_t;
+
+// tag names the scratch directory (/tmp/radxa-penta-<tag>.XXXXXX).
+// history_sec > 0 opens history.dat with that many seconds of synthetic
+// CPU, drive and duty rows up to now; 0 leaves it to the caller.
+int mock_open(mock_backend_t *m, const char *tag, int history_sec);
+void mock_close(mock_backend_t *m);
+
+// Put a smartctl first on PATH that is this binary under another name;
+// main() must hand over to mock_smartctl_main() when mock_is_smartctl()
+int mock_install_smartctl(mock_backend_t *m);
+int mock_is_smartctl(const char *argv0);
+// Print mock_smart_report() for the drive on the command line, a little
+// warmer per drive letter; -j selects the JSON form
+int mock_smartctl_main(int argc, char *argv[]);
+
+// Canned smartctl output for a drive at temp °C: ATA attributes as text,
+// or an NVMe health log as --json. Returns the length as snprintf() does.
+int mock_smart_report(char *buf, size_t len, int json, int temp);
+
+// Point everything cfg writes or listens on into the scratch directory
+// (control and metrics sockets, flight recorder, history, usage
+// counters), read the ambient file, and drive one unit with a PWM fan on
+// the mock tree and no display or button. Surfaces keep their enable flags.
+void mock_configure(const mock_backend_t *m, config_t *cfg);
+
+// MQTT 3.1.1 broker stand-in on 127.0.0.1 (ephemeral port): answers
+// CONNECT with CONNACK and PINGREQ with PINGRESP, counts and drops
+// PUBLISH. One client at a time, served from mock_broker_service().
+typedef struct {
+    int listen_fd;
+    int fd;                         // Connected client, -1 = none
+    int port;
+    uint8_t in[MOCK_BROKER_BUF];
+    size_t in_len;
+    unsigned long connects;
+    unsigned long publishes;
+    unsigned long pings;
+} mock_broker_t;
+
+int mock_broker_open(mock_broker_t *b);
+// Accept, read and answer whatever is pending; never blocks
+void mock_broker_service(mock_broker_t *b);
+void mock_broker_close(mock_broker_t *b);
+
+#endif // MOCK_BACKEND_H
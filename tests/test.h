@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <math.h>
+#include "config.h"
+
+// Minimal harness for radxa-penta-tests: a failed check prints where and
+// why and is counted; the run exits non-zero if any check failed.
+extern int test_checks;
+extern int test_failures;
+
+#define CHECK(cond) \
+    test_check((cond), __FILE__, __LINE__, #cond)
+#define CHECK_INT(got, want) \
+    test_check_int((long)(got), (long)(want), __FILE__, __LINE__, #got)
+#define CHECK_NEAR(got, want, eps) \
+    test_check_near((double)(got), (double)(want), (double)(eps), __FILE__, __LINE__, #got)
+
+void test_check(int ok, const char *file, int line, const char *expr);
+void test_check_int(long got, long want, const char *file, int line, const char *expr);
+void test_check_near(double got, double want, double eps, const char *file, int line, const char *expr);
+
+// Load text as a config file (written to a scratch file and removed)
+int test_load_config(config_t *cfg, const char *text);
+
+void test_config(void);
+void test_controller(void);
+void test_smart(void);
+void test_render(void);
+
+#endif // TEST_H
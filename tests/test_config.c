@@ -0,0 +1,173 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// Config parsing: defaults, profile inheritance, schedule order, units
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "ambient.h"
+#include "thermal.h"
+
+static void test_defaults(void) {
+    static config_t cfg;
+    CHECK_INT(test_load_config(&cfg, "# nothing set\n"), 0);
+    CHECK_INT(cfg.profile_count, 1);
+    CHECK(strcmp(cfg.active->name, CONFIG_DEFAULT_PROFILE) == 0);
+    CHECK_NEAR(cfg.active->fan.lv0, 55.0, 0.0);
+    CHECK_NEAR(cfg.active->fan.lv3, 78.0, 0.0);
+    CHECK_NEAR(cfg.active->fan_ssd.lv0, 45.0, 0.0);
+    CHECK_NEAR(cfg.active->thermal.hysteresis_c, 3.0, 0.0);
+    CHECK_INT(cfg.unit_count, 1);
+    CHECK(strcmp(cfg.units[0].name, CONFIG_DEFAULT_UNIT) == 0);
+    CHECK_INT(cfg.ambient_relative, 0);
+    CHECK_NEAR(cfg.ambient_reference, AMBIENT_DEFAULT_REFERENCE, 0.0);
+
+    // A missing file is not an error: the same defaults
+    static config_t missing;
+    CHECK_INT(config_load_file(&missing, "/nonexistent/radxa-penta-fan-ctrl.conf"), 0);
+    CHECK_NEAR(missing.active->fan.lv1, cfg.active->fan.lv1, 0.0);
+    CHECK_INT(missing.unit_count, 1);
+}
+
+static void test_profiles(void) {
+    static config_t cfg;
+    // The profile comes first but still starts from the final [fan]/[thermal]
+    CHECK_INT(test_load_config(&cfg,
+        "[profile.quiet]\n"
+        "lv0 = 60\n"
+        "ssd_lv3 = 62\n"
+        "down_rate = 0.02\n"
+        "\n"
+        "[fan]\n"
+        "lv0 = 50\n"
+        "lv3 = 80  # comment\n"
+        "\n"
+        "[thermal]\n"
+        "hysteresis = 4.5\n"
+        "\n"
+        "[schedule]\n"
+        "23:00 = quiet\n"
+        "07:30 = default\n"), 0);
+
+    CHECK_INT(cfg.profile_count, 2);
+    CHECK_NEAR(cfg.profiles[0].fan.lv0, 50.0, 0.0);
+    CHECK_NEAR(cfg.profiles[0].fan.lv1, 62.0, 0.0);
+    CHECK_NEAR(cfg.profiles[0].fan.lv3, 80.0, 0.0);
+    CHECK_NEAR(cfg.profiles[0].thermal.hysteresis_c, 4.5, 0.0);
+
+    int quiet = config_find_profile(&cfg, "quiet");
+    CHECK(quiet > 0);
+    CHECK_INT(config_find_profile(&cfg, "nope"), -1);
+    if (quiet > 0) {
+        const fan_profile_t *p = &cfg.profiles[quiet];
+        CHECK_NEAR(p->fan.lv0, 60.0, 0.0);
+        CHECK_NEAR(p->fan.lv3, 80.0, 0.0);
+        CHECK_NEAR(p->fan_ssd.lv3, 62.0, 0.0);
+        CHECK_NEAR(p->fan_ssd.lv0, 45.0, 0.0);
+        CHECK_NEAR(p->thermal.down_rate_per_cycle, 0.02, 0.0);
+        CHECK_NEAR(p->thermal.hysteresis_c, 4.5, 0.0);
+    }
+
+    CHECK_INT(cfg.schedule_count, 2);
+    CHECK_INT(cfg.schedule[0].minute, 7 * 60 + 30);
+    CHECK_INT(cfg.schedule[0].profile, 0);
+    CHECK_INT(cfg.schedule[1].minute, 23 * 60);
+    CHECK_INT(cfg.schedule[1].profile, quiet);
+}
+
+static void test_units(void) {
+    static config_t cfg;
+    CHECK_INT(test_load_config(&cfg,
+        "[oled]\n"
+        "rotate = true\n"
+        "\n"
+        "[unit.top]\n"
+        "fan = pwm\n"
+        "pwm_chip = 1\n"
+        "oled = 1\n"
+        "disks = sda,sdb\n"
+        "\n"
+        "[unit.bottom]\n"
+        "fan = pwm\n"
+        "pwm_chip = 1\n"
+        "oled_rotate = false\n"
+        "cpu = 0\n"
+        "disks = none\n"
+        "\n"
+        "[ambient]\n"
+        "source = drives\n"
+        "reference = 22.5\n"
+        "relative = true\n"), 0);
+
+    CHECK_INT(cfg.unit_count, 2);
+    CHECK_INT(config_find_unit(&cfg, "top"), 0);
+    CHECK_INT(config_find_unit(&cfg, "bottom"), 1);
+    CHECK_INT(config_find_unit(&cfg, CONFIG_DEFAULT_UNIT), -1);
+
+    CHECK_INT(cfg.units[0].fan, UNIT_FAN_PWM);
+    CHECK_INT(cfg.units[0].pwm_chip, 1);
+    CHECK_INT(cfg.units[0].disks, 0x3);
+    CHECK_INT(cfg.units[0].cpu, 1);
+    CHECK_INT(cfg.units[0].oled_rotate, 1);
+    // Same PWM channel as "top": dropped, the rest of the unit kept
+    CHECK_INT(cfg.units[1].fan, UNIT_FAN_NONE);
+    CHECK_INT(cfg.units[1].cpu, 0);
+    CHECK_INT(cfg.units[1].disks, 0);
+    CHECK_INT(cfg.units[1].oled_rotate, 0);
+
+    CHECK(strcmp(cfg.ambient_source, AMBIENT_SOURCE_DRIVES) == 0);
+    CHECK_NEAR(cfg.ambient_reference, 22.5, 0.0);
+    // Refused on the drives baseline, which warms with drive load
+    CHECK_INT(cfg.ambient_relative, 0);
+}
+
+// Paths up to their field size are kept whole; longer ones (the line
+// itself still fits MAX_LINE) are refused and the default stays
+static void test_long_values(void) {
+    char path[200], text[MAX_LINE * 3];
+    static config_t cfg;
+
+    memset(path, 'h', sizeof(path));
+    memcpy(path, "/var/lib/", 9);
+    path[90] = '\0';
+    snprintf(text, sizeof(text),
+             "[history]\npath = %s\n"
+             "[metrics]\nlisten = unix:%s\n", path, path);
+    CHECK_INT(test_load_config(&cfg, text), 0);
+    CHECK(strcmp(cfg.history_path, path) == 0);
+    CHECK(strcmp(cfg.metrics_listen, CONFIG_METRICS_LISTEN) == 0);
+
+    path[90] = 'h';
+    path[sizeof(path) - 1] = '\0';
+    snprintf(text, sizeof(text),
+             "[history]\npath = %s\n"
+             "[usage]\npath = %s\n"
+             "[ambient]\nsource = %s\n"
+             "[fan]\nlv0 = 51\n", path, path, path);
+    CHECK_INT(test_load_config(&cfg, text), 0);
+    CHECK(strlen(cfg.history_path) < sizeof(cfg.history_path));
+    CHECK(strncmp(cfg.history_path, "/var/lib/hhh", 12) != 0);
+    CHECK(strncmp(cfg.usage_path, "/var/lib/hhh", 12) != 0);
+    CHECK_INT(cfg.ambient_source[0], '\0');
+    CHECK_NEAR(cfg.active->fan.lv0, 51.0, 0.0);
+}
+
+static void test_levels(void) {
+    fan_config_t f = { 55.0, 62.0, 70.0, 78.0 };
+    CHECK_NEAR(config_temp_to_dc(&f, 40.0), 0.0, 0.0);
+    CHECK_NEAR(config_temp_to_dc(&f, 55.0), 0.25, 0.0);
+    CHECK_NEAR(config_temp_to_dc(&f, 65.0), 0.50, 0.0);
+    CHECK_NEAR(config_temp_to_dc(&f, 70.0), 0.75, 0.0);
+    CHECK_NEAR(config_temp_to_dc(&f, 90.0), 1.0, 0.0);
+}
+
+void test_config(void) {
+    test_defaults();
+    test_profiles();
+    test_units();
+    test_long_values();
+    test_levels();
+}
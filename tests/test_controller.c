@@ -0,0 +1,258 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// The built-in control law through controller_step() on the virtual clock
+// (one-second steps), the [ambient] sources and relative curves
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "ambient.h"
+#include "controller.h"
+#include "thermal.h"
+#include "timebase.h"
+
+#define TEST_COLD_MC 40000
+#define TEST_HOT_MC 90000
+#define TEST_RAMP_EPS 1e-3          // The fixed-point law rounds to ppm
+#define TEST_MAX_STEPS 600
+#define TEST_W1_POLLS 200           // 10 ms apart
+
+static double step(controller_t *c, config_t *cfg, int32_t cpu_mc) {
+    static const int ssd[MAX_DEVICES] = { 0 };
+    timebase_virtual_advance(1.0);
+    return controller_step(c, cfg, cpu_mc, ssd, 0);
+}
+
+static void test_step(void) {
+    static config_t cfg;
+    CHECK_INT(test_load_config(&cfg, "# defaults\n"), 0);
+    const thermal_tunables_t *t = &cfg.active->thermal;
+
+    thermal_state_t ts;
+    controller_t c;
+    thermal_state_init(&ts);
+    ts.quiet = 1;
+    CHECK_INT(controller_load(&c, &cfg, &ts, "test"), 0);
+    CHECK(c.builtin);
+
+    // Below lv0 the fan stays off
+    double duty = 0.0;
+    for (int i = 0; i < 30; i++) duty = step(&c, &cfg, TEST_COLD_MC);
+    CHECK_NEAR(duty, 0.0, 0.0);
+
+    // Over lv3: rises every step by at most the fastest up ramp, to full speed
+    int steps = 0, monotonic = 1, bounded = 1;
+    double prev = duty;
+    while (duty < 1.0 && steps < TEST_MAX_STEPS) {
+        duty = step(&c, &cfg, TEST_HOT_MC);
+        if (duty < prev) monotonic = 0;
+        if (duty - prev > t->up_rate_max_per_cycle + TEST_RAMP_EPS) bounded = 0;
+        prev = duty;
+        steps++;
+    }
+    CHECK_NEAR(duty, 1.0, 0.0);
+    CHECK(monotonic);
+    CHECK(bounded);
+    CHECK(steps >= (int)(1.0 / t->up_rate_max_per_cycle));
+
+    // Cold again: held for cooldown_hold_sec from the step that reached full
+    // speed, then down no faster than down_rate
+    duty = step(&c, &cfg, TEST_COLD_MC);
+    CHECK_NEAR(duty, 1.0, 0.0);
+    steps = 1;
+    monotonic = bounded = 1;
+    prev = duty;
+    int held = 1;
+    while (duty > 0.0 && steps < TEST_MAX_STEPS) {
+        duty = step(&c, &cfg, TEST_COLD_MC);
+        if (duty > prev) monotonic = 0;
+        if (prev - duty > t->down_rate_per_cycle + TEST_RAMP_EPS) bounded = 0;
+        if (duty == 1.0) held++;
+        prev = duty;
+        steps++;
+    }
+    CHECK_NEAR(duty, 0.0, 0.0);
+    CHECK(monotonic);
+    CHECK(bounded);
+    CHECK((double)held >= t->cooldown_hold_sec - 1.0);
+    CHECK_INT(c.bad_outputs, 0);
+    CHECK(c.steps > 0);
+
+    controller_unload(&c);
+}
+
+static int write_text(const char *path, const char *text) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return -1;
+    int rc = fputs(text, fp) < 0 ? -1 : 0;
+    return fclose(fp) != 0 ? -1 : rc;
+}
+
+static int load_ambient(config_t *cfg, const char *source) {
+    char text[256];
+    snprintf(text, sizeof(text), "[ambient]\nsource = %s\n", source);
+    return test_load_config(cfg, text);
+}
+
+// An hwmon file is read by the tick's batch, a 1-wire one by a reader thread
+static void test_ambient_sources(void) {
+    static config_t cfg;
+    static const int ssd[MAX_DEVICES] = { 0 };
+    char dir[] = "/tmp/radxa-penta-ambient.XXXXXX";
+    char hwmon[64], w1[64];
+    CHECK(mkdtemp(dir) != NULL);
+    snprintf(hwmon, sizeof(hwmon), "%s/temp1_input", dir);
+    snprintf(w1, sizeof(w1), "%s/w1_slave", dir);
+    CHECK_INT(write_text(hwmon, "31500\n"), 0);
+    CHECK_INT(write_text(w1, "72 01 4b 46 7f ff 0e 10 57 : crc=57 YES\n72 01 4b 46 7f ff 0e 10 57 t=23125\n"), 0);
+
+    sensors_t sensors;
+    ambient_t a;
+    int32_t mc = 0;
+    sensors_init(&sensors, 0);
+    CHECK_INT(load_ambient(&cfg, hwmon), 0);
+    ambient_init(&a, &cfg);
+    CHECK_INT(ambient_start(&a, &sensors), 0);
+    CHECK_INT(sensors.count, 1);
+    CHECK(!a.reader);
+    sensors_read_all(&sensors);
+    ambient_update(&a, ssd, 1.0);
+    CHECK(ambient_current(&a, 1.0, &mc));
+    CHECK_INT(mc, 31500);
+    ambient_stop(&a);
+    sensors_close(&sensors);
+
+    sensors_init(&sensors, 0);
+    CHECK_INT(load_ambient(&cfg, w1), 0);
+    ambient_init(&a, &cfg);
+    CHECK_INT(ambient_start(&a, &sensors), 0);
+    CHECK_INT(sensors.count, 0);
+    CHECK(a.reader);
+    int valid = 0;
+    for (int i = 0; i < TEST_W1_POLLS && !valid; i++) {
+        ambient_update(&a, ssd, 1.0);
+        valid = ambient_current(&a, 1.0, &mc);
+        if (!valid) usleep(10000);
+    }
+    CHECK(valid);
+    CHECK_INT(mc, 23125);
+    ambient_stop(&a);
+    CHECK(!a.reader);
+    sensors_close(&sensors);
+
+    unlink(hwmon);
+    unlink(w1);
+    rmdir(dir);
+}
+
+// Sustained drive load warms the drives baseline: that may speed the ramps
+// up, but relative thresholds on it are refused so it never slows the fan
+static void test_drives_baseline(void) {
+    static config_t cfg;
+    CHECK_INT(test_load_config(&cfg, "[ambient]\nsource = drives\nrelative = true\n"), 0);
+    CHECK_INT(cfg.ambient_relative, 0);
+
+    thermal_state_t ts;
+    fan_config_t idle_cpu, idle_ssd, cpu, ssd;
+    thermal_state_init(&ts);
+    thermal_curves(&cfg, cfg.active, &ts, &idle_cpu, &idle_ssd);
+
+    ambient_t a;
+    int temps[MAX_DEVICES] = { 55, 56 };
+    double mono = 0.0;
+    ambient_init(&a, &cfg);
+    CHECK_INT(ambient_start(&a, NULL), 0);
+    for (int i = 0; i < AMBIENT_BASELINE_SLOTS * 2; i++) {
+        mono += (double)a.interval_sec;
+        ambient_update(&a, temps, mono);
+    }
+    ts.ambient_valid = ambient_current(&a, mono, &ts.ambient_mc);
+    CHECK(ts.ambient_valid);
+    CHECK_INT(ts.ambient_mc, 55000 - a.drive_offset_mc);
+
+    thermal_curves(&cfg, cfg.active, &ts, &cpu, &ssd);
+    CHECK_NEAR(cpu.lv0, idle_cpu.lv0, 0.0);
+    CHECK_NEAR(cpu.lv2, idle_cpu.lv2, 0.0);
+    CHECK_NEAR(ssd.lv0, idle_ssd.lv0, 0.0);
+    CHECK_NEAR(ssd.lv2, idle_ssd.lv2, 0.0);
+    CHECK(thermal_ambient_rate(&cfg, &ts) > 1.0);
+    ambient_stop(&a);
+}
+
+static void test_relative_curves(void) {
+    static config_t cfg;
+    CHECK_INT(test_load_config(&cfg,
+        "[fan]\n"
+        "lv0 = 30\n"
+        "lv1 = 37\n"
+        "lv2 = 45\n"
+        "lv3 = 53\n"
+        "[fan_ssd]\n"
+        "lv0 = 20\n"
+        "lv1 = 25\n"
+        "lv2 = 30\n"
+        "lv3 = 35\n"
+        "[ambient]\n"
+        "reference = 25\n"
+        "relative = true\n"), 0);
+
+    thermal_state_t ts;
+    thermal_state_init(&ts);
+    fan_config_t cpu, ssd;
+
+    // No reading and a cool room both count as the reference
+    thermal_curves(&cfg, cfg.active, &ts, &cpu, &ssd);
+    CHECK_NEAR(cpu.lv0, 55.0, 1e-9);
+    CHECK_NEAR(cpu.lv3, 78.0, 1e-9);
+    CHECK_NEAR(ssd.lv0, 45.0, 1e-9);
+    CHECK_NEAR(ssd.lv3, 60.0, 1e-9);
+    ts.ambient_valid = 1;
+    ts.ambient_mc = 18000;
+    thermal_curves(&cfg, cfg.active, &ts, &cpu, &ssd);
+    CHECK_NEAR(cpu.lv0, 55.0, 1e-9);
+    CHECK_NEAR(cpu.lv2, 70.0, 1e-9);
+    CHECK_NEAR(cpu.lv3, 78.0, 1e-9);
+    CHECK_NEAR(thermal_ambient_rate(&cfg, &ts), 1.0 - 7.0 * cfg.ambient_rate_gain, 1e-9);
+
+    // A warm room raises lv0-lv2 up to the lv3 ceiling, which stays put
+    ts.ambient_mc = 35000;
+    thermal_curves(&cfg, cfg.active, &ts, &cpu, &ssd);
+    CHECK_NEAR(cpu.lv0, 65.0, 1e-9);
+    CHECK_NEAR(cpu.lv1, 72.0, 1e-9);
+    CHECK_NEAR(cpu.lv2, 78.0, 1e-9);
+    CHECK_NEAR(cpu.lv3, 78.0, 1e-9);
+    CHECK_NEAR(ssd.lv0, 55.0, 1e-9);
+    CHECK_NEAR(ssd.lv2, 60.0, 1e-9);
+    CHECK_NEAR(ssd.lv3, 60.0, 1e-9);
+
+    // At a fixed reading the duty step is flat below the reference and only
+    // falls as the room warms; over the lv3 ceiling it is always full speed
+    static const int32_t rooms_mc[] = { 5000, 15000, 25000, 30000, 35000, 45000 };
+    static const double want_70c[] = { 0.75, 0.75, 0.75, 0.50, 0.25, 0.0 };
+    for (size_t i = 0; i < sizeof(rooms_mc) / sizeof(rooms_mc[0]); i++) {
+        ts.ambient_mc = rooms_mc[i];
+        thermal_curves(&cfg, cfg.active, &ts, &cpu, &ssd);
+        CHECK_NEAR(config_temp_to_dc(&cpu, 70.0), want_70c[i], 0.0);
+        CHECK_NEAR(config_temp_to_dc(&cpu, 80.0), 1.0, 0.0);
+    }
+
+    // Absolute curves ignore the room
+    cfg.ambient_relative = 0;
+    config_changed(&cfg);
+    thermal_curves(&cfg, cfg.active, &ts, &cpu, &ssd);
+    CHECK_NEAR(cpu.lv0, 30.0, 0.0);
+    CHECK_NEAR(cpu.lv3, 53.0, 0.0);
+}
+
+void test_controller(void) {
+    test_ambient_sources();
+    test_drives_baseline();
+    test_relative_curves();
+    timebase_virtual_enable(timebase_wall_sec());
+    test_step();
+}
@@ -0,0 +1,80 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// radxa-penta-tests: config parsing, the control law, the smartctl parser
+// and OLED page composition on mock backends. Run by ctest; needs nothing
+// but a writable /tmp.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "logger.h"
+#include "mock_backend.h"
+
+int test_checks;
+int test_failures;
+
+void test_check(int ok, const char *file, int line, const char *expr) {
+    test_checks++;
+    if (ok) return;
+    test_failures++;
+    fprintf(stderr, "FAIL %s:%d: %s\n", file, line, expr);
+}
+
+void test_check_int(long got, long want, const char *file, int line, const char *expr) {
+    test_checks++;
+    if (got == want) return;
+    test_failures++;
+    fprintf(stderr, "FAIL %s:%d: %s is %ld, want %ld\n", file, line, expr, got, want);
+}
+
+void test_check_near(double got, double want, double eps, const char *file, int line, const char *expr) {
+    test_checks++;
+    if (fabs(got - want) <= eps) return;
+    test_failures++;
+    fprintf(stderr, "FAIL %s:%d: %s is %g, want %g\n", file, line, expr, got, want);
+}
+
+int test_load_config(config_t *cfg, const char *text) {
+    char path[] = "/tmp/radxa-penta-test.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        exit(1);
+    }
+    size_t len = strlen(text);
+    int ok = write(fd, text, len) == (ssize_t)len;
+    close(fd);
+    int rc = ok ? config_load_file(cfg, path) : -1;
+    unlink(path);
+    return rc;
+}
+
+int main(int argc, char *argv[]) {
+    // The render test puts this binary first on PATH as smartctl
+    if (mock_is_smartctl(argv[0])) return mock_smartctl_main(argc, argv);
+    logger_init("warning", 0, NULL);
+
+    // The controller test switches to the virtual clock; keep it last
+    static const struct {
+        const char *name;
+        void (*run)(void);
+    } suites[] = {
+        { "config", test_config },
+        { "smart", test_smart },
+        { "render", test_render },
+        { "controller", test_controller },
+    };
+
+    for (size_t i = 0; i < sizeof(suites) / sizeof(suites[0]); i++) {
+        int failures = test_failures;
+        suites[i].run();
+        printf("%-12s %s\n", suites[i].name, test_failures == failures ? "ok" : "FAILED");
+    }
+    printf("%d checks, %d failed\n", test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
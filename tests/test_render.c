@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// OLED page composition on the mock backend: the thermal zone file, the
+// canned smartctl, a fixed address and a synthetic history
+
+#include <string.h>
+#include "test.h"
+#include "oled_render.h"
+#include "thermal.h"
+#include "mock_backend.h"
+
+#define TEST_HISTORY_SEC 7200
+
+static const char *line(const oled_frame_t *f, int i) {
+    return i < f->text_count ? f->text[i].text : "";
+}
+
+static int starts_with(const char *s, const char *prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static void test_text_pages(oled_t *oled) {
+    oled_frame_t f;
+
+    oled_render_page(oled, PAGE_SYSTEM, &f);
+    CHECK_INT(f.text_count, 3);
+    CHECK(starts_with(line(&f, 0), "Up "));
+    CHECK(starts_with(line(&f, 1), "CPU: 47."));
+    CHECK(strcmp(line(&f, 2), "IP 192.0.2.10") == 0);
+
+    oled_render_page(oled, PAGE_DISKS, &f);
+    CHECK_INT(f.text_count, 2);
+    CHECK(strcmp(line(&f, 0), "SDA:37C SDB:38C") == 0);
+    CHECK(strcmp(line(&f, 1), "SDC:39C SDD:40C") == 0);
+
+    oled_render_page(oled, PAGE_HEALTH, &f);
+    CHECK_INT(f.text_count, 2);
+    CHECK(strcmp(line(&f, 0), "SDA:97% SDB:97%") == 0);
+
+    // Only the drives this display shows
+    oled->disks = 1u << 2;
+    oled_render_page(oled, PAGE_DISKS, &f);
+    CHECK(strcmp(line(&f, 0), "SDC:39C") == 0);
+    oled->disks = 0;
+    oled_render_page(oled, PAGE_DISKS, &f);
+    CHECK(strcmp(line(&f, 0), "No SSD data") == 0);
+    oled->disks = ~0u;
+
+    // The mock's RAID mount is its scratch directory
+    oled_render_page(oled, PAGE_RAID, &f);
+    CHECK_INT(f.text_count, 1);
+    CHECK(starts_with(line(&f, 0), "RAID:"));
+    CHECK(strchr(line(&f, 0), '%') != NULL);
+
+    oled_render_page(oled, PAGE_RESOURCES, &f);
+    CHECK_INT(f.text_count, 2);
+    for (int x = 0; x < OLED_WIDTH; x++) {
+        if (f.bar_top[x] != OLED_NO_BAR) {
+            CHECK(!"text page drew a bar");
+            break;
+        }
+    }
+}
+
+static void test_graph(oled_t *oled, history_t *history) {
+    oled_frame_t f;
+
+    oled->history = NULL;
+    oled_render_page(oled, PAGE_GRAPH, &f);
+    CHECK(strcmp(line(&f, 0), "History disabled") == 0);
+
+    oled->history = history;
+    oled_render_page(oled, PAGE_GRAPH, &f);
+    CHECK_INT(f.text_count, 1);
+    CHECK(starts_with(line(&f, 0), "CPU 2h "));
+    int bars = 0, in_range = 1;
+    for (int x = 0; x < OLED_WIDTH; x++) {
+        if (f.bar_top[x] == OLED_NO_BAR) continue;
+        bars++;
+        if (f.bar_top[x] < 8 || f.bar_top[x] > OLED_HEIGHT - 1) in_range = 0;
+    }
+    // Two hours of one-second samples cover every column
+    CHECK_INT(bars, OLED_WIDTH);
+    CHECK(in_range);
+}
+
+void test_render(void) {
+    static mock_backend_t mock;
+    CHECK_INT(mock_open(&mock, "tests", TEST_HISTORY_SEC), 0);
+    CHECK(mock.have_history);
+    CHECK_INT(mock_install_smartctl(&mock), 0);
+    thermal_set_zone_path(mock.zone);
+
+    // One sensor pass fills the drive cache and, the first time, health
+    thermal_sample_t sample;
+    thermal_sample(&sample);
+    CHECK_INT(sample.cpu_mc, MOCK_CPU_MC);
+    CHECK_INT(sample.ssd_count, SSD_DEVICE_COUNT);
+    CHECK_INT(sample.ssd_temps[0], MOCK_SMART_TEMP);
+
+    oled_t oled;
+    memset(&oled, 0, sizeof(oled));
+    oled.disks = ~0u;
+    oled.sysinfo = &mock.sysinfo;
+    test_text_pages(&oled);
+    if (mock.have_history) test_graph(&oled, &mock.history);
+
+    thermal_set_zone_path(NULL);
+    mock_close(&mock);
+}
@@ -0,0 +1,143 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * Copyright (c) 2025 Francisco Javier Acosta Padilla
+ */
+
+// smartctl parser on the captured outputs in tests/smart-corpus and the
+// mock's canned reports: expected fields, fed whole and byte by byte
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "smart.h"
+#include "thermal.h"
+#include "mock_backend.h"
+
+#ifndef RADXA_PENTA_SMART_CORPUS
+#define RADXA_PENTA_SMART_CORPUS "tests/smart-corpus"
+#endif
+#define TEST_SMART_MAX (64 * 1024)
+#define TEST_SMART_PATH_LEN 512
+#define NONE (-1L)
+
+typedef struct {
+    const char *file;
+    smart_mode_t mode;
+    long temp;
+    long reallocated;
+    long pending;
+    long wear;
+    long used;
+    long media_errors;
+} smart_expect_t;
+
+static const smart_expect_t corpus[] = {
+    { "ata-brief.txt",  SMART_MODE_TEXT, 38, 0,    0,    NONE, NONE, NONE },
+    { "ata.json",       SMART_MODE_JSON, 36, 2,    1,    97,   NONE, NONE },
+    { "ata.txt",        SMART_MODE_TEXT, 36, 2,    1,    97,   NONE, NONE },
+    { "nvme.json",      SMART_MODE_JSON, 41, NONE, NONE, NONE, 3,    0 },
+    { "nvme.txt",       SMART_MODE_TEXT, 41, NONE, NONE, NONE, 3,    0 },
+    { "scsi-noeol.txt", SMART_MODE_TEXT, 29, NONE, NONE, NONE, NONE, NONE },
+    { "scsi.json",      SMART_MODE_JSON, 33, NONE, NONE, NONE, NONE, NONE },
+    { "scsi.txt",       SMART_MODE_TEXT, 33, NONE, NONE, NONE, NONE, NONE },
+};
+
+static char capture[TEST_SMART_MAX];
+
+static size_t load(const char *name) {
+    char path[TEST_SMART_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", RADXA_PENTA_SMART_CORPUS, name);
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "FAIL cannot open %s\n", path);
+        return 0;
+    }
+    size_t len = fread(capture, 1, sizeof(capture), fp);
+    fclose(fp);
+    return len;
+}
+
+// chunk 0 = the whole buffer in one feed
+static void parse(smart_parser_t *p, unsigned int want, const char *buf, size_t len, size_t chunk) {
+    size_t off = 0;
+    int done = 0;
+    smart_parser_init(p, want);
+    while (!done && off < len) {
+        size_t n = chunk == 0 || chunk > len - off ? len - off : chunk;
+        done = smart_parser_feed(p, buf + off, n);
+        off += n;
+    }
+    if (!done) smart_parser_finish(p);
+}
+
+// want NONE: the capture has no such field and none may be reported
+static void check_field(const smart_parser_t *p, const char *file, const char *field, unsigned int bit,
+                        long got, long want) {
+    char what[128];
+    int found = (p->found & bit) != 0;
+    if (want == NONE) {
+        snprintf(what, sizeof(what), "%s: %s reported, not in the capture", file, field);
+        test_check(!found, __FILE__, __LINE__, what);
+    } else if (!found) {
+        snprintf(what, sizeof(what), "%s: %s missing", file, field);
+        test_check(0, __FILE__, __LINE__, what);
+    } else {
+        snprintf(what, sizeof(what), "%s: %s", file, field);
+        test_check_int(got, want, __FILE__, __LINE__, what);
+    }
+}
+
+static void check_expect(const smart_parser_t *p, const smart_expect_t *e) {
+    CHECK_INT(p->mode, e->mode);
+    check_field(p, e->file, "temp", SMART_TEMP, p->temp, e->temp);
+    check_field(p, e->file, "reallocated", SMART_REALLOCATED, p->reallocated, e->reallocated);
+    check_field(p, e->file, "pending", SMART_PENDING, p->pending, e->pending);
+    check_field(p, e->file, "wear", SMART_WEAR, p->wear, e->wear);
+    check_field(p, e->file, "percent_used", SMART_USED, p->percent_used, e->used);
+    check_field(p, e->file, "media_errors", SMART_MEDIA_ERRORS, p->media_errors, e->media_errors);
+}
+
+static void test_corpus(void) {
+    static const size_t chunks[] = { 0, 1, 7, SMARTCTL_READ_CHUNK };
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        size_t len = load(corpus[i].file);
+        CHECK(len > 0);
+        if (len == 0) continue;
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            smart_parser_t p;
+            parse(&p, SMART_TEMP | SMART_HEALTH, capture, len, chunks[c]);
+            check_expect(&p, &corpus[i]);
+
+            // A temperature-only pass may stop early but finds the same temperature
+            parse(&p, SMART_TEMP, capture, len, chunks[c]);
+            check_field(&p, corpus[i].file, "temp", SMART_TEMP, p.temp, corpus[i].temp);
+        }
+    }
+}
+
+static void test_mock_reports(void) {
+    char buf[2048];
+    smart_parser_t p;
+
+    int len = mock_smart_report(buf, sizeof(buf), 0, MOCK_SMART_TEMP);
+    CHECK(len > 0 && (size_t)len < sizeof(buf));
+    parse(&p, SMART_TEMP | SMART_HEALTH, buf, (size_t)len, 0);
+    CHECK_INT(p.mode, SMART_MODE_TEXT);
+    CHECK_INT(p.found & (SMART_TEMP | SMART_REALLOCATED | SMART_PENDING | SMART_WEAR),
+              SMART_TEMP | SMART_REALLOCATED | SMART_PENDING | SMART_WEAR);
+    CHECK_INT(p.temp, MOCK_SMART_TEMP);
+    CHECK_INT(p.wear, 97);
+
+    len = mock_smart_report(buf, sizeof(buf), 1, MOCK_SMART_TEMP);
+    CHECK(len > 0 && (size_t)len < sizeof(buf));
+    parse(&p, SMART_TEMP | SMART_HEALTH, buf, (size_t)len, 3);
+    CHECK_INT(p.mode, SMART_MODE_JSON);
+    CHECK_INT(p.temp, MOCK_SMART_TEMP);
+    CHECK_INT(p.percent_used, 4);
+    CHECK_INT(p.media_errors, 0);
+}
+
+void test_smart(void) {
+    test_corpus();
+    test_mock_reports();
+}